@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+农历数据分区生成工具
+根据 main/lunar_calendar.c 中的月份表和节气表，为1900-01-31至2101-01-28的
+每一天预先计算农历月日文本、节气和传统节日，生成定长记录的二进制文件，
+烧录到 partitions.csv 中的 almanac 分区，设备端用 esp_partition_mmap 直接查表。
+
+使用方法:
+1. 生成: python almanac_tool.py --output build/almanac.bin
+2. 烧录: idf.py flash 会随工程一起烧录（见CMakeLists.txt），
+   或单独执行 parttool.py write_partition --partition-name almanac --input build/almanac.bin
+3. 校验: python almanac_tool.py --verify build/almanac.bin
+
+文件布局与 main/almanac.h 一致。
+"""
+
+import argparse
+import datetime
+import re
+import struct
+import sys
+import zlib
+from pathlib import Path
+
+ALMANAC_MAGIC = 0x4E4D4C41  # "ALMN"
+ALMANAC_VERSION = 1
+HEADER_FORMAT = '<IHHiIIHHII'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+RECORD_FORMAT = '<HbB'
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+STRING_SIZE = 20
+PARTITION_SIZE = 0x50000
+
+MIN_YEAR = 1900
+EPOCH = datetime.date(1970, 1, 1)
+LUNAR_EPOCH = datetime.date(1900, 1, 31)  # 1900年正月初一
+
+MONTH_NAMES = ['正月', '二月', '三月', '四月', '五月', '六月', '七月', '八月', '九月', '十月', '冬月', '腊月']
+DAY_TENS = ['初', '十', '廿', '三']
+DIGITS = ['', '一', '二', '三', '四', '五', '六', '七', '八', '九', '十']
+
+# 与 lunar_festival_t 的取值一致
+FESTIVALS = {
+    (1, 1): 1, (1, 15): 2, (2, 2): 3, (5, 5): 5, (7, 7): 6, (7, 15): 7,
+    (8, 15): 8, (9, 9): 9, (12, 8): 10, (12, 23): 11,
+}
+FESTIVAL_QINGMING = 4
+FESTIVAL_NEW_YEARS_EVE = 12
+SOLAR_TERM_QINGMING = 6
+
+
+def parse_c_array(source, name):
+    """从C源码中取出数组的全部整数"""
+    match = re.search(r'\b' + name + r'\[[^\]]*\](?:\[[^\]]*\])?\s*=\s*\{(.*?)\};', source, re.S)
+    if not match:
+        raise ValueError(f'未在lunar_calendar.c中找到数组 {name}')
+    body = re.sub(r'//[^\n]*', '', match.group(1))
+    return [int(tok, 0) for tok in re.findall(r'0x[0-9a-fA-F]+|\d+', body)]
+
+
+def load_tables(source_path):
+    source = Path(source_path).read_text(encoding='utf-8')
+    tables = {
+        'info': parse_c_array(source, 'lunar_info'),
+        'new_year': parse_c_array(source, 'lunar_new_year_offset'),
+        'term_base': parse_c_array(source, 'solar_term_base'),
+        'term_table': parse_c_array(source, 'solar_term_table'),
+    }
+    years = len(tables['info'])
+    if len(tables['new_year']) != years + 1 or len(tables['term_base']) != 24 or \
+            len(tables['term_table']) != years * 6:
+        raise ValueError('lunar_calendar.c 中的表长度不一致')
+    return tables
+
+
+def format_lunar(month, day, leap):
+    if day == 10:
+        day_text = '初十'
+    elif day == 20:
+        day_text = '二十'
+    elif day == 30:
+        day_text = '三十'
+    else:
+        day_text = DAY_TENS[day // 10] + DIGITS[day % 10]
+    return ('闰' if leap else '') + MONTH_NAMES[month - 1] + ' ' + day_text
+
+
+def text_index(month, day, leap):
+    return ((12 if leap else 0) + month - 1) * 30 + day - 1
+
+
+def solar_term_day(tables, year, term):
+    row = tables['term_table'][(year - MIN_YEAR) * 6:(year - MIN_YEAR) * 6 + 6]
+    return tables['term_base'][term] + ((row[term >> 2] >> ((term & 3) * 2)) & 0x3)
+
+
+def iterate_days(tables):
+    """按公历日期顺序产出 (公历日期, 农历月, 日, 闰月, 本月天数)"""
+    date = LUNAR_EPOCH
+    for index, info in enumerate(tables['info']):
+        leap_month = info & 0xf
+        months = []
+        for month in range(1, 13):
+            months.append((month, False, 30 if info & (0x10000 >> month) else 29))
+            if month == leap_month:
+                months.append((month, True, 30 if info & 0x10000 else 29))
+        assert (date - LUNAR_EPOCH).days == tables['new_year'][index], f'{MIN_YEAR + index}年正月初一偏移不符'
+        for month, leap, days in months:
+            for day in range(1, days + 1):
+                yield date, month, day, leap, days
+                date += datetime.timedelta(days=1)
+
+
+def build_almanac(tables):
+    strings = bytearray(24 * 30 * STRING_SIZE)
+    for leap in (False, True):
+        for month in range(1, 13):
+            for day in range(1, 31):
+                text = format_lunar(month, day, leap).encode('utf-8')
+                assert len(text) < STRING_SIZE
+                offset = text_index(month, day, leap) * STRING_SIZE
+                strings[offset:offset + len(text)] = text
+
+    records = bytearray()
+    first_date = None
+    count = 0
+    for date, month, day, leap, days in iterate_days(tables):
+        if first_date is None:
+            first_date = date
+        term = -1
+        if date.year - MIN_YEAR < len(tables['info']):
+            for candidate in ((date.month - 1) * 2, (date.month - 1) * 2 + 1):
+                if solar_term_day(tables, date.year, candidate) == date.day:
+                    term = candidate
+        festival = 0
+        if term == SOLAR_TERM_QINGMING:
+            festival = FESTIVAL_QINGMING
+        elif not leap:
+            festival = FESTIVALS.get((month, day), 0)
+            if month == 12 and day == days:
+                festival = FESTIVAL_NEW_YEARS_EVE
+        records += struct.pack(RECORD_FORMAT, text_index(month, day, leap), term, festival)
+        count += 1
+
+    record_offset = HEADER_SIZE
+    string_offset = record_offset + len(records)
+    body = bytes(records) + bytes(strings)
+    header = struct.pack(HEADER_FORMAT, ALMANAC_MAGIC, ALMANAC_VERSION, RECORD_SIZE,
+                         (first_date - EPOCH).days, count, string_offset,
+                         len(strings) // STRING_SIZE, STRING_SIZE, record_offset,
+                         zlib.crc32(body) & 0xffffffff)
+    return header + body
+
+
+def verify_almanac(data):
+    if len(data) < HEADER_SIZE:
+        return False, '文件过短'
+    (magic, version, record_size, first_day, count, string_offset,
+     string_count, string_size, record_offset, crc) = struct.unpack_from(HEADER_FORMAT, data)
+    if magic != ALMANAC_MAGIC or version != ALMANAC_VERSION or record_size != RECORD_SIZE:
+        return False, '头部格式不符'
+    end = max(record_offset + count * record_size, string_offset + string_count * string_size)
+    if end > len(data):
+        return False, '数据不完整'
+    if zlib.crc32(data[HEADER_SIZE:end]) & 0xffffffff != crc:
+        return False, 'CRC校验失败'
+    first = EPOCH + datetime.timedelta(days=first_day)
+    last = first + datetime.timedelta(days=count - 1)
+    return True, f'{count}天 ({first} ~ {last})，CRC 0x{crc:08x}'
+
+
+def main():
+    parser = argparse.ArgumentParser(description='生成ESP32农历数据分区镜像')
+    parser.add_argument('--source', default=str(Path(__file__).parent / 'main' / 'lunar_calendar.c'),
+                        help='农历表所在的C源文件')
+    parser.add_argument('--output', default='build/almanac.bin', help='输出文件')
+    parser.add_argument('--verify', metavar='FILE', help='只校验已生成的文件')
+    args = parser.parse_args()
+
+    if args.verify:
+        ok, message = verify_almanac(Path(args.verify).read_bytes())
+        print(('✅ ' if ok else '❌ ') + message)
+        return 0 if ok else 1
+
+    data = build_almanac(load_tables(args.source))
+    if len(data) > PARTITION_SIZE:
+        print(f'❌ 数据大小 {len(data)} 超过分区大小 {PARTITION_SIZE}')
+        return 1
+
+    output = Path(args.output)
+    output.parent.mkdir(parents=True, exist_ok=True)
+    output.write_bytes(data)
+    ok, message = verify_almanac(data)
+    print(f'{"✅" if ok else "❌"} {output}: {len(data)} bytes, {message}')
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+云端替身服务器
+在局域网内模拟腾讯云ASR和GLM接口，并按比例注入卡顿，用于验证对冲请求与取消
+
+使用方法:
+1. 在 main/tls_session.h 中把 TLS_SESSION_STUB_HOST 设为运行本脚本的电脑IP，重新编译烧录
+2. 运行: python cloud_stall_server.py --stall-rate 0.2 --stall-seconds 8
+3. 在AI助手页面多次提问，观察串口日志中的对冲记录和 /api/status 中 net.latency 的统计
+
+卡顿的请求在响应头之前停顿，设备端对冲请求胜出后会断开连接，此时本脚本记录"客户端已断开"。
+加 --gzip 时按设备的Accept-Encoding压缩响应，用于验证响应解压（/api/status 中的 net.encoding）。
+"""
+
+import argparse
+import gzip
+import json
+import random
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+GLM_PATH = '/api/paas/v4/chat/completions'
+
+request_counter = 0
+counter_lock = threading.Lock()
+
+
+def next_request_id():
+    global request_counter
+    with counter_lock:
+        request_counter += 1
+        return request_counter
+
+
+def asr_response(body):
+    """腾讯云一句话识别的响应格式"""
+    try:
+        data_len = json.loads(body).get('DataLen', 0)
+    except ValueError:
+        data_len = 0
+    duration_ms = int(data_len / 32) if data_len else 0     # 16kHz 16位单声道
+    return {
+        'Response': {
+            'Result': '今天天气怎么样',
+            'AudioDuration': duration_ms,
+            'WordSize': 0,
+            'WordList': None,
+            'RequestId': 'stub-%d' % int(time.time() * 1000),
+        }
+    }
+
+
+def glm_response(body):
+    """GLM对话接口的响应格式"""
+    try:
+        question = json.loads(body)['messages'][0]['content']
+    except (ValueError, KeyError, IndexError):
+        question = ''
+    return {
+        'id': 'stub-%d' % int(time.time() * 1000),
+        'model': 'glm-4-flash',
+        'choices': [{
+            'index': 0,
+            'finish_reason': 'stop',
+            'message': {'role': 'assistant', 'content': '替身服务器收到：%s' % question[:40]},
+        }],
+        'usage': {'prompt_tokens': 10, 'completion_tokens': 10, 'total_tokens': 20},
+    }
+
+
+class StallHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'   # 设备端保持连接
+    options = None
+
+    def log_message(self, format, *args):
+        pass
+
+    def do_HEAD(self):
+        # 设备端预热连接用HEAD
+        self.send_response(200)
+        self.send_header('Content-Length', '0')
+        self.end_headers()
+
+    def do_POST(self):
+        request_id = next_request_id()
+        started = time.time()
+        length = int(self.headers.get('Content-Length', 0))
+        body = self.rfile.read(length) if length else b''
+
+        if self.path.startswith(GLM_PATH):
+            endpoint, payload = 'GLM', glm_response(body)
+        else:
+            endpoint, payload = 'ASR', asr_response(body)
+
+        opts = self.options
+        delay = max(0.0, random.gauss(opts.latency_ms, opts.jitter_ms) / 1000.0)
+        stalled = random.random() < opts.stall_rate
+        if stalled:
+            delay += opts.stall_seconds
+        time.sleep(delay)
+
+        data = json.dumps(payload, ensure_ascii=False).encode('utf-8')
+        compressed = opts.gzip and 'gzip' in self.headers.get('Accept-Encoding', '')
+        if compressed:
+            data = gzip.compress(data)
+        try:
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/json; charset=utf-8')
+            if compressed:
+                self.send_header('Content-Encoding', 'gzip')
+            self.send_header('Content-Length', str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+            result = '完成'
+        except (BrokenPipeError, ConnectionResetError):
+            result = '客户端已断开'
+
+        print(f"#{request_id:<4} {endpoint} 来自 {self.client_address[0]} 请求体 {len(body)} 字节 "
+              f"{'卡顿' if stalled else '正常'} {'gzip ' if compressed else ''}耗时 {(time.time() - started) * 1000:.0f} ms {result}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description='云端替身服务器（注入卡顿）')
+    parser.add_argument('--host', default='0.0.0.0', help='监听地址')
+    parser.add_argument('--port', '-p', type=int, default=8080, help='监听端口，与TLS_SESSION_STUB_PORT一致')
+    parser.add_argument('--latency-ms', type=float, default=600, help='正常请求的平均耗时(ms)')
+    parser.add_argument('--jitter-ms', type=float, default=150, help='正常请求耗时的标准差(ms)')
+    parser.add_argument('--stall-rate', type=float, default=0.1, help='卡顿请求的比例 (0~1)')
+    parser.add_argument('--stall-seconds', type=float, default=8, help='卡顿时额外停顿的秒数')
+    parser.add_argument('--seed', type=int, help='随机种子，便于复现')
+    parser.add_argument('--gzip', action='store_true', help='设备声明支持时用gzip压缩响应')
+    args = parser.parse_args()
+
+    if args.seed is not None:
+        random.seed(args.seed)
+
+    StallHandler.options = args
+    server = ThreadingHTTPServer((args.host, args.port), StallHandler)
+    server.daemon_threads = True
+    print(f"替身服务器监听 {args.host}:{args.port}，正常耗时 {args.latency_ms:.0f}±{args.jitter_ms:.0f} ms，"
+          f"卡顿比例 {args.stall_rate:.0%}，卡顿 {args.stall_seconds:.1f} 秒")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        print("\n已停止")
+
+
+if __name__ == '__main__':
+    main()
@@ -6,24 +6,81 @@
 #include "wifi_manager.h"
 #include "esp_system.h"
 #include "esp_heap_caps.h"
+#include "tls_session.h"
+#include "json_stream.h"
+#include "http_decode.h"
+#include "json_arena.h"
+#include "net_service.h"
+#include "net_hedge.h"
 #include <string.h>
 #include <stdlib.h>
 
 static const char *TAG = "AI_CHAT";
 
-// HTTP响应数据结构
+static tls_session_t glm_session = TLS_SESSION_INITIALIZER("GLM");  // 跨请求复用TLS会话
+static tls_session_t glm_hedge_session = TLS_SESSION_INITIALIZER("GLM对冲");  // 对冲请求的独立连接
+static json_arena_t glm_arena = JSON_ARENA_INITIALIZER("GLM");      // 请求JSON的cJSON节点
+static json_arena_t glm_hedge_arena = JSON_ARENA_INITIALIZER("GLM对冲");
+
+// 主请求与对冲请求各用一个槽位，连接、分配池和回复缓冲区互不共享
+typedef struct {
+    tls_session_t *session;
+    json_arena_t *arena;
+    const char *user_message;
+    ai_chat_response_t response;    // 胜出时整体交给调用者
+} glm_slot_t;
+
+static http_decode_endpoint_t glm_decode = HTTP_DECODE_ENDPOINT_INITIALIZER("GLM");
+
+static glm_slot_t glm_primary = { .session = &glm_session, .arena = &glm_arena };
+static glm_slot_t glm_hedge_slot = { .session = &glm_hedge_session, .arena = &glm_hedge_arena };
+
+static esp_err_t run_chat_attempt(void *arg, net_cancel_t *cancel);
+static void discard_chat_response(void *arg);
+static net_hedge_t glm_hedge = NET_HEDGE_INITIALIZER("GLM", GLM_HEDGE_PERCENTILE,
+                                                     run_chat_attempt, discard_chat_response,
+                                                     &glm_primary, &glm_hedge_slot);
+
+// 响应流式解析：只取回复内容和错误信息，不缓存响应体（压缩传输时边解压边解析）
 typedef struct {
-    char *data;
-    size_t len;
-    size_t capacity;
-} http_response_data_t;
+    tls_session_t *session;
+    http_decoder_t decoder;
+    json_stream_t stream;
+    json_stream_field_t fields[4];
+    char *content;              // PSRAM，GLM_MAX_RESPONSE_SIZE字节，成功时交给ai_chat_response_t
+    char error_message[160];
+    char error_code[32];
+} glm_response_parser_t;
+
+enum { GLM_FIELD_CONTENT, GLM_FIELD_ERROR, GLM_FIELD_ERROR_MESSAGE, GLM_FIELD_ERROR_CODE };
+
+static void feed_response(const char *data, int len, void *ctx)
+{
+    json_stream_feed(ctx, data, len);
+}
+
+static void glm_parser_init(glm_response_parser_t *parser)
+{
+    parser->fields[GLM_FIELD_CONTENT] = (json_stream_field_t)JSON_STREAM_FIELD(
+        "choices[0].message.content", parser->content, GLM_MAX_RESPONSE_SIZE);
+    parser->fields[GLM_FIELD_ERROR] = (json_stream_field_t)JSON_STREAM_PRESENCE("error");
+    parser->fields[GLM_FIELD_ERROR_MESSAGE] = (json_stream_field_t)JSON_STREAM_FIELD(
+        "error.message", parser->error_message, sizeof(parser->error_message));
+    parser->fields[GLM_FIELD_ERROR_CODE] = (json_stream_field_t)JSON_STREAM_FIELD(
+        "error.code", parser->error_code, sizeof(parser->error_code));
+    json_stream_init(&parser->stream, parser->fields, sizeof(parser->fields) / sizeof(parser->fields[0]));
+    http_decoder_begin(&parser->decoder, &glm_decode, feed_response, &parser->stream);
+}
 
 /**
  * @brief HTTP事件处理函数
  */
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
-    http_response_data_t *response_data = (http_response_data_t *)evt->user_data;
+    glm_response_parser_t *parser = (glm_response_parser_t *)evt->user_data;
+    
+    // 预热请求没有parser，只发生在主连接上
+    tls_session_on_event(parser ? parser->session : &glm_session, evt);
     
     switch (evt->event_id) {
         case HTTP_EVENT_ERROR:
@@ -37,34 +94,15 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
             break;
         case HTTP_EVENT_ON_HEADER:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER: %s: %s", evt->header_key, evt->header_value);
+            if (parser) {
+                http_decoder_on_event(&parser->decoder, evt);
+            }
             break;
         case HTTP_EVENT_ON_DATA:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA: 接收到 %d 字节数据", evt->data_len);
-            
-            // 确保有足够的缓冲区空间
-            if (response_data->len + evt->data_len >= response_data->capacity) {
-                size_t new_capacity = response_data->capacity * 1.5;  // 使用更保守的增长因子
-                if (new_capacity < response_data->len + evt->data_len + 1) {
-                    new_capacity = response_data->len + evt->data_len + 512;  // 更小的缓冲区增量
-                }
-                
-                ESP_LOGI(TAG, "扩展响应缓冲区: %d -> %d 字节", response_data->capacity, new_capacity);
-                
-                // 使用PSRAM分配内存
-                char *new_data = heap_caps_realloc(response_data->data, new_capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-                if (new_data == NULL) {
-                    ESP_LOGE(TAG, "重新分配内存失败 (%d 字节), 当前可用HEAP: %d 字节", 
-                            new_capacity, heap_caps_get_free_size(MALLOC_CAP_8BIT));
-                    break;
-                }
-                response_data->data = new_data;
-                response_data->capacity = new_capacity;
+            if (parser) {
+                http_decoder_on_event(&parser->decoder, evt);
             }
-            
-            // 复制数据
-            memcpy(response_data->data + response_data->len, evt->data, evt->data_len);
-            response_data->len += evt->data_len;
-            response_data->data[response_data->len] = '\0';  // 确保字符串结束
             break;
         case HTTP_EVENT_ON_FINISH:
             ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
@@ -78,6 +116,28 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
+/**
+ * @brief GLM客户端配置（请求与预热共用）
+ */
+static void glm_client_config(esp_http_client_config_t *config, void *user_data)
+{
+    *config = (esp_http_client_config_t) {
+        .url = GLM_API_URL,
+        .method = HTTP_METHOD_POST,
+        .timeout_ms = GLM_REQUEST_TIMEOUT_MS,
+        .event_handler = http_event_handler,
+        .user_data = user_data,
+        .transport_type = HTTP_TRANSPORT_OVER_SSL,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .skip_cert_common_name_check = false,
+        .use_global_ca_store = false,
+        .disable_auto_redirect = true,
+        .is_async = false,
+        .buffer_size = 2048,  // 减小缓冲区大小
+        .buffer_size_tx = 2048,  // 减小发送缓冲区大小
+    };
+}
+
 /**
  * @brief 构建GLM-4-Flash API请求JSON
  */
@@ -115,73 +175,59 @@ static char* build_request_json(const char *user_message)
 }
 
 /**
- * @brief 解析GLM-4-Flash API响应JSON
+ * @brief 格式化API返回的错误对象，没有错误对象时返回false
  */
-static bool parse_response_json(const char *json_str, ai_chat_response_t *response)
+static bool format_api_error(const glm_response_parser_t *parser, ai_chat_response_t *response)
 {
-    cJSON *root = cJSON_Parse(json_str);
-    if (root == NULL) {
-        snprintf(response->error_msg, sizeof(response->error_msg), "JSON解析失败");
-        ESP_LOGE(TAG, "JSON解析失败: %s", json_str);
+    if (parser->fields[GLM_FIELD_ERROR].type == JSON_STREAM_NONE) {
         return false;
     }
-    
-    // 检查是否有错误
-    cJSON *error = cJSON_GetObjectItem(root, "error");
-    if (error != NULL) {
-        cJSON *error_message = cJSON_GetObjectItem(error, "message");
-        cJSON *error_code = cJSON_GetObjectItem(error, "code");
-        if (error_message && cJSON_IsString(error_message)) {
-            if (error_code && cJSON_IsString(error_code)) {
-                snprintf(response->error_msg, sizeof(response->error_msg), 
-                        "API错误[%s]: %s", error_code->valuestring, error_message->valuestring);
-            } else {
-                snprintf(response->error_msg, sizeof(response->error_msg), 
-                        "API错误: %s", error_message->valuestring);
-            }
+    if (parser->fields[GLM_FIELD_ERROR_MESSAGE].type == JSON_STREAM_STRING) {
+        if (parser->fields[GLM_FIELD_ERROR_CODE].type != JSON_STREAM_NONE) {
+            snprintf(response->error_msg, sizeof(response->error_msg),
+                    "API错误[%s]: %s", parser->error_code, parser->error_message);
         } else {
-            snprintf(response->error_msg, sizeof(response->error_msg), "未知API错误");
+            snprintf(response->error_msg, sizeof(response->error_msg),
+                    "API错误: %s", parser->error_message);
         }
-        ESP_LOGE(TAG, "API返回错误: %s", response->error_msg);
-        cJSON_Delete(root);
+    } else {
+        snprintf(response->error_msg, sizeof(response->error_msg), "未知API错误");
+    }
+    return true;
+}
+
+/**
+ * @brief 检查流式解析结果，成功时把回复缓冲区交给response
+ */
+static bool parse_response_json(glm_response_parser_t *parser, ai_chat_response_t *response)
+{
+    if (json_stream_finish(&parser->stream) != ESP_OK) {
+        snprintf(response->error_msg, sizeof(response->error_msg), "JSON解析失败");
+        ESP_LOGE(TAG, "JSON解析失败 (已接收 %u 字节)", (unsigned)parser->stream.bytes);
         return false;
     }
     
-    // 解析正常响应
-    cJSON *choices = cJSON_GetObjectItem(root, "choices");
-    if (!choices || !cJSON_IsArray(choices) || cJSON_GetArraySize(choices) == 0) {
-        snprintf(response->error_msg, sizeof(response->error_msg), "响应格式错误: 缺少choices");
-        ESP_LOGE(TAG, "响应格式错误: 缺少choices");
-        cJSON_Delete(root);
+    // 检查是否有错误
+    if (format_api_error(parser, response)) {
+        ESP_LOGE(TAG, "API返回错误: %s", response->error_msg);
         return false;
     }
     
-    cJSON *first_choice = cJSON_GetArrayItem(choices, 0);
-    cJSON *message = cJSON_GetObjectItem(first_choice, "message");
-    cJSON *content = cJSON_GetObjectItem(message, "content");
-    
-    if (!content || !cJSON_IsString(content)) {
+    const json_stream_field_t *content = &parser->fields[GLM_FIELD_CONTENT];
+    if (content->type != JSON_STREAM_STRING) {
         snprintf(response->error_msg, sizeof(response->error_msg), "响应格式错误: 缺少content");
         ESP_LOGE(TAG, "响应格式错误: 缺少content");
-        cJSON_Delete(root);
         return false;
     }
-    
-    // 复制内容
-    response->content_len = strlen(content->valuestring);
-    response->content = malloc(response->content_len + 1);
-    if (response->content == NULL) {
-        snprintf(response->error_msg, sizeof(response->error_msg), "内存分配失败");
-        ESP_LOGE(TAG, "内存分配失败");
-        cJSON_Delete(root);
-        return false;
+    if (content->truncated) {
+        ESP_LOGW(TAG, "AI回复超过 %d 字节，已截断", GLM_MAX_RESPONSE_SIZE);
     }
     
-    strcpy(response->content, content->valuestring);
+    response->content = parser->content;
+    response->content_len = strlen(parser->content);
+    parser->content = NULL;
     
     ESP_LOGI(TAG, "AI回复: %s", response->content);
-    
-    cJSON_Delete(root);
     return true;
 }
 
@@ -209,9 +255,12 @@ esp_err_t ai_chat_init(void)
     return ESP_OK;
 }
 
-esp_err_t ai_chat_send_message(const char *user_message, ai_chat_response_t *response)
+static esp_err_t send_message(glm_slot_t *slot, net_cancel_t *cancel)
 {
-    if (user_message == NULL || response == NULL) {
+    const char *user_message = slot->user_message;
+    ai_chat_response_t *response = &slot->response;
+    
+    if (user_message == NULL) {
         ESP_LOGE(TAG, "参数不能为空");
         return ESP_ERR_INVALID_ARG;
     }
@@ -252,50 +301,39 @@ esp_err_t ai_chat_send_message(const char *user_message, ai_chat_response_t *res
     
     ESP_LOGD(TAG, "请求JSON: %s", request_json);
     
-    // 初始化HTTP响应数据 - 使用PSRAM
-    http_response_data_t http_response = {0};
-    http_response.capacity = 1024;  // 使用较小的初始大小
-    http_response.data = heap_caps_malloc(http_response.capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (http_response.data == NULL) {
-        free(request_json);
+    // 回复内容直接解析到PSRAM中的定长缓冲区
+    glm_response_parser_t parser;
+    parser.session = slot->session;
+    parser.content = heap_caps_malloc(GLM_MAX_RESPONSE_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (parser.content == NULL) {
+        cJSON_free(request_json);
         snprintf(response->error_msg, sizeof(response->error_msg), "内存分配失败");
         ESP_LOGE(TAG, "内存分配失败");
         return ESP_FAIL;
     }
-    http_response.data[0] = '\0';
+    glm_parser_init(&parser);
     
     // 配置HTTP客户端 - 使用优化的SSL配置
-    esp_http_client_config_t config = {
-        .url = GLM_API_URL,
-        .method = HTTP_METHOD_POST,
-        .timeout_ms = 30000,
-        .event_handler = http_event_handler,
-        .user_data = &http_response,
-        .transport_type = HTTP_TRANSPORT_OVER_SSL,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .skip_cert_common_name_check = false,
-        .use_global_ca_store = false,
-        .disable_auto_redirect = true,
-        .is_async = false,
-        .buffer_size = 2048,  // 减小缓冲区大小
-        .buffer_size_tx = 2048,  // 减小发送缓冲区大小
-    };
+    esp_http_client_config_t config;
+    glm_client_config(&config, &parser);
     
     // 分配额外内存以避免堆栈溢出
     ESP_LOGI(TAG, "初始化HTTP客户端前可用内存: %d 字节", heap_caps_get_free_size(MALLOC_CAP_8BIT));
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    esp_http_client_handle_t client = tls_session_acquire(slot->session, &config);
     if (client == NULL) {
-        free(request_json);
-        free(http_response.data);
+        cJSON_free(request_json);
+        free(parser.content);
         snprintf(response->error_msg, sizeof(response->error_msg), "HTTP客户端初始化失败");
         ESP_LOGE(TAG, "HTTP客户端初始化失败");
         return ESP_FAIL;
     }
     
-    // 设置请求头
+    // 设置请求头（句柄可能刚做过HEAD预热，方法每次重新设置）
+    esp_http_client_set_method(client, HTTP_METHOD_POST);
     esp_http_client_set_header(client, "Content-Type", "application/json");
     esp_http_client_set_header(client, "Accept", "application/json");
     esp_http_client_set_header(client, "User-Agent", "ESP32-GLM4-Client/1.0");
+    http_decode_accept(client);
     
     // 设置Authorization头 - Bearer token格式
     char auth_header[512];
@@ -309,41 +347,116 @@ esp_err_t ai_chat_send_message(const char *user_message, ai_chat_response_t *res
     ESP_LOGI(TAG, "发送请求前可用内存: %d 字节", heap_caps_get_free_size(MALLOC_CAP_8BIT));
     
     // 发送请求
-    esp_err_t err = esp_http_client_perform(client);
+    esp_err_t err = tls_session_perform(slot->session, client, cancel);
+    esp_err_t decode_err = http_decoder_finish(&parser.decoder);
+    if (err == ESP_OK) {
+        err = decode_err;
+    }
     int status_code = esp_http_client_get_status_code(client);
     
     ESP_LOGI(TAG, "HTTP状态码: %d", status_code);
     
     if (err == ESP_OK && status_code == 200) {
-        ESP_LOGI(TAG, "API响应: %s", http_response.data);
-        
-        // 解析响应JSON
-        if (parse_response_json(http_response.data, response)) {
+        // 检查解析结果
+        if (parse_response_json(&parser, response)) {
             response->success = true;
             err = ESP_OK;
         } else {
             response->success = false;
-            err = ESP_FAIL;
+            err = ESP_ERR_INVALID_RESPONSE;
         }
     } else {
-        snprintf(response->error_msg, sizeof(response->error_msg), 
-                "HTTP请求失败: 状态码=%d, 错误=%s", status_code, esp_err_to_name(err));
         ESP_LOGE(TAG, "HTTP请求失败: 状态码=%d, 错误=%s", status_code, esp_err_to_name(err));
-        if (http_response.len > 0) {
-            ESP_LOGE(TAG, "响应内容: %s", http_response.data);
+        // 4xx响应体中通常带有error对象，优先给出服务端的错误信息
+        if (err != ESP_OK || json_stream_finish(&parser.stream) != ESP_OK ||
+            !format_api_error(&parser, response)) {
+            snprintf(response->error_msg, sizeof(response->error_msg), 
+                    "HTTP请求失败: 状态码=%d, 错误=%s", status_code, esp_err_to_name(err));
         }
+        ESP_LOGE(TAG, "%s", response->error_msg);
         response->success = false;
-        err = ESP_FAIL;
+        if (err == ESP_OK) {
+            // 鉴权、参数等4xx错误重试无意义，只有服务端繁忙时重试
+            err = (status_code >= 500 || status_code == 429) ? ESP_FAIL : ESP_ERR_INVALID_RESPONSE;
+        }
     }
     
-    // 清理资源
-    esp_http_client_cleanup(client);
-    free(request_json);
-    free(http_response.data);
+    // 清理资源（成功时保留客户端和TLS会话供下次复用）
+    tls_session_release(slot->session, err);
+    cJSON_free(request_json);
+    free(parser.content);   // 成功时已交给response，这里为NULL
     
     return err;
 }
 
+typedef struct {
+    const char *user_message;
+    ai_chat_response_t *response;
+    net_cancel_t *cancel;
+} glm_request_args_t;
+
+// 一次对话请求，主请求在工作任务中执行，对冲请求在对冲任务中执行
+static esp_err_t run_chat_attempt(void *arg, net_cancel_t *cancel)
+{
+    glm_slot_t *slot = arg;
+    // 构建请求用到的cJSON分配在请求结束时一次性释放
+    json_arena_begin(slot->arena);
+    esp_err_t err = send_message(slot, cancel);
+    json_arena_end(slot->arena);
+    return err;
+}
+
+// 落后但已成功的一方释放自己的回复
+static void discard_chat_response(void *arg)
+{
+    glm_slot_t *slot = arg;
+    ai_chat_free_response(&slot->response);
+}
+
+static esp_err_t run_chat_request(void *arg)
+{
+    const glm_request_args_t *args = arg;
+    if (args->user_message == NULL || args->response == NULL) {
+        ESP_LOGE(TAG, "参数不能为空");
+        return ESP_ERR_INVALID_ARG;
+    }
+    glm_primary.user_message = args->user_message;
+    glm_hedge_slot.user_message = args->user_message;
+    
+    // 慢于p90时在另一条连接上对冲，取先成功的回复
+    int winner = 0;
+    esp_err_t err = net_hedge_call(&glm_hedge, args->cancel, &winner);
+    glm_slot_t *slot = winner ? &glm_hedge_slot : &glm_primary;
+    *args->response = slot->response;   // 回复缓冲区的所有权交给调用者
+    memset(&slot->response, 0, sizeof(slot->response));
+    return err;
+}
+
+esp_err_t ai_chat_send_message(const char *user_message, ai_chat_response_t *response, net_cancel_t *cancel)
+{
+    glm_request_args_t args = {
+        .user_message = user_message,
+        .response = response,
+        .cancel = cancel,
+    };
+    // 从语音识别请求内调用时已在网络服务的工作任务中，直接执行
+    net_request_t request = {
+        .host = GLM_API_HOST,
+        .priority = NET_PRIORITY_VOICE,
+        .run = run_chat_request,
+        .arg = &args,
+        .max_attempts = 2,
+        .backoff_ms = 300,
+        .cancel = cancel,
+    };
+    esp_err_t err = net_service_call(&request);
+    if (err == ESP_ERR_INVALID_STATE && net_cancel_is_cancelled(cancel)) {
+        response->success = false;
+        snprintf(response->error_msg, sizeof(response->error_msg), "请求已取消");
+    }
+    return err;
+}
+
 void ai_chat_free_response(ai_chat_response_t *response)
 {
     if (response && response->content) {
@@ -356,4 +469,39 @@ void ai_chat_free_response(ai_chat_response_t *response)
 void ai_chat_cleanup(void)
 {
     ESP_LOGI(TAG, "清理AI对话模块");
-} 
\ No newline at end of file
+    tls_session_reset(&glm_session);
+    tls_session_reset(&glm_hedge_session);
+}
+
+esp_err_t ai_chat_prewarm(void)
+{
+    esp_http_client_config_t config;
+    glm_client_config(&config, NULL);
+    return tls_session_prewarm(&glm_session, &config);
+}
+
+void ai_chat_close_idle(void)
+{
+    tls_session_close_idle(&glm_session);
+    tls_session_close_idle(&glm_hedge_session);
+}
+
+void ai_chat_get_tls_stats(tls_session_stats_t *stats)
+{
+    tls_session_get_stats(&glm_session, stats);
+} 
+
+void ai_chat_get_json_arena_stats(json_arena_stats_t *stats)
+{
+    json_arena_get_stats(&glm_arena, stats);
+}
+
+void ai_chat_get_hedge_stats(net_hedge_stats_t *stats)
+{
+    net_hedge_get_stats(&glm_hedge, stats);
+}
+
+void ai_chat_get_decode_stats(http_decode_stats_t *stats)
+{
+    http_decode_get_stats(&glm_decode, stats);
+}
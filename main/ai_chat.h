@@ -10,12 +10,19 @@ extern "C" {
 #include "esp_http_client.h"
 #include "cJSON.h"
 #include "secrets.h"
+#include "tls_session.h"
+#include "json_arena.h"
+#include "net_service.h"
+#include "net_hedge.h"
+#include "http_decode.h"
 
 // GLM-4-Flash API配置
 #define GLM_API_URL "https://open.bigmodel.cn/api/paas/v4/chat/completions"
+#define GLM_API_HOST "open.bigmodel.cn"
 #define GLM_MODEL_NAME "glm-4-flash"
-#define GLM_MAX_RESPONSE_SIZE 4096
+#define GLM_MAX_RESPONSE_SIZE 4096     // AI回复内容的最大长度（含结尾0）
 #define GLM_REQUEST_TIMEOUT_MS 30000
+#define GLM_HEDGE_PERCENTILE 90         // 超过该分位耗时未返回时在新连接上重发，0关闭对冲
 
 // API Key配置 - 现在从 secrets.h 文件中读取
 
@@ -39,9 +46,10 @@ esp_err_t ai_chat_init(void);
  * @brief 发送用户消息给GLM-4-Flash并获取回复
  * @param user_message 用户输入的消息
  * @param response 输出参数，存储AI的回复
+ * @param cancel 取消令牌，可为NULL；取消后尽快断开连接并返回ESP_ERR_INVALID_STATE
  * @return ESP_OK 成功，其他值表示失败
  */
-esp_err_t ai_chat_send_message(const char *user_message, ai_chat_response_t *response);
+esp_err_t ai_chat_send_message(const char *user_message, ai_chat_response_t *response, net_cancel_t *cancel);
 
 /**
  * @brief 释放AI对话响应资源
@@ -54,6 +62,36 @@ void ai_chat_free_response(ai_chat_response_t *response);
  */
 void ai_chat_cleanup(void);
 
+/**
+ * @brief 提前建立到GLM服务器的连接并保持（阻塞到握手完成）
+ */
+esp_err_t ai_chat_prewarm(void);
+
+/**
+ * @brief 关闭保持的空闲连接（TLS会话票据保留）
+ */
+void ai_chat_close_idle(void);
+
+/**
+ * @brief 获取GLM连接的TLS握手统计
+ */
+void ai_chat_get_tls_stats(tls_session_stats_t *stats);
+
+/**
+ * @brief 获取构建请求JSON所用cJSON分配池的统计
+ */
+void ai_chat_get_json_arena_stats(json_arena_stats_t *stats);
+
+/**
+ * @brief 获取GLM请求的耗时分布与对冲统计
+ */
+void ai_chat_get_hedge_stats(net_hedge_stats_t *stats);
+
+/**
+ * @brief 获取GLM响应的传输统计（线上字节与解压后字节）
+ */
+void ai_chat_get_decode_stats(http_decode_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
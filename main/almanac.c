@@ -0,0 +1,107 @@
+#include "almanac.h"
+#include "civil_time.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+#include <stddef.h>
+
+static const char *TAG = "ALMANAC";
+
+static const uint8_t *almanac_base = NULL;     // 映射后的分区起始地址
+static const almanac_header_t *almanac_hdr = NULL;
+static esp_partition_mmap_handle_t almanac_mmap_handle;
+
+/* 校验头部中的偏移和长度都落在分区内 */
+static bool almanac_header_valid(const almanac_header_t *hdr, size_t size)
+{
+    if (hdr->magic != ALMANAC_MAGIC || hdr->version != ALMANAC_VERSION ||
+        hdr->record_size != sizeof(almanac_record_t) || hdr->string_size == 0) {
+        return false;
+    }
+    uint64_t records_end = (uint64_t)hdr->record_offset + (uint64_t)hdr->day_count * hdr->record_size;
+    uint64_t strings_end = (uint64_t)hdr->string_offset + (uint64_t)hdr->string_count * hdr->string_size;
+    return hdr->record_offset >= sizeof(almanac_header_t) && records_end <= size &&
+           hdr->string_offset >= sizeof(almanac_header_t) && strings_end <= size;
+}
+
+esp_err_t almanac_init(void)
+{
+    if (almanac_hdr) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ALMANAC_PARTITION_SUBTYPE,
+                                                           ALMANAC_PARTITION_LABEL);
+    if (!part) {
+        ESP_LOGW(TAG, "Almanac partition not found");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void *ptr = NULL;
+    esp_err_t ret = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &almanac_mmap_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map almanac partition: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    const almanac_header_t *hdr = (const almanac_header_t *)ptr;
+    if (!almanac_header_valid(hdr, part->size)) {
+        ESP_LOGW(TAG, "Almanac partition is empty or has an unknown format");
+        esp_partition_munmap(almanac_mmap_handle);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    /* CRC覆盖头部之后到数据末尾 */
+    uint32_t data_end = hdr->string_offset + (uint32_t)hdr->string_count * hdr->string_size;
+    uint32_t records_end = hdr->record_offset + hdr->day_count * hdr->record_size;
+    if (records_end > data_end) {
+        data_end = records_end;
+    }
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)ptr + sizeof(almanac_header_t),
+                                    data_end - sizeof(almanac_header_t));
+    if (crc != hdr->crc32) {
+        ESP_LOGE(TAG, "Almanac checksum mismatch (0x%08lx != 0x%08lx)",
+                 (unsigned long)crc, (unsigned long)hdr->crc32);
+        esp_partition_munmap(almanac_mmap_handle);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    almanac_base = (const uint8_t *)ptr;
+    almanac_hdr = hdr;
+    ESP_LOGI(TAG, "Almanac mapped: %lu days from day %ld",
+             (unsigned long)hdr->day_count, (long)hdr->first_day);
+    return ESP_OK;
+}
+
+bool almanac_available(void)
+{
+    return almanac_hdr != NULL;
+}
+
+esp_err_t almanac_lookup(int year, int month, int day, almanac_day_t *result)
+{
+    if (!almanac_hdr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!result || !civil_date_is_valid(year, month, day)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t index = civil_days_from_date(year, month, day) - almanac_hdr->first_day;
+    if (index < 0 || index >= (int64_t)almanac_hdr->day_count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const almanac_record_t *rec = (const almanac_record_t *)
+        (almanac_base + almanac_hdr->record_offset + (size_t)index * sizeof(almanac_record_t));
+    if (rec->text_index >= almanac_hdr->string_count) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    result->lunar_text = (const char *)(almanac_base + almanac_hdr->string_offset +
+                                        (size_t)rec->text_index * almanac_hdr->string_size);
+    result->solar_term = rec->solar_term;
+    result->festival = rec->festival;
+    return ESP_OK;
+}
@@ -0,0 +1,77 @@
+#ifndef ALMANAC_H
+#define ALMANAC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 预计算农历数据分区（由almanac_tool.py生成，烧录到"almanac"分区）
+ *
+ * 文件布局（小端）：
+ *   头部 almanac_header_t
+ *   每日记录 almanac_record_t，按公历日期连续排列，下标 = 日期天数 - first_day
+ *   字符串表 string_count个定长槽位，存放渲染好的农历月日文本
+ */
+
+#define ALMANAC_PARTITION_LABEL     "almanac"
+#define ALMANAC_PARTITION_SUBTYPE   0x40
+#define ALMANAC_MAGIC               0x4E4D4C41  // "ALMN"
+#define ALMANAC_VERSION             1
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;       // sizeof(almanac_record_t)
+    int32_t first_day;          // 第一条记录的日期（1970-01-01起的天数）
+    uint32_t day_count;
+    uint32_t string_offset;
+    uint16_t string_count;
+    uint16_t string_size;       // 每个字符串槽位的字节数（含结尾'\0'）
+    uint32_t record_offset;
+    uint32_t crc32;             // 头部之后全部数据的CRC32
+} almanac_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t text_index;        // 字符串表下标
+    int8_t solar_term;          // 节气 0-23，无则为-1
+    uint8_t festival;           // lunar_festival_t
+} almanac_record_t;
+
+/**
+ * @brief 查询结果，文本指向映射的flash，无需释放
+ */
+typedef struct {
+    const char *lunar_text;     // 如"五月 二十"
+    int8_t solar_term;
+    uint8_t festival;
+} almanac_day_t;
+
+/**
+ * @brief 映射农历数据分区并校验头部与CRC
+ *
+ * @return esp_err_t 分区不存在返回ESP_ERR_NOT_FOUND，校验失败返回ESP_ERR_INVALID_CRC等
+ */
+esp_err_t almanac_init(void);
+
+/**
+ * @brief 数据分区是否可用
+ */
+bool almanac_available(void);
+
+/**
+ * @brief 按公历日期查询（O(1)，不分配内存，不访问网络）
+ *
+ * @return esp_err_t 分区不可用返回ESP_ERR_INVALID_STATE，日期超出范围返回ESP_ERR_NOT_FOUND
+ */
+esp_err_t almanac_lookup(int year, int month, int day, almanac_day_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ALMANAC_H
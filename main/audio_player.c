@@ -589,26 +589,16 @@ void audio_free_wav_file(wav_file_t* wav_file) {
 }
 
 /**
- * @brief 播放WAV文件
+ * @brief 预加载WAV文件并应用音量，供需要立即出声的场景使用
  */
-esp_err_t audio_play_wav_file(const char* filename, uint8_t volume) {
-    if (!audio_initialized) {
-        ESP_LOGE(TAG, "Audio player not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    wav_file_t wav_file = {0};
-    esp_err_t ret = audio_load_wav_file(filename, &wav_file);
+esp_err_t audio_prepare_wav_file(const char* filename, uint8_t volume, wav_file_t* wav_file) {
+    esp_err_t ret = audio_load_wav_file(filename, wav_file);
     if (ret != ESP_OK) {
         return ret;
     }
 
-    current_audio_state = AUDIO_STATE_PLAYING;
-
-    // 播放WAV数据
-    size_t bytes_written = 0;
-    int16_t* samples = (int16_t*)wav_file.data;
-    size_t sample_count = wav_file.data_size / sizeof(int16_t);
+    int16_t* samples = (int16_t*)wav_file->data;
+    size_t sample_count = wav_file->data_size / sizeof(int16_t);
     
     // 音量调节
     float volume_factor = volume / 100.0f;
@@ -617,14 +607,54 @@ esp_err_t audio_play_wav_file(const char* filename, uint8_t volume) {
         samples[i] = (int16_t)(samples[i] * volume_factor);
     }
 
-    ret = i2s_channel_write(tx_handle, wav_file.data, wav_file.data_size, &bytes_written, portMAX_DELAY);
+    return ESP_OK;
+}
+
+/**
+ * @brief 播放已预加载的WAV数据
+ */
+esp_err_t audio_play_prepared_wav(const wav_file_t* wav_file) {
+    if (!audio_initialized) {
+        ESP_LOGE(TAG, "Audio player not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!wav_file || !wav_file->data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    current_audio_state = AUDIO_STATE_PLAYING;
+
+    size_t bytes_written = 0;
+    esp_err_t ret = i2s_channel_write(tx_handle, wav_file->data, wav_file->data_size, &bytes_written, portMAX_DELAY);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to write WAV data to I2S");
         current_audio_state = AUDIO_STATE_ERROR;
     } else {
-        ESP_LOGI(TAG, "WAV file played successfully: %s", filename);
         current_audio_state = AUDIO_STATE_IDLE;
     }
+    return ret;
+}
+
+/**
+ * @brief 播放WAV文件
+ */
+esp_err_t audio_play_wav_file(const char* filename, uint8_t volume) {
+    if (!audio_initialized) {
+        ESP_LOGE(TAG, "Audio player not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    wav_file_t wav_file = {0};
+    esp_err_t ret = audio_prepare_wav_file(filename, volume, &wav_file);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // 播放WAV数据
+    ret = audio_play_prepared_wav(&wav_file);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "WAV file played successfully: %s", filename);
+    }
 
     audio_free_wav_file(&wav_file);
     return ret;
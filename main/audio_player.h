@@ -164,6 +164,22 @@ esp_err_t audio_load_wav_file(const char* filename, wav_file_t* wav_file);
  */
 void audio_free_wav_file(wav_file_t* wav_file);
 
+/**
+ * @brief 预加载WAV文件并按音量缩放，之后可用 audio_play_prepared_wav 立即播放
+ * @param filename 文件名
+ * @param volume 音量 (0-100)
+ * @param wav_file WAV文件信息结构体（输出），用完需 audio_free_wav_file 释放
+ * @return ESP_OK 成功，其他值失败
+ */
+esp_err_t audio_prepare_wav_file(const char* filename, uint8_t volume, wav_file_t* wav_file);
+
+/**
+ * @brief 播放已预加载的WAV数据（不释放内存）
+ * @param wav_file 由 audio_prepare_wav_file 加载的WAV文件
+ * @return ESP_OK 成功，其他值失败
+ */
+esp_err_t audio_play_prepared_wav(const wav_file_t* wav_file);
+
 /**
  * @brief 播放WAV文件
  * @param filename 文件名
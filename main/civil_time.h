@@ -0,0 +1,153 @@
+#ifndef CIVIL_TIME_H
+#define CIVIL_TIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 公历日期计算（仅头文件，无内存分配，不依赖newlib的TZ/mktime/gmtime）
+ *
+ * 日期与1970-01-01起的天数互换采用按400年周期计算的days-from-civil算法，
+ * 以3月为一年的起点，闰日落在年末，无需月份表和循环。
+ * 时区一律以显式的UTC偏移（秒）传入。
+ */
+
+#define CIVIL_SECONDS_PER_DAY   86400
+
+/**
+ * @brief 日期时间（不含时区）
+ */
+typedef struct {
+    int year;
+    uint8_t month;          // 1-12
+    uint8_t day;            // 1-31
+    uint8_t hour;           // 0-23
+    uint8_t minute;         // 0-59
+    uint8_t second;         // 0-59
+    uint8_t day_of_week;    // 1=周一 ... 7=周日
+} civil_time_t;
+
+/* 向下取整除法（负数也按数轴向下） */
+static inline int64_t civil_floor_div(int64_t a, int64_t b)
+{
+    return (a - ((a % b + b) % b)) / b;
+}
+
+static inline bool civil_is_leap(int year)
+{
+    return (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0);
+}
+
+static inline int civil_days_in_month(int year, int month)
+{
+    /* 2月以外：31,30交替，7月后错开一位 */
+    if (month == 2) {
+        return 28 + civil_is_leap(year);
+    }
+    return 30 + ((month + (month >> 3)) & 1);
+}
+
+/**
+ * @brief 公历日期转为1970-01-01起的天数
+ */
+static inline int64_t civil_days_from_date(int year, int month, int day)
+{
+    const int64_t y = (int64_t)year - (month <= 2);
+    const int64_t era = civil_floor_div(y, 400);
+    const int64_t yoe = y - era * 400;                                          // [0, 399]
+    const int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1; // [0, 365]
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                  // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * @brief 1970-01-01起的天数转为公历日期
+ */
+static inline void civil_date_from_days(int64_t days, int *year, int *month, int *day)
+{
+    const int64_t z = days + 719468;
+    const int64_t era = civil_floor_div(z, 146097);
+    const int64_t doe = z - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    const int m = (int)(mp < 10 ? mp + 3 : mp - 9);
+
+    *day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *month = m;
+    *year = (int)(yoe + era * 400) + (m <= 2);
+}
+
+/**
+ * @brief 天数对应的星期（1=周一 ... 7=周日，与DS3231一致）
+ */
+static inline int civil_weekday(int64_t days)
+{
+    /* 1970-01-01为周四 */
+    return (int)((days + 3 - civil_floor_div(days + 3, 7) * 7) + 1);
+}
+
+/**
+ * @brief 一年中的第几天（1月1日为1）
+ */
+static inline int civil_day_of_year(int year, int month, int day)
+{
+    return (int)(civil_days_from_date(year, month, day) - civil_days_from_date(year, 1, 1)) + 1;
+}
+
+/**
+ * @brief 日期加减天数
+ */
+static inline void civil_add_days(int *year, int *month, int *day, int64_t delta)
+{
+    civil_date_from_days(civil_days_from_date(*year, *month, *day) + delta, year, month, day);
+}
+
+/**
+ * @brief 日期是否存在（月份、当月天数）
+ */
+static inline bool civil_date_is_valid(int year, int month, int day)
+{
+    return month >= 1 && month <= 12 && day >= 1 && day <= civil_days_in_month(year, month);
+}
+
+/**
+ * @brief 本地日期时间转为Unix时间戳
+ *
+ * @param utc_offset_s 该本地时间相对UTC的偏移（北京时间为 8*3600）
+ */
+static inline int64_t civil_to_epoch(const civil_time_t *t, int32_t utc_offset_s)
+{
+    return civil_days_from_date(t->year, t->month, t->day) * CIVIL_SECONDS_PER_DAY +
+           t->hour * 3600 + t->minute * 60 + t->second - utc_offset_s;
+}
+
+/**
+ * @brief Unix时间戳转为指定偏移下的本地日期时间
+ */
+static inline void civil_from_epoch(int64_t epoch_s, int32_t utc_offset_s, civil_time_t *t)
+{
+    const int64_t local_s = epoch_s + utc_offset_s;
+    const int64_t days = civil_floor_div(local_s, CIVIL_SECONDS_PER_DAY);
+    const int64_t rem = local_s - days * CIVIL_SECONDS_PER_DAY;
+    int y, m, d;
+
+    civil_date_from_days(days, &y, &m, &d);
+    t->year = y;
+    t->month = (uint8_t)m;
+    t->day = (uint8_t)d;
+    t->hour = (uint8_t)(rem / 3600);
+    t->minute = (uint8_t)(rem % 3600 / 60);
+    t->second = (uint8_t)(rem % 60);
+    t->day_of_week = (uint8_t)civil_weekday(days);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CIVIL_TIME_H
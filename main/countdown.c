@@ -0,0 +1,280 @@
+#include "countdown.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "COUNTDOWN";
+
+#define US_PER_SECOND  1000000LL
+
+typedef enum {
+    COUNTDOWN_IDLE,
+    COUNTDOWN_RUNNING,
+    COUNTDOWN_PAUSED
+} countdown_state_t;
+
+typedef struct {
+    bool used;
+    countdown_state_t state;
+    esp_timer_handle_t timer;
+    int64_t deadline_us;        // 运行时：到期的绝对时间（esp_timer时基）
+    int64_t remaining_us;       // 暂停时：剩余时间
+    uint32_t reported_s;        // 上次回调报告的剩余秒数
+    countdown_cb_t cb;
+    void *arg;
+} countdown_t;
+
+static countdown_t countdowns[COUNTDOWN_MAX_TIMERS];
+static SemaphoreHandle_t countdown_mutex = NULL;
+
+/* 剩余秒数向上取整：剩余 (k-1, k] 秒时显示 k */
+static uint32_t us_to_seconds(int64_t us)
+{
+    if (us <= 0) {
+        return 0;
+    }
+    return (uint32_t)((us + US_PER_SECOND - 1) / US_PER_SECOND);
+}
+
+static countdown_t *countdown_get(int id)
+{
+    if (id < 0 || id >= COUNTDOWN_MAX_TIMERS || !countdowns[id].used) {
+        return NULL;
+    }
+    return &countdowns[id];
+}
+
+/* 将esp_timer安排到下一个秒边沿（剩余时间降到整秒处）或到期时刻 */
+static void countdown_schedule(countdown_t *cd, int64_t now)
+{
+    int64_t remaining = cd->deadline_us - now;
+    int64_t delay = 0;
+    if (remaining > 0) {
+        delay = remaining - (int64_t)(us_to_seconds(remaining) - 1) * US_PER_SECOND;
+    }
+    esp_timer_stop(cd->timer);
+    esp_timer_start_once(cd->timer, delay);
+}
+
+static void countdown_timer_callback(void *arg)
+{
+    countdown_t *cd = (countdown_t *)arg;
+    int id = cd - countdowns;
+
+    xSemaphoreTake(countdown_mutex, portMAX_DELAY);
+    if (cd->state != COUNTDOWN_RUNNING) {
+        xSemaphoreGive(countdown_mutex);
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    uint32_t remaining_s = us_to_seconds(cd->deadline_us - now);
+    countdown_event_t event = COUNTDOWN_EVENT_TICK;
+    bool notify = true;
+
+    if (remaining_s == 0) {
+        cd->state = COUNTDOWN_IDLE;
+        cd->remaining_us = 0;
+        event = COUNTDOWN_EVENT_EXPIRED;
+    } else {
+        notify = (remaining_s != cd->reported_s);
+        countdown_schedule(cd, now);
+    }
+    cd->reported_s = remaining_s;
+
+    countdown_cb_t cb = cd->cb;
+    void *cb_arg = cd->arg;
+    xSemaphoreGive(countdown_mutex);
+
+    if (notify && cb) {
+        cb(id, event, remaining_s, cb_arg);
+    }
+}
+
+int countdown_create(countdown_cb_t cb, void *arg)
+{
+    if (countdown_mutex == NULL) {
+        countdown_mutex = xSemaphoreCreateMutex();
+        if (countdown_mutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create mutex");
+            return -1;
+        }
+    }
+
+    xSemaphoreTake(countdown_mutex, portMAX_DELAY);
+    int id = -1;
+    for (int i = 0; i < COUNTDOWN_MAX_TIMERS; i++) {
+        if (!countdowns[i].used) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0) {
+        xSemaphoreGive(countdown_mutex);
+        ESP_LOGE(TAG, "No free countdown slot");
+        return -1;
+    }
+
+    countdown_t *cd = &countdowns[id];
+    memset(cd, 0, sizeof(*cd));
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = countdown_timer_callback,
+        .arg = cd,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "countdown",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &cd->timer);
+    if (ret != ESP_OK) {
+        xSemaphoreGive(countdown_mutex);
+        ESP_LOGE(TAG, "Failed to create esp_timer: %s", esp_err_to_name(ret));
+        return -1;
+    }
+
+    cd->used = true;
+    cd->state = COUNTDOWN_IDLE;
+    cd->cb = cb;
+    cd->arg = arg;
+    xSemaphoreGive(countdown_mutex);
+    return id;
+}
+
+esp_err_t countdown_start(int id, uint64_t duration_us)
+{
+    countdown_t *cd = countdown_get(id);
+    if (!cd || duration_us == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(countdown_mutex, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    cd->deadline_us = now + (int64_t)duration_us;
+    cd->remaining_us = (int64_t)duration_us;
+    cd->reported_s = us_to_seconds((int64_t)duration_us);
+    cd->state = COUNTDOWN_RUNNING;
+    countdown_schedule(cd, now);
+    xSemaphoreGive(countdown_mutex);
+
+    ESP_LOGI(TAG, "Countdown %d started: %llu us", id, (unsigned long long)duration_us);
+    return ESP_OK;
+}
+
+esp_err_t countdown_stop(int id)
+{
+    countdown_t *cd = countdown_get(id);
+    if (!cd) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(countdown_mutex, portMAX_DELAY);
+    esp_timer_stop(cd->timer);
+    cd->state = COUNTDOWN_IDLE;
+    cd->remaining_us = 0;
+    cd->reported_s = 0;
+    xSemaphoreGive(countdown_mutex);
+    return ESP_OK;
+}
+
+esp_err_t countdown_pause(int id)
+{
+    countdown_t *cd = countdown_get(id);
+    if (!cd) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(countdown_mutex, portMAX_DELAY);
+    if (cd->state != COUNTDOWN_RUNNING) {
+        xSemaphoreGive(countdown_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_timer_stop(cd->timer);
+    cd->remaining_us = cd->deadline_us - esp_timer_get_time();
+    if (cd->remaining_us < 0) {
+        cd->remaining_us = 0;
+    }
+    cd->state = COUNTDOWN_PAUSED;
+    xSemaphoreGive(countdown_mutex);
+    return ESP_OK;
+}
+
+esp_err_t countdown_resume(int id)
+{
+    countdown_t *cd = countdown_get(id);
+    if (!cd) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(countdown_mutex, portMAX_DELAY);
+    if (cd->state != COUNTDOWN_PAUSED) {
+        xSemaphoreGive(countdown_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t now = esp_timer_get_time();
+    cd->deadline_us = now + cd->remaining_us;
+    cd->state = COUNTDOWN_RUNNING;
+    countdown_schedule(cd, now);
+    xSemaphoreGive(countdown_mutex);
+    return ESP_OK;
+}
+
+esp_err_t countdown_extend(int id, int64_t delta_us)
+{
+    countdown_t *cd = countdown_get(id);
+    if (!cd) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(countdown_mutex, portMAX_DELAY);
+    esp_err_t ret = ESP_OK;
+    if (cd->state == COUNTDOWN_RUNNING) {
+        /* 缩短到已过期时立即触发到期回调 */
+        cd->deadline_us += delta_us;
+        countdown_schedule(cd, esp_timer_get_time());
+    } else if (cd->state == COUNTDOWN_PAUSED) {
+        cd->remaining_us += delta_us;
+        if (cd->remaining_us < 0) {
+            cd->remaining_us = 0;
+        }
+    } else {
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreGive(countdown_mutex);
+    return ret;
+}
+
+int64_t countdown_remaining_us(int id)
+{
+    countdown_t *cd = countdown_get(id);
+    if (!cd) {
+        return 0;
+    }
+
+    xSemaphoreTake(countdown_mutex, portMAX_DELAY);
+    int64_t remaining = 0;
+    if (cd->state == COUNTDOWN_RUNNING) {
+        remaining = cd->deadline_us - esp_timer_get_time();
+    } else if (cd->state == COUNTDOWN_PAUSED) {
+        remaining = cd->remaining_us;
+    }
+    xSemaphoreGive(countdown_mutex);
+    return remaining > 0 ? remaining : 0;
+}
+
+uint32_t countdown_remaining_s(int id)
+{
+    return us_to_seconds(countdown_remaining_us(id));
+}
+
+bool countdown_is_running(int id)
+{
+    countdown_t *cd = countdown_get(id);
+    return cd && cd->state == COUNTDOWN_RUNNING;
+}
+
+bool countdown_is_paused(int id)
+{
+    countdown_t *cd = countdown_get(id);
+    return cd && cd->state == COUNTDOWN_PAUSED;
+}
@@ -0,0 +1,83 @@
+#ifndef COUNTDOWN_H
+#define COUNTDOWN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COUNTDOWN_MAX_TIMERS  4
+
+/**
+ * @brief 倒计时事件类型
+ */
+typedef enum {
+    COUNTDOWN_EVENT_TICK,       // 剩余整秒数变化（秒边沿）
+    COUNTDOWN_EVENT_EXPIRED     // 倒计时结束
+} countdown_event_t;
+
+/**
+ * @brief 倒计时回调，在esp_timer任务中执行，应尽快返回
+ *
+ * @param id 倒计时编号
+ * @param event 事件类型
+ * @param remaining_s 剩余秒数（向上取整，结束时为0）
+ * @param arg 用户参数
+ */
+typedef void (*countdown_cb_t)(int id, countdown_event_t event, uint32_t remaining_s, void *arg);
+
+/**
+ * @brief 创建一个倒计时
+ *
+ * @param cb 事件回调
+ * @param arg 回调用户参数
+ * @return int 倒计时编号，失败返回-1
+ */
+int countdown_create(countdown_cb_t cb, void *arg);
+
+/**
+ * @brief 以给定时长（微秒）开始倒计时，正在运行的倒计时会被重新开始
+ */
+esp_err_t countdown_start(int id, uint64_t duration_us);
+
+/**
+ * @brief 停止倒计时，剩余时间清零，不触发回调
+ */
+esp_err_t countdown_stop(int id);
+
+/**
+ * @brief 暂停倒计时，保留剩余时间
+ */
+esp_err_t countdown_pause(int id);
+
+/**
+ * @brief 从暂停处继续倒计时
+ */
+esp_err_t countdown_resume(int id);
+
+/**
+ * @brief 延长（正值）或缩短（负值）倒计时，运行和暂停状态均可
+ */
+esp_err_t countdown_extend(int id, int64_t delta_us);
+
+/**
+ * @brief 获取剩余时间（微秒）
+ */
+int64_t countdown_remaining_us(int id);
+
+/**
+ * @brief 获取剩余秒数（向上取整，与显示一致）
+ */
+uint32_t countdown_remaining_s(int id);
+
+bool countdown_is_running(int id);
+bool countdown_is_paused(int id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COUNTDOWN_H */
@@ -1,13 +1,19 @@
 #include "ds3231.h"
-#include "driver/i2c.h"
+#include "i2c_bus.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include "esp_timer.h"
 #include "esp_log.h"
 
 static const char *TAG = "DS3231";
 
 #define DS3231_I2C_ADDR     0x68
-#define DS3231_I2C_PORT     I2C_NUM_0
-#define DS3231_SDA_PIN      9
-#define DS3231_SCL_PIN      8
+#define DS3231_I2C_SPEED_HZ 400000
+#define DS3231_I2C_TIMEOUT_MS 50
 
 /* DS3231寄存器地址 */
 #define DS3231_REG_SECONDS  0x00
@@ -17,6 +23,48 @@ static const char *TAG = "DS3231";
 #define DS3231_REG_DATE     0x04
 #define DS3231_REG_MONTH    0x05
 #define DS3231_REG_YEAR     0x06
+#define DS3231_REG_ALARM1   0x07
+#define DS3231_REG_ALARM2   0x0B
+#define DS3231_REG_CONTROL  0x0E
+#define DS3231_REG_STATUS   0x0F
+#define DS3231_REG_AGING    0x10
+#define DS3231_REG_TEMP_MSB 0x11
+
+/* 控制寄存器位 */
+#define DS3231_CTRL_A1IE    0x01
+#define DS3231_CTRL_A2IE    0x02
+#define DS3231_CTRL_INTCN   0x04
+#define DS3231_CTRL_CONV    0x20
+
+/* 闹钟屏蔽位（写在各闹钟寄存器的bit7），置位表示该字段不参与匹配 */
+#define DS3231_ALARM_MASK   0x80
+
+/* 异步读取请求 */
+typedef struct {
+    ds3231_regs_cb_t callback;
+    void *arg;
+} ds3231_async_req_t;
+
+#define DS3231_ASYNC_QUEUE_LEN  4
+
+static i2c_master_dev_handle_t dev_handle = NULL;
+static SemaphoreHandle_t tx_mutex = NULL;
+static SemaphoreHandle_t ctrl_mutex = NULL;     // 控制寄存器读-改-写期间持有（tx_mutex只覆盖单次传输）
+static uint8_t tx_buf[1 + DS3231_REG_COUNT];   // 预分配的写缓冲：寄存器地址 + 数据
+static QueueHandle_t async_queue = NULL;
+
+/* 闹钟任务的通知位 */
+#define ALARM_NOTIFY_EDGE       0x01    // INT引脚下降沿
+#define ALARM_NOTIFY_RECHECK    0x02    // 中断使能变化，重新计算看门狗超时
+
+static ds3231_alarm_cb_t alarm1_callback = NULL;
+static ds3231_alarm_cb_t alarm2_callback = NULL;
+static ds3231_int_lost_cb_t int_lost_callback = NULL;
+static TaskHandle_t alarm_task_handle = NULL;
+static volatile int64_t alarm_int_time_us = 0;
+static volatile bool alarm_int_ready = false;
+static volatile uint8_t alarm_int_enabled = 0;      // 已使能中断的闹钟（DS3231_ALARM1/2）
+static volatile bool alarm1_every_second = false;   // 闹钟1处于每秒模式，INT应每秒拉低一次
 
 /* BCD转换函数 */
 static uint8_t bcd_to_dec(uint8_t bcd)
@@ -29,73 +77,150 @@ static uint8_t dec_to_bcd(uint8_t dec)
     return ((dec / 10) << 4) | (dec % 10);
 }
 
-static esp_err_t ds3231_write_reg(uint8_t reg, uint8_t data)
+static esp_err_t ds3231_write_regs(uint8_t reg, const uint8_t *data, size_t len)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_write_byte(cmd, data, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(DS3231_I2C_PORT, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
+    if (!dev_handle || len > DS3231_REG_COUNT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(tx_mutex, portMAX_DELAY);
+    tx_buf[0] = reg;
+    memcpy(&tx_buf[1], data, len);
+    esp_err_t ret = i2c_master_transmit(dev_handle, tx_buf, len + 1, DS3231_I2C_TIMEOUT_MS);
+    xSemaphoreGive(tx_mutex);
     return ret;
 }
 
-static esp_err_t ds3231_read_reg(uint8_t reg, uint8_t *data)
+static esp_err_t ds3231_write_reg(uint8_t reg, uint8_t data)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_READ, true);
-    i2c_master_read_byte(cmd, data, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(DS3231_I2C_PORT, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
-    return ret;
+    return ds3231_write_regs(reg, &data, 1);
 }
 
 static esp_err_t ds3231_read_regs(uint8_t reg, uint8_t *data, size_t len)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, reg, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_READ, true);
-    i2c_master_read(cmd, data, len, I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(DS3231_I2C_PORT, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
+    if (!dev_handle) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return i2c_master_transmit_receive(dev_handle, &reg, 1, data, len, DS3231_I2C_TIMEOUT_MS);
+}
+
+static esp_err_t ds3231_read_reg(uint8_t reg, uint8_t *data)
+{
+    return ds3231_read_regs(reg, data, 1);
+}
+
+/*
+ * 控制寄存器读-改-写：先清除clear再置位set。时间服务（闹钟1秒中断）和闹钟设置（闹钟2）
+ * 在不同任务中修改同一寄存器，整个过程持锁，避免一方写回时丢掉另一方的使能位
+ */
+static esp_err_t ds3231_update_control(uint8_t clear, uint8_t set)
+{
+    if (!ctrl_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(ctrl_mutex, portMAX_DELAY);
+    uint8_t ctrl;
+    esp_err_t ret = ds3231_read_reg(DS3231_REG_CONTROL, &ctrl);
+    if (ret == ESP_OK) {
+        ctrl = (ctrl & ~clear) | set;
+        ret = ds3231_write_reg(DS3231_REG_CONTROL, ctrl);
+    }
+    if (ret == ESP_OK) {
+        alarm_int_enabled = ctrl & (DS3231_ALARM1 | DS3231_ALARM2);    // A1IE/A2IE与闹钟位相同
+    }
+    xSemaphoreGive(ctrl_mutex);
     return ret;
 }
 
+static void ds3231_parse_time(const uint8_t *data, ds3231_time_t *time)
+{
+    time->second = bcd_to_dec(data[0] & 0x7F);
+    time->minute = bcd_to_dec(data[1] & 0x7F);
+    time->hour = bcd_to_dec(data[2] & 0x3F);
+    time->day_of_week = bcd_to_dec(data[3] & 0x07);
+    time->date = bcd_to_dec(data[4] & 0x3F);
+    time->month = bcd_to_dec(data[5] & 0x1F);
+    time->year = 2000 + bcd_to_dec(data[6]);
+}
+
+/* 异步读取工作任务：按请求顺序整块读取寄存器后回调 */
+static void ds3231_async_task(void *arg)
+{
+    ds3231_async_req_t req;
+    ds3231_regs_t regs;
+
+    while (1) {
+        if (xQueueReceive(async_queue, &req, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        esp_err_t ret = ds3231_read_all(&regs);
+        if (req.callback) {
+            req.callback(ret, &regs, req.arg);
+        }
+    }
+}
+
 esp_err_t ds3231_init(void)
 {
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = DS3231_SDA_PIN,
-        .scl_io_num = DS3231_SCL_PIN,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = 100000,
-    };
-    
-    esp_err_t ret = i2c_param_config(DS3231_I2C_PORT, &conf);
+    if (dev_handle) {
+        return ESP_OK;
+    }
+
+    tx_mutex = xSemaphoreCreateMutex();
+    ctrl_mutex = xSemaphoreCreateMutex();
+    async_queue = xQueueCreate(DS3231_ASYNC_QUEUE_LEN, sizeof(ds3231_async_req_t));
+    if (!tx_mutex || !ctrl_mutex || !async_queue) {
+        ESP_LOGE(TAG, "Failed to allocate driver resources");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = i2c_bus_add_device(DS3231_I2C_ADDR, DS3231_I2C_SPEED_HZ, &dev_handle);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "I2C config failed");
+        ESP_LOGE(TAG, "I2C device add failed");
         return ret;
     }
+
+    if (xTaskCreate(ds3231_async_task, "ds3231_async", 3072, NULL, 5, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create async task");
+        return ESP_ERR_NO_MEM;
+    }
     
-    ret = i2c_driver_install(DS3231_I2C_PORT, conf.mode, 0, 0, 0);
+    ESP_LOGI(TAG, "DS3231 initialized (%d kHz)", DS3231_I2C_SPEED_HZ / 1000);
+    return ESP_OK;
+}
+
+esp_err_t ds3231_read_all(ds3231_regs_t *regs)
+{
+    uint8_t data[DS3231_REG_COUNT];
+    esp_err_t ret = ds3231_read_regs(DS3231_REG_SECONDS, data, sizeof(data));
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "I2C driver install failed");
+        ESP_LOGE(TAG, "Failed to read registers");
         return ret;
     }
-    
-    ESP_LOGI(TAG, "DS3231 initialized");
+
+    ds3231_parse_time(data, &regs->time);
+    regs->control = data[DS3231_REG_CONTROL];
+    regs->status = data[DS3231_REG_STATUS];
+    regs->aging = (int8_t)data[DS3231_REG_AGING];
+    /* 温度为10位补码，低字节高两位为小数部分，单位0.25°C */
+    regs->temperature_q = (int16_t)((data[DS3231_REG_TEMP_MSB] << 8) | data[DS3231_REG_TEMP_MSB + 1]) >> 6;
+    return ESP_OK;
+}
+
+esp_err_t ds3231_read_all_async(ds3231_regs_cb_t callback, void *arg)
+{
+    if (!async_queue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ds3231_async_req_t req = {
+        .callback = callback,
+        .arg = arg,
+    };
+    if (xQueueSend(async_queue, &req, 0) != pdTRUE) {
+        return ESP_ERR_NO_MEM;
+    }
     return ESP_OK;
 }
 
@@ -108,14 +233,7 @@ esp_err_t ds3231_get_time(ds3231_time_t *time)
         return ret;
     }
     
-    time->second = bcd_to_dec(data[0] & 0x7F);
-    time->minute = bcd_to_dec(data[1] & 0x7F);
-    time->hour = bcd_to_dec(data[2] & 0x3F);
-    time->day_of_week = bcd_to_dec(data[3] & 0x07);
-    time->date = bcd_to_dec(data[4] & 0x3F);
-    time->month = bcd_to_dec(data[5] & 0x1F);
-    time->year = 2000 + bcd_to_dec(data[6]);
-    
+    ds3231_parse_time(data, time);
     return ESP_OK;
 }
 
@@ -131,18 +249,301 @@ esp_err_t ds3231_set_time(const ds3231_time_t *time)
     data[5] = dec_to_bcd(time->month);
     data[6] = dec_to_bcd(time->year - 2000);
     
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, DS3231_REG_SECONDS, true);
-    i2c_master_write(cmd, data, 7, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(DS3231_I2C_PORT, cmd, 1000 / portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
-    
+    esp_err_t ret = ds3231_write_regs(DS3231_REG_SECONDS, data, 7);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to set time");
     }
     
     return ret;
-} 
\ No newline at end of file
+}
+
+esp_err_t ds3231_get_aging_offset(int8_t *aging)
+{
+    uint8_t data;
+    esp_err_t ret = ds3231_read_reg(DS3231_REG_AGING, &data);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read aging offset");
+        return ret;
+    }
+
+    *aging = (int8_t)data;
+    return ESP_OK;
+}
+
+esp_err_t ds3231_set_aging_offset(int8_t aging)
+{
+    esp_err_t ret = ds3231_write_reg(DS3231_REG_AGING, (uint8_t)aging);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write aging offset");
+        return ret;
+    }
+
+    /* 老化偏移在下一次温度转换后才作用于振荡器，这里手动触发一次 */
+    ret = ds3231_update_control(0, DS3231_CTRL_CONV);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to start temperature conversion");
+    }
+    return ESP_OK;
+}
+
+esp_err_t ds3231_set_alarm1(uint8_t hour, uint8_t minute, uint8_t second)
+{
+    /* A1M1~A1M3清零、A1M4置位：时分秒匹配，每天触发 */
+    uint8_t data[4];
+    data[0] = dec_to_bcd(second);
+    data[1] = dec_to_bcd(minute);
+    data[2] = dec_to_bcd(hour);
+    data[3] = DS3231_ALARM_MASK;
+
+    esp_err_t ret = ds3231_write_regs(DS3231_REG_ALARM1, data, sizeof(data));
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set alarm1");
+    } else {
+        alarm1_every_second = false;
+    }
+    return ret;
+}
+
+esp_err_t ds3231_set_alarm1_every_second(void)
+{
+    /* A1M1~A1M4全部置位：每秒匹配 */
+    uint8_t data[4] = {DS3231_ALARM_MASK, DS3231_ALARM_MASK, DS3231_ALARM_MASK, DS3231_ALARM_MASK};
+
+    esp_err_t ret = ds3231_write_regs(DS3231_REG_ALARM1, data, sizeof(data));
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set alarm1 once-per-second mode");
+    } else {
+        alarm1_every_second = true;
+    }
+    return ret;
+}
+
+esp_err_t ds3231_set_alarm2(uint8_t hour, uint8_t minute)
+{
+    /* A2M2/A2M3清零、A2M4置位：时分匹配，每天触发 */
+    uint8_t data[3];
+    data[0] = dec_to_bcd(minute);
+    data[1] = dec_to_bcd(hour);
+    data[2] = DS3231_ALARM_MASK;
+
+    esp_err_t ret = ds3231_write_regs(DS3231_REG_ALARM2, data, sizeof(data));
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set alarm2");
+    }
+    return ret;
+}
+
+esp_err_t ds3231_set_alarm_enabled(uint8_t mask, bool enable)
+{
+    /* INTCN置位：INT/SQW引脚输出闹钟中断而不是方波 */
+    uint8_t bits = 0;
+    if (mask & DS3231_ALARM1) {
+        bits |= DS3231_CTRL_A1IE;
+    }
+    if (mask & DS3231_ALARM2) {
+        bits |= DS3231_CTRL_A2IE;
+    }
+
+    esp_err_t ret = ds3231_update_control(enable ? 0 : bits, DS3231_CTRL_INTCN | (enable ? bits : 0));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to update control register");
+        return ret;
+    }
+
+    if (alarm_task_handle) {
+        xTaskNotify(alarm_task_handle, ALARM_NOTIFY_RECHECK, eSetBits);
+    }
+    return ESP_OK;
+}
+
+esp_err_t ds3231_get_alarm_flags(uint8_t *flags)
+{
+    uint8_t status;
+    esp_err_t ret = ds3231_read_reg(DS3231_REG_STATUS, &status);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read status register");
+        return ret;
+    }
+
+    *flags = status & (DS3231_ALARM1 | DS3231_ALARM2);
+    return ESP_OK;
+}
+
+/*
+ * 标志位写0清除、写1不变：mask以外的标志写1，读取之后才置位的闹钟标志不会被误清；
+ * 其余位（OSF、EN32kHz）按已读到的状态原样写回。标志清除后INT引脚释放
+ */
+static esp_err_t ds3231_write_status_cleared(uint8_t status, uint8_t mask)
+{
+    status = (status | DS3231_ALARM1 | DS3231_ALARM2) & ~(mask & (DS3231_ALARM1 | DS3231_ALARM2));
+    esp_err_t ret = ds3231_write_reg(DS3231_REG_STATUS, status);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write status register");
+    }
+    return ret;
+}
+
+esp_err_t ds3231_clear_alarm_flags(uint8_t mask)
+{
+    uint8_t status;
+    esp_err_t ret = ds3231_read_reg(DS3231_REG_STATUS, &status);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read status register");
+        return ret;
+    }
+    return ds3231_write_status_cleared(status, mask);
+}
+
+static void IRAM_ATTR ds3231_int_isr_handler(void *arg)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    alarm_int_time_us = esp_timer_get_time();
+    xTaskNotifyFromISR(alarm_task_handle, ALARM_NOTIFY_EDGE, eSetBits, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/* 看门狗超时：闹钟1标志已置位却没有收到下降沿，INT引脚没有接线，停用中断交给调用者回退 */
+static void ds3231_check_int_wiring(void)
+{
+    uint8_t flags = 0;
+    if (ds3231_get_alarm_flags(&flags) != ESP_OK || !(flags & DS3231_ALARM1)) {
+        return;     // 读取失败或RTC本秒尚未递增，继续等待
+    }
+
+    ESP_LOGW(TAG, "No INT edge on GPIO %d within %d ms, falling back to software timing",
+             DS3231_INT_PIN, DS3231_INT_WATCHDOG_MS);
+    gpio_isr_handler_remove(DS3231_INT_PIN);
+    alarm_int_ready = false;
+    ds3231_set_alarm_enabled(DS3231_ALARM1 | DS3231_ALARM2, false);
+    ds3231_clear_alarm_flags(DS3231_ALARM1 | DS3231_ALARM2);
+
+    if (int_lost_callback) {
+        int_lost_callback();
+    }
+}
+
+/* 闹钟中断处理任务：ISR中不能访问I2C，在此读取并清除标志后回调 */
+static void ds3231_alarm_task(void *arg)
+{
+    while (1) {
+        /* 闹钟1每秒模式下INT应每秒拉低一次，超时未到时检查是否接线 */
+        bool watchdog = alarm_int_ready && alarm1_every_second && (alarm_int_enabled & DS3231_ALARM1);
+        uint32_t events = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &events,
+                            watchdog ? pdMS_TO_TICKS(DS3231_INT_WATCHDOG_MS) : portMAX_DELAY) != pdTRUE) {
+            ds3231_check_int_wiring();
+            continue;
+        }
+        if (!(events & ALARM_NOTIFY_EDGE)) {
+            continue;
+        }
+        int64_t int_time_us = alarm_int_time_us;
+
+        /* 每秒一次：读一次状态寄存器，用读到的值直接写回清除标志，共两次I2C传输 */
+        uint8_t status;
+        if (ds3231_read_reg(DS3231_REG_STATUS, &status) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read status register");
+            continue;
+        }
+        uint8_t flags = status & (DS3231_ALARM1 | DS3231_ALARM2);
+        if (flags == 0) {
+            continue;
+        }
+
+        ds3231_write_status_cleared(status, flags);
+
+        if ((flags & DS3231_ALARM1) && alarm1_callback) {
+            alarm1_callback(DS3231_ALARM1, int_time_us);
+        }
+        if ((flags & DS3231_ALARM2) && alarm2_callback) {
+            alarm2_callback(DS3231_ALARM2, int_time_us);
+        }
+    }
+}
+
+esp_err_t ds3231_register_alarm_callback(uint8_t alarm, ds3231_alarm_cb_t callback)
+{
+    if (alarm == DS3231_ALARM1) {
+        alarm1_callback = callback;
+    } else if (alarm == DS3231_ALARM2) {
+        alarm2_callback = callback;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+void ds3231_register_int_lost_callback(ds3231_int_lost_cb_t callback)
+{
+    int_lost_callback = callback;
+}
+
+esp_err_t ds3231_alarm_int_init(void)
+{
+    gpio_num_t int_pin = DS3231_INT_PIN;
+    if (int_pin == GPIO_NUM_NC) {
+        ESP_LOGW(TAG, "INT pin not wired, hardware alarm disabled");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (alarm_int_ready) {
+        return ESP_OK;
+    }
+
+    /* 上电后可能残留旧的闹钟标志，先全部禁用并清除，避免INT一直被拉低 */
+    esp_err_t ret = ds3231_set_alarm_enabled(DS3231_ALARM1 | DS3231_ALARM2, false);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = ds3231_clear_alarm_flags(DS3231_ALARM1 | DS3231_ALARM2);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << int_pin),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    ret = gpio_config(&io_conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "INT pin config failed");
+        return ret;
+    }
+
+    /* ISR服务可能已被其他模块安装 */
+    ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "GPIO ISR service install failed");
+        return ret;
+    }
+
+    /* 任务句柄在ISR中使用，先于处理函数登记；失败时删除，不留下孤立的任务 */
+    if (xTaskCreate(ds3231_alarm_task, "ds3231_alarm", 3072, NULL, 6, &alarm_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create alarm task");
+        alarm_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ret = gpio_isr_handler_add(int_pin, ds3231_int_isr_handler, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "INT handler add failed");
+        vTaskDelete(alarm_task_handle);
+        alarm_task_handle = NULL;
+        return ret;
+    }
+
+    alarm_int_ready = true;
+    ESP_LOGI(TAG, "Alarm interrupt enabled on GPIO %d", int_pin);
+    return ESP_OK;
+}
+
+bool ds3231_alarm_int_available(void)
+{
+    return alarm_int_ready;
+}
@@ -2,7 +2,9 @@
 #define DS3231_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
+#include "driver/gpio.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,9 +20,67 @@ typedef struct {
     uint16_t year;
 } ds3231_time_t;
 
+/* 寄存器0x00~0x12整块读取的结果 */
+#define DS3231_REG_COUNT        0x13
+
+typedef struct {
+    ds3231_time_t time;
+    int16_t temperature_q;      /* 芯片温度，单位0.25°C */
+    uint8_t control;            /* 控制寄存器0x0E */
+    uint8_t status;             /* 状态寄存器0x0F */
+    int8_t aging;               /* 老化偏移寄存器0x10 */
+} ds3231_regs_t;
+
+/* 异步读取完成回调，在驱动工作任务中执行 */
+typedef void (*ds3231_regs_cb_t)(esp_err_t result, const ds3231_regs_t *regs, void *arg);
+
+/*
+ * DS3231 INT/SQW引脚（开漏，低电平有效，需上拉）。引脚没有接线时不必修改：闹钟1每秒模式下
+ * 超过DS3231_INT_WATCHDOG_MS没有中断而闹钟1标志已置位，即判定为未接线，停用中断并通知调用者回退为软件方式。
+ * 确定不接线时也可改为 GPIO_NUM_NC，省去开机检测。
+ */
+#define DS3231_INT_PIN          GPIO_NUM_14
+#define DS3231_INT_WATCHDOG_MS  1500
+
+/* 状态寄存器中的闹钟标志位，同时用作中断使能掩码；闹钟1由时间服务用作每秒中断 */
+#define DS3231_ALARM1           0x01
+#define DS3231_ALARM2           0x02
+
+/* 闹钟中断回调，在驱动任务上下文中执行（非ISR）；int_time_us为ISR中记录的esp_timer时间 */
+typedef void (*ds3231_alarm_cb_t)(uint8_t alarm, int64_t int_time_us);
+
+/* INT引脚判定为未接线、中断已停用时的回调，在驱动任务上下文中执行 */
+typedef void (*ds3231_int_lost_cb_t)(void);
+
 esp_err_t ds3231_init(void);
 esp_err_t ds3231_get_time(ds3231_time_t *time);
 esp_err_t ds3231_set_time(const ds3231_time_t *time);
+/* 一次突发读取时间、控制/状态、老化偏移和温度寄存器 */
+esp_err_t ds3231_read_all(ds3231_regs_t *regs);
+/* 异步整块读取，立即返回，完成后在驱动任务中回调；队列满时返回 ESP_ERR_NO_MEM */
+esp_err_t ds3231_read_all_async(ds3231_regs_cb_t callback, void *arg);
+/* 老化偏移寄存器：每LSB约0.1ppm，正值使振荡器变慢；写入后触发一次温度转换使其立即生效 */
+esp_err_t ds3231_get_aging_offset(int8_t *aging);
+esp_err_t ds3231_set_aging_offset(int8_t aging);
+
+/* 闹钟1：每天在 hour:minute:second 匹配 */
+esp_err_t ds3231_set_alarm1(uint8_t hour, uint8_t minute, uint8_t second);
+/* 闹钟1：每秒触发一次，秒寄存器递增时INT拉低 */
+esp_err_t ds3231_set_alarm1_every_second(void);
+/* 闹钟2：每天在 hour:minute 匹配（秒为00时触发） */
+esp_err_t ds3231_set_alarm2(uint8_t hour, uint8_t minute);
+/* 使能或禁用mask中的闹钟中断（DS3231_ALARM1/DS3231_ALARM2组合），其余闹钟不受影响 */
+esp_err_t ds3231_set_alarm_enabled(uint8_t mask, bool enable);
+esp_err_t ds3231_get_alarm_flags(uint8_t *flags);
+esp_err_t ds3231_clear_alarm_flags(uint8_t mask);
+/* 配置INT引脚中断；引脚未接线时返回 ESP_ERR_NOT_SUPPORTED */
+esp_err_t ds3231_alarm_int_init(void);
+/* 为单个闹钟（DS3231_ALARM1或DS3231_ALARM2）注册回调 */
+esp_err_t ds3231_register_alarm_callback(uint8_t alarm, ds3231_alarm_cb_t callback);
+/* 注册INT引脚失效回调（只保留一个） */
+void ds3231_register_int_lost_callback(ds3231_int_lost_cb_t callback);
+/* INT中断是否可用；初始化成功后仍可能因判定为未接线而变为false */
+bool ds3231_alarm_int_available(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,293 @@
+#include "http_cache.h"
+#include "time_service.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>
+
+static const char *TAG = "HTTP_CACHE";
+
+#define HTTP_CACHE_MAGIC        0x31454348  // "HCE1"
+#define HTTP_CACHE_CHUNK        256         // 回放时每次读取的字节数
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#define STATS_INC(policy, field) do { \
+    portENTER_CRITICAL(&stats_lock); \
+    (policy)->stats.field++; \
+    portEXIT_CRITICAL(&stats_lock); \
+} while (0)
+
+/* FNV-1a，文件名只用键的散列（SPIFFS文件名长度有限），条目头里保存完整键防止碰撞 */
+static uint32_t key_hash(const char *key)
+{
+    uint32_t hash = 2166136261u;
+    for (; *key; key++) {
+        hash ^= (uint8_t)*key;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void copy_header_value(char *dest, size_t size, const char *value)
+{
+    strncpy(dest, value, size - 1);
+    dest[size - 1] = '\0';
+}
+
+/* 解析Cache-Control中的max-age和no-store */
+static void parse_cache_control(http_cache_txn_t *txn, const char *value)
+{
+    if (strstr(value, "no-store") != NULL) {
+        txn->no_store = true;
+    }
+    const char *max_age = strstr(value, "max-age=");
+    if (max_age != NULL) {
+        txn->max_age = atoi(max_age + strlen("max-age="));
+    }
+}
+
+static bool read_entry(const char *path, const char *key, http_cache_entry_t *entry)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    bool ok = fread(entry, sizeof(*entry), 1, fp) == 1 &&
+              entry->magic == HTTP_CACHE_MAGIC &&
+              entry->body_len <= HTTP_CACHE_MAX_BODY &&
+              strncmp(entry->key, key, sizeof(entry->key)) == 0;
+    fclose(fp);
+    return ok;
+}
+
+http_cache_state_t http_cache_begin(http_cache_txn_t *txn, http_cache_policy_t *policy, const char *key)
+{
+    memset(txn, 0, sizeof(*txn));
+    txn->policy = policy;
+    txn->max_age = -1;
+    snprintf(txn->path, sizeof(txn->path), HTTP_CACHE_BASE_PATH "/hc_%08" PRIx32 ".bin", key_hash(key));
+    STATS_INC(policy, lookups);
+
+    if (!read_entry(txn->path, key, &txn->entry)) {
+        memset(&txn->entry, 0, sizeof(txn->entry));
+        copy_header_value(txn->entry.key, sizeof(txn->entry.key), key);
+        txn->state = HTTP_CACHE_MISS;
+        return txn->state;
+    }
+
+    int64_t now = time_service_get_utc_seconds();
+    bool fresh = now > 0 && txn->entry.stored_at > 0 &&
+                 now >= txn->entry.stored_at && now < txn->entry.expires_at;
+    txn->state = fresh ? HTTP_CACHE_FRESH : HTTP_CACHE_STALE;
+    if (fresh) {
+        ESP_LOGI(TAG, "%s: 缓存命中，%lld 秒后过期", policy->name, (long long)(txn->entry.expires_at - now));
+    }
+    return txn->state;
+}
+
+esp_err_t http_cache_replay(http_cache_txn_t *txn, http_cache_sink_t sink, void *ctx)
+{
+    if (txn->state == HTTP_CACHE_MISS) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    FILE *fp = fopen(txn->path, "rb");
+    if (fp == NULL || fseek(fp, sizeof(http_cache_entry_t), SEEK_SET) != 0) {
+        if (fp) {
+            fclose(fp);
+        }
+        STATS_INC(txn->policy, errors);
+        return ESP_FAIL;
+    }
+
+    char chunk[HTTP_CACHE_CHUNK];
+    size_t remaining = txn->entry.body_len;
+    while (remaining > 0) {
+        size_t want = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+        size_t got = fread(chunk, 1, want, fp);
+        if (got != want) {
+            fclose(fp);
+            STATS_INC(txn->policy, errors);
+            return ESP_FAIL;
+        }
+        sink(chunk, (int)got, ctx);
+        remaining -= got;
+    }
+    fclose(fp);
+    return ESP_OK;
+}
+
+void http_cache_prepare_request(http_cache_txn_t *txn, esp_http_client_handle_t client)
+{
+    if (txn->state != HTTP_CACHE_MISS && txn->entry.etag[0] != '\0') {
+        esp_http_client_set_header(client, "If-None-Match", txn->entry.etag);
+    } else {
+        esp_http_client_delete_header(client, "If-None-Match");
+    }
+    if (txn->state != HTTP_CACHE_MISS && txn->entry.last_modified[0] != '\0') {
+        esp_http_client_set_header(client, "If-Modified-Since", txn->entry.last_modified);
+    } else {
+        esp_http_client_delete_header(client, "If-Modified-Since");
+    }
+}
+
+void http_cache_on_event(http_cache_txn_t *txn, const esp_http_client_event_t *evt)
+{
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_HEADER:
+            if (strcasecmp(evt->header_key, "ETag") == 0) {
+                copy_header_value(txn->etag, sizeof(txn->etag), evt->header_value);
+            } else if (strcasecmp(evt->header_key, "Last-Modified") == 0) {
+                copy_header_value(txn->last_modified, sizeof(txn->last_modified), evt->header_value);
+            } else if (strcasecmp(evt->header_key, "Cache-Control") == 0) {
+                parse_cache_control(txn, evt->header_value);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void http_cache_append(http_cache_txn_t *txn, const char *data, int len)
+{
+    if (txn->overflow) {
+        return;
+    }
+    if (txn->body == NULL) {
+        txn->body = heap_caps_malloc(HTTP_CACHE_MAX_BODY, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (txn->body == NULL) {
+            txn->overflow = true;
+            return;
+        }
+    }
+    if (txn->body_len + len > HTTP_CACHE_MAX_BODY) {
+        txn->overflow = true;
+        return;
+    }
+    memcpy(txn->body + txn->body_len, data, len);
+    txn->body_len += len;
+}
+
+void http_cache_limit_max_age(http_cache_txn_t *txn, int32_t max_age_s)
+{
+    if (max_age_s < 0) {
+        max_age_s = 0;
+    }
+    if (txn->max_age < 0 || max_age_s < txn->max_age) {
+        txn->max_age = max_age_s;
+    }
+}
+
+static int64_t expiry_from(const http_cache_txn_t *txn, int64_t now)
+{
+    if (now <= 0) {
+        return 0;       // 时钟未建立，下次必须重新验证
+    }
+    int64_t ttl = txn->policy->ttl_s;
+    if (txn->max_age >= 0 && txn->max_age < ttl) {
+        ttl = txn->max_age;
+    }
+    return now + ttl;
+}
+
+/* 先写临时文件再改名，写到一半断电不会留下损坏的条目 */
+static esp_err_t store_entry(http_cache_txn_t *txn)
+{
+    int64_t now = time_service_get_utc_seconds();
+    http_cache_entry_t *entry = &txn->entry;
+    entry->magic = HTTP_CACHE_MAGIC;
+    entry->body_len = txn->body_len;
+    entry->stored_at = now > 0 ? now : 0;
+    entry->expires_at = expiry_from(txn, now);
+    copy_header_value(entry->etag, sizeof(entry->etag), txn->etag);
+    copy_header_value(entry->last_modified, sizeof(entry->last_modified), txn->last_modified);
+
+    char tmp_path[sizeof(txn->path) + 1];
+    snprintf(tmp_path, sizeof(tmp_path), "%s~", txn->path);
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        return ESP_FAIL;
+    }
+    bool ok = fwrite(entry, sizeof(*entry), 1, fp) == 1 &&
+              fwrite(txn->body, 1, txn->body_len, fp) == txn->body_len;
+    ok = fclose(fp) == 0 && ok;
+    if (ok) {
+        remove(txn->path);
+        ok = rename(tmp_path, txn->path) == 0;
+    }
+    if (!ok) {
+        remove(tmp_path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/* 304：响应体不变，只更新有效期（和可能变化的验证器） */
+static esp_err_t refresh_entry(http_cache_txn_t *txn)
+{
+    int64_t now = time_service_get_utc_seconds();
+    http_cache_entry_t *entry = &txn->entry;
+    entry->stored_at = now > 0 ? now : 0;
+    entry->expires_at = expiry_from(txn, now);
+    if (txn->etag[0] != '\0') {
+        copy_header_value(entry->etag, sizeof(entry->etag), txn->etag);
+    }
+    if (txn->last_modified[0] != '\0') {
+        copy_header_value(entry->last_modified, sizeof(entry->last_modified), txn->last_modified);
+    }
+
+    FILE *fp = fopen(txn->path, "r+b");
+    if (fp == NULL) {
+        return ESP_FAIL;
+    }
+    bool ok = fwrite(entry, sizeof(*entry), 1, fp) == 1;
+    ok = fclose(fp) == 0 && ok;
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+void http_cache_finish(http_cache_txn_t *txn, int status_code, bool valid)
+{
+    http_cache_policy_t *policy = txn->policy;
+
+    if (status_code == 0 || status_code == 304) {
+        if (!valid) {
+            ESP_LOGW(TAG, "%s: 缓存内容无效，删除", policy->name);
+            remove(txn->path);
+            STATS_INC(policy, errors);
+        } else if (status_code == 0) {
+            STATS_INC(policy, fresh_hits);
+        } else {
+            STATS_INC(policy, revalidated);
+            if (refresh_entry(txn) != ESP_OK) {
+                STATS_INC(policy, errors);
+            }
+        }
+    } else if (status_code == 200) {
+        STATS_INC(policy, misses);
+        if (valid && !txn->no_store && !txn->overflow && txn->body_len > 0) {
+            if (store_entry(txn) == ESP_OK) {
+                STATS_INC(policy, stores);
+                ESP_LOGI(TAG, "%s: 已缓存 %u 字节%s%s", policy->name, (unsigned)txn->body_len,
+                         txn->etag[0] ? "，ETag " : "", txn->etag);
+            } else {
+                STATS_INC(policy, errors);
+            }
+        }
+    }
+
+    free(txn->body);
+    txn->body = NULL;
+    txn->body_len = 0;
+}
+
+void http_cache_get_stats(const http_cache_policy_t *policy, http_cache_stats_t *stats)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *stats = policy->stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
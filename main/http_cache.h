@@ -0,0 +1,146 @@
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 轮询接口的响应缓存
+ *
+ * 响应体连同ETag/Last-Modified和过期时间存到SPIFFS（storage分区，由audio_spiffs_init挂载），
+ * 每个缓存键一个文件：
+ * - 未过期：直接回放缓存的响应体，不联网
+ * - 已过期：带If-None-Match/If-Modified-Since请求，304时回放缓存并延长有效期
+ * - 200：调用者确认内容有效（如业务status正确）后才写入，错误响应不会覆盖好的缓存
+ *
+ * 有效期取端点策略的TTL，响应带Cache-Control: max-age时取两者较小值，no-store不缓存。
+ * 过期时间按UTC墙上时间记录，重启后仍然有效；时钟未建立时一律视为过期（需要重新验证）。
+ * SPIFFS未挂载或读写失败时退化为直接请求。
+ */
+
+#define HTTP_CACHE_BASE_PATH        "/spiffs"
+#define HTTP_CACHE_MAX_BODY         8192    // 超过此大小的响应不缓存
+#define HTTP_CACHE_KEY_LEN          64
+#define HTTP_CACHE_ETAG_LEN         72
+#define HTTP_CACHE_DATE_LEN         40
+
+typedef enum {
+    HTTP_CACHE_MISS = 0,        // 没有可用的缓存
+    HTTP_CACHE_STALE,           // 有缓存但已过期，需要条件请求
+    HTTP_CACHE_FRESH,           // 缓存未过期，直接使用
+} http_cache_state_t;
+
+/**
+ * @brief 单个端点的缓存统计
+ */
+typedef struct {
+    uint32_t lookups;
+    uint32_t fresh_hits;        // 未联网直接使用缓存
+    uint32_t revalidated;       // 条件请求得到304，沿用缓存
+    uint32_t misses;            // 完整下载（无缓存或内容已变）
+    uint32_t stores;
+    uint32_t errors;            // 文件读写失败或缓存内容损坏
+} http_cache_stats_t;
+
+/**
+ * @brief 端点的缓存策略，由使用模块静态持有
+ */
+typedef struct {
+    const char *name;
+    uint32_t ttl_s;             // 缓存有效期上限
+    http_cache_stats_t stats;
+} http_cache_policy_t;
+
+#define HTTP_CACHE_POLICY_INITIALIZER(policy_name, policy_ttl_s) { \
+    .name = (policy_name), \
+    .ttl_s = (policy_ttl_s), \
+}
+
+/**
+ * @brief 文件中的条目头，后接响应体
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t body_len;
+    int64_t stored_at;              // UTC秒，0表示写入时时钟未建立
+    int64_t expires_at;
+    char key[HTTP_CACHE_KEY_LEN];
+    char etag[HTTP_CACHE_ETAG_LEN];
+    char last_modified[HTTP_CACHE_DATE_LEN];
+} http_cache_entry_t;
+
+/**
+ * @brief 一次查找到写回的过程，由调用者放在栈上
+ */
+typedef struct {
+    http_cache_policy_t *policy;
+    http_cache_state_t state;
+    char path[32];
+    http_cache_entry_t entry;       // state非MISS时为已有条目
+    /* 以下记录本次网络响应 */
+    char etag[HTTP_CACHE_ETAG_LEN];
+    char last_modified[HTTP_CACHE_DATE_LEN];
+    int32_t max_age;                // -1表示响应没有给出
+    bool no_store;
+    bool overflow;
+    char *body;                     // PSRAM，收到响应体时分配
+    size_t body_len;
+} http_cache_txn_t;
+
+typedef void (*http_cache_sink_t)(const char *data, int len, void *ctx);
+
+/**
+ * @brief 查找缓存，开始一次事务（之后必须调用http_cache_finish）
+ */
+http_cache_state_t http_cache_begin(http_cache_txn_t *txn, http_cache_policy_t *policy, const char *key);
+
+/**
+ * @brief 把缓存的响应体分块交给sink
+ */
+esp_err_t http_cache_replay(http_cache_txn_t *txn, http_cache_sink_t sink, void *ctx);
+
+/**
+ * @brief 发请求前调用：有旧条目时设置条件请求头，否则清除上次留下的条件请求头
+ */
+void http_cache_prepare_request(http_cache_txn_t *txn, esp_http_client_handle_t client);
+
+/**
+ * @brief 在HTTP事件处理函数中调用，记录缓存相关的响应头
+ */
+void http_cache_on_event(http_cache_txn_t *txn, const esp_http_client_event_t *evt);
+
+/**
+ * @brief 记录解码后的响应体（压缩传输时缓存的是解压后的内容），只有200响应会被写入
+ */
+void http_cache_append(http_cache_txn_t *txn, const char *data, int len);
+
+/**
+ * @brief 按内容限制本次写入的有效期（如按上游发布时间推算），与max-age一样取较小值
+ */
+void http_cache_limit_max_age(http_cache_txn_t *txn, int32_t max_age_s);
+
+/**
+ * @brief 结束事务
+ *
+ * @param status_code 0表示直接使用了新鲜缓存，没有发请求；请求失败时传-1
+ * @param valid 调用者解析后的结论：200时决定是否写入，304/0时为假表示缓存内容已损坏，删除之
+ */
+void http_cache_finish(http_cache_txn_t *txn, int status_code, bool valid);
+
+/**
+ * @brief 复制端点的缓存统计
+ */
+void http_cache_get_stats(const http_cache_policy_t *policy, http_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_CACHE_H
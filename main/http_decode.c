@@ -0,0 +1,362 @@
+#include "http_decode.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "rom/miniz.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "HTTP_DECODE";
+
+/* gzip头（RFC 1952）的标志位 */
+#define GZIP_FHCRC      0x02
+#define GZIP_FEXTRA     0x04
+#define GZIP_FNAME      0x08
+#define GZIP_FCOMMENT   0x10
+#define GZIP_FRESERVED  0xE0
+#define GZIP_FIXED_LEN  10
+#define GZIP_TRAILER_LEN 8
+
+typedef enum {
+    STAGE_GZIP_FIXED,       // 10字节固定头
+    STAGE_GZIP_EXTRA_LEN,
+    STAGE_GZIP_EXTRA,
+    STAGE_GZIP_NAME,
+    STAGE_GZIP_COMMENT,
+    STAGE_GZIP_HCRC,
+    STAGE_ZLIB_PROBE,       // deflate编码：按前两字节判断是否带zlib头
+    STAGE_BODY,
+    STAGE_TRAILER,          // gzip尾：CRC32和原始长度
+    STAGE_DONE,
+} inflate_stage_t;
+
+struct http_inflate {
+    tinfl_decompressor tinfl;
+    uint32_t tinfl_flags;
+    inflate_stage_t stage;
+    uint8_t gzip_flags;
+    uint8_t buf[GZIP_FIXED_LEN];    // 正在收集的头/尾字节
+    size_t buf_len;
+    uint32_t skip;                  // FEXTRA剩余字节
+    uint32_t crc;                   // gzip：解压输出的CRC32，与尾部比对
+    size_t dict_ofs;
+    uint8_t dict[TINFL_LZ_DICT_SIZE];   // 解压输出同时作为滑动窗口，环形使用
+};
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void http_decode_accept(esp_http_client_handle_t client)
+{
+    esp_http_client_set_header(client, "Accept-Encoding", HTTP_DECODE_ACCEPT_ENCODING);
+}
+
+void http_decoder_begin(http_decoder_t *dec, http_decode_endpoint_t *endpoint, http_decode_sink_t sink, void *ctx)
+{
+    memset(dec, 0, sizeof(*dec));
+    dec->endpoint = endpoint;
+    dec->sink = sink;
+    dec->ctx = ctx;
+}
+
+static http_encoding_t parse_encoding(const char *value)
+{
+    while (*value == ' ' || *value == '\t') {
+        value++;
+    }
+    if (*value == '\0' || strcasecmp(value, "identity") == 0) {
+        return HTTP_ENCODING_IDENTITY;
+    }
+    if (strcasecmp(value, "gzip") == 0 || strcasecmp(value, "x-gzip") == 0) {
+        return HTTP_ENCODING_GZIP;
+    }
+    if (strcasecmp(value, "deflate") == 0) {
+        return HTTP_ENCODING_DEFLATE;
+    }
+    return HTTP_ENCODING_UNSUPPORTED;
+}
+
+static void emit(http_decoder_t *dec, const uint8_t *data, size_t len)
+{
+    if (dec->encoding == HTTP_ENCODING_GZIP) {
+        dec->inflate->crc = esp_rom_crc32_le(dec->inflate->crc, data, len);
+    }
+    dec->decoded_bytes += len;
+    dec->sink((const char *)data, (int)len, dec->ctx);
+}
+
+/* gzip头的可选字段按标志位依次出现 */
+static inflate_stage_t next_gzip_stage(const http_inflate_t *inf, inflate_stage_t stage)
+{
+    switch (stage) {
+        case STAGE_GZIP_FIXED:
+            if (inf->gzip_flags & GZIP_FEXTRA) {
+                return STAGE_GZIP_EXTRA_LEN;
+            }
+            /* fall through */
+        case STAGE_GZIP_EXTRA_LEN:
+        case STAGE_GZIP_EXTRA:
+            if (inf->gzip_flags & GZIP_FNAME) {
+                return STAGE_GZIP_NAME;
+            }
+            /* fall through */
+        case STAGE_GZIP_NAME:
+            if (inf->gzip_flags & GZIP_FCOMMENT) {
+                return STAGE_GZIP_COMMENT;
+            }
+            /* fall through */
+        case STAGE_GZIP_COMMENT:
+            if (inf->gzip_flags & GZIP_FHCRC) {
+                return STAGE_GZIP_HCRC;
+            }
+            /* fall through */
+        default:
+            return STAGE_BODY;
+    }
+}
+
+/* 把一段压缩数据交给tinfl，输出满一段就交给sink；返回已消耗的字节数，出错返回-1 */
+static int inflate_chunk(http_decoder_t *dec, const uint8_t *data, size_t len)
+{
+    http_inflate_t *inf = dec->inflate;
+    size_t consumed = 0;
+
+    for (;;) {
+        size_t in_bytes = len - consumed;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - inf->dict_ofs;
+        tinfl_status status = tinfl_decompress(&inf->tinfl, data + consumed, &in_bytes,
+                                               inf->dict, inf->dict + inf->dict_ofs, &out_bytes,
+                                               inf->tinfl_flags);
+        consumed += in_bytes;
+        if (out_bytes > 0) {
+            emit(dec, inf->dict + inf->dict_ofs, out_bytes);
+        }
+        inf->dict_ofs = (inf->dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status < TINFL_STATUS_DONE) {
+            ESP_LOGE(TAG, "%s: 解压失败(%d)", dec->endpoint->name, (int)status);
+            return -1;
+        }
+        if (status == TINFL_STATUS_DONE) {
+            inf->stage = dec->encoding == HTTP_ENCODING_GZIP ? STAGE_TRAILER : STAGE_DONE;
+            inf->buf_len = 0;
+            /*
+             * ROM中的tinfl快速路径会预读输入到位缓冲，结束时不退回（预读可能来自之前的数据块）。
+             * 去掉最后一个字节的填充位后，位缓冲中剩下的整字节就是gzip尾的开头
+             */
+            uint32_t bits = inf->tinfl.m_num_bits & ~7u;
+            uint64_t bit_buf = (uint64_t)inf->tinfl.m_bit_buf >> (inf->tinfl.m_num_bits & 7);
+            for (; bits > 0 && inf->buf_len < GZIP_TRAILER_LEN; bits -= 8, bit_buf >>= 8) {
+                inf->buf[inf->buf_len++] = (uint8_t)bit_buf;
+            }
+            inf->tinfl.m_num_bits = 0;
+            return (int)consumed;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && consumed == len) {
+            return (int)consumed;
+        }
+        /* HAS_MORE_OUTPUT：窗口写满一圈，继续 */
+    }
+}
+
+/* gzip尾：解压输出的CRC32和长度（模2^32），小端 */
+static esp_err_t check_gzip_trailer(http_decoder_t *dec)
+{
+    http_inflate_t *inf = dec->inflate;
+    uint32_t crc = inf->buf[0] | (inf->buf[1] << 8) | (inf->buf[2] << 16) | ((uint32_t)inf->buf[3] << 24);
+    uint32_t isize = inf->buf[4] | (inf->buf[5] << 8) | (inf->buf[6] << 16) | ((uint32_t)inf->buf[7] << 24);
+    if (isize != dec->decoded_bytes) {
+        ESP_LOGE(TAG, "%s: gzip长度不符(%lu/%lu)", dec->endpoint->name,
+                 (unsigned long)dec->decoded_bytes, (unsigned long)isize);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (crc != inf->crc) {
+        ESP_LOGE(TAG, "%s: gzip校验失败(%08lx/%08lx)", dec->endpoint->name,
+                 (unsigned long)inf->crc, (unsigned long)crc);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    inf->stage = STAGE_DONE;
+    return ESP_OK;
+}
+
+static esp_err_t inflate_feed(http_decoder_t *dec, const uint8_t *data, size_t len)
+{
+    http_inflate_t *inf = dec->inflate;
+
+    while (len > 0) {
+        switch (inf->stage) {
+            case STAGE_GZIP_FIXED:
+                inf->buf[inf->buf_len++] = *data++;
+                len--;
+                if (inf->buf_len == GZIP_FIXED_LEN) {
+                    if (inf->buf[0] != 0x1f || inf->buf[1] != 0x8b || inf->buf[2] != 8 ||
+                        (inf->buf[3] & GZIP_FRESERVED)) {
+                        ESP_LOGE(TAG, "%s: gzip头无效", dec->endpoint->name);
+                        return ESP_ERR_INVALID_RESPONSE;
+                    }
+                    inf->gzip_flags = inf->buf[3];
+                    inf->buf_len = 0;
+                    inf->stage = next_gzip_stage(inf, STAGE_GZIP_FIXED);
+                }
+                break;
+            case STAGE_GZIP_EXTRA_LEN:
+                inf->buf[inf->buf_len++] = *data++;
+                len--;
+                if (inf->buf_len == 2) {
+                    inf->skip = inf->buf[0] | (inf->buf[1] << 8);
+                    inf->buf_len = 0;
+                    inf->stage = inf->skip > 0 ? STAGE_GZIP_EXTRA : next_gzip_stage(inf, STAGE_GZIP_EXTRA);
+                }
+                break;
+            case STAGE_GZIP_EXTRA: {
+                size_t n = len < inf->skip ? len : inf->skip;
+                data += n;
+                len -= n;
+                inf->skip -= n;
+                if (inf->skip == 0) {
+                    inf->stage = next_gzip_stage(inf, STAGE_GZIP_EXTRA);
+                }
+                break;
+            }
+            case STAGE_GZIP_NAME:
+            case STAGE_GZIP_COMMENT:
+                /* 以0结尾的字符串 */
+                len--;
+                if (*data++ == 0) {
+                    inf->stage = next_gzip_stage(inf, inf->stage);
+                }
+                break;
+            case STAGE_GZIP_HCRC:
+                data++;
+                len--;
+                if (++inf->buf_len == 2) {
+                    inf->buf_len = 0;
+                    inf->stage = STAGE_BODY;
+                }
+                break;
+            case STAGE_ZLIB_PROBE:
+                inf->buf[inf->buf_len++] = *data++;
+                len--;
+                if (inf->buf_len == 2) {
+                    /* RFC 2616的deflate是zlib格式，但也有服务器直接发裸deflate */
+                    uint16_t header = (inf->buf[0] << 8) | inf->buf[1];
+                    if ((inf->buf[0] & 0x0F) == 8 && header % 31 == 0) {
+                        inf->tinfl_flags |= TINFL_FLAG_PARSE_ZLIB_HEADER;
+                    }
+                    inf->stage = STAGE_BODY;
+                    inf->buf_len = 0;
+                    if (inflate_chunk(dec, inf->buf, 2) < 0) {
+                        return ESP_ERR_INVALID_RESPONSE;
+                    }
+                }
+                break;
+            case STAGE_BODY: {
+                int consumed = inflate_chunk(dec, data, len);
+                if (consumed < 0) {
+                    return ESP_ERR_INVALID_RESPONSE;
+                }
+                data += consumed;
+                len -= consumed;
+                /* gzip尾可能已整个在位缓冲里 */
+                if (inf->stage == STAGE_TRAILER && inf->buf_len == GZIP_TRAILER_LEN &&
+                    check_gzip_trailer(dec) != ESP_OK) {
+                    return ESP_ERR_INVALID_RESPONSE;
+                }
+                break;
+            }
+            case STAGE_TRAILER:
+                inf->buf[inf->buf_len++] = *data++;
+                len--;
+                if (inf->buf_len == GZIP_TRAILER_LEN && check_gzip_trailer(dec) != ESP_OK) {
+                    return ESP_ERR_INVALID_RESPONSE;
+                }
+                break;
+            case STAGE_DONE:
+                return ESP_OK;      // 压缩流之后的多余字节忽略
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t feed(http_decoder_t *dec, const uint8_t *data, size_t len)
+{
+    if (dec->encoding == HTTP_ENCODING_IDENTITY) {
+        emit(dec, data, len);
+        return ESP_OK;
+    }
+    if (dec->encoding == HTTP_ENCODING_UNSUPPORTED) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (dec->inflate == NULL) {
+        dec->inflate = heap_caps_malloc(sizeof(http_inflate_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (dec->inflate == NULL) {
+            ESP_LOGE(TAG, "%s: 解压缓冲区分配失败", dec->endpoint->name);
+            return ESP_ERR_NO_MEM;
+        }
+        tinfl_init(&dec->inflate->tinfl);
+        dec->inflate->tinfl_flags = TINFL_FLAG_HAS_MORE_INPUT;
+        dec->inflate->stage = dec->encoding == HTTP_ENCODING_GZIP ? STAGE_GZIP_FIXED : STAGE_ZLIB_PROBE;
+        dec->inflate->buf_len = 0;
+        dec->inflate->dict_ofs = 0;
+        dec->inflate->crc = 0;
+    }
+    return inflate_feed(dec, data, len);
+}
+
+void http_decoder_on_event(http_decoder_t *dec, const esp_http_client_event_t *evt)
+{
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_HEADER:
+            if (strcasecmp(evt->header_key, "Content-Encoding") == 0) {
+                dec->encoding = parse_encoding(evt->header_value);
+            }
+            break;
+        case HTTP_EVENT_ON_DATA:
+            dec->wire_bytes += evt->data_len;
+            if (!dec->failed && feed(dec, evt->data, evt->data_len) != ESP_OK) {
+                dec->failed = true;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+esp_err_t http_decoder_finish(http_decoder_t *dec)
+{
+    bool compressed = dec->encoding != HTTP_ENCODING_IDENTITY;
+    bool incomplete = compressed && dec->wire_bytes > 0 &&
+                      (dec->inflate == NULL || dec->inflate->stage != STAGE_DONE);
+    bool error = dec->failed || incomplete;
+
+    if (compressed && dec->wire_bytes > 0) {
+        ESP_LOGI(TAG, "%s: 压缩传输 %lu 字节，解压后 %lu 字节%s", dec->endpoint->name,
+                 (unsigned long)dec->wire_bytes, (unsigned long)dec->decoded_bytes, error ? "（失败）" : "");
+    }
+
+    free(dec->inflate);
+    dec->inflate = NULL;
+
+    http_decode_stats_t *stats = &dec->endpoint->stats;
+    portENTER_CRITICAL(&stats_lock);
+    stats->responses++;
+    if (compressed) {
+        stats->compressed++;
+    }
+    stats->wire_bytes += dec->wire_bytes;
+    stats->decoded_bytes += dec->decoded_bytes;
+    if (error) {
+        stats->errors++;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    return error ? ESP_ERR_INVALID_RESPONSE : ESP_OK;
+}
+
+void http_decode_get_stats(const http_decode_endpoint_t *endpoint, http_decode_stats_t *stats)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *stats = endpoint->stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,102 @@
+#ifndef HTTP_DECODE_H
+#define HTTP_DECODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 响应体的gzip/deflate透明解压
+ *
+ * 请求时带上Accept-Encoding，服务器压缩传输时，响应体在HTTP事件里逐块交给ROM中的tinfl解压，
+ * 解压结果直接交给调用者的sink（通常是json_stream），不保留完整的压缩数据。
+ * 解压状态（约43KB，含32KB滑动窗口）只在收到压缩响应时从PSRAM分配，请求结束即释放。
+ * 未压缩的响应原样交给sink。
+ */
+
+#define HTTP_DECODE_ACCEPT_ENCODING     "gzip, deflate"
+
+/**
+ * @brief 单个端点的传输统计
+ */
+typedef struct {
+    uint32_t responses;
+    uint32_t compressed;        // 压缩传输的响应数
+    uint64_t wire_bytes;        // 线上收到的响应体字节
+    uint64_t decoded_bytes;     // 解压后交给解析器的字节
+    uint32_t errors;            // 解压失败或压缩数据不完整
+} http_decode_stats_t;
+
+/**
+ * @brief 端点，由使用模块静态持有
+ */
+typedef struct {
+    const char *name;
+    http_decode_stats_t stats;
+} http_decode_endpoint_t;
+
+#define HTTP_DECODE_ENDPOINT_INITIALIZER(endpoint_name) { .name = (endpoint_name) }
+
+typedef enum {
+    HTTP_ENCODING_IDENTITY = 0,
+    HTTP_ENCODING_GZIP,
+    HTTP_ENCODING_DEFLATE,
+    HTTP_ENCODING_UNSUPPORTED,
+} http_encoding_t;
+
+typedef void (*http_decode_sink_t)(const char *data, int len, void *ctx);
+
+typedef struct http_inflate http_inflate_t;
+
+/**
+ * @brief 一次响应的解码过程，与响应解析器放在一起
+ */
+typedef struct {
+    http_decode_endpoint_t *endpoint;
+    http_decode_sink_t sink;
+    void *ctx;
+    http_encoding_t encoding;
+    http_inflate_t *inflate;        // PSRAM，收到压缩响应体时分配
+    uint32_t wire_bytes;
+    uint32_t decoded_bytes;
+    bool failed;
+} http_decoder_t;
+
+/**
+ * @brief 在请求上声明接受gzip/deflate（句柄复用时设置一次即可）
+ */
+void http_decode_accept(esp_http_client_handle_t client);
+
+/**
+ * @brief 发请求前调用，开始一次响应的解码
+ */
+void http_decoder_begin(http_decoder_t *dec, http_decode_endpoint_t *endpoint, http_decode_sink_t sink, void *ctx);
+
+/**
+ * @brief 在HTTP事件处理函数中调用，处理Content-Encoding头和响应体
+ */
+void http_decoder_on_event(http_decoder_t *dec, const esp_http_client_event_t *evt);
+
+/**
+ * @brief 请求结束后调用，释放解压状态并计入统计
+ *
+ * @return esp_err_t 压缩数据损坏、不完整或编码不支持时返回ESP_ERR_INVALID_RESPONSE
+ */
+esp_err_t http_decoder_finish(http_decoder_t *dec);
+
+/**
+ * @brief 复制端点的传输统计
+ */
+void http_decode_get_stats(const http_decode_endpoint_t *endpoint, http_decode_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_DECODE_H
@@ -0,0 +1,57 @@
+#include "i2c_bus.h"
+#include "esp_log.h"
+
+static const char *TAG = "I2C_BUS";
+
+static i2c_master_bus_handle_t bus_handle = NULL;
+
+esp_err_t i2c_bus_init(void)
+{
+    if (bus_handle) {
+        return ESP_OK;
+    }
+
+    i2c_master_bus_config_t bus_config = {
+        .i2c_port = I2C_BUS_PORT,
+        .sda_io_num = I2C_BUS_SDA_PIN,
+        .scl_io_num = I2C_BUS_SCL_PIN,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+
+    esp_err_t ret = i2c_new_master_bus(&bus_config, &bus_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "I2C bus init failed: %s", esp_err_to_name(ret));
+        bus_handle = NULL;
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "I2C bus initialized (SDA=%d, SCL=%d)", I2C_BUS_SDA_PIN, I2C_BUS_SCL_PIN);
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_add_device(uint16_t address, uint32_t scl_speed_hz, i2c_master_dev_handle_t *dev_handle)
+{
+    esp_err_t ret = i2c_bus_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = address,
+        .scl_speed_hz = scl_speed_hz,
+    };
+
+    ret = i2c_master_bus_add_device(bus_handle, &dev_config, dev_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add device 0x%02x: %s", address, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+i2c_master_bus_handle_t i2c_bus_get_handle(void)
+{
+    return bus_handle;
+}
@@ -0,0 +1,44 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_BUS_PORT        I2C_NUM_0
+#define I2C_BUS_SDA_PIN     9
+#define I2C_BUS_SCL_PIN     8
+
+/**
+ * @brief 初始化共享I2C主机总线（可重复调用）
+ *
+ * @return esp_err_t 成功返回ESP_OK
+ */
+esp_err_t i2c_bus_init(void);
+
+/**
+ * @brief 向共享总线添加一个7位地址的设备
+ *
+ * 各设备可使用不同的SCL速率，驱动内部按事务加锁，多个设备可在不同任务中并发访问。
+ *
+ * @param address 7位设备地址
+ * @param scl_speed_hz SCL频率
+ * @param dev_handle 输出的设备句柄
+ * @return esp_err_t 成功返回ESP_OK
+ */
+esp_err_t i2c_bus_add_device(uint16_t address, uint32_t scl_speed_hz, i2c_master_dev_handle_t *dev_handle);
+
+/**
+ * @brief 获取共享总线句柄，未初始化时返回NULL
+ */
+i2c_master_bus_handle_t i2c_bus_get_handle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* I2C_BUS_H */
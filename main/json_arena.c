@@ -0,0 +1,248 @@
+#include "json_arena.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "cJSON.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "JSON_ARENA";
+
+#define ARENA_ALIGN(size)   (((size) + 7) & ~(size_t)7)    // cJSON节点含double，按8字节对齐
+
+struct json_arena_chunk {
+    json_arena_chunk_t *next;
+    size_t reserved;                // 保持data按8字节对齐
+    uint8_t data[JSON_ARENA_CHUNK_SIZE];
+};
+
+struct json_arena_large {
+    json_arena_large_t *next;
+    size_t size;
+    uint8_t data[];
+};
+
+static portMUX_TYPE arena_lock = portMUX_INITIALIZER_UNLOCKED;
+static json_arena_t *active_arenas[JSON_ARENA_MAX_ACTIVE];     // 按进入顺序排列
+static int active_count = 0;
+
+static size_t boot_largest_block = 0;
+static size_t min_largest_block = SIZE_MAX;
+
+/* 优先放在PSRAM，没有PSRAM时退回内部RAM */
+static void *arena_sys_alloc(size_t size)
+{
+    void *ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ptr == NULL) {
+        ptr = malloc(size);
+    }
+    return ptr;
+}
+
+/* 当前任务最内层的分配池 */
+static json_arena_t *current_arena(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    json_arena_t *arena = NULL;
+    portENTER_CRITICAL(&arena_lock);
+    for (int i = active_count - 1; i >= 0; i--) {
+        if (active_arenas[i]->owner == self) {
+            arena = active_arenas[i];
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&arena_lock);
+    return arena;
+}
+
+static void *arena_malloc(size_t size)
+{
+    json_arena_t *arena = current_arena();
+    if (arena == NULL) {
+        return malloc(size);
+    }
+
+    size = ARENA_ALIGN(size);
+    arena->stats.allocs++;
+    arena->scope_bytes += size;
+
+    if (size > JSON_ARENA_LARGE_SIZE) {
+        json_arena_large_t *large = arena_sys_alloc(sizeof(json_arena_large_t) + size);
+        if (large == NULL) {
+            return NULL;
+        }
+        large->size = size;
+        portENTER_CRITICAL(&arena_lock);
+        large->next = arena->large;
+        arena->large = large;
+        portEXIT_CRITICAL(&arena_lock);
+        arena->stats.large_allocs++;
+        return large->data;
+    }
+
+    if (arena->chunks == NULL || arena->chunk_used + size > JSON_ARENA_CHUNK_SIZE) {
+        json_arena_chunk_t *chunk = arena_sys_alloc(sizeof(json_arena_chunk_t));
+        if (chunk == NULL) {
+            return NULL;
+        }
+        portENTER_CRITICAL(&arena_lock);
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        portEXIT_CRITICAL(&arena_lock);
+        arena->chunk_used = 0;
+        arena->stats.chunk_allocs++;
+    }
+
+    void *ptr = arena->chunks->data + arena->chunk_used;
+    arena->chunk_used += size;
+    return ptr;
+}
+
+/*
+ * 块内的分配不单独释放；大块立即归还；不属于任何分配池的指针
+ * （作用域外创建、作用域内删除的对象）交给普通堆。
+ */
+static void arena_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    json_arena_large_t *release = NULL;
+    bool owned = false;
+    portENTER_CRITICAL(&arena_lock);
+    for (int i = 0; i < active_count && !owned; i++) {
+        json_arena_t *arena = active_arenas[i];
+        for (json_arena_chunk_t *chunk = arena->chunks; chunk; chunk = chunk->next) {
+            if ((uint8_t *)ptr >= chunk->data && (uint8_t *)ptr < chunk->data + JSON_ARENA_CHUNK_SIZE) {
+                owned = true;
+                break;
+            }
+        }
+        for (json_arena_large_t **link = &arena->large; *link && !owned; link = &(*link)->next) {
+            if ((*link)->data == ptr) {
+                release = *link;
+                *link = release->next;
+                owned = true;
+                break;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&arena_lock);
+
+    if (release) {
+        free(release);
+    } else if (!owned) {
+        free(ptr);
+    }
+}
+
+void json_arena_install(void)
+{
+    cJSON_Hooks hooks = {
+        .malloc_fn = arena_malloc,
+        .free_fn = arena_free,
+    };
+    cJSON_InitHooks(&hooks);
+    boot_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    ESP_LOGI(TAG, "cJSON分配池已安装，内部RAM最大空闲块 %u 字节", (unsigned)boot_largest_block);
+}
+
+void json_arena_begin(json_arena_t *arena)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    bool registered = false;
+    portENTER_CRITICAL(&arena_lock);
+    if (arena->owner == self) {
+        arena->reentry++;       // 同一任务重入同一分配池，沿用外层作用域
+        registered = true;
+    } else if (arena->owner == NULL && active_count < JSON_ARENA_MAX_ACTIVE) {
+        arena->owner = self;
+        arena->scope_bytes = 0;
+        active_arenas[active_count++] = arena;
+        registered = true;
+    }
+    portEXIT_CRITICAL(&arena_lock);
+
+    if (!registered) {
+        ESP_LOGW(TAG, "%s: 无法进入分配池，本次使用普通堆", arena->name);
+    }
+}
+
+void json_arena_end(json_arena_t *arena)
+{
+    json_arena_chunk_t *chunks = NULL;
+    json_arena_large_t *large = NULL;
+
+    portENTER_CRITICAL(&arena_lock);
+    if (arena->owner != xTaskGetCurrentTaskHandle() || arena->reentry > 0) {
+        if (arena->owner == xTaskGetCurrentTaskHandle()) {
+            arena->reentry--;
+        }
+        portEXIT_CRITICAL(&arena_lock);
+        return;     // 重入的内层作用域，或begin时未能注册
+    }
+    for (int i = 0; i < active_count; i++) {
+        if (active_arenas[i] == arena) {
+            memmove(&active_arenas[i], &active_arenas[i + 1], (active_count - i - 1) * sizeof(active_arenas[0]));
+            active_count--;
+            break;
+        }
+    }
+    arena->owner = NULL;
+    /* 保留最早申请的一块（链表尾）供下次使用，其余整体释放 */
+    if (arena->chunks) {
+        json_arena_chunk_t **tail = &arena->chunks;
+        while ((*tail)->next) {
+            tail = &(*tail)->next;
+        }
+        json_arena_chunk_t *keep = *tail;
+        *tail = NULL;
+        chunks = arena->chunks;
+        arena->chunks = keep;
+    }
+    arena->chunk_used = 0;
+    large = arena->large;
+    arena->large = NULL;
+
+    arena->stats.scopes++;
+    arena->stats.last_bytes = arena->scope_bytes;
+    if (arena->scope_bytes > arena->stats.peak_bytes) {
+        arena->stats.peak_bytes = arena->scope_bytes;
+    }
+    portEXIT_CRITICAL(&arena_lock);
+
+    while (chunks) {
+        json_arena_chunk_t *next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+    while (large) {
+        json_arena_large_t *next = large->next;
+        free(large);
+        large = next;
+    }
+
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    portENTER_CRITICAL(&arena_lock);
+    if (largest < min_largest_block) {
+        min_largest_block = largest;
+    }
+    portEXIT_CRITICAL(&arena_lock);
+}
+
+void json_arena_get_stats(const json_arena_t *arena, json_arena_stats_t *stats)
+{
+    portENTER_CRITICAL(&arena_lock);
+    *stats = arena->stats;
+    portEXIT_CRITICAL(&arena_lock);
+}
+
+void json_arena_get_heap_report(json_arena_heap_report_t *report)
+{
+    report->largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    report->internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    portENTER_CRITICAL(&arena_lock);
+    report->boot_largest_block = boot_largest_block;
+    report->min_largest_block = min_largest_block == SIZE_MAX ? report->largest_block : min_largest_block;
+    portEXIT_CRITICAL(&arena_lock);
+}
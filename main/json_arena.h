@@ -0,0 +1,102 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * cJSON分配池
+ *
+ * cJSON每个节点和字符串各malloc一次，构建/解析一次JSON会在内部RAM里
+ * 留下几十上百个小块，与WiFi、TLS缓冲区交错形成碎片。
+ * json_arena_install通过cJSON_InitHooks接管cJSON的分配：
+ * 任务处于json_arena_begin/json_arena_end之间时，节点从PSRAM中的大块里
+ * 顺序切分，单独的free不做任何事，json_arena_end一次性整体释放；
+ * 不在作用域内的分配仍走普通堆，行为与原来相同。
+ *
+ * 作用域内cJSON_Print的结果同样来自分配池，必须在json_arena_end之前用完，
+ * 用cJSON_free释放（或不释放），不能再交给其他任务。
+ */
+
+#define JSON_ARENA_CHUNK_SIZE       4096    // 每块大小，第一块在作用域之间保留复用
+#define JSON_ARENA_LARGE_SIZE       1024    // 超过此大小的分配单独申请，free时立即归还
+#define JSON_ARENA_MAX_ACTIVE       4       // 同时处于作用域内的分配池数（含嵌套）
+
+typedef struct json_arena_chunk json_arena_chunk_t;
+typedef struct json_arena_large json_arena_large_t;
+
+/**
+ * @brief 分配池统计
+ */
+typedef struct {
+    uint32_t scopes;                // 已完成的作用域数
+    uint32_t allocs;                // 作用域内的分配次数
+    uint32_t chunk_allocs;          // 向系统申请块的次数（不含保留复用的第一块）
+    uint32_t large_allocs;
+    size_t last_bytes;              // 上个作用域分配的总字节数
+    size_t peak_bytes;              // 单个作用域分配字节数的最大值
+} json_arena_stats_t;
+
+/**
+ * @brief 分配池，由使用模块静态持有
+ */
+typedef struct {
+    const char *name;
+    TaskHandle_t owner;             // 作用域内的任务，NULL表示未激活
+    uint8_t reentry;                // 同一任务重入的层数
+    json_arena_chunk_t *chunks;     // 链表头为当前切分的块
+    size_t chunk_used;
+    json_arena_large_t *large;
+    size_t scope_bytes;
+    json_arena_stats_t stats;
+} json_arena_t;
+
+#define JSON_ARENA_INITIALIZER(arena_name) { .name = (arena_name) }
+
+/**
+ * @brief 内部RAM最大空闲块的变化，用于观察长时间运行后的碎片
+ */
+typedef struct {
+    size_t boot_largest_block;      // 安装分配池时
+    size_t largest_block;           // 当前
+    size_t min_largest_block;       // 每个作用域结束时采样的最小值
+    size_t internal_free;
+} json_arena_heap_report_t;
+
+/**
+ * @brief 安装cJSON分配钩子，应在任何cJSON调用之前执行一次
+ */
+void json_arena_install(void);
+
+/**
+ * @brief 当前任务进入分配池作用域（可嵌套，最内层生效）
+ */
+void json_arena_begin(json_arena_t *arena);
+
+/**
+ * @brief 结束作用域，一次性释放作用域内的全部cJSON分配
+ */
+void json_arena_end(json_arena_t *arena);
+
+/**
+ * @brief 复制分配池统计
+ */
+void json_arena_get_stats(const json_arena_t *arena, json_arena_stats_t *stats);
+
+/**
+ * @brief 获取内部RAM最大空闲块报告
+ */
+void json_arena_get_heap_report(json_arena_heap_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_ARENA_H
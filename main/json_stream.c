@@ -0,0 +1,447 @@
+#include "json_stream.h"
+#include <string.h>
+#include <stdio.h>
+
+enum {
+    ST_VALUE,           // 期待一个值
+    ST_VALUE_OR_END,    // '['之后：值或']'
+    ST_KEY_OR_END,      // '{'之后：键或'}'
+    ST_KEY,             // ','之后：键
+    ST_COLON,
+    ST_AFTER_VALUE,     // 值之后：','、'}'、']'，顶层只允许空白
+    ST_STRING,
+    ST_ESCAPE,
+    ST_UNICODE,
+    ST_LITERAL,
+};
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool is_literal_char(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '-' || c == '+' || c == '.';
+}
+
+static esp_err_t fail(json_stream_t *js, esp_err_t err)
+{
+    js->error = err;
+    return err;
+}
+
+/* 截断时去掉末尾不完整的UTF-8字符，避免界面显示乱码 */
+static size_t trim_utf8(const char *buf, size_t len)
+{
+    size_t i = len;
+    while (i > 0 && len - i < 3 && ((unsigned char)buf[i - 1] & 0xC0) == 0x80) {
+        i--;
+    }
+    if (i > 0 && ((unsigned char)buf[i - 1] & 0xC0) == 0xC0) {
+        unsigned char lead = (unsigned char)buf[i - 1];
+        size_t need = lead >= 0xF0 ? 4 : (lead >= 0xE0 ? 3 : 2);
+        if (len - (i - 1) < need) {
+            return i - 1;
+        }
+    }
+    return len;
+}
+
+static void path_overflow(json_stream_t *js)
+{
+    if (js->overflow_depth == 0) {
+        js->overflow_depth = js->depth;
+    }
+}
+
+static void path_append(json_stream_t *js, const char *s, size_t n)
+{
+    if (js->path_len + n >= JSON_STREAM_PATH_SIZE) {
+        path_overflow(js);
+        return;
+    }
+    memcpy(js->path + js->path_len, s, n);
+    js->path_len += n;
+    js->path[js->path_len] = '\0';
+}
+
+/* 当前层的元素路径回到容器路径，准备追加新的键或下标 */
+static void path_rewind(json_stream_t *js)
+{
+    if (js->overflow_depth == js->depth) {
+        js->overflow_depth = 0;
+    }
+    js->path_len = js->stack[js->depth - 1].base_len;
+    js->path[js->path_len] = '\0';
+}
+
+static void path_set_index(json_stream_t *js)
+{
+    char index[8];
+    path_rewind(js);
+    int n = snprintf(index, sizeof(index), "[%u]", (unsigned)js->stack[js->depth - 1].index);
+    path_append(js, index, (size_t)n);
+}
+
+static void path_begin_key(json_stream_t *js)
+{
+    path_rewind(js);
+    if (js->path_len > 0) {
+        path_append(js, ".", 1);
+    }
+    js->in_key = true;
+    js->state = ST_STRING;
+}
+
+static json_stream_field_t *find_field(json_stream_t *js)
+{
+    if (js->overflow_depth != 0) {
+        return NULL;
+    }
+    for (size_t i = 0; i < js->field_count; i++) {
+        if (strcmp(js->fields[i].path, js->path) == 0) {
+            return &js->fields[i];
+        }
+    }
+    return NULL;
+}
+
+static void begin_value(json_stream_t *js, json_stream_type_t type)
+{
+    json_stream_field_t *field = find_field(js);
+    js->target = NULL;
+    if (field == NULL) {
+        return;
+    }
+    field->type = type;
+    field->truncated = false;
+    if (field->size > 0) {
+        field->buf[0] = '\0';
+    }
+    if (type != JSON_STREAM_CONTAINER && field->size > 0) {
+        js->target = field;
+        js->target_len = 0;
+    }
+}
+
+static void end_value(json_stream_t *js)
+{
+    json_stream_field_t *field = js->target;
+    if (field) {
+        size_t len = field->truncated ? trim_utf8(field->buf, js->target_len) : js->target_len;
+        field->buf[len] = '\0';
+        js->target = NULL;
+    }
+    js->state = ST_AFTER_VALUE;
+}
+
+static void emit(json_stream_t *js, char c)
+{
+    if (js->in_key) {
+        path_append(js, &c, 1);
+    } else if (js->target) {
+        if (js->target_len + 1 < js->target->size) {
+            js->target->buf[js->target_len++] = c;
+        } else {
+            js->target->truncated = true;
+        }
+    }
+}
+
+static void emit_codepoint(json_stream_t *js, uint32_t cp)
+{
+    if (cp < 0x80) {
+        emit(js, (char)cp);
+    } else if (cp < 0x800) {
+        emit(js, (char)(0xC0 | (cp >> 6)));
+        emit(js, (char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        emit(js, (char)(0xE0 | (cp >> 12)));
+        emit(js, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        emit(js, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        emit(js, (char)(0xF0 | (cp >> 18)));
+        emit(js, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        emit(js, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        emit(js, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+/* 孤立的高代理项按U+FFFD输出 */
+static void flush_surrogate(json_stream_t *js)
+{
+    if (js->high_surrogate) {
+        js->high_surrogate = 0;
+        emit_codepoint(js, 0xFFFD);
+    }
+}
+
+static void emit_unicode(json_stream_t *js, uint32_t cp)
+{
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        flush_surrogate(js);
+        js->high_surrogate = (uint16_t)cp;
+    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        if (js->high_surrogate) {
+            cp = 0x10000 + (((uint32_t)js->high_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+            js->high_surrogate = 0;
+            emit_codepoint(js, cp);
+        } else {
+            emit_codepoint(js, 0xFFFD);
+        }
+    } else {
+        flush_surrogate(js);
+        emit_codepoint(js, cp);
+    }
+}
+
+static void end_string(json_stream_t *js)
+{
+    flush_surrogate(js);
+    if (js->in_key) {
+        js->in_key = false;
+        js->state = ST_COLON;
+    } else {
+        end_value(js);
+    }
+}
+
+static esp_err_t push(json_stream_t *js, bool is_array)
+{
+    if (js->depth >= JSON_STREAM_MAX_DEPTH) {
+        return fail(js, ESP_ERR_INVALID_SIZE);
+    }
+    js->stack[js->depth].is_array = is_array;
+    js->stack[js->depth].index = 0;
+    js->stack[js->depth].base_len = (uint8_t)js->path_len;
+    js->depth++;
+    if (is_array) {
+        path_set_index(js);
+        js->state = ST_VALUE_OR_END;
+    } else {
+        js->state = ST_KEY_OR_END;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t pop(json_stream_t *js, bool is_array)
+{
+    if (js->depth == 0 || js->stack[js->depth - 1].is_array != is_array) {
+        return fail(js, ESP_FAIL);
+    }
+    js->path_len = js->stack[js->depth - 1].base_len;
+    js->path[js->path_len] = '\0';
+    js->depth--;
+    if (js->overflow_depth > js->depth) {
+        js->overflow_depth = 0;
+    }
+    js->state = ST_AFTER_VALUE;
+    return ESP_OK;
+}
+
+static esp_err_t begin_any_value(json_stream_t *js, char c)
+{
+    switch (c) {
+        case '{':
+            begin_value(js, JSON_STREAM_CONTAINER);
+            return push(js, false);
+        case '[':
+            begin_value(js, JSON_STREAM_CONTAINER);
+            return push(js, true);
+        case '"':
+            begin_value(js, JSON_STREAM_STRING);
+            js->in_key = false;
+            js->state = ST_STRING;
+            return ESP_OK;
+        default:
+            if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+                begin_value(js, JSON_STREAM_LITERAL);
+                emit(js, c);
+                js->state = ST_LITERAL;
+                return ESP_OK;
+            }
+            return fail(js, ESP_FAIL);
+    }
+}
+
+void json_stream_init(json_stream_t *js, json_stream_field_t *fields, size_t field_count)
+{
+    memset(js, 0, sizeof(*js));
+    js->fields = fields;
+    js->field_count = field_count;
+    js->state = ST_VALUE;
+    for (size_t i = 0; i < field_count; i++) {
+        fields[i].type = JSON_STREAM_NONE;
+        fields[i].truncated = false;
+        if (fields[i].size > 0) {
+            fields[i].buf[0] = '\0';
+        }
+    }
+}
+
+esp_err_t json_stream_feed(json_stream_t *js, const char *data, size_t len)
+{
+    if (js->error != ESP_OK) {
+        return js->error;
+    }
+
+    size_t i = 0;
+    while (i < len) {
+        char c = data[i];
+        esp_err_t err = ESP_OK;
+
+        switch (js->state) {
+            case ST_STRING:
+                if (c == '"') {
+                    end_string(js);
+                } else if (c == '\\') {
+                    js->state = ST_ESCAPE;
+                } else {
+                    flush_surrogate(js);
+                    emit(js, c);
+                }
+                break;
+
+            case ST_ESCAPE:
+                js->state = ST_STRING;
+                if (c == 'u') {
+                    js->hex_count = 0;
+                    js->hex_value = 0;
+                    js->state = ST_UNICODE;
+                    break;
+                }
+                flush_surrogate(js);
+                switch (c) {
+                    case 'n': emit(js, '\n'); break;
+                    case 't': emit(js, '\t'); break;
+                    case 'r': emit(js, '\r'); break;
+                    case 'b': emit(js, '\b'); break;
+                    case 'f': emit(js, '\f'); break;
+                    case '"': case '\\': case '/': emit(js, c); break;
+                    default: err = fail(js, ESP_FAIL); break;
+                }
+                break;
+
+            case ST_UNICODE: {
+                int digit;
+                if (c >= '0' && c <= '9') {
+                    digit = c - '0';
+                } else if (c >= 'a' && c <= 'f') {
+                    digit = c - 'a' + 10;
+                } else if (c >= 'A' && c <= 'F') {
+                    digit = c - 'A' + 10;
+                } else {
+                    err = fail(js, ESP_FAIL);
+                    break;
+                }
+                js->hex_value = (uint16_t)((js->hex_value << 4) | digit);
+                if (++js->hex_count == 4) {
+                    emit_unicode(js, js->hex_value);
+                    js->state = ST_STRING;
+                }
+                break;
+            }
+
+            case ST_LITERAL:
+                if (is_literal_char(c)) {
+                    emit(js, c);
+                    break;
+                }
+                end_value(js);
+                continue;       // 分隔符交给ST_AFTER_VALUE处理
+
+            case ST_VALUE:
+                if (!is_space(c)) {
+                    err = begin_any_value(js, c);
+                }
+                break;
+
+            case ST_VALUE_OR_END:
+                if (is_space(c)) {
+                    break;
+                }
+                err = (c == ']') ? pop(js, true) : begin_any_value(js, c);
+                break;
+
+            case ST_KEY_OR_END:
+            case ST_KEY:
+                if (is_space(c)) {
+                    break;
+                }
+                if (c == '"') {
+                    path_begin_key(js);
+                } else if (c == '}' && js->state == ST_KEY_OR_END) {
+                    err = pop(js, false);
+                } else {
+                    err = fail(js, ESP_FAIL);
+                }
+                break;
+
+            case ST_COLON:
+                if (c == ':') {
+                    js->state = ST_VALUE;
+                } else if (!is_space(c)) {
+                    err = fail(js, ESP_FAIL);
+                }
+                break;
+
+            case ST_AFTER_VALUE:
+                if (is_space(c)) {
+                    break;
+                }
+                if (js->depth == 0) {
+                    err = fail(js, ESP_FAIL);       // 顶层值之后只允许空白
+                } else if (c == ',') {
+                    if (js->stack[js->depth - 1].is_array) {
+                        js->stack[js->depth - 1].index++;
+                        path_set_index(js);
+                        js->state = ST_VALUE;
+                    } else {
+                        js->state = ST_KEY;
+                    }
+                } else if (c == '}' || c == ']') {
+                    err = pop(js, c == ']');
+                } else {
+                    err = fail(js, ESP_FAIL);
+                }
+                break;
+
+            default:
+                err = fail(js, ESP_FAIL);
+                break;
+        }
+
+        if (err != ESP_OK) {
+            return err;
+        }
+        i++;
+        js->bytes++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t json_stream_finish(json_stream_t *js)
+{
+    if (js->error != ESP_OK) {
+        return js->error;
+    }
+    if (js->state == ST_LITERAL && js->depth == 0) {
+        end_value(js);
+    }
+    if (js->state != ST_AFTER_VALUE || js->depth != 0) {
+        return fail(js, ESP_FAIL);      // 响应不完整
+    }
+    return ESP_OK;
+}
+
+const char *json_stream_get(const json_stream_t *js, const char *path)
+{
+    for (size_t i = 0; i < js->field_count; i++) {
+        if (js->fields[i].type != JSON_STREAM_NONE && strcmp(js->fields[i].path, path) == 0) {
+            return js->fields[i].buf;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,108 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 流式JSON字段提取
+ *
+ * 直接在HTTP_EVENT_ON_DATA中按块喂入响应体，逐字符解析，
+ * 只把路径命中的值写入调用者提供的定长缓冲区，不保存整个响应、不建DOM。
+ *
+ * 路径写法："currentTime"、"Response.Result"、"choices[0].message.content"、
+ * "lives[0].weather"。字符串值按JSON转义解码为UTF-8（含\uXXXX和代理对），
+ * 数字/true/false/null按原文复制；对象和数组命中时只标记类型，缓冲区置空。
+ */
+
+#define JSON_STREAM_MAX_DEPTH   16      // 最大嵌套层数
+#define JSON_STREAM_PATH_SIZE   128     // 当前路径的最大长度
+
+/**
+ * @brief 命中值的类型
+ */
+typedef enum {
+    JSON_STREAM_NONE = 0,       // 响应中没有该路径
+    JSON_STREAM_STRING,
+    JSON_STREAM_LITERAL,        // 数字、true、false、null（原文）
+    JSON_STREAM_CONTAINER,      // 对象或数组
+} json_stream_type_t;
+
+/**
+ * @brief 要提取的字段，由调用者提供路径和缓冲区
+ */
+typedef struct {
+    const char *path;
+    char *buf;
+    size_t size;                // buf容量（含结尾'\0'）
+    json_stream_type_t type;    // 解析后填写
+    bool truncated;             // 值超出容量，已在UTF-8字符边界截断
+} json_stream_field_t;
+
+#define JSON_STREAM_FIELD(field_path, field_buf, field_size) \
+    { .path = (field_path), .buf = (field_buf), .size = (field_size) }
+
+/* 只关心是否存在（对象/数组）的字段 */
+#define JSON_STREAM_PRESENCE(field_path)    JSON_STREAM_FIELD(field_path, NULL, 0)
+
+/**
+ * @brief 解析器状态，由调用者持有（约300字节，可放在栈上）
+ */
+typedef struct {
+    json_stream_field_t *fields;
+    size_t field_count;
+    esp_err_t error;                    // 出错后保持，后续输入被忽略
+    uint8_t state;
+    uint8_t depth;
+    uint8_t overflow_depth;             // 路径超长的层（0表示没有），其下不再匹配
+    bool in_key;                        // 当前字符串是对象的键
+    uint8_t hex_count;
+    uint16_t hex_value;
+    uint16_t high_surrogate;
+    json_stream_field_t *target;        // 当前值写入的字段，NULL表示跳过
+    size_t target_len;
+    size_t path_len;
+    size_t bytes;                       // 已处理的字节数
+    char path[JSON_STREAM_PATH_SIZE];
+    struct {
+        bool is_array;
+        uint16_t index;
+        uint8_t base_len;               // 容器自身路径的长度
+    } stack[JSON_STREAM_MAX_DEPTH];
+} json_stream_t;
+
+/**
+ * @brief 初始化解析器并清空全部字段（buf置为空串，type置为NONE）
+ */
+void json_stream_init(json_stream_t *js, json_stream_field_t *fields, size_t field_count);
+
+/**
+ * @brief 喂入一段响应数据，可在任意字节处分块
+ *
+ * @return ESP_OK；语法错误返回ESP_FAIL，嵌套超过JSON_STREAM_MAX_DEPTH返回ESP_ERR_INVALID_SIZE
+ */
+esp_err_t json_stream_feed(json_stream_t *js, const char *data, size_t len);
+
+/**
+ * @brief 响应结束，检查文档是否完整
+ *
+ * @return ESP_OK 顶层值已完整解析
+ */
+esp_err_t json_stream_finish(json_stream_t *js);
+
+/**
+ * @brief 按路径查找字段，命中时返回其缓冲区，否则返回NULL
+ */
+const char *json_stream_get(const json_stream_t *js, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_STREAM_H
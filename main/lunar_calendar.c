@@ -0,0 +1,519 @@
+#include "lunar_calendar.h"
+#include "civil_time.h"
+#include <stdio.h>
+
+#define LUNAR_YEARS     (LUNAR_CALENDAR_MAX_YEAR - LUNAR_CALENDAR_MIN_YEAR + 1)
+
+/*
+ * 每年一个条目：
+ *   bit 0-3   闰月月份（0为无闰月）
+ *   bit 4-15  正月..腊月是否为大月（bit 15为正月）
+ *   bit 16    闰月是否为大月
+ */
+static const uint32_t lunar_info[LUNAR_YEARS] = {
+    0x04bd8, 0x04ae0, 0x0a570, 0x054d5, 0x0d260, 0x0d950, 0x16554, 0x056a0, 0x09ad0, 0x055d2,  // 1900
+    0x04ae0, 0x0a5b6, 0x0a4d0, 0x0d250, 0x1d255, 0x0b540, 0x0d6a0, 0x0ada2, 0x095b0, 0x14977,  // 1910
+    0x04970, 0x0a4b0, 0x0b4b5, 0x06a50, 0x06d40, 0x1ab54, 0x02b60, 0x09570, 0x052f2, 0x04970,  // 1920
+    0x06566, 0x0d4a0, 0x0ea50, 0x16a95, 0x05ad0, 0x02b60, 0x186e3, 0x092e0, 0x1c8d7, 0x0c950,  // 1930
+    0x0d4a0, 0x1d8a6, 0x0b550, 0x056a0, 0x1a5b4, 0x025d0, 0x092d0, 0x0d2b2, 0x0a950, 0x0b557,  // 1940
+    0x06ca0, 0x0b550, 0x15355, 0x04da0, 0x0a5b0, 0x14573, 0x052b0, 0x0a9a8, 0x0e950, 0x06aa0,  // 1950
+    0x0aea6, 0x0ab50, 0x04b60, 0x0aae4, 0x0a570, 0x05260, 0x0f263, 0x0d950, 0x05b57, 0x056a0,  // 1960
+    0x096d0, 0x04dd5, 0x04ad0, 0x0a4d0, 0x0d4d4, 0x0d250, 0x0d558, 0x0b540, 0x0b6a0, 0x195a6,  // 1970
+    0x095b0, 0x049b0, 0x0a974, 0x0a4b0, 0x0b27a, 0x06a50, 0x06d40, 0x0af46, 0x0ab60, 0x09570,  // 1980
+    0x04af5, 0x04970, 0x064b0, 0x074a3, 0x0ea50, 0x06b58, 0x05ac0, 0x0ab60, 0x096d5, 0x092e0,  // 1990
+    0x0c960, 0x0d954, 0x0d4a0, 0x0da50, 0x07552, 0x056a0, 0x0abb7, 0x025d0, 0x092d0, 0x0cab5,  // 2000
+    0x0a950, 0x0b4a0, 0x0baa4, 0x0ad50, 0x055d9, 0x04ba0, 0x0a5b0, 0x15176, 0x052b0, 0x0a930,  // 2010
+    0x07954, 0x06aa0, 0x0ad50, 0x05b52, 0x04b60, 0x0a6e6, 0x0a4e0, 0x0d260, 0x0ea65, 0x0d530,  // 2020
+    0x05aa0, 0x076a3, 0x096d0, 0x04afb, 0x04ad0, 0x0a4d0, 0x1d0b6, 0x0d250, 0x0d520, 0x0dd45,  // 2030
+    0x0b5a0, 0x056d0, 0x055b2, 0x049b0, 0x0a577, 0x0a4b0, 0x0aa50, 0x1b255, 0x06d20, 0x0ada0,  // 2040
+    0x14b63, 0x09370, 0x049f8, 0x04970, 0x064b0, 0x168a6, 0x0ea50, 0x06b20, 0x1a6c4, 0x0aae0,  // 2050
+    0x092e0, 0x0d2e3, 0x0c960, 0x0d557, 0x0d4a0, 0x0da50, 0x05d55, 0x056a0, 0x0a6d0, 0x055d4,  // 2060
+    0x052d0, 0x0a9b8, 0x0a950, 0x0b4a0, 0x0b6a6, 0x0ad50, 0x055a0, 0x0aba4, 0x0a5b0, 0x052b0,  // 2070
+    0x0b273, 0x06930, 0x07337, 0x06aa0, 0x0ad50, 0x14b55, 0x04b60, 0x0a570, 0x054e4, 0x0d160,  // 2080
+    0x0e968, 0x0d520, 0x0daa0, 0x16aa6, 0x056d0, 0x04ae0, 0x0a9d4, 0x0a2d0, 0x0d150, 0x0f252,  // 2090
+    0x0d520,  // 2100
+};
+
+/* 各农历年正月初一距1900-01-31（1900年正月初一）的天数，最后一项为表尾 */
+static const uint32_t lunar_new_year_offset[LUNAR_YEARS + 1] = {
+    0, 384, 738, 1093, 1476, 1830, 2185, 2569, 2923, 3278,
+    3662, 4016, 4400, 4754, 5108, 5492, 5846, 6201, 6585, 6940,
+    7324, 7678, 8032, 8416, 8770, 9124, 9509, 9863, 10218, 10602,
+    10956, 11339, 11693, 12048, 12432, 12787, 13141, 13525, 13879, 14263,
+    14617, 14971, 15355, 15710, 16064, 16449, 16803, 17157, 17541, 17895,
+    18279, 18633, 18988, 19372, 19726, 20081, 20465, 20819, 21202, 21557,
+    21911, 22295, 22650, 23004, 23388, 23743, 24096, 24480, 24835, 25219,
+    25573, 25928, 26312, 26666, 27020, 27404, 27758, 28142, 28496, 28851,
+    29235, 29590, 29944, 30328, 30682, 31066, 31420, 31774, 32158, 32513,
+    32868, 33252, 33606, 33960, 34343, 34698, 35082, 35436, 35791, 36175,
+    36529, 36883, 37267, 37621, 37976, 38360, 38714, 39099, 39453, 39807,
+    40191, 40545, 40899, 41283, 41638, 42022, 42376, 42731, 43115, 43469,
+    43823, 44207, 44561, 44916, 45300, 45654, 46038, 46392, 46746, 47130,
+    47485, 47839, 48223, 48578, 48962, 49316, 49670, 50054, 50408, 50762,
+    51146, 51501, 51856, 52240, 52594, 52978, 53332, 53686, 54070, 54424,
+    54779, 55163, 55518, 55902, 56256, 56610, 56993, 57348, 57702, 58086,
+    58441, 58795, 59179, 59533, 59917, 60271, 60626, 61010, 61364, 61719,
+    62103, 62457, 62841, 63195, 63549, 63933, 64288, 64642, 65026, 65381,
+    65735, 66119, 66473, 66857, 67211, 67566, 67950, 68304, 68659, 69042,
+    69396, 69780, 70134, 70489, 70873, 71228, 71582, 71966, 72320, 72674,
+    73058, 73412
+};
+
+/*
+ * 二十四节气日期：第k个节气的日 = solar_term_base[k] + 2位偏移。
+ * 每年48位，按节气顺序从低位起排列；由天文算法（VSOP87太阳黄经、
+ * Meeus朔望、UTC+8）计算生成。
+ */
+static const uint8_t solar_term_base[24] = {
+    4, 19, 3, 18, 4, 19, 4, 19, 4, 20, 4, 20, 6, 22, 6, 22, 6, 22, 7, 22, 6, 21, 6, 21
+};
+static const uint8_t solar_term_table[LUNAR_YEARS][6] = {
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},  // 1900
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0xaa, 0xba, 0xaa, 0xaa, 0xaa},
+    {0xaa, 0xaf, 0xbb, 0xba, 0xab, 0xaa},
+    {0xab, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa},
+    {0xaa, 0xaf, 0xbb, 0xba, 0xab, 0xaa},
+    {0xab, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa},  // 1910
+    {0xaa, 0xaf, 0xbb, 0xba, 0xab, 0xaa},
+    {0xab, 0x5a, 0xa6, 0x65, 0xa6, 0x56},
+    {0x56, 0x9a, 0xaa, 0xa6, 0xa6, 0x6a},
+    {0x5a, 0x9a, 0xaa, 0xaa, 0xaa, 0xaa},
+    {0xaa, 0xae, 0xba, 0xaa, 0xab, 0xaa},
+    {0xaa, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x9a, 0xa6, 0xa6, 0xa6, 0x6a},
+    {0x5a, 0x9a, 0xaa, 0xaa, 0xaa, 0x6a},
+    {0xaa, 0xae, 0xba, 0xaa, 0xab, 0xaa},
+    {0xaa, 0x5a, 0xa6, 0x65, 0x96, 0x56},  // 1920
+    {0x56, 0x5a, 0xa6, 0xa6, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xaa, 0xaa, 0x6a},
+    {0x6a, 0xaa, 0xba, 0xaa, 0xab, 0xaa},
+    {0xaa, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x5a, 0xa6, 0xa6, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0xaa, 0xba, 0xaa, 0xab, 0xaa},
+    {0xaa, 0x5a, 0xa6, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},  // 1930
+    {0x6a, 0xaa, 0xba, 0xaa, 0xaa, 0xaa},
+    {0xaa, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa},
+    {0xaa, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa},
+    {0xaa, 0x5a, 0x66, 0x65, 0x56, 0x55},  // 1940
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa},
+    {0xaa, 0x5a, 0x65, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x9a, 0xaa, 0xa6, 0xa6, 0x6a},
+    {0x5a, 0x9a, 0xaa, 0xaa, 0xaa, 0xaa},
+    {0xaa, 0x59, 0x65, 0x55, 0x56, 0x55},
+    {0x55, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x5a, 0xa6, 0xa6, 0xa6, 0x6a},  // 1950
+    {0x5a, 0x9a, 0xaa, 0xaa, 0xaa, 0x6a},
+    {0xaa, 0x59, 0x65, 0x55, 0x56, 0x55},
+    {0x55, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x5a, 0xa6, 0xa6, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0xaa, 0x55, 0x65, 0x55, 0x56, 0x55},
+    {0x55, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0x55, 0x65, 0x55, 0x55, 0x55},  // 1960
+    {0x55, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0x55, 0x65, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},  // 1970
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xaa, 0x6a},
+    {0x6a, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x9a, 0xaa, 0xa6, 0xa6, 0x6a},
+    {0x6a, 0x45, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0x96, 0x5a},
+    {0x56, 0x9a, 0xa6, 0xa6, 0xa6, 0x6a},
+    {0x6a, 0x45, 0x55, 0x55, 0x55, 0x55},  // 1980
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x5a, 0xa6, 0xa6, 0xa6, 0x6a},
+    {0x5a, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x59, 0x65, 0x55, 0x56, 0x55},
+    {0x55, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x5a, 0xa6, 0xa5, 0xa6, 0x5a},
+    {0x5a, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x55, 0x55, 0x65, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x96, 0x56},  // 1990
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x65, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x45, 0x55, 0x51, 0x55, 0x15},  // 2000
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0xa6, 0x5a},
+    {0x5a, 0x45, 0x55, 0x51, 0x51, 0x15},
+    {0x15, 0x45, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},  // 2010
+    {0x56, 0x5a, 0xa6, 0x65, 0x96, 0x5a},
+    {0x5a, 0x45, 0x51, 0x51, 0x51, 0x15},
+    {0x15, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},
+    {0x56, 0x5a, 0xa6, 0x65, 0x96, 0x56},
+    {0x56, 0x05, 0x51, 0x51, 0x51, 0x15},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x59, 0x65, 0x55, 0x56, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x96, 0x56},
+    {0x56, 0x05, 0x51, 0x10, 0x51, 0x15},  // 2020
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x55, 0x55, 0x65, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x96, 0x56},
+    {0x56, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},  // 2030
+    {0x55, 0x5a, 0x66, 0x65, 0x56, 0x55},
+    {0x56, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},
+    {0x56, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},
+    {0x56, 0x05, 0x51, 0x10, 0x51, 0x05},  // 2040
+    {0x05, 0x45, 0x51, 0x51, 0x51, 0x15},
+    {0x15, 0x45, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},
+    {0x56, 0x05, 0x51, 0x10, 0x41, 0x05},
+    {0x05, 0x05, 0x51, 0x51, 0x51, 0x15},
+    {0x15, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x5a, 0x65, 0x55, 0x56, 0x55},
+    {0x56, 0x05, 0x11, 0x10, 0x41, 0x01},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x15},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x55},  // 2050
+    {0x55, 0x55, 0x65, 0x55, 0x55, 0x55},
+    {0x55, 0x05, 0x11, 0x10, 0x41, 0x01},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x15},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x05, 0x11, 0x10, 0x41, 0x01},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x55, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x05, 0x11, 0x10, 0x01, 0x00},  // 2060
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x05, 0x11, 0x10, 0x01, 0x00},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x05, 0x10, 0x00, 0x01, 0x00},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x51, 0x51, 0x51, 0x15},  // 2070
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},
+    {0x55, 0x05, 0x10, 0x00, 0x01, 0x00},
+    {0x01, 0x05, 0x51, 0x10, 0x41, 0x05},
+    {0x05, 0x45, 0x51, 0x51, 0x51, 0x15},
+    {0x15, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x05, 0x10, 0x00, 0x01, 0x00},
+    {0x01, 0x05, 0x51, 0x10, 0x41, 0x05},
+    {0x05, 0x05, 0x51, 0x50, 0x51, 0x15},
+    {0x15, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x05, 0x10, 0x00, 0x01, 0x00},  // 2080
+    {0x01, 0x05, 0x11, 0x10, 0x41, 0x01},
+    {0x05, 0x05, 0x51, 0x10, 0x51, 0x15},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x00, 0x10, 0x00, 0x00, 0x00},
+    {0x00, 0x05, 0x11, 0x10, 0x41, 0x01},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x15},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x55},
+    {0x55, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x05, 0x11, 0x10, 0x41, 0x01},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x05},  // 2090
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x55, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x05, 0x11, 0x10, 0x01, 0x00},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x05, 0x11, 0x00, 0x01, 0x00},
+    {0x01, 0x05, 0x51, 0x10, 0x51, 0x05},
+    {0x05, 0x45, 0x55, 0x51, 0x55, 0x15},
+    {0x15, 0x55, 0x55, 0x55, 0x55, 0x55},  // 2100
+};
+
+static const char *const solar_term_names[24] = {
+    "小寒", "大寒", "立春", "雨水", "惊蛰", "春分", "清明", "谷雨",
+    "立夏", "小满", "芒种", "夏至", "小暑", "大暑", "立秋", "处暑",
+    "白露", "秋分", "寒露", "霜降", "立冬", "小雪", "大雪", "冬至"
+};
+
+static const char *const festival_names[] = {
+    "", "春节", "元宵", "龙抬头", "清明", "端午", "七夕", "中元", "中秋", "重阳", "腊八", "小年", "除夕"
+};
+
+static const char *const month_names[12] = {
+    "正月", "二月", "三月", "四月", "五月", "六月", "七月", "八月", "九月", "十月", "冬月", "腊月"
+};
+
+static const char *const day_tens[4] = {"初", "十", "廿", "三"};
+static const char *const digit_names[11] = {"", "一", "二", "三", "四", "五", "六", "七", "八", "九", "十"};
+static const char *const stem_names[10] = {"甲", "乙", "丙", "丁", "戊", "己", "庚", "辛", "壬", "癸"};
+static const char *const branch_names[12] = {"子", "丑", "寅", "卯", "辰", "巳", "午", "未", "申", "酉", "戌", "亥"};
+static const char *const zodiac_names[12] = {"鼠", "牛", "虎", "兔", "龙", "蛇", "马", "羊", "猴", "鸡", "狗", "猪"};
+
+static inline bool lunar_year_in_range(int lunar_year)
+{
+    return lunar_year >= LUNAR_CALENDAR_MIN_YEAR && lunar_year <= LUNAR_CALENDAR_MAX_YEAR;
+}
+
+int lunar_calendar_leap_month(int lunar_year)
+{
+    if (!lunar_year_in_range(lunar_year)) {
+        return 0;
+    }
+    return lunar_info[lunar_year - LUNAR_CALENDAR_MIN_YEAR] & 0xf;
+}
+
+int lunar_calendar_month_days(int lunar_year, int lunar_month, bool leap)
+{
+    if (!lunar_year_in_range(lunar_year) || lunar_month < 1 || lunar_month > 12) {
+        return 0;
+    }
+    uint32_t info = lunar_info[lunar_year - LUNAR_CALENDAR_MIN_YEAR];
+    if (leap) {
+        if ((int)(info & 0xf) != lunar_month) {
+            return 0;
+        }
+        return (info & 0x10000) ? 30 : 29;
+    }
+    return (info & (0x10000 >> lunar_month)) ? 30 : 29;
+}
+
+int lunar_calendar_solar_term_day(int year, int term)
+{
+    if (!lunar_year_in_range(year) || term < 0 || term > 23) {
+        return 0;
+    }
+    const uint8_t *row = solar_term_table[year - LUNAR_CALENDAR_MIN_YEAR];
+    return solar_term_base[term] + ((row[term >> 2] >> ((term & 3) * 2)) & 0x3);
+}
+
+/* 1900-01-31（1900年正月初一）距1970-01-01的天数 */
+static int64_t lunar_epoch_days(void)
+{
+    return civil_days_from_date(LUNAR_CALENDAR_MIN_YEAR, 1, 31);
+}
+
+static lunar_festival_t lunar_festival_of(const lunar_date_t *lunar)
+{
+    if (lunar->solar_term == 6) {
+        return LUNAR_FESTIVAL_QINGMING;
+    }
+    if (lunar->leap) {
+        return LUNAR_FESTIVAL_NONE;
+    }
+
+    switch (lunar->month * 100 + lunar->day) {
+        case 101:  return LUNAR_FESTIVAL_SPRING;
+        case 115:  return LUNAR_FESTIVAL_LANTERN;
+        case 202:  return LUNAR_FESTIVAL_DRAGON_HEAD;
+        case 505:  return LUNAR_FESTIVAL_DRAGON_BOAT;
+        case 707:  return LUNAR_FESTIVAL_QIXI;
+        case 715:  return LUNAR_FESTIVAL_ZHONGYUAN;
+        case 815:  return LUNAR_FESTIVAL_MID_AUTUMN;
+        case 909:  return LUNAR_FESTIVAL_DOUBLE_NINTH;
+        case 1208: return LUNAR_FESTIVAL_LABA;
+        case 1223: return LUNAR_FESTIVAL_LITTLE_NEW_YEAR;
+        default:
+            break;
+    }
+    if (lunar->month == 12 && lunar->day == lunar->month_days) {
+        return LUNAR_FESTIVAL_NEW_YEARS_EVE;
+    }
+    return LUNAR_FESTIVAL_NONE;
+}
+
+esp_err_t lunar_calendar_from_solar(int year, int month, int day, lunar_date_t *lunar)
+{
+    if (!lunar || !civil_date_is_valid(year, month, day)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t offset = civil_days_from_date(year, month, day) - lunar_epoch_days();
+    if (offset < 0 || offset >= (int64_t)lunar_new_year_offset[LUNAR_YEARS]) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* 农历年为公历年或其前一年 */
+    int index = year - LUNAR_CALENDAR_MIN_YEAR;
+    if (index >= LUNAR_YEARS || (uint32_t)offset < lunar_new_year_offset[index]) {
+        index--;
+    }
+    uint32_t info = lunar_info[index];
+    int leap_month = info & 0xf;
+    int remain = (int)(offset - lunar_new_year_offset[index]);
+
+    /* 按月份顺序扣减，闰月紧跟在同名月之后 */
+    int lunar_month = 1;
+    bool leap = false;
+    int days;
+    while (1) {
+        days = (info & (0x10000 >> lunar_month)) ? 30 : 29;
+        if (remain < days) {
+            break;
+        }
+        remain -= days;
+        if (lunar_month == leap_month) {
+            days = (info & 0x10000) ? 30 : 29;
+            if (remain < days) {
+                leap = true;
+                break;
+            }
+            remain -= days;
+        }
+        lunar_month++;
+    }
+
+    lunar->year = LUNAR_CALENDAR_MIN_YEAR + index;
+    lunar->month = (uint8_t)lunar_month;
+    lunar->day = (uint8_t)(remain + 1);
+    lunar->leap = leap;
+    lunar->month_days = (uint8_t)days;
+    /* 1900年为庚子年 */
+    lunar->stem = (uint8_t)((index + 6) % 10);
+    lunar->branch = (uint8_t)(index % 12);
+
+    /* 每个公历月有两个节气 */
+    int term = (month - 1) * 2;
+    lunar->solar_term = LUNAR_SOLAR_TERM_NONE;
+    if (lunar_calendar_solar_term_day(year, term) == day) {
+        lunar->solar_term = (int8_t)term;
+    } else if (lunar_calendar_solar_term_day(year, term + 1) == day) {
+        lunar->solar_term = (int8_t)(term + 1);
+    }
+
+    lunar->festival = lunar_festival_of(lunar);
+    return ESP_OK;
+}
+
+esp_err_t lunar_calendar_to_solar(int lunar_year, int lunar_month, int lunar_day, bool leap,
+                                  int *year, int *month, int *day)
+{
+    int days = lunar_calendar_month_days(lunar_year, lunar_month, leap);
+    if (days == 0) {
+        return lunar_year_in_range(lunar_year) ? ESP_ERR_NOT_FOUND : ESP_ERR_INVALID_ARG;
+    }
+    if (lunar_day < 1 || lunar_day > days) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int index = lunar_year - LUNAR_CALENDAR_MIN_YEAR;
+    uint32_t info = lunar_info[index];
+    int leap_month = info & 0xf;
+    int64_t offset = lunar_new_year_offset[index];
+    for (int m = 1; m < lunar_month; m++) {
+        offset += (info & (0x10000 >> m)) ? 30 : 29;
+        if (m == leap_month) {
+            offset += (info & 0x10000) ? 30 : 29;
+        }
+    }
+    if (leap) {
+        offset += (info & (0x10000 >> lunar_month)) ? 30 : 29;
+    }
+    offset += lunar_day - 1;
+
+    civil_date_from_days(lunar_epoch_days() + offset, year, month, day);
+    return ESP_OK;
+}
+
+static size_t lunar_format_day(int day, char *buf, size_t size)
+{
+    int n;
+    if (day == 10) {
+        n = snprintf(buf, size, "初十");
+    } else if (day == 20) {
+        n = snprintf(buf, size, "二十");
+    } else if (day == 30) {
+        n = snprintf(buf, size, "三十");
+    } else {
+        n = snprintf(buf, size, "%s%s", day_tens[day / 10], digit_names[day % 10]);
+    }
+    return n < 0 ? 0 : (size_t)n;
+}
+
+size_t lunar_calendar_format(const lunar_date_t *lunar, char *buf, size_t size)
+{
+    if (!lunar || !buf || size == 0 || lunar->month < 1 || lunar->month > 12 ||
+        lunar->day < 1 || lunar->day > 30) {
+        if (buf && size > 0) {
+            buf[0] = '\0';
+        }
+        return 0;
+    }
+
+    int n = snprintf(buf, size, "%s%s ", lunar->leap ? "闰" : "", month_names[lunar->month - 1]);
+    if (n < 0 || (size_t)n >= size) {
+        return n < 0 ? 0 : size - 1;
+    }
+    size_t len = (size_t)n + lunar_format_day(lunar->day, buf + n, size - n);
+    return len < size ? len : size - 1;
+}
+
+size_t lunar_calendar_format_year(const lunar_date_t *lunar, char *buf, size_t size)
+{
+    if (!lunar || !buf || size == 0) {
+        return 0;
+    }
+    int n = snprintf(buf, size, "%s%s%s年", stem_names[lunar->stem % 10],
+                     branch_names[lunar->branch % 12], zodiac_names[lunar->branch % 12]);
+    if (n < 0) {
+        return 0;
+    }
+    return (size_t)n < size ? (size_t)n : size - 1;
+}
+
+const char *lunar_calendar_solar_term_name(int term)
+{
+    if (term < 0 || term > 23) {
+        return "";
+    }
+    return solar_term_names[term];
+}
+
+const char *lunar_calendar_festival_name(lunar_festival_t festival)
+{
+    if ((unsigned)festival >= sizeof(festival_names) / sizeof(festival_names[0])) {
+        return "";
+    }
+    return festival_names[festival];
+}
@@ -0,0 +1,107 @@
+#ifndef LUNAR_CALENDAR_H
+#define LUNAR_CALENDAR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 离线农历与二十四节气计算，覆盖1900-2100 */
+#define LUNAR_CALENDAR_MIN_YEAR     1900
+#define LUNAR_CALENDAR_MAX_YEAR     2100
+#define LUNAR_SOLAR_TERM_NONE       (-1)
+
+/**
+ * @brief 传统节日
+ */
+typedef enum {
+    LUNAR_FESTIVAL_NONE = 0,
+    LUNAR_FESTIVAL_SPRING,          // 春节 正月初一
+    LUNAR_FESTIVAL_LANTERN,         // 元宵 正月十五
+    LUNAR_FESTIVAL_DRAGON_HEAD,     // 龙抬头 二月初二
+    LUNAR_FESTIVAL_QINGMING,        // 清明（节气）
+    LUNAR_FESTIVAL_DRAGON_BOAT,     // 端午 五月初五
+    LUNAR_FESTIVAL_QIXI,            // 七夕 七月初七
+    LUNAR_FESTIVAL_ZHONGYUAN,       // 中元 七月十五
+    LUNAR_FESTIVAL_MID_AUTUMN,      // 中秋 八月十五
+    LUNAR_FESTIVAL_DOUBLE_NINTH,    // 重阳 九月初九
+    LUNAR_FESTIVAL_LABA,            // 腊八 腊月初八
+    LUNAR_FESTIVAL_LITTLE_NEW_YEAR, // 小年 腊月廿三
+    LUNAR_FESTIVAL_NEW_YEARS_EVE,   // 除夕 腊月最后一天
+} lunar_festival_t;
+
+/**
+ * @brief 农历日期
+ */
+typedef struct {
+    int year;               // 农历年（以正月初一为界）
+    uint8_t month;          // 1-12
+    uint8_t day;            // 1-30
+    bool leap;              // 是否闰月
+    uint8_t month_days;     // 本月天数（29或30）
+    uint8_t stem;           // 年天干 0-9（甲..癸）
+    uint8_t branch;         // 年地支 0-11（子..亥），即生肖
+    int8_t solar_term;      // 当天节气 0-23（0=小寒 ... 23=冬至），无则为LUNAR_SOLAR_TERM_NONE
+    lunar_festival_t festival;
+} lunar_date_t;
+
+/**
+ * @brief 公历日期转农历
+ *
+ * @param year 公历年
+ * @param month 公历月 1-12
+ * @param day 公历日 1-31
+ * @param lunar 输出的农历日期
+ * @return esp_err_t 超出1900-01-31至2101-01-28范围或日期非法返回ESP_ERR_INVALID_ARG
+ */
+esp_err_t lunar_calendar_from_solar(int year, int month, int day, lunar_date_t *lunar);
+
+/**
+ * @brief 农历转公历
+ *
+ * @param leap 是否闰月（该年无此闰月时返回ESP_ERR_NOT_FOUND）
+ */
+esp_err_t lunar_calendar_to_solar(int lunar_year, int lunar_month, int lunar_day, bool leap,
+                                  int *year, int *month, int *day);
+
+/**
+ * @brief 农历年的闰月（0表示无闰月）
+ */
+int lunar_calendar_leap_month(int lunar_year);
+
+/**
+ * @brief 农历月天数（29或30），参数无效返回0
+ */
+int lunar_calendar_month_days(int lunar_year, int lunar_month, bool leap);
+
+/**
+ * @brief 公历某年第term个节气（0=小寒 ... 23=冬至）所在的日，参数无效返回0
+ *
+ * 第term个节气位于公历 term/2+1 月。
+ */
+int lunar_calendar_solar_term_day(int year, int term);
+
+/**
+ * @brief 格式化农历月日，如"五月 二十"、"闰四月 初一"
+ *
+ * @return size_t 写入的字节数（不含结尾'\0'）
+ */
+size_t lunar_calendar_format(const lunar_date_t *lunar, char *buf, size_t size);
+
+/**
+ * @brief 格式化干支纪年，如"甲辰龙年"
+ */
+size_t lunar_calendar_format_year(const lunar_date_t *lunar, char *buf, size_t size);
+
+const char *lunar_calendar_solar_term_name(int term);
+const char *lunar_calendar_festival_name(lunar_festival_t festival);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LUNAR_CALENDAR_H
@@ -5,13 +5,18 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
-#include "esp_http_client.h"
 #include "esp_task_wdt.h"
-#include "cJSON.h"
 #include "lvgl.h"
 #include "lv_port_disp.h"
 #include "lv_port_indev.h"
 #include "ds3231.h"
+#include "time_service.h"
+#include "rtc_calib.h"
+#include "civil_time.h"
+#include "lunar_calendar.h"
+#include "almanac.h"
+#include "json_arena.h"
+#include "net_service.h"
 #include "wifi_manager.h"
 #include "weather_api.h"
 #include "ec11.h"
@@ -20,6 +25,7 @@
 #include "driver/adc.h"  // ADC相关头文件
 #include "esp_adc_cal.h"
 #include "audio_player.h"
+#include "countdown.h"
 #include "secrets.h"
 
 // MQ2烟雾传感器相关定义
@@ -114,7 +120,9 @@ static int countdown_hours = 0;
 static int countdown_minutes = 0;
 static int countdown_seconds = 0;
 static bool timer_running = false;
-static TickType_t timer_start_tick = 0;
+static int timer_countdown_id = -1;             // 倒计时引擎中的编号
+static TaskHandle_t timer_display_task_handle = NULL;
+#define TIMER_EXTEND_STEP_US (60 * 1000000LL)   // 倒计时中旋转编码器每格延长/缩短1分钟
 
 /* 闹钟相关变量 */
 typedef enum {
@@ -132,6 +140,15 @@ static int alarm_minutes = 0;
 static bool alarm_enabled = false;  // 闹钟是否启用
 static bool alarm_ringing = false;  // 闹钟是否正在响铃
 
+/* DS3231硬件闹钟：闹钟2在设定的时分触发响铃（闹钟1由时间服务用作秒中断），
+ * 响铃前几秒由秒边沿触发铃声预加载 */
+#define ALARM_PRELOAD_SECONDS 5
+static bool alarm_hw_irq = false;              // INT引脚中断是否可用
+static wav_file_t alarm_preloaded_wav = {0};   // 预加载的铃声数据
+static volatile bool alarm_preloaded = false;
+static uint32_t alarm_preload_gen = 0;         // 闹钟/铃声设置变化时递增，作废进行中的预加载
+static portMUX_TYPE alarm_preload_lock = portMUX_INITIALIZER_UNLOCKED;
+
 /* 事件提醒相关变量 */
 static char reminder_title[64] = {0};
 static char reminder_description[128] = {0};
@@ -167,24 +184,8 @@ static int setting_hour = 12;
 static int setting_minute = 0;
 static int setting_second = 0;
 
-/* 天气预报相关变量 */
-typedef struct {
-    char date[16];           // 日期 YYYY-MM-DD
-    char week[8];            // 星期几
-    char dayweather[32];     // 白天天气
-    char nightweather[32];   // 晚上天气
-    char daytemp[8];         // 白天温度
-    char nighttemp[8];       // 晚上温度
-    char daywind[16];        // 白天风向
-    char nightwind[16];      // 晚上风向
-    char daypower[8];        // 白天风力
-    char nightpower[8];      // 晚上风力
-} weather_forecast_t;
-
-static weather_forecast_t forecast_data[4];  // 存储4天预报数据
-static bool forecast_updated = false;        // 预报数据更新标志
-static char forecast_city[32] = "";          // 预报城市名
-static char forecast_update_time[32] = "";   // 预报更新时间
+/* 天气快照（实况+预报），由天气任务从weather_api复制，桌面1和桌面4共用 */
+static weather_report_t weather_report;
 
 /* LVGL相关变量 - 桌面1 */
 static lv_obj_t *time_label;
@@ -267,11 +268,13 @@ static void start_vibration(void);
 // MQ2相关函数声明已删除
 static void timer_audio_task(void *arg);
 static void alarm_audio_task(void *arg);
+static void alarm_check_preload(const ds3231_time_t *now);
 static void memory_monitor_task(void *arg);
 static esp_err_t dht11_init(void);
 static esp_err_t dht11_read_data(float *temperature, float *humidity);
 static void dht11_update_task(void *arg);
 static void update_indoor_temp_humid_display(void);
+static void update_forecast_display(void);
 
 
 /* LVGL相关变量 - 桌面2 */
@@ -304,692 +307,108 @@ TickType_t last_scan_time = 0;      // 导出为全局变量
 #define SCAN_INTERVAL_MS 30000  // 30秒扫描一次
 
 /* 天气更新相关变量 */
-static TickType_t last_weather_update = 0;
-#define WEATHER_UPDATE_INTERVAL_MS 60000 // 60秒更新一次天气
+static int64_t last_weather_attempt_us = 0;             // 最近一次提交刷新的esp_timer时间（任一城市）
+static int64_t last_home_attempt_us = 0;                // 最近一次提交本地城市刷新的esp_timer时间
+static volatile bool weather_refresh_pending = false;   // 刷新请求已交给网络服务，尚未完成
+static struct {
+    weather_city_t city;
+    bool include_forecast;
+} weather_request;                                      // 本轮请求的城市，只在无请求时修改
+static weather_city_t weather_cities[WEATHER_MAX_CITIES];  // 关注的城市，[0]为本地城市
+static int weather_city_count = 0;
+static char weather_home_adcode[8] = "";                // 桌面1当前显示的城市
+static int forecast_page = 0;                           // 桌面4当前显示的城市序号
+static weather_report_t forecast_report;                // 桌面4显示的城市快照
+#define WEATHER_ALARM_PREFETCH_S 180    // 闹钟前3分钟预取一次天气，响铃时显示最新数据
+#define WEATHER_CITY_STAGGER_S 30       // 相邻两次刷新请求的最小间隔，多个城市依次错开不集中发起
 
 /* 农历更新相关变量 */
-static TickType_t last_lunar_update = 0;
-static bool lunar_first_update = false;  // 标记是否已进行首次农历更新
-#define LUNAR_UPDATE_INTERVAL_MS 3600000  // 30秒更新一次农历（调试用，正式版本可改为3600000）
-#define LUNAR_API_URL "http://api.tiax.cn/almanac/"
-
-/* 农历缓存相关变量 */
-typedef struct {
-    int year;
-    int month;
-    int day;
-    char lunar_date[64];      // 农历日期（如"二月十五"）
-    bool valid;               // 数据是否有效
-} lunar_cache_t;
-
-#define LUNAR_CACHE_DAYS 7
-static lunar_cache_t lunar_cache[LUNAR_CACHE_DAYS];
-static time_t lunar_cache_timestamp = 0;  // 缓存时间戳
-#define LUNAR_CACHE_VALID_SECONDS (24 * 3600)  // 缓存24小时有效
-
-/* 天气缓存相关变量 */
-static char cached_weather_str[256] = "正在获取天气信息...";
-static bool weather_cache_valid = false;
-static time_t weather_cache_time = 0;
-#define WEATHER_CACHE_TIMEOUT (6 * 3600)  // 缓存6小时有效
-
-/* 时间同步相关变量 */
-static bool time_synced = false;
-static TickType_t last_time_sync = 0;
-#define TIME_SYNC_INTERVAL_MS 3600000  // 1小时同步一次时间
-#define TIME_SYNC_URL "http://f.m.suning.com/api/ct.do"
+static int64_t lunar_shown_day = INT64_MIN;  // 当前农历标签对应的日期（1970-01-01起的天数），按日期失效
+
+/* 天气显示相关变量：开机先显示NVS快照（灰色），联网验证后恢复黑色 */
+static bool weather_shown = false;                  // 本次开机是否已显示过天气
+#define WEATHER_OFFLINE_MAX_AGE_S (6 * 3600)        // 断网时仍显示的实况最长时间
+#define WEATHER_STALE_COLOR 0x888888                // 旧数据显示为灰色
 
 /* 星期名称数组 - 中文显示 */
 static const char *weekdays[] = {
     "", "星期一", "星期二", "星期三", "星期四", "星期五", "星期六", "星期天"
 };
 
-/* HTTP响应数据结构 */
-typedef struct {
-    char *data;
-    size_t len;
-} http_response_t;
-
-/* HTTP事件处理函数 */
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
-{
-    http_response_t *response = (http_response_t *)evt->user_data;
-    
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGE(TAG, "HTTP_EVENT_ERROR");
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_CONNECTED");
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT");
-            break;
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-            break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_DATA: 接收到 %d 字节数据", evt->data_len);
-            if (response->data == NULL) {
-                response->data = malloc(evt->data_len + 1);
-                response->len = 0;
-                if (response->data == NULL) {
-                    ESP_LOGE(TAG, "HTTP响应数据内存分配失败");
-                    break;
-                }
-            } else {
-                // 重新分配内存以容纳新数据
-                response->data = realloc(response->data, response->len + evt->data_len + 1);
-                if (response->data == NULL) {
-                    ESP_LOGE(TAG, "HTTP响应数据内存重新分配失败");
-                    break;
-                }
-            }
-            memcpy(response->data + response->len, evt->data, evt->data_len);
-            response->len += evt->data_len;
-            response->data[response->len] = '\0';
-            ESP_LOGI(TAG, "HTTP数据累计长度: %d", response->len);
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
-            break;
-        default:
-            break;
-    }
-    return ESP_OK;
-}
-
-/* 时间戳转换为ds3231_time_t结构 */
-static void timestamp_to_ds3231_time(long long timestamp_ms, ds3231_time_t *time_struct)
-{
-    time_t timestamp_sec = timestamp_ms / 1000;
-    
-    /* 转换为北京时间 (+8小时) */
-    timestamp_sec += 8 * 3600;
-    
-    struct tm *timeinfo = gmtime(&timestamp_sec);
-    
-    time_struct->year = timeinfo->tm_year + 1900;
-    time_struct->month = timeinfo->tm_mon + 1;
-    time_struct->date = timeinfo->tm_mday;
-    time_struct->hour = timeinfo->tm_hour;
-    time_struct->minute = timeinfo->tm_min;
-    time_struct->second = timeinfo->tm_sec;
-    time_struct->day_of_week = timeinfo->tm_wday == 0 ? 7 : timeinfo->tm_wday; // 调整星期格式
-}
-
-/* 网络时间同步函数 */
-static esp_err_t sync_time_from_network(void)
-{
-    // 如果用户选择不使用网络时间，直接返回
-    if (!use_network_time) {
-        ESP_LOGI(TAG, "网络时间同步已禁用");
-        return ESP_OK;
-    }
-    
-    ESP_LOGI(TAG, "开始网络时间同步...");
-    
-    /* 先获取DS3231当前时间 */
-    ds3231_time_t ds3231_time;
-    bool ds3231_valid = (ds3231_get_time(&ds3231_time) == ESP_OK);
-    
-    http_response_t response = {0};
-    
-    esp_http_client_config_t config = {
-        .url = TIME_SYNC_URL,
-        .event_handler = http_event_handler,
-        .user_data = &response,
-        .timeout_ms = 10000,
-    };
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    esp_err_t err = esp_http_client_perform(client);
-    
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        if (status_code == 200 && response.data != NULL) {
-            ESP_LOGI(TAG, "时间API响应: %s", response.data);
-            
-            /* 解析JSON响应 */
-            cJSON *json = cJSON_Parse(response.data);
-            if (json != NULL) {
-                cJSON *current_time = cJSON_GetObjectItem(json, "currentTime");
-                cJSON *code = cJSON_GetObjectItem(json, "code");
-                
-                if (current_time != NULL && code != NULL && 
-                    cJSON_IsNumber(current_time) && strcmp(cJSON_GetStringValue(code), "1") == 0) {
-                    
-                    long long timestamp = (long long)cJSON_GetNumberValue(current_time);
-                    ESP_LOGI(TAG, "获取到网络时间戳: %lld", timestamp);
-                    
-                    /* 转换网络时间戳 */
-                    ds3231_time_t network_time;
-                    timestamp_to_ds3231_time(timestamp, &network_time);
-                    
-                    bool should_sync = false;
-                    
-                    if (!ds3231_valid) {
-                        ESP_LOGI(TAG, "DS3231时间无效，执行同步");
-                        should_sync = true;
-                    } else {
-                        /* 计算时间差异（秒） */
-                        time_t ds3231_timestamp = mktime(&(struct tm){
-                            .tm_year = ds3231_time.year - 1900,
-                            .tm_mon = ds3231_time.month - 1,
-                            .tm_mday = ds3231_time.date,
-                            .tm_hour = ds3231_time.hour,
-                            .tm_min = ds3231_time.minute,
-                            .tm_sec = ds3231_time.second
-                        });
-                        
-                        time_t network_timestamp = timestamp / 1000;
-                        long time_diff = abs((long)(network_timestamp - ds3231_timestamp));
-                        
-                        ESP_LOGI(TAG, "DS3231时间: %04d-%02d-%02d %02d:%02d:%02d", 
-                                ds3231_time.year, ds3231_time.month, ds3231_time.date,
-                                ds3231_time.hour, ds3231_time.minute, ds3231_time.second);
-                        ESP_LOGI(TAG, "网络时间: %04d-%02d-%02d %02d:%02d:%02d", 
-                                network_time.year, network_time.month, network_time.date,
-                                network_time.hour, network_time.minute, network_time.second);
-                        ESP_LOGI(TAG, "时间差异: %ld 秒", time_diff);
-                        
-                        /* 只有时间差异超过5分钟（300秒）才同步 */
-                        if (time_diff > 300) {
-                            ESP_LOGI(TAG, "时间差异过大，执行同步");
-                            should_sync = true;
-                        } else {
-                            ESP_LOGI(TAG, "时间差异较小，跳过同步，保持DS3231时间");
-                            should_sync = false;
-                        }
-                    }
-                    
-                    if (should_sync) {
-                        esp_err_t set_result = ds3231_set_time(&network_time);
-                        if (set_result == ESP_OK) {
-                            ESP_LOGI(TAG, "时间同步成功: %04d-%02d-%02d %02d:%02d:%02d", 
-                                    network_time.year, network_time.month, network_time.date,
-                                    network_time.hour, network_time.minute, network_time.second);
-                            time_synced = true;
-                            last_time_sync = xTaskGetTickCount();
-                            
-                            /* 更新同步状态显示 */
-                            if (sync_status_label) {
-                                lv_label_set_text(sync_status_label, "✓");
-                                lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0x00AA00), 0); // 绿色
-                            }
-                            
-                            err = ESP_OK;
-                        } else {
-                            ESP_LOGE(TAG, "设置DS3231时间失败");
-                            
-                            /* 更新同步状态显示为失败 */
-                            if (sync_status_label) {
-                                lv_label_set_text(sync_status_label, "✗");
-                                lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0xAA0000), 0); // 红色
-                            }
-                            
-                            err = ESP_FAIL;
-                        }
-                    } else {
-                        /* 跳过同步，但标记为已检查 */
-                        time_synced = true;
-                        last_time_sync = xTaskGetTickCount();
-                        
-                        /* 更新同步状态显示为已检查但未同步 */
-                        if (sync_status_label) {
-                            lv_label_set_text(sync_status_label, "◐");
-                            lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0x0000AA), 0); // 蓝色
-                        }
-                        
-                        err = ESP_OK;
-                    }
-                } else {
-                    ESP_LOGE(TAG, "JSON数据格式错误");
-                    
-                    /* 更新同步状态显示为失败 */
-                    if (sync_status_label) {
-                        lv_label_set_text(sync_status_label, "✗");
-                        lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0xAA0000), 0); // 红色
-                    }
-                    
-                    err = ESP_FAIL;
-                }
-                cJSON_Delete(json);
-            } else {
-                ESP_LOGE(TAG, "JSON解析失败");
-                
-                /* 更新同步状态显示为失败 */
-                if (sync_status_label) {
-                    lv_label_set_text(sync_status_label, "✗");
-                    lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0xAA0000), 0); // 红色
-                }
-                
-                err = ESP_FAIL;
-            }
-        } else {
-            ESP_LOGE(TAG, "HTTP请求失败，状态码: %d", status_code);
-            
-            /* 更新同步状态显示为失败 */
-            if (sync_status_label) {
-                lv_label_set_text(sync_status_label, "✗");
-                lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0xAA0000), 0); // 红色
-            }
-            
-            err = ESP_FAIL;
-        }
-    } else {
-        ESP_LOGE(TAG, "HTTP请求执行失败: %s", esp_err_to_name(err));
-        
-        /* 更新同步状态显示为失败 */
-        if (sync_status_label) {
-            lv_label_set_text(sync_status_label, "✗");
-            lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0xAA0000), 0); // 红色
-        }
-    }
-    
-    /* 清理资源 */
-    if (response.data) {
-        free(response.data);
-    }
-    esp_http_client_cleanup(client);
-    
-    return err;
-}
-
-/* 提取农历月份和日期 */
-static void extract_lunar_month_day(const char* full_lunar_date, char* result, size_t result_size)
-{
-    if (full_lunar_date == NULL || result == NULL || result_size == 0) {
-        if (result && result_size > 0) {
-            result[0] = '\0';
-        }
-        return;
-    }
-    
-    ESP_LOGI(TAG, "开始提取农历月日: %s", full_lunar_date);
-    
-    /* 查找年份后的空格位置，格式通常为 "农历二零二三年 五月(小) 二十" */
-    const char *year_end = strstr(full_lunar_date, "年 ");
-    if (year_end == NULL) {
-        /* 如果没找到"年 "，尝试其他格式 */
-        year_end = strstr(full_lunar_date, "年");
-        if (year_end != NULL) {
-            year_end += strlen("年");
-            /* 跳过可能的空格 */
-            while (*year_end == ' ') year_end++;
-        }
-    } else {
-        year_end += strlen("年 ");
-    }
-    
-    if (year_end != NULL && *year_end != '\0') {
-        /* 找到年份后的内容 */
-        const char *month_start = year_end;
-        
-        /* 复制月份和日期部分，但要处理可能的括号信息 */
-        char temp_buffer[64];
-        strncpy(temp_buffer, month_start, sizeof(temp_buffer) - 1);
-        temp_buffer[sizeof(temp_buffer) - 1] = '\0';
-        
-        /* 移除括号内容，如 "(小)" 或 "(大)" */
-        char *bracket_start = strchr(temp_buffer, '(');
-        if (bracket_start != NULL) {
-            char *bracket_end = strchr(bracket_start, ')');
-            if (bracket_end != NULL) {
-                /* 移除括号及其内容 */
-                memmove(bracket_start, bracket_end + 1, strlen(bracket_end + 1) + 1);
-            }
-        }
-        
-        /* 复制结果到输出缓冲区 */
-        strncpy(result, temp_buffer, result_size - 1);
-        result[result_size - 1] = '\0';
-        
-        /* 移除尾部空格 */
-        int len = strlen(result);
-        while (len > 0 && result[len - 1] == ' ') {
-            result[--len] = '\0';
-        }
-        
-        ESP_LOGI(TAG, "提取的农历月日: %s", result);
-    } else {
-        /* 如果提取失败，使用原字符串 */
-        strncpy(result, full_lunar_date, result_size - 1);
-        result[result_size - 1] = '\0';
-        ESP_LOGW(TAG, "农历提取失败，使用原字符串: %s", result);
-    }
-}
-
-/* 初始化农历缓存 */
-static void init_lunar_cache(void)
-{
-    for (int i = 0; i < LUNAR_CACHE_DAYS; i++) {
-        lunar_cache[i].valid = false;
-        lunar_cache[i].lunar_date[0] = '\0';
-    }
-    lunar_cache_timestamp = 0;
-}
-
-/* 检查农历缓存是否有效 */
-static bool is_lunar_cache_valid(void)
-{
-    if (lunar_cache_timestamp == 0) {
-        return false;
-    }
-    
-    time_t current_time;
-    time(&current_time);
-    
-    return (current_time - lunar_cache_timestamp) < LUNAR_CACHE_VALID_SECONDS;
-}
-
-/* 从缓存获取农历日期 */
-static bool get_lunar_from_cache(int year, int month, int day, char* result, size_t result_size)
-{
-    if (!is_lunar_cache_valid()) {
-        return false;
-    }
-    
-    for (int i = 0; i < LUNAR_CACHE_DAYS; i++) {
-        if (lunar_cache[i].valid && 
-            lunar_cache[i].year == year && 
-            lunar_cache[i].month == month && 
-            lunar_cache[i].day == day) {
-            strncpy(result, lunar_cache[i].lunar_date, result_size - 1);
-            result[result_size - 1] = '\0';
-            return true;
-        }
-    }
-    
-    return false;
-}
-
-/* 保存农历日期到缓存 */
-static void save_lunar_to_cache(int year, int month, int day, const char* lunar_date)
-{
-    for (int i = 0; i < LUNAR_CACHE_DAYS; i++) {
-        if (!lunar_cache[i].valid) {
-            lunar_cache[i].year = year;
-            lunar_cache[i].month = month;
-            lunar_cache[i].day = day;
-            strncpy(lunar_cache[i].lunar_date, lunar_date, sizeof(lunar_cache[i].lunar_date) - 1);
-            lunar_cache[i].lunar_date[sizeof(lunar_cache[i].lunar_date) - 1] = '\0';
-            lunar_cache[i].valid = true;
-            break;
-        }
-    }
-}
-
-/* 计算指定日期的下一天 */
-static void get_next_day(int* year, int* month, int* day)
-{
-    int days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-    
-    // 检查闰年
-    if (*year % 4 == 0 && (*year % 100 != 0 || *year % 400 == 0)) {
-        days_in_month[1] = 29;
-    }
-    
-    (*day)++;
-    if (*day > days_in_month[*month - 1]) {
-        *day = 1;
-        (*month)++;
-        if (*month > 12) {
-            *month = 1;
-            (*year)++;
-        }
-    }
-}
-
-/* 天气缓存管理函数 */
-static void update_weather_cache(const char *weather_info)
-{
-    if (weather_info && strlen(weather_info) > 0) {
-        snprintf(cached_weather_str, sizeof(cached_weather_str), "%s", weather_info);
-        weather_cache_valid = true;
-        weather_cache_time = time(NULL);
-        ESP_LOGI(TAG, "天气信息已缓存: %s", cached_weather_str);
-    }
-}
-
-static bool is_weather_cache_valid(void)
+/* 实况是否仍值得显示：本次开机取到的或快照中的，取得时间在WEATHER_OFFLINE_MAX_AGE_S内 */
+static bool weather_live_recent(void)
 {
-    if (!weather_cache_valid) {
+    if (!weather_report.live_valid) {
         return false;
     }
-    
-    time_t current_time = time(NULL);
-    time_t cache_age = current_time - weather_cache_time;
-    
-    if (cache_age > WEATHER_CACHE_TIMEOUT) {
-        ESP_LOGI(TAG, "天气缓存已过期，缓存时间: %lld 秒前", (long long)cache_age);
-        weather_cache_valid = false;
-        return false;
+    int64_t now = time_service_get_utc_seconds();
+    if (now <= 0 || weather_report.live_fetched_at <= 0) {
+        return true;        // 时钟未建立时无法判断，照常显示
     }
-    
-    ESP_LOGI(TAG, "使用缓存的天气信息，缓存时间: %lld 秒前", (long long)cache_age);
-    return true;
-}
-
-static const char* get_cached_weather(void)
-{
-    return cached_weather_str;
+    return now - weather_report.live_fetched_at <= WEATHER_OFFLINE_MAX_AGE_S;
 }
 
-/* 获取单个日期的农历信息 */
-static esp_err_t get_single_lunar_date(int year, int month, int day, char* lunar_result, size_t result_size)
+/* 显示实况，未经本次联网验证的显示为灰色 */
+static void show_live_weather(void)
 {
-    /* 构建API URL */
-    char url[256];
-    snprintf(url, sizeof(url), "%s?year=%d&month=%d&day=%d", 
-             LUNAR_API_URL, year, month, day);
-    
-    ESP_LOGI(TAG, "农历API URL: %s", url);
-    
-    http_response_t response = {0};
-    
-    esp_http_client_config_t config = {
-        .url = url,
-        .event_handler = http_event_handler,
-        .user_data = &response,
-        .timeout_ms = 10000,
-    };
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "农历API HTTP客户端初始化失败");
-        return ESP_FAIL;
+    char weather_str[256];
+    if (!weather_label) {
+        return;
     }
-    
-    ESP_LOGI(TAG, "开始发送农历API HTTP请求...");
-    esp_err_t err = esp_http_client_perform(client);
-    ESP_LOGI(TAG, "农历API HTTP请求完成，结果: %s", esp_err_to_name(err));
-    
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        ESP_LOGI(TAG, "农历API HTTP状态码: %d", status_code);
-        
-        if (status_code == 200 && response.data != NULL && response.len > 0) {
-            ESP_LOGI(TAG, "农历API响应: %s", response.data);
-            
-            /* 解析JSON响应 */
-            cJSON *json = cJSON_Parse(response.data);
-            if (json != NULL) {
-                cJSON *lunar_date_obj = cJSON_GetObjectItem(json, "农历日期");
-                
-                if (lunar_date_obj != NULL && cJSON_IsString(lunar_date_obj)) {
-                    const char *full_lunar_date = cJSON_GetStringValue(lunar_date_obj);
-                    ESP_LOGI(TAG, "完整农历日期: %s", full_lunar_date);
-                    
-                    /* 提取月份和日期部分 */
-                    extract_lunar_month_day(full_lunar_date, lunar_result, result_size);
-                    
-                    ESP_LOGI(TAG, "农历日期获取成功: %s", lunar_result);
-                    err = ESP_OK;
-                } else {
-                    ESP_LOGE(TAG, "农历日期字段不存在或格式错误");
-                    err = ESP_FAIL;
-                }
-                cJSON_Delete(json);
-            } else {
-                ESP_LOGE(TAG, "农历API JSON解析失败");
-                err = ESP_FAIL;
-            }
-        } else {
-            ESP_LOGE(TAG, "农历API HTTP请求失败，状态码: %d", status_code);
-            err = ESP_FAIL;
-        }
+    /* 格式化天气信息显示 - 只使用字库中有的字 */
+    const char *city_name = weather_city_count > 0 ? weather_cities[0].name : WEATHER_DEFAULT_CITY_NAME;
+    if (weather_report.live.temperature != WEATHER_TEMP_UNKNOWN) {
+        snprintf(weather_str, sizeof(weather_str), "%s %s %d°C", city_name,
+                 weather_code_name(weather_report.live.weather), weather_report.live.temperature);
     } else {
-        ESP_LOGE(TAG, "农历API HTTP请求执行失败: %s", esp_err_to_name(err));
-    }
-    
-    /* 清理资源 */
-    if (response.data) {
-        free(response.data);
+        snprintf(weather_str, sizeof(weather_str), "%s %s", city_name, weather_code_name(weather_report.live.weather));
     }
-    esp_http_client_cleanup(client);
-    
-    return err;
-}
+    lv_label_set_text(weather_label, weather_str);
+    lv_obj_set_style_text_font(weather_label, &my_font_1, 0);
+    lv_obj_set_style_text_color(weather_label, weather_report.live_stale ?
+                                lv_color_hex(WEATHER_STALE_COLOR) : lv_color_black(), 0);
 
-/* 农历批量获取任务 */
-static void lunar_batch_task(void *arg)
-{
-    ESP_LOGI(TAG, "农历批量获取任务启动");
-    
-    /* 获取当前日期 */
-    ds3231_time_t current_time;
-    if (ds3231_get_time(&current_time) != ESP_OK) {
-        ESP_LOGE(TAG, "无法获取当前时间");
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    ESP_LOGI(TAG, "当前时间: %04d-%02d-%02d", current_time.year, current_time.month, current_time.date);
-    
-    /* 检查WiFi连接状态 */
-    wifi_status_t wifi_status = wifi_get_status();
-    if (wifi_status != WIFI_STATUS_CONNECTED) {
-        ESP_LOGW(TAG, "WiFi未连接，无法获取农历信息");
-        vTaskDelete(NULL);
-        return;
+    if (!weather_shown) {
+        weather_shown = true;
+        ESP_LOGI(TAG, "上电后 %lld ms 首次显示天气（%s）: %s", (long long)(esp_timer_get_time() / 1000),
+                 weather_report.live_stale ? "快照" : "联网", weather_str);
     }
-    
-    /* 清空现有缓存 */
-    init_lunar_cache();
-    
-    int success_count = 0;
-    int target_year = current_time.year;
-    int target_month = current_time.month;
-    int target_day = current_time.date;
-    
-    /* 获取未来7天的农历信息 */
-    for (int i = 0; i < LUNAR_CACHE_DAYS; i++) {
-        char lunar_result[64];
-        
-        ESP_LOGI(TAG, "正在获取第%d天的农历: %04d-%02d-%02d", i+1, target_year, target_month, target_day);
-        
-        if (get_single_lunar_date(target_year, target_month, target_day, lunar_result, sizeof(lunar_result)) == ESP_OK) {
-            save_lunar_to_cache(target_year, target_month, target_day, lunar_result);
-            success_count++;
-            ESP_LOGI(TAG, "成功获取第%d天农历: %s", i+1, lunar_result);
-        } else {
-            ESP_LOGW(TAG, "获取第%d天农历失败", i+1);
-        }
-        
-        /* 计算下一天 */
-        get_next_day(&target_year, &target_month, &target_day);
-        
-        /* 增加短暂延时，避免请求过于频繁 */
-        vTaskDelay(pdMS_TO_TICKS(1000));
-    }
-    
-    if (success_count > 0) {
-        time(&lunar_cache_timestamp);
-        ESP_LOGI(TAG, "农历批量获取完成，成功获取%d天数据", success_count);
-    } else {
-        ESP_LOGE(TAG, "农历批量获取失败，没有成功获取任何数据");
-    }
-    
-    /* 任务完成，删除自身 */
-    vTaskDelete(NULL);
 }
 
-/* 获取农历日期函数 */
-static esp_err_t get_lunar_date(void)
+/* 获取农历日期函数：优先查almanac分区，分区不可用时离线计算 */
+static esp_err_t get_lunar_date(const ds3231_time_t *current)
 {
-    ESP_LOGI(TAG, "开始获取农历日期...");
-    
-    /* 获取当前日期 */
-    ds3231_time_t current_time;
-    if (ds3231_get_time(&current_time) != ESP_OK) {
-        ESP_LOGE(TAG, "无法获取当前时间");
-        if (lunar_date_label) {
-            lv_label_set_text(lunar_date_label, "农历时间获取失败");
-            lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
-        }
-        return ESP_FAIL;
-    }
-    
-    ESP_LOGI(TAG, "当前时间: %04d-%02d-%02d", current_time.year, current_time.month, current_time.date);
-    
-    /* 首先尝试从缓存获取 */
     char lunar_display[64];
-    if (get_lunar_from_cache(current_time.year, current_time.month, current_time.date, 
-                           lunar_display, sizeof(lunar_display))) {
-        /* 从缓存获取成功 */
+    almanac_day_t day;
+    esp_err_t ret = almanac_lookup(current->year, current->month, current->date, &day);
+    if (ret == ESP_OK) {
+        snprintf(lunar_display, sizeof(lunar_display), "%s", day.lunar_text);
         if (lunar_date_label) {
             lv_label_set_text(lunar_date_label, lunar_display);
             lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
         }
-        ESP_LOGI(TAG, "从缓存获取农历日期成功: %s", lunar_display);
+        ESP_LOGI(TAG, "农历日期: %s", lunar_display);
         return ESP_OK;
     }
-    
-    /* 缓存中没有，尝试在线获取 */
-    wifi_status_t wifi_status = wifi_get_status();
-    if (wifi_status != WIFI_STATUS_CONNECTED) {
-        ESP_LOGW(TAG, "WiFi未连接且缓存无效，无法获取农历信息");
+
+    lunar_date_t lunar;
+    ret = lunar_calendar_from_solar(current->year, current->month, current->date, &lunar);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "日期超出农历表范围: %04d-%02d-%02d", current->year, current->month, current->date);
         if (lunar_date_label) {
             lv_label_set_text(lunar_date_label, "农历获取失败");
             lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
         }
-        return ESP_ERR_WIFI_NOT_CONNECT;
+        return ret;
     }
     
-    /* 在线获取当前日期的农历 */
-    if (get_single_lunar_date(current_time.year, current_time.month, current_time.date, 
-                            lunar_display, sizeof(lunar_display)) == ESP_OK) {
-        /* 保存到缓存 */
-        save_lunar_to_cache(current_time.year, current_time.month, current_time.date, lunar_display);
-        
-        /* 更新显示 */
-        if (lunar_date_label) {
-            lv_label_set_text(lunar_date_label, lunar_display);
-            lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
-        }
-        
-        ESP_LOGI(TAG, "在线获取农历日期成功: %s", lunar_display);
-        last_lunar_update = xTaskGetTickCount();
-        
-        /* 如果缓存无效，启动批量获取任务 */
-        if (!is_lunar_cache_valid()) {
-            ESP_LOGI(TAG, "启动农历批量获取任务...");
-            xTaskCreate(lunar_batch_task, "lunar_batch_task", 12288, NULL, 3, NULL);
-        }
-        
-        return ESP_OK;
-    } else {
-        ESP_LOGE(TAG, "在线获取农历日期失败");
-        if (lunar_date_label) {
-            lv_label_set_text(lunar_date_label, "农历获取失败");
-            lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
-        }
-        return ESP_FAIL;
+    lunar_calendar_format(&lunar, lunar_display, sizeof(lunar_display));
+    if (lunar_date_label) {
+        lv_label_set_text(lunar_date_label, lunar_display);
+        lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
     }
+    ESP_LOGI(TAG, "农历日期: %s", lunar_display);
+    return ESP_OK;
 }
 
 /* 获取认证模式字符串 */
@@ -1018,6 +437,47 @@ static void lv_tick_task(void *arg)
 /* WiFi状态更新任务已移至wifi_status_task.c */
 
 /* 时间更新任务 */
+static TaskHandle_t time_update_task_handle = NULL;
+
+/* 按时间服务的校时状态刷新同步图标 */
+static void update_sync_status_label(void)
+{
+    static time_sync_state_t shown_state = TIME_SYNC_STATE_NONE;
+    time_sync_info_t info;
+
+    time_service_get_sync_info(&info);
+    if (!sync_status_label || info.state == shown_state) {
+        return;
+    }
+    shown_state = info.state;
+
+    switch (info.state) {
+        case TIME_SYNC_STATE_SYNCED:
+            lv_label_set_text(sync_status_label, "✓");
+            lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0x00AA00), 0); // 绿色
+            break;
+        case TIME_SYNC_STATE_CHECKED:
+            lv_label_set_text(sync_status_label, "◐");
+            lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0x0000AA), 0); // 蓝色
+            break;
+        case TIME_SYNC_STATE_FAILED:
+            lv_label_set_text(sync_status_label, "✗");
+            lv_obj_set_style_text_color(sync_status_label, lv_color_hex(0xAA0000), 0); // 红色
+            break;
+        default:
+            lv_label_set_text(sync_status_label, "");
+            break;
+    }
+}
+
+/* 时间服务秒边沿回调：唤醒时间显示任务 */
+static void time_update_tick(void)
+{
+    if (time_update_task_handle) {
+        xTaskNotifyGive(time_update_task_handle);
+    }
+}
+
 static void time_update_task(void *arg)
 {
     ds3231_time_t time;
@@ -1025,8 +485,18 @@ static void time_update_task(void *arg)
     char date_str[128];  // 增加缓冲区大小以容纳字符
     char reminder_alert_str[128];
     
+    time_update_task_handle = xTaskGetCurrentTaskHandle();
+    time_service_register_tick(time_update_tick);
+    
     while (1) {
-        if (ds3231_get_time(&time) == ESP_OK) {
+        /* 在RTC秒边沿刷新显示，超时兜底防止秒中断丢失时界面停住 */
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1500));
+        
+        update_sync_status_label();
+        
+        if (time_service_get_time(&time) == ESP_OK) {
+            alarm_check_preload(&time);
+            
             /* 格式化时间字符串 - 支持12/24小时制 */
             if (use_24hour_format) {
                 snprintf(time_str, sizeof(time_str), "%02d:%02d:%02d", 
@@ -1063,38 +533,33 @@ static void time_update_task(void *arg)
                 lv_obj_set_style_text_font(date_label, &my_font_1, 0);
             }
             
+            /* 农历按日期刷新：开机第一秒即显示，之后只在跨天（含校时跨天）时重查 */
+            int64_t today = civil_days_from_date(time.year, time.month, time.date);
+            if (today != lunar_shown_day) {
+                get_lunar_date(&time);  // 超出表范围时当天不再重试
+                lunar_shown_day = today;
+            }
+            
             /* 检查是否有临近事件并更新桌面1提醒 */
             if (reminder_valid && reminder_datetime[0] != '\0' && strlen(reminder_datetime) >= 19) {
-                struct tm event_time = {0};
-                struct tm current_time = {0};
+                int ev_year = 0, ev_month = 0, ev_day = 0, ev_hour = 0, ev_min = 0, ev_sec = 0;
                 
-                // 解析提醒事件的时间
+                // 解析提醒事件的时间（与RTC同为本地时间）
                 sscanf(reminder_datetime, "%d-%d-%dT%d:%d:%d",
-                       &event_time.tm_year, &event_time.tm_mon, &event_time.tm_mday,
-                       &event_time.tm_hour, &event_time.tm_min, &event_time.tm_sec);
-                
-                // 转换为标准格式
-                event_time.tm_year -= 1900;   // 年份从1900年开始
-                event_time.tm_mon -= 1;       // 月份从0开始
-                
-                // 设置当前时间
-                current_time.tm_year = time.year - 1900;
-                current_time.tm_mon = time.month - 1;
-                current_time.tm_mday = time.date;
-                current_time.tm_hour = time.hour;
-                current_time.tm_min = time.minute;
-                current_time.tm_sec = time.second;
+                       &ev_year, &ev_month, &ev_day, &ev_hour, &ev_min, &ev_sec);
                 
                 // 计算时间差（秒）
-                time_t event_timestamp = mktime(&event_time);
-                time_t current_timestamp = mktime(&current_time);
-                double diff_seconds = difftime(event_timestamp, current_timestamp);
+                int64_t event_seconds = civil_days_from_date(ev_year, ev_month, ev_day) * CIVIL_SECONDS_PER_DAY +
+                                        ev_hour * 3600 + ev_min * 60 + ev_sec;
+                int64_t current_seconds = civil_days_from_date(time.year, time.month, time.date) * CIVIL_SECONDS_PER_DAY +
+                                          time.hour * 3600 + time.minute * 60 + time.second;
+                int64_t diff_seconds = event_seconds - current_seconds;
                 
                 // 如果事件在24小时内，在桌面1显示提醒
                 if (diff_seconds > 0 && diff_seconds <= 24 * 3600) {
                     // 计算剩余小时和分钟
                     int hours_left = (int)(diff_seconds / 3600);
-                    int minutes_left = (int)((diff_seconds - hours_left * 3600) / 60);
+                    int minutes_left = (int)((diff_seconds % 3600) / 60);
                     
                     if (hours_left > 0) {
                         snprintf(reminder_alert_str, sizeof(reminder_alert_str), 
@@ -1124,10 +589,8 @@ static void time_update_task(void *arg)
             
             ESP_LOGI(TAG, "Time: %s, Date: %s", time_str, date_str);
         } else {
-            ESP_LOGE(TAG, "Failed to get time from DS3231");
+            ESP_LOGE(TAG, "Failed to get time from time service");
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
 }
 
@@ -1179,9 +642,9 @@ static void update_timer_display(void)
             break;
             
         case TIMER_STATE_COUNTDOWN:
-            snprintf(display_str, sizeof(display_str), "倒计时中");
+            snprintf(display_str, sizeof(display_str), countdown_is_paused(timer_countdown_id) ? "已暂停" : "倒计时中");
             snprintf(status_str, sizeof(status_str), "%02d:%02d:%02d", countdown_hours, countdown_minutes, countdown_seconds);
-            snprintf(hint_str, sizeof(hint_str), "倒计时进行中...");
+            snprintf(hint_str, sizeof(hint_str), "旋转调整时长，按键停止");
             break;
             
         case TIMER_STATE_TIME_UP:
@@ -1214,51 +677,71 @@ static void update_timer_display(void)
     }
 }
 
+static void timer_set_countdown_fields(uint32_t remaining_s)
+{
+    countdown_hours = remaining_s / 3600;
+    countdown_minutes = (remaining_s % 3600) / 60;
+    countdown_seconds = remaining_s % 60;
+}
+
+/* 倒计时引擎回调（esp_timer任务中执行）：到期时立即启动震动和铃声，显示交给定时器任务 */
+static void timer_countdown_callback(int id, countdown_event_t event, uint32_t remaining_s, void *arg)
+{
+    timer_set_countdown_fields(remaining_s);
+    
+    if (event == COUNTDOWN_EVENT_EXPIRED) {
+        // 时间到
+        timer_running = false;
+        timer_state = TIMER_STATE_TIME_UP;
+        ESP_LOGI(TAG, "Timer finished!");
+        
+        // 启动震动
+        start_vibration();
+        
+        // 播放定时器结束铃声（异步）
+        // 创建任务异步播放音频，避免阻塞esp_timer任务
+        xTaskCreate(timer_audio_task, "timer_audio", 4096, NULL, 3, NULL);
+    }
+    
+    if (timer_display_task_handle) {
+        xTaskNotifyGive(timer_display_task_handle);
+    }
+}
+
+/* 定时器显示任务：只在倒计时的秒边沿被唤醒刷新显示 */
 static void timer_countdown_task(void *arg)
 {
+    timer_display_task_handle = xTaskGetCurrentTaskHandle();
+    timer_countdown_id = countdown_create(timer_countdown_callback, NULL);
+    if (timer_countdown_id < 0) {
+        ESP_LOGE(TAG, "倒计时引擎初始化失败");
+    }
+    
     while (1) {
-        if (timer_running && timer_state == TIMER_STATE_COUNTDOWN) {
-            TickType_t current_tick = xTaskGetTickCount();
-            TickType_t elapsed_ticks = current_tick - timer_start_tick;
-            int elapsed_seconds = elapsed_ticks / portTICK_PERIOD_MS / 1000;
-            
-            int total_seconds = timer_hours * 3600 + timer_minutes * 60 + timer_seconds;
-            int remaining_seconds = total_seconds - elapsed_seconds;
-            
-            if (remaining_seconds <= 0) {
-                // 时间到
-                timer_running = false;
-                timer_state = TIMER_STATE_TIME_UP;
-                countdown_hours = 0;
-                countdown_minutes = 0; 
-                countdown_seconds = 0;
-                ESP_LOGI(TAG, "Timer finished!");
-                
-                // 立即更新显示为TIME UP状态
-                if (current_desktop == 1) {
-                    update_timer_display();
-                }
-                
-                // 启动震动
-                start_vibration();
-                
-                // 播放定时器结束铃声（异步）
-                ESP_LOGI(TAG, "播放定时器结束铃声");
-                // 创建任务异步播放音频，避免阻塞定时器任务
-                xTaskCreate(timer_audio_task, "timer_audio", 4096, NULL, 3, NULL);
-            } else {
-                countdown_hours = remaining_seconds / 3600;
-                countdown_minutes = (remaining_seconds % 3600) / 60;
-                countdown_seconds = remaining_seconds % 60;
-                
-                // 只有在桌面2时才更新显示
-                if (current_desktop == 1) {
-                    update_timer_display();
-                }
-            }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        // 只有在桌面2时才更新显示
+        if (current_desktop == 1) {
+            update_timer_display();
         }
         
-        vTaskDelay(pdMS_TO_TICKS(1000)); // 每秒更新一次
+        if (timer_state == TIMER_STATE_TIME_UP && !timer_running) {
+            web_server_update_timer_status(0, 0, 0, false);
+        }
+    }
+}
+
+/* 按设定时长启动倒计时 */
+static void timer_start_countdown(void)
+{
+    uint64_t duration_us = (uint64_t)(timer_hours * 3600 + timer_minutes * 60 + timer_seconds) * 1000000ULL;
+    timer_state = TIMER_STATE_COUNTDOWN;
+    countdown_hours = timer_hours;
+    countdown_minutes = timer_minutes;
+    countdown_seconds = timer_seconds;
+    timer_running = (countdown_start(timer_countdown_id, duration_us) == ESP_OK);
+    if (!timer_running) {
+        timer_state = TIMER_STATE_MAIN;
     }
 }
 
@@ -1293,12 +776,7 @@ static void handle_timer_button_press(void)
             // 开始倒计时
             if (timer_hours > 0 || timer_minutes > 0 || timer_seconds > 0) {
                 ESP_LOGI(TAG, "倒计时开始: %02d:%02d:%02d", timer_hours, timer_minutes, timer_seconds);
-                timer_state = TIMER_STATE_COUNTDOWN;
-                countdown_hours = timer_hours;
-                countdown_minutes = timer_minutes;
-                countdown_seconds = timer_seconds;
-                timer_running = true;
-                timer_start_tick = xTaskGetTickCount();
+                timer_start_countdown();
                 
                 // 更新Web服务器定时器状态
                 web_server_update_timer_status(countdown_hours, countdown_minutes, countdown_seconds, timer_running);
@@ -1310,6 +788,7 @@ static void handle_timer_button_press(void)
             
         case TIMER_STATE_COUNTDOWN:
             // 停止倒计时，回到主界面
+            countdown_stop(timer_countdown_id);
             timer_running = false;
             timer_state = TIMER_STATE_MAIN;
             
@@ -1343,6 +822,17 @@ static void handle_timer_rotation(ec11_rotate_t rotate)
             max_value = 59;
             break;
             
+        case TIMER_STATE_COUNTDOWN:
+            // 倒计时中旋转延长/缩短时长，缩短到0时立即到期
+            countdown_extend(timer_countdown_id,
+                             rotate == EC11_ROTATE_RIGHT ? TIMER_EXTEND_STEP_US : -TIMER_EXTEND_STEP_US);
+            if (timer_state == TIMER_STATE_COUNTDOWN) {
+                timer_set_countdown_fields(countdown_remaining_s(timer_countdown_id));
+                update_timer_display();
+                web_server_update_timer_status(countdown_hours, countdown_minutes, countdown_seconds, timer_running);
+            }
+            return;
+            
         default:
             return; // 其他状态不处理旋转
     }
@@ -1489,30 +979,148 @@ static void update_alarm_display(void)
     }
 }
 
+/* 闹钟响铃：启动震动和铃声 */
+static void alarm_trigger_ring(void)
+{
+    alarm_ringing = true;
+    alarm_state = ALARM_STATE_RINGING;
+    ESP_LOGI(TAG, "闹钟响铃！时间: %02d:%02d", alarm_hours, alarm_minutes);
+    
+    // 启动震动
+    start_vibration();
+    
+    // 播放闹钟铃声（异步）
+    ESP_LOGI(TAG, "播放闹钟铃声");
+    // 创建任务异步播放音频，避免阻塞闹钟任务
+    xTaskCreate(alarm_audio_task, "alarm_audio", 4096, NULL, 3, NULL);
+    
+    /* 只有在桌面3时才更新显示 */
+    if (current_desktop == 2) {
+        update_alarm_display();
+    }
+}
+
+/* 响铃前预加载WAV铃声，响铃时直接写入I2S */
+static void alarm_preload_ringtone(void)
+{
+    if (selected_ringtone != RINGTONE_WAV_FILE || alarm_preloaded) {
+        return;
+    }
+    portENTER_CRITICAL(&alarm_preload_lock);
+    uint32_t gen = alarm_preload_gen;
+    portEXIT_CRITICAL(&alarm_preload_lock);
+
+    wav_file_t wav = {0};
+    if (audio_prepare_wav_file("ring.wav", system_volume, &wav) != ESP_OK) {
+        return;
+    }
+    /* 加载期间设置已变化则丢弃，避免按旧设置响铃 */
+    portENTER_CRITICAL(&alarm_preload_lock);
+    bool stale = gen != alarm_preload_gen || alarm_preloaded;
+    if (!stale) {
+        alarm_preloaded_wav = wav;
+        alarm_preloaded = true;
+    }
+    portEXIT_CRITICAL(&alarm_preload_lock);
+
+    if (stale) {
+        audio_free_wav_file(&wav);
+    } else {
+        ESP_LOGI(TAG, "闹钟铃声已预加载");
+    }
+}
+
+/* 取走预加载的铃声，之后由调用者负责释放 */
+static bool alarm_take_preload(wav_file_t *wav)
+{
+    portENTER_CRITICAL(&alarm_preload_lock);
+    bool taken = alarm_preloaded;
+    if (taken) {
+        *wav = alarm_preloaded_wav;
+        alarm_preloaded_wav = (wav_file_t){0};
+        alarm_preloaded = false;
+    }
+    portEXIT_CRITICAL(&alarm_preload_lock);
+    return taken;
+}
+
+/* 闹钟时间、开关或铃声变化时释放预加载的铃声（约184KB PSRAM），到点前重新预加载 */
+static void alarm_drop_preload(void)
+{
+    portENTER_CRITICAL(&alarm_preload_lock);
+    alarm_preload_gen++;
+    portEXIT_CRITICAL(&alarm_preload_lock);
+
+    wav_file_t wav;
+    if (alarm_take_preload(&wav)) {
+        audio_free_wav_file(&wav);
+        ESP_LOGI(TAG, "闹钟设置已变化，释放预加载的铃声");
+    }
+}
+
+static void alarm_preload_task(void *arg)
+{
+    alarm_preload_ringtone();
+    vTaskDelete(NULL);
+}
+
+/* 每秒检查是否到达预加载时间，加载WAV较慢，放到单独任务中执行 */
+static void alarm_check_preload(const ds3231_time_t *now)
+{
+    if (!alarm_enabled || alarm_ringing || alarm_preloaded) {
+        return;
+    }
+    int preload = (alarm_hours * 3600 + alarm_minutes * 60 - ALARM_PRELOAD_SECONDS + 86400) % 86400;
+    if (now->hour * 3600 + now->minute * 60 + now->second == preload) {
+        xTaskCreate(alarm_preload_task, "alarm_preload", 4096, NULL, 3, NULL);
+    }
+}
+
+/* DS3231闹钟2中断回调（驱动任务上下文） */
+static void alarm_hw_callback(uint8_t alarm, int64_t int_time_us)
+{
+    if (!alarm_enabled || alarm_ringing) {
+        return;
+    }
+    alarm_trigger_ring();
+}
+
+/* 根据当前闹钟设置重新编程DS3231闹钟寄存器 */
+static void alarm_rearm(void)
+{
+    alarm_drop_preload();
+    if (!alarm_hw_irq) {
+        return;
+    }
+
+    if (!alarm_enabled) {
+        ds3231_set_alarm_enabled(DS3231_ALARM2, false);
+        return;
+    }
+
+    if (ds3231_set_alarm2(alarm_hours, alarm_minutes) != ESP_OK) {
+        ESP_LOGE(TAG, "DS3231闹钟编程失败");
+        return;
+    }
+    ds3231_clear_alarm_flags(DS3231_ALARM2);
+    ds3231_set_alarm_enabled(DS3231_ALARM2, true);
+    ESP_LOGI(TAG, "DS3231硬件闹钟已设置: %02d:%02d", alarm_hours, alarm_minutes);
+}
+
+/* INT引脚不可用时的软件轮询回退；引脚在运行中被判定为未接线时从硬件闹钟切换过来 */
 static void alarm_check_task(void *arg)
 {
     while (1) {
-        if (alarm_enabled && !alarm_ringing) {
+        if (alarm_hw_irq && !ds3231_alarm_int_available()) {
+            alarm_hw_irq = false;
+            ESP_LOGW(TAG, "DS3231 INT引脚无中断，闹钟改为软件轮询");
+        }
+        if (!alarm_hw_irq && alarm_enabled && !alarm_ringing) {
             ds3231_time_t current_time;
-            if (ds3231_get_time(&current_time) == ESP_OK) {
+            if (time_service_get_time(&current_time) == ESP_OK) {
                 /* 检查是否到达闹钟时间 */
                 if (current_time.hour == alarm_hours && current_time.minute == alarm_minutes) {
-                    alarm_ringing = true;
-                    alarm_state = ALARM_STATE_RINGING;
-                    ESP_LOGI(TAG, "闹钟响铃！时间: %02d:%02d", alarm_hours, alarm_minutes);
-                    
-                    // 启动震动
-                    start_vibration();
-                    
-                    // 播放闹钟铃声（异步）
-                    ESP_LOGI(TAG, "播放闹钟铃声");
-                    // 创建任务异步播放音频，避免阻塞闹钟任务
-                    xTaskCreate(alarm_audio_task, "alarm_audio", 4096, NULL, 3, NULL);
-                    
-                    /* 只有在桌面3时才更新显示 */
-                    if (current_desktop == 2) {
-                        update_alarm_display();
-                    }
+                    alarm_trigger_ring();
                 }
             }
         }
@@ -1556,6 +1164,7 @@ static void handle_alarm_button_press(void)
             alarm_ringing = false;
             alarm_state = ALARM_STATE_ALARM_SET;
             ESP_LOGI(TAG, "闹钟设置完成: %02d:%02d", alarm_hours, alarm_minutes);
+            alarm_rearm();
             
             /* 更新Web服务器闹钟状态 */
             web_server_update_alarm_status(alarm_hours, alarm_minutes, alarm_enabled);
@@ -1566,6 +1175,7 @@ static void handle_alarm_button_press(void)
             alarm_enabled = false;
             alarm_state = ALARM_STATE_MAIN;
             ESP_LOGI(TAG, "闹钟已关闭");
+            alarm_rearm();
             
             /* 更新Web服务器闹钟状态 */
             web_server_update_alarm_status(alarm_hours, alarm_minutes, alarm_enabled);
@@ -1577,6 +1187,7 @@ static void handle_alarm_button_press(void)
             alarm_enabled = false;  // 闹钟响过后自动关闭
             alarm_state = ALARM_STATE_MAIN;
             ESP_LOGI(TAG, "闹钟已关闭");
+            alarm_rearm();
             
             /* 更新Web服务器闹钟状态 */
             web_server_update_alarm_status(alarm_hours, alarm_minutes, alarm_enabled);
@@ -2031,7 +1642,7 @@ static void handle_setting_button_press_delayed(void)
             setting_state = SETTING_STATE_MENU;
             // 从当前时间初始化设置值
             ds3231_time_t current_time;
-            if (ds3231_get_time(&current_time) == ESP_OK) {
+            if (time_service_get_time(&current_time) == ESP_OK) {
                 setting_year = current_time.year;
                 setting_month = current_time.month;
                 setting_day = current_time.date;
@@ -2119,13 +1730,10 @@ static void handle_setting_button_press_delayed(void)
                 new_time.minute = setting_minute;
                 new_time.second = setting_second;
                 
-                // 计算星期几 (简化算法)
-                int day_of_week = (setting_day + ((13 * (setting_month + 1)) / 5) + 
-                                 setting_year + (setting_year / 4) - (setting_year / 100) + 
-                                 (setting_year / 400)) % 7;
-                new_time.day_of_week = (day_of_week == 0) ? 7 : day_of_week;
+                // 计算星期几
+                new_time.day_of_week = civil_weekday(civil_days_from_date(setting_year, setting_month, setting_day));
                 
-                if (ds3231_set_time(&new_time) == ESP_OK) {
+                if (time_service_set_time(&new_time) == ESP_OK) {
                     ESP_LOGI(TAG, "时间设置成功: %04d-%02d-%02d %02d:%02d:%02d", 
                             setting_year, setting_month, setting_day,
                             setting_hour, setting_minute, setting_second);
@@ -2379,7 +1987,7 @@ static void handle_setting_button_press(void)
         setting_state = SETTING_STATE_MENU;
         // 从当前时间初始化设置值
         ds3231_time_t current_time_val;
-        if (ds3231_get_time(&current_time_val) == ESP_OK) {
+        if (time_service_get_time(&current_time_val) == ESP_OK) {
             setting_year = current_time_val.year;
             setting_month = current_time_val.month;
             setting_day = current_time_val.date;
@@ -2431,6 +2039,7 @@ static void handle_setting_rotation(ec11_rotate_t rotate)
         case SETTING_STATE_NETWORK_TIME:
             // 旋转切换网络时间设置
             use_network_time = !use_network_time;
+            time_service_set_network_enabled(use_network_time);
             update_setting_display();
             ESP_LOGI(TAG, "网络时间设置切换为: %s", use_network_time ? "开启" : "关闭");
             break;
@@ -2444,8 +2053,9 @@ static void handle_setting_rotation(ec11_rotate_t rotate)
                 system_volume += 5;
                 if (system_volume > 100) system_volume = 100;
             }
-            // 应用音量设置并播放测试音效
+            // 应用音量设置并播放测试音效；预加载的铃声按旧音量缩放过，需重新加载
             audio_player_set_volume(system_volume);
+            alarm_drop_preload();
             audio_player_play_pcm(beep_sound_data, beep_sound_size);
             update_setting_display();
             ESP_LOGI(TAG, "音量调节为: %d%%", system_volume);
@@ -2454,6 +2064,7 @@ static void handle_setting_rotation(ec11_rotate_t rotate)
         case SETTING_STATE_RINGTONE:
             // 旋转切换铃声类型
             selected_ringtone = (selected_ringtone == RINGTONE_WAV_FILE) ? RINGTONE_BUILTIN_TONE : RINGTONE_WAV_FILE;
+            alarm_drop_preload();
             update_setting_display();
             
             // 播放选中的铃声预览（短暂播放）
@@ -2608,42 +2219,64 @@ static void handle_forecast_button_press(void)
     /* 播放按键音效 */
     audio_player_play_pcm(beep_sound_data, beep_sound_size);
     
-    // 桌面4只有文字显示，无需控制模式
-    ESP_LOGI(TAG, "桌面4: 天气预报显示");
+    /* 翻到下一个关注的城市，数据取自已有快照 */
+    if (weather_city_count > 1) {
+        forecast_page = (forecast_page + 1) % weather_city_count;
+        update_forecast_display();
+    }
+    ESP_LOGI(TAG, "桌面4: 天气预报显示 %d/%d", forecast_page + 1, weather_city_count);
 }
 
 
 
+/* 显示forecast_page对应城市的预报，只读weather_api中的快照，不触发请求 */
 static void update_forecast_display(void)
 {
-    if (!forecast_updated || !forecast_display_label) {
+    if (!forecast_display_label) {
+        return;
+    }
+    if (forecast_page >= weather_city_count) {
+        forecast_page = 0;
+    }
+    if (weather_api_get_report(forecast_page, &forecast_report) != ESP_OK) {
         return;
     }
     
     char display_text[1024];
     int pos = 0;
     
-    // 添加城市信息
-    pos += snprintf(display_text + pos, sizeof(display_text) - pos, 
-                   "%s天气预报\n\n", forecast_city);
+    // 添加城市信息，多个城市时附上页码
+    const char *city_name = weather_cities[forecast_page].name[0] != '\0' ?
+                            weather_cities[forecast_page].name : forecast_report.city;
+    pos += snprintf(display_text + pos, sizeof(display_text) - pos, "%s天气预报", city_name);
+    if (weather_city_count > 1) {
+        pos += snprintf(display_text + pos, sizeof(display_text) - pos, " %d/%d",
+                        forecast_page + 1, weather_city_count);
+    }
+    pos += snprintf(display_text + pos, sizeof(display_text) - pos, "\n\n");
+    if (!forecast_report.forecast_valid) {
+        snprintf(display_text + pos, sizeof(display_text) - pos, "正在获取天气预报...");
+        lv_label_set_text(forecast_display_label, display_text);
+        return;
+    }
     
     // 显示预报数据（改用纵向卡片式布局，避免对齐问题）
-    for (int i = 0; i < 3 && i < 4; i++) {
-        if (strlen(forecast_data[i].date) > 0) {
-            // 提取月日信息
-            char month_day[8] = "";
-            if (strlen(forecast_data[i].date) >= 10) {
-                snprintf(month_day, sizeof(month_day), "%.2s/%.2s", 
-                        forecast_data[i].date + 5, forecast_data[i].date + 8);
-            }
+    for (int i = 0; i < 3 && i < forecast_report.cast_count; i++) {
+        const weather_forecast_t *cast = &forecast_report.casts[i];
+        if (cast->date > 0) {
+            // 月日与星期由日期算出
+            int year, month, day;
+            civil_date_from_days(cast->date, &year, &month, &day);
+            char power[8];
+            weather_power_format(cast->daypower, power, sizeof(power));
             
             // 卡片式显示格式
             pos += snprintf(display_text + pos, sizeof(display_text) - pos,
-                          "%s %s\n%s %s~%s° %s%s级\n",
-                          month_day, forecast_data[i].week,
-                          forecast_data[i].dayweather,
-                          forecast_data[i].nighttemp, forecast_data[i].daytemp,
-                          forecast_data[i].daywind, forecast_data[i].daypower);
+                          "%02d/%02d %d\n%s %d~%d° %s%s级\n",
+                          month, day, civil_weekday(cast->date),
+                          weather_code_name(cast->dayweather),
+                          cast->nighttemp, cast->daytemp,
+                          weather_wind_name(cast->daywind), power);
             
             // 添加分隔线（除了最后一天）
             if (i < 2) {
@@ -3063,7 +2696,7 @@ static void init_time_if_needed(void)
     ds3231_time_t time;
     
     /* 尝试读取时间，只有在读取失败或时间明显不合理时才设置初始时间 */
-    if (ds3231_get_time(&time) != ESP_OK) {
+    if (time_service_get_time(&time) != ESP_OK) {
         ESP_LOGW(TAG, "DS3231读取失败，可能电池没电，设置初始时间...");
         
         /* 设置初始时间为 2024年12月25日 12:00:00 周三 */
@@ -3075,7 +2708,7 @@ static void init_time_if_needed(void)
         time.minute = 0;
         time.second = 0;
         
-        if (ds3231_set_time(&time) == ESP_OK) {
+        if (time_service_set_time(&time) == ESP_OK) {
             ESP_LOGI(TAG, "Initial time set successfully");
         } else {
             ESP_LOGE(TAG, "Failed to set initial time");
@@ -3099,7 +2732,7 @@ static void init_time_if_needed(void)
             time.minute = 0;
             time.second = 0;
             
-            if (ds3231_set_time(&time) == ESP_OK) {
+            if (time_service_set_time(&time) == ESP_OK) {
                 ESP_LOGI(TAG, "时间重置成功");
             } else {
                 ESP_LOGE(TAG, "时间重置失败");
@@ -3124,12 +2757,109 @@ static void wifi_connect_task(void *arg)
     vTaskDelete(NULL);  // 删除当前任务
 }
 
-/* 天气信息更新任务 */
-static void weather_update_task(void *arg)
+/* 天气刷新请求，在网络服务的后台工作任务中执行 */
+static esp_err_t weather_refresh_request(void *arg)
 {
-    weather_info_t weather_info;
-    char weather_str[256];
+    const weather_city_t *city = arg;
+    return weather_api_refresh(city->adcode, weather_request.include_forecast);
+}
+
+/* 天气刷新完成（含重试用尽），更新显示 */
+static void weather_refresh_done(esp_err_t ret, void *ctx)
+{
+    const weather_city_t *city = ctx;
+    
+    /* 如果桌面4正在显示该城市，更新显示 */
+    if (current_desktop == 3 && forecast_page < weather_city_count &&
+        strcmp(weather_cities[forecast_page].adcode, city->adcode) == 0) {
+        update_forecast_display();
+    }
     
+    /* 其他城市只在桌面4显示 */
+    if (strcmp(weather_home_adcode, city->adcode) != 0) {
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "%s 天气刷新失败: %s", city->name, esp_err_to_name(ret));
+        }
+        weather_refresh_pending = false;
+        return;
+    }
+    
+    bool had_forecast = weather_report.forecast_valid;
+    int64_t prev_live_us = weather_report.live_updated_us;
+    int64_t prev_forecast_us = weather_report.forecast_updated_us;
+    weather_api_get_report(0, &weather_report);
+    
+    if (weather_report.forecast_updated_us != prev_forecast_us) {
+        ESP_LOGI(TAG, "天气预报%s", had_forecast ? "已更新" : "首次获取成功");
+    }
+    
+    if (weather_report.live_updated_us != prev_live_us) {
+        show_live_weather();
+        ESP_LOGI(TAG, "Weather updated: %s %d°C", weather_code_name(weather_report.live.weather),
+                 weather_report.live.temperature);
+    } else {
+        ESP_LOGE(TAG, "Failed to get weather info: %s", esp_err_to_name(ret));
+        
+        /* 仍有近期数据（含开机快照）时继续显示，否则显示具体的错误信息 */
+        if (weather_live_recent()) {
+            show_live_weather();
+        } else if (weather_label) {
+            if (ret == ESP_ERR_WIFI_NOT_CONNECT) {
+                lv_label_set_text(weather_label, "等待连接");
+            } else {
+                lv_label_set_text(weather_label, "连接失败");
+            }
+            lv_obj_set_style_text_font(weather_label, &my_font_1, 0);
+            lv_obj_set_style_text_color(weather_label, lv_color_black(), 0);
+        }
+    }
+    
+    weather_refresh_pending = false;
+}
+
+/* 闹钟即将响铃且本窗口内还没有刷新过时预取一次 */
+static bool weather_alarm_prefetch_due(void)
+{
+    ds3231_time_t now;
+    if (!alarm_enabled || time_service_get_time(&now) != ESP_OK) {
+        return false;
+    }
+    int to_alarm = (alarm_hours * 3600 + alarm_minutes * 60 -
+                    (now.hour * 3600 + now.minute * 60 + now.second) + 86400) % 86400;
+    if (to_alarm == 0 || to_alarm > WEATHER_ALARM_PREFETCH_S) {
+        return false;
+    }
+    return esp_timer_get_time() - last_home_attempt_us > WEATHER_ALARM_PREFETCH_S * 1000000LL;
+}
+
+/* 本地城市（关注列表第一个）变化时重新载入桌面1；开机时即为NVS中的快照，不等WiFi */
+static void weather_sync_home(void)
+{
+    weather_city_count = weather_api_get_cities(weather_cities, WEATHER_MAX_CITIES);
+    if (weather_city_count == 0 || strcmp(weather_home_adcode, weather_cities[0].adcode) == 0) {
+        return;
+    }
+    snprintf(weather_home_adcode, sizeof(weather_home_adcode), "%s", weather_cities[0].adcode);
+    weather_api_get_report(0, &weather_report);
+    if (weather_report.live_valid) {
+        show_live_weather();
+    } else if (weather_label) {
+        lv_label_set_text(weather_label, "等待连接");
+        lv_obj_set_style_text_font(weather_label, &my_font_1, 0);
+        lv_obj_set_style_text_color(weather_label, lv_color_black(), 0);
+    }
+    if (current_desktop == 3) {
+        update_forecast_display();
+    }
+}
+
+/*
+ * 天气信息更新任务：到期时向网络服务提交刷新请求，结果在weather_refresh_done中处理。
+ * 到期时间由weather_api按reporttime逐个城市推算，上游未更新时退避；闹钟前额外预取一次本地城市。
+ * 每次只提交一个城市，相邻请求至少间隔WEATHER_CITY_STAGGER_S，多个城市同时到期也依次错开。
+ */
+static void weather_update_task(void *arg)
+{
     /* 初始化天气API */
     esp_err_t ret = weather_api_init();
     if (ret != ESP_OK) {
@@ -3141,135 +2871,67 @@ static void weather_update_task(void *arg)
     ESP_LOGI(TAG, "Weather API initialized successfully");
     
     while (1) {
+        /* 城市列表可能已通过网页修改；首次进入时显示上次保存的快照 */
+        weather_sync_home();
+        
         /* 检查WiFi连接状态 */
         wifi_status_t wifi_status = wifi_get_status();
         if (wifi_status == WIFI_STATUS_CONNECTED) {
             
-            /* 首次连接或定时同步网络时间（仅在启用网络时间时执行） */
-            if (use_network_time && (!time_synced || 
-                (xTaskGetTickCount() - last_time_sync) >= pdMS_TO_TICKS(TIME_SYNC_INTERVAL_MS))) {
-                ESP_LOGI(TAG, "执行网络时间同步...");
-                esp_err_t sync_result = sync_time_from_network();
-                if (sync_result == ESP_OK) {
-                    ESP_LOGI(TAG, "网络时间同步成功");
+            /* 检查是否到了天气更新时间，与上一次请求错开 */
+            int64_t now_us = esp_timer_get_time();
+            bool staggered = last_weather_attempt_us == 0 ||
+                             now_us - last_weather_attempt_us >= WEATHER_CITY_STAGGER_S * 1000000LL;
+            if (!weather_refresh_pending && staggered && weather_city_count > 0) {
+                /* 实况每轮刷新（未到期时由响应缓存直接给出），预报到期时在同一连接上一起取回 */
+                weather_city_t city;
+                bool include_forecast = false;
+                bool prefetch = weather_alarm_prefetch_due();
+                bool due = prefetch;
+                if (prefetch) {
+                    city = weather_cities[0];
+                    include_forecast = true;
                 } else {
-                    ESP_LOGE(TAG, "网络时间同步失败");
+                    due = weather_api_next_due(now_us, &city, &include_forecast);
                 }
-            } else if (!use_network_time) {
-                ESP_LOGI(TAG, "网络时间同步已禁用，跳过同步");
-            }
-            
-            /* 检查是否到了天气更新时间 */
-            if ((xTaskGetTickCount() - last_weather_update) >= pdMS_TO_TICKS(WEATHER_UPDATE_INTERVAL_MS)) {
-                ESP_LOGI(TAG, "Updating weather information...");
                 
-                /* 获取即墨天气信息 (城市编码: 370215) */
-                ret = weather_api_get_weather("370215", &weather_info);
-                if (ret == ESP_OK) {
-                    /* 格式化天气信息显示 - 只使用字库中有的字 */
-                    snprintf(weather_str, sizeof(weather_str), 
-                            "即墨 %s %s°C", 
-                            weather_info.weather, 
-                            weather_info.temperature);
+                if (due) {
+                    ESP_LOGI(TAG, "Updating weather information: %s%s...", city.name,
+                             prefetch ? " (alarm prefetch)" : "");
+                    weather_request.city = city;
+                    weather_request.include_forecast = include_forecast;
                     
-                    /* 更新天气缓存 */
-                    update_weather_cache(weather_str);
-                    
-                    /* 更新天气显示 */
-                    if (weather_label) {
-                        lv_label_set_text(weather_label, weather_str);
-                        /* 使用新字体 */
-                        lv_obj_set_style_text_font(weather_label, &my_font_1, 0);
+                    net_request_t request = {
+                        .key = "weather",
+                        .host = WEATHER_API_HOST,
+                        .priority = NET_PRIORITY_WEATHER,
+                        .run = weather_refresh_request,
+                        .arg = &weather_request.city,
+                        .done = weather_refresh_done,
+                        .done_ctx = &weather_request.city,
+                        .max_attempts = 3,
+                        .backoff_ms = 2000,
+                    };
+                    weather_refresh_pending = true;
+                    last_weather_attempt_us = now_us;
+                    if (strcmp(city.adcode, weather_home_adcode) == 0) {
+                        last_home_attempt_us = now_us;
                     }
-                    
-                    ESP_LOGI(TAG, "Weather updated: %s", weather_str);
-                    last_weather_update = xTaskGetTickCount();
-                } else {
-                    ESP_LOGE(TAG, "Failed to get weather info: %s", esp_err_to_name(ret));
-                    
-                    /* 显示具体的错误信息 */
-                    if (weather_label) {
-                        if (ret == ESP_ERR_WIFI_NOT_CONNECT) {
-                            lv_label_set_text(weather_label, "等待连接");
-                        } else {
-                            lv_label_set_text(weather_label, "连接失败");
-                        }
-                        lv_obj_set_style_text_font(weather_label, &my_font_1, 0);
+                    if (net_service_submit(&request) != ESP_OK) {
+                        weather_refresh_pending = false;    // 队列已满，下个周期再试
                     }
                 }
             }
-            
-            /* 检查是否到了农历更新时间（首次连接立即更新，之后按间隔更新） */
-            if (!lunar_first_update || 
-                (xTaskGetTickCount() - last_lunar_update) >= pdMS_TO_TICKS(LUNAR_UPDATE_INTERVAL_MS)) {
-                ESP_LOGI(TAG, "Updating lunar date information...");
-                
-                /* 获取农历日期信息 */
-                esp_err_t lunar_ret = get_lunar_date();
-                if (lunar_ret == ESP_OK) {
-                    ESP_LOGI(TAG, "Lunar date updated successfully");
-                    lunar_first_update = true;  // 标记已完成首次更新
-                } else {
-                    ESP_LOGE(TAG, "Failed to update lunar date: %s", esp_err_to_name(lunar_ret));
-                }
-            }
         } else {
-            ESP_LOGW(TAG, "WiFi not connected, skipping weather and time sync");
+            ESP_LOGW(TAG, "WiFi not connected, skipping weather update");
             
-            /* 显示WiFi未连接状态或缓存的天气信息 */
-            if (weather_label) {
-                if (is_weather_cache_valid()) {
-                    /* 使用缓存的天气信息 */
-                    lv_label_set_text(weather_label, get_cached_weather());
-                    ESP_LOGI(TAG, "显示缓存天气信息: %s", get_cached_weather());
-                } else {
-                    /* 无缓存或缓存过期，显示等待连接 */
-                    lv_label_set_text(weather_label, "等待连接");
-                }
+            /* 显示近期的天气信息，无数据或已过期时显示等待连接 */
+            if (weather_live_recent()) {
+                show_live_weather();
+            } else if (weather_label) {
+                lv_label_set_text(weather_label, "等待连接");
                 lv_obj_set_style_text_font(weather_label, &my_font_1, 0);
-            }
-            /* 检查农历缓存，如果有有效缓存就使用，否则显示等待连接 */
-            ds3231_time_t current_time;
-            if (ds3231_get_time(&current_time) == ESP_OK) {
-                char cached_lunar[64];
-                if (get_lunar_from_cache(current_time.year, current_time.month, current_time.date, 
-                                       cached_lunar, sizeof(cached_lunar))) {
-                    /* 使用缓存的农历信息 */
-                    if (lunar_date_label) {
-                        lv_label_set_text(lunar_date_label, cached_lunar);
-                        lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
-                    }
-                    ESP_LOGI(TAG, "显示缓存农历信息: %s", cached_lunar);
-                } else {
-                    /* 无缓存或缓存过期 */
-                    if (lunar_date_label) {
-                        lv_label_set_text(lunar_date_label, "农历等待连接");
-                        lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
-                    }
-                }
-            } else {
-                if (lunar_date_label) {
-                    lv_label_set_text(lunar_date_label, "农历等待连接");
-                    lv_obj_set_style_text_font(lunar_date_label, &my_font_1, 0);
-                }
-            }
-            
-            /* 重置时间同步标志，WiFi重连后重新同步 */
-            if (time_synced) {
-                time_synced = false;
-                ESP_LOGI(TAG, "WiFi断连，重置时间同步标志");
-            }
-            
-            /* 即使WiFi断开，也要定期检查农历缓存 */
-            if ((xTaskGetTickCount() - last_lunar_update) >= pdMS_TO_TICKS(60000)) { // 每分钟检查一次
-                ESP_LOGI(TAG, "WiFi断开状态下检查农历缓存...");
-                esp_err_t lunar_ret = get_lunar_date();
-                if (lunar_ret == ESP_OK) {
-                    ESP_LOGI(TAG, "成功从缓存获取农历信息");
-                } else {
-                    ESP_LOGI(TAG, "缓存中无有效农历信息");
-                }
-                last_lunar_update = xTaskGetTickCount();
+                lv_obj_set_style_text_color(weather_label, lv_color_black(), 0);
             }
         }
         
@@ -3277,180 +2939,6 @@ static void weather_update_task(void *arg)
     }
 }
 
-static esp_err_t get_weather_forecast(void)
-{
-    /* 检查WiFi连接状态 */
-    wifi_status_t wifi_status = wifi_get_status();
-    if (wifi_status != WIFI_STATUS_CONNECTED) {
-        ESP_LOGW(TAG, "WiFi未连接，跳过天气预报获取");
-        return ESP_FAIL;
-    }
-
-    char url[512];
-    snprintf(url, sizeof(url), 
-        "http://restapi.amap.com/v3/weather/weatherInfo?key=%s&city=370215&extensions=all&output=json", WEATHER_API_KEY);
-
-    ESP_LOGI(TAG, "天气预报请求URL: %s", url);
-
-    esp_http_client_config_t config = {
-        .url = url,
-        .event_handler = http_event_handler,
-        .buffer_size = 8192,
-        .timeout_ms = 10000,
-    };
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client for forecast");
-        return ESP_FAIL;
-    }
-
-    http_response_t response = {0};
-    esp_http_client_set_user_data(client, &response);
-
-    ESP_LOGI(TAG, "开始执行天气预报HTTP请求...");
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        ESP_LOGI(TAG, "天气预报HTTP GET Status = %d, content_length = %lld",
-                status_code, esp_http_client_get_content_length(client));
-        
-        if (status_code == 200 && response.data) {
-            ESP_LOGI(TAG, "天气预报响应数据长度: %d", response.len);
-            ESP_LOGI(TAG, "天气预报响应: %s", response.data);
-            
-            cJSON *json = cJSON_Parse(response.data);
-            if (json) {
-                cJSON *status = cJSON_GetObjectItem(json, "status");
-                if (status && cJSON_IsString(status) && strcmp(status->valuestring, "1") == 0) {
-                    cJSON *forecasts = cJSON_GetObjectItem(json, "forecasts");
-                    if (forecasts && cJSON_IsArray(forecasts)) {
-                        cJSON *forecast = cJSON_GetArrayItem(forecasts, 0);
-                        if (forecast) {
-                            // 获取城市和更新时间
-                            cJSON *city = cJSON_GetObjectItem(forecast, "city");
-                            cJSON *reporttime = cJSON_GetObjectItem(forecast, "reporttime");
-                            
-                            if (city && cJSON_IsString(city)) {
-                                strncpy(forecast_city, city->valuestring, sizeof(forecast_city) - 1);
-                            }
-                            if (reporttime && cJSON_IsString(reporttime)) {
-                                strncpy(forecast_update_time, reporttime->valuestring, sizeof(forecast_update_time) - 1);
-                            }
-                            
-                            // 获取预报数据
-                            cJSON *casts = cJSON_GetObjectItem(forecast, "casts");
-                            if (casts && cJSON_IsArray(casts)) {
-                                int count = cJSON_GetArraySize(casts);
-                                if (count > 4) count = 4; // 最多4天数据
-                                
-                                for (int i = 0; i < count; i++) {
-                                    cJSON *cast = cJSON_GetArrayItem(casts, i);
-                                    if (cast) {
-                                        cJSON *date = cJSON_GetObjectItem(cast, "date");
-                                        cJSON *week = cJSON_GetObjectItem(cast, "week");
-                                        cJSON *dayweather = cJSON_GetObjectItem(cast, "dayweather");
-                                        cJSON *nightweather = cJSON_GetObjectItem(cast, "nightweather");
-                                        cJSON *daytemp = cJSON_GetObjectItem(cast, "daytemp");
-                                        cJSON *nighttemp = cJSON_GetObjectItem(cast, "nighttemp");
-                                        cJSON *daywind = cJSON_GetObjectItem(cast, "daywind");
-                                        cJSON *nightwind = cJSON_GetObjectItem(cast, "nightwind");
-                                        cJSON *daypower = cJSON_GetObjectItem(cast, "daypower");
-                                        cJSON *nightpower = cJSON_GetObjectItem(cast, "nightpower");
-                                        
-                                        // 清空数据
-                                        memset(&forecast_data[i], 0, sizeof(weather_forecast_t));
-                                        
-                                        // 填充数据
-                                        if (date && cJSON_IsString(date)) {
-                                            strncpy(forecast_data[i].date, date->valuestring, sizeof(forecast_data[i].date) - 1);
-                                        }
-                                        if (week && cJSON_IsString(week)) {
-                                            strncpy(forecast_data[i].week, week->valuestring, sizeof(forecast_data[i].week) - 1);
-                                        }
-                                        if (dayweather && cJSON_IsString(dayweather)) {
-                                            strncpy(forecast_data[i].dayweather, dayweather->valuestring, sizeof(forecast_data[i].dayweather) - 1);
-                                        }
-                                        if (nightweather && cJSON_IsString(nightweather)) {
-                                            strncpy(forecast_data[i].nightweather, nightweather->valuestring, sizeof(forecast_data[i].nightweather) - 1);
-                                        }
-                                        if (daytemp && cJSON_IsString(daytemp)) {
-                                            strncpy(forecast_data[i].daytemp, daytemp->valuestring, sizeof(forecast_data[i].daytemp) - 1);
-                                        }
-                                        if (nighttemp && cJSON_IsString(nighttemp)) {
-                                            strncpy(forecast_data[i].nighttemp, nighttemp->valuestring, sizeof(forecast_data[i].nighttemp) - 1);
-                                        }
-                                        if (daywind && cJSON_IsString(daywind)) {
-                                            strncpy(forecast_data[i].daywind, daywind->valuestring, sizeof(forecast_data[i].daywind) - 1);
-                                        }
-                                        if (nightwind && cJSON_IsString(nightwind)) {
-                                            strncpy(forecast_data[i].nightwind, nightwind->valuestring, sizeof(forecast_data[i].nightwind) - 1);
-                                        }
-                                        if (daypower && cJSON_IsString(daypower)) {
-                                            strncpy(forecast_data[i].daypower, daypower->valuestring, sizeof(forecast_data[i].daypower) - 1);
-                                        }
-                                        if (nightpower && cJSON_IsString(nightpower)) {
-                                            strncpy(forecast_data[i].nightpower, nightpower->valuestring, sizeof(forecast_data[i].nightpower) - 1);
-                                        }
-                                    }
-                                }
-                                
-                                forecast_updated = true;
-                                ESP_LOGI(TAG, "天气预报更新成功");
-                            }
-                        }
-                    }
-                }
-                cJSON_Delete(json);
-            } else {
-                ESP_LOGE(TAG, "天气预报JSON解析失败");
-            }
-        } else {
-            ESP_LOGE(TAG, "天气预报HTTP响应错误: status_code=%d, data=%s", status_code, response.data ? "有数据" : "无数据");
-        }
-    } else {
-        ESP_LOGE(TAG, "天气预报HTTP GET request failed: %s", esp_err_to_name(err));
-    }
-
-    if (response.data) {
-        free(response.data);
-    }
-    esp_http_client_cleanup(client);
-    return err;
-}
-
-static void weather_forecast_update_task(void *arg)
-{
-    ESP_LOGI(TAG, "天气预报更新任务启动");
-    
-    /* 等待30秒让系统完全初始化 */
-    vTaskDelay(pdMS_TO_TICKS(30000));
-    ESP_LOGI(TAG, "天气预报任务等待结束，开始工作");
-    
-    while (1) {
-        /* 检查WiFi连接状态 */
-        wifi_status_t wifi_status = wifi_get_status();
-        if (wifi_status == WIFI_STATUS_CONNECTED) {
-            ESP_LOGI(TAG, "开始获取天气预报...");
-            esp_err_t ret = get_weather_forecast();
-            if (ret == ESP_OK) {
-                ESP_LOGI(TAG, "天气预报获取成功");
-                /* 如果当前在桌面4，更新显示 */
-                if (current_desktop == 3) {
-                    update_forecast_display();
-                }
-                    } else {
-            ESP_LOGE(TAG, "天气预报获取失败: %s", esp_err_to_name(ret));
-        }
-        } else {
-            ESP_LOGW(TAG, "WiFi未连接，跳过天气预报获取");
-        }
-        
-        /* 每30分钟获取一次天气预报 */
-        vTaskDelay(pdMS_TO_TICKS(30 * 60 * 1000));
-    }
-}
-
 /* AI助手显示更新任务 */
 static void speech_display_update_task(void *arg)
 {
@@ -3829,7 +3317,12 @@ static void timer_audio_task(void *arg)
 /* 闹钟音频播放任务 */
 static void alarm_audio_task(void *arg)
 {
-    if (selected_ringtone == RINGTONE_WAV_FILE) {
+    wav_file_t wav;
+    if (alarm_take_preload(&wav)) {
+        ESP_LOGI(TAG, "闹钟响铃：播放预加载的WAV铃声");
+        audio_play_prepared_wav(&wav);
+        audio_free_wav_file(&wav);
+    } else if (selected_ringtone == RINGTONE_WAV_FILE) {
         ESP_LOGI(TAG, "闹钟响铃：播放WAV文件铃声");
         audio_play_wav_file("ring.wav", system_volume);
     } else {
@@ -4375,7 +3868,7 @@ void update_time_format(bool use_24h_format)
     // 立即更新显示
     if (time_label) {
         ds3231_time_t current_time;
-        if (ds3231_get_time(&current_time) == ESP_OK) {
+        if (time_service_get_time(&current_time) == ESP_OK) {
             char time_str[32];
             if (use_24hour_format) {
                 snprintf(time_str, sizeof(time_str), "%02d:%02d:%02d", 
@@ -4423,6 +3916,7 @@ void update_alarm_settings(uint8_t hour, uint8_t minute, bool enabled)
     if (alarm_enabled) {
         alarm_state = ALARM_STATE_ALARM_SET;
     }
+    alarm_rearm();
     
     // 立即更新显示（如果在闹钟页面）
     if (current_desktop == 1) {
@@ -4430,13 +3924,20 @@ void update_alarm_settings(uint8_t hour, uint8_t minute, bool enabled)
     }
 }
 
-/* 定时器设置更新函数 - 供Web服务器调用 */
-void update_timer_settings(uint8_t hours, uint8_t minutes, uint8_t seconds, bool running, const char* action)
+/*
+ * 定时器设置更新函数 - 供Web服务器调用
+ * 执行后按倒计时引擎的实际剩余时间和状态更新Web状态；动作未生效时返回错误
+ */
+esp_err_t update_timer_settings(uint8_t hours, uint8_t minutes, uint8_t seconds, const char* action)
 {
-    // 更新全局定时器变量
-    timer_hours = hours;
-    timer_minutes = minutes;
-    timer_seconds = seconds;
+    esp_err_t ret = ESP_OK;
+    
+    // 更新全局定时器变量（extend时参数为增量，不覆盖设定时长）
+    if (strcmp(action, "extend") != 0) {
+        timer_hours = hours;
+        timer_minutes = minutes;
+        timer_seconds = seconds;
+    }
     
     // 记录日志
     ESP_LOGI(TAG, "定时器设置已更新: %02d:%02d:%02d", timer_hours, timer_minutes, timer_seconds);
@@ -4444,15 +3945,12 @@ void update_timer_settings(uint8_t hours, uint8_t minutes, uint8_t seconds, bool
     // 根据动作执行不同操作
     if (strcmp(action, "start") == 0) {
         // 开始定时器
-        timer_running = true;
-        timer_state = TIMER_STATE_COUNTDOWN;
-        countdown_hours = hours;
-        countdown_minutes = minutes;
-        countdown_seconds = seconds;
-        timer_start_tick = xTaskGetTickCount();
-        ESP_LOGI(TAG, "定时器已启动");
+        timer_start_countdown();
+        ret = timer_running ? ESP_OK : ESP_FAIL;
+        ESP_LOGI(TAG, "定时器%s", timer_running ? "已启动" : "启动失败");
     } else if (strcmp(action, "stop") == 0) {
         // 停止定时器
+        countdown_stop(timer_countdown_id);
         timer_running = false;
         if (timer_state == TIMER_STATE_COUNTDOWN) {
             timer_state = TIMER_STATE_MAIN;
@@ -4460,18 +3958,47 @@ void update_timer_settings(uint8_t hours, uint8_t minutes, uint8_t seconds, bool
         ESP_LOGI(TAG, "定时器已停止");
     } else if (strcmp(action, "reset") == 0) {
         // 重置定时器
+        countdown_stop(timer_countdown_id);
         timer_running = false;
         timer_state = TIMER_STATE_MAIN;
         countdown_hours = 0;
         countdown_minutes = 0;
         countdown_seconds = 0;
         ESP_LOGI(TAG, "定时器已重置");
+    } else if (strcmp(action, "pause") == 0) {
+        // 暂停定时器，保留剩余时间
+        ret = countdown_pause(timer_countdown_id);
+        if (ret == ESP_OK) {
+            timer_running = false;
+            ESP_LOGI(TAG, "定时器已暂停");
+        }
+    } else if (strcmp(action, "resume") == 0) {
+        // 从暂停处继续
+        ret = countdown_resume(timer_countdown_id);
+        if (ret == ESP_OK) {
+            timer_running = true;
+            ESP_LOGI(TAG, "定时器已继续");
+        }
+    } else if (strcmp(action, "extend") == 0) {
+        // 延长定时器，时分秒参数为增加的时长
+        ret = countdown_extend(timer_countdown_id, (int64_t)(hours * 3600 + minutes * 60 + seconds) * 1000000LL);
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "定时器已延长");
+        }
+    } else {
+        ret = ESP_ERR_INVALID_ARG;
     }
     
+    // 停止、重置和到期后引擎剩余时间为0
+    timer_set_countdown_fields(countdown_remaining_s(timer_countdown_id));
+    web_server_update_timer_status(countdown_hours, countdown_minutes, countdown_seconds,
+                                   countdown_is_running(timer_countdown_id));
+    
     // 立即更新显示（如果在定时器页面）
     if (current_desktop == 1) {
         update_timer_display();
     }
+    return ret;
 }
 
 /* 事件提醒设置更新函数 - 供Web服务器调用 */
@@ -4512,6 +4039,12 @@ void app_main(void)
     ESP_LOGI(TAG, "系统启动时可用堆内存: %ld 字节", esp_get_free_heap_size());
     ESP_LOGI(TAG, "最小可用堆内存: %ld 字节", esp_get_minimum_free_heap_size());
     
+    /* cJSON分配改走分配池，须在任何cJSON调用之前 */
+    json_arena_install();
+    
+    /* 网络请求服务，须在语音、校时、天气任务发起请求之前 */
+    ESP_ERROR_CHECK(net_service_init());
+    
     /* 初始化LVGL */
     lv_init();
     
@@ -4524,13 +4057,15 @@ void app_main(void)
     /* 初始化DS3231 */
     ESP_ERROR_CHECK(ds3231_init());
     
+    /* 启动时间服务：读取一次RTC，之后由秒中断维护内存时钟 */
+    time_service_init();
+    
+    /* 映射农历数据分区，失败时农历改为离线计算 */
+    almanac_init();
+    
     /* 初始化时间（如果需要） */
     init_time_if_needed();
     
-    /* 初始化农历缓存 */
-    ESP_LOGI(TAG, "Initializing lunar calendar cache...");
-    init_lunar_cache();
-    
     /* 创建UI界面 */
     create_ui();
     
@@ -4552,6 +4087,15 @@ void app_main(void)
         ESP_LOGE(TAG, "系统将在没有WiFi的情况下继续运行");
     }
     
+    /* 加载RTC漂移校准历史（依赖WiFi初始化中的NVS） */
+    rtc_calib_init();
+    
+    /* 启动后台网络校时（SNTP，失败时回退HTTP） */
+    time_service_set_network_enabled(use_network_time);
+    if (wifi_ret == ESP_OK) {
+        time_service_start_network();
+    }
+    
     /* 初始化震动模块 */
     ESP_LOGI(TAG, "Initializing vibration motor...");
     esp_err_t vibration_ret = vibration_init();
@@ -4643,12 +4187,14 @@ void app_main(void)
     /* 创建定时器任务 */
     xTaskCreate(timer_countdown_task, "timer_countdown_task", 2048, NULL, 4, NULL);
     
-    /* 创建闹钟任务 */
+    /* 闹钟：INT引脚可用时由DS3231硬件闹钟中断触发；轮询任务始终创建，引脚不可用时接手 */
+    alarm_hw_irq = ds3231_alarm_int_available() &&
+                   ds3231_register_alarm_callback(DS3231_ALARM2, alarm_hw_callback) == ESP_OK;
+    if (alarm_hw_irq) {
+        alarm_rearm();
+    }
     xTaskCreate(alarm_check_task, "alarm_check_task", 2048, NULL, 4, NULL);
     
-    /* 创建天气预报获取任务 */
-    xTaskCreate(weather_forecast_update_task, "weather_forecast_task", 4096, NULL, 3, NULL);
-    
     /* 创建MQ2传感器更新任务 */
     if (mq2_ret == ESP_OK) {
         xTaskCreate(mq2_sensor_update_task, "mq2_sensor_task", 4096, NULL, 4, NULL);
@@ -0,0 +1,343 @@
+#include "net_hedge.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "NET_HEDGE";
+
+#define NET_HEDGE_STACK_SIZE    8192
+#define NET_HEDGE_TASK_PRIORITY 5       // 与前台工作任务相同
+#define NET_HEDGE_QUEUE_LEN     4       // 含已撤销、对冲任务尚未取走的项
+
+typedef enum {
+    HEDGE_IDLE = 0,
+    HEDGE_ARMED,        // 已交给对冲任务，等待阈值
+    HEDGE_RUNNING,      // 对冲请求执行中
+    HEDGE_DONE,
+} hedge_state_t;
+
+// 桶上限(ms)：1秒内100ms一档，5秒内250ms一档，30秒内5秒一档，最后一档为超过30秒
+static const uint32_t latency_bounds[NET_LATENCY_BUCKETS] = {
+    100, 200, 300, 400, 500, 600, 700, 800, 900, 1000,
+    1250, 1500, 1750, 2000, 2250, 2500, 2750, 3000, 3250, 3500,
+    3750, 4000, 4250, 4500, 4750, 5000,
+    10000, 15000, 20000, 25000, 30000, 60000,
+};
+
+typedef struct {
+    net_hedge_t *hedge;
+    uint32_t seq;
+} hedge_item_t;
+
+static portMUX_TYPE hedge_lock = portMUX_INITIALIZER_UNLOCKED;
+static QueueHandle_t hedge_queue = NULL;
+static TaskHandle_t hedge_task_handle = NULL;
+static SemaphoreHandle_t hedge_done = NULL;
+static StaticSemaphore_t hedge_done_buffer;
+static net_hedge_t *hedge_busy = NULL;     // 占用对冲任务的端点：等待阈值、执行中或落后一方收尾
+static uint32_t hedge_seq = 0;
+static uint32_t armed_seq = 0;              // 等待阈值的那一项，主请求先结束时清零即撤销
+
+static uint32_t elapsed_ms(int64_t since_us)
+{
+    return (uint32_t)((esp_timer_get_time() - since_us) / 1000);
+}
+
+void net_latency_record(net_latency_t *latency, uint32_t ms)
+{
+    int bucket = 0;
+    while (bucket < NET_LATENCY_BUCKETS - 1 && ms > latency_bounds[bucket]) {
+        bucket++;
+    }
+
+    if (latency->samples >= NET_LATENCY_DECAY_SAMPLES) {
+        latency->samples = 0;
+        for (int i = 0; i < NET_LATENCY_BUCKETS; i++) {
+            latency->counts[i] /= 2;
+            latency->samples += latency->counts[i];
+        }
+    }
+    latency->counts[bucket]++;
+    latency->samples++;
+    latency->total_samples++;
+}
+
+uint32_t net_latency_percentile(const net_latency_t *latency, uint8_t percent)
+{
+    if (latency->samples < NET_LATENCY_MIN_SAMPLES || percent == 0) {
+        return 0;
+    }
+
+    uint32_t target = (latency->samples * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < NET_LATENCY_BUCKETS; i++) {
+        seen += latency->counts[i];
+        if (seen >= target) {
+            return latency_bounds[i];
+        }
+    }
+    return latency_bounds[NET_LATENCY_BUCKETS - 1];
+}
+
+// 在锁内直接置位：执行中的请求轮询该标志，不需要唤醒工作任务
+static void mark_cancelled(net_cancel_t *token)
+{
+    if (!token->cancelled) {
+        token->cancelled_at_us = esp_timer_get_time();
+        token->cancelled = true;
+    }
+}
+
+static void record_latency(net_hedge_t *hedge, uint32_t ms)
+{
+    portENTER_CRITICAL(&hedge_lock);
+    net_latency_record(&hedge->latency, ms);
+    portEXIT_CRITICAL(&hedge_lock);
+}
+
+static void hedge_task(void *pvParameters)
+{
+    hedge_item_t item;
+
+    while (1) {
+        if (xQueueReceive(hedge_queue, &item, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        net_hedge_t *hedge = item.hedge;
+
+        // 等到阈值；主请求先结束时撤销并通知，这里醒来后直接丢弃
+        bool fire = false;
+        while (1) {
+            portENTER_CRITICAL(&hedge_lock);
+            bool armed = armed_seq == item.seq;
+            uint32_t waited = elapsed_ms(hedge->start_us);
+            fire = armed && waited >= hedge->delay_ms;
+            if (fire) {
+                armed_seq = 0;
+                hedge->hedge_state = HEDGE_RUNNING;
+                hedge->hedge_start_us = esp_timer_get_time();
+                hedge->hedges++;
+            }
+            portEXIT_CRITICAL(&hedge_lock);
+
+            if (fire || !armed) {
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(hedge->delay_ms - waited) + 1);
+        }
+
+        if (!fire) {
+            continue;
+        }
+
+        ESP_LOGI(TAG, "%s 超过%lu ms未返回，发出对冲请求", hedge->name, (unsigned long)hedge->delay_ms);
+        esp_err_t ret = hedge->run(hedge->slot_args[1], &hedge->slot_cancel[1]);
+        uint32_t took = elapsed_ms(hedge->hedge_start_us);
+
+        bool won = false;
+        bool wake_caller = false;
+        portENTER_CRITICAL(&hedge_lock);
+        // 调用方已返回（主请求先成功或等待超时）时状态不再是RUNNING，本次结果作废
+        if (ret == ESP_OK && hedge->hedge_state == HEDGE_RUNNING && hedge->winner < 0) {
+            hedge->winner = 1;
+            hedge->hedge_wins++;
+            won = true;
+            mark_cancelled(&hedge->slot_cancel[0]);
+        }
+        // 结束状态与caller_waiting在同一临界区内确定：调用方此后看到DONE就不再等待
+        if (hedge->hedge_state == HEDGE_RUNNING) {
+            hedge->hedge_state = HEDGE_DONE;
+        }
+        wake_caller = hedge->caller_waiting;
+        hedge->caller_waiting = false;
+        bool discard = !won && ret == ESP_OK && hedge->discard != NULL;
+        if (!discard) {
+            hedge_busy = NULL;
+        }
+        portEXIT_CRITICAL(&hedge_lock);
+
+        if (wake_caller) {
+            xSemaphoreGive(hedge_done);
+        }
+        if (ret == ESP_OK) {
+            record_latency(hedge, took);
+        }
+        if (discard) {
+            hedge->discard(hedge->slot_args[1]);    // 主请求已先成功，丢弃后才让出对冲任务
+            portENTER_CRITICAL(&hedge_lock);
+            hedge_busy = NULL;
+            portEXIT_CRITICAL(&hedge_lock);
+        }
+        ESP_LOGI(TAG, "%s 对冲请求%s，耗时%lu ms", hedge->name,
+                 won ? "胜出" : (ret == ESP_OK ? "落后" : "失败"), (unsigned long)took);
+    }
+}
+
+esp_err_t net_hedge_init(void)
+{
+    if (hedge_task_handle != NULL) {
+        return ESP_OK;
+    }
+
+    hedge_queue = xQueueCreate(NET_HEDGE_QUEUE_LEN, sizeof(hedge_item_t));
+    hedge_done = xSemaphoreCreateBinaryStatic(&hedge_done_buffer);
+    if (hedge_queue == NULL || hedge_done == NULL) {
+        ESP_LOGE(TAG, "创建对冲队列失败");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(hedge_task, "net_hedge", NET_HEDGE_STACK_SIZE, NULL,
+                    NET_HEDGE_TASK_PRIORITY, &hedge_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "创建对冲任务失败");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t net_hedge_call(net_hedge_t *hedge, net_cancel_t *cancel, int *winner)
+{
+    uint32_t threshold = 0;
+    hedge_item_t item = { .hedge = hedge, .seq = 0 };
+
+    net_cancel_reset(&hedge->slot_cancel[0]);
+    hedge->slot_cancel[0].parent = cancel;
+    xSemaphoreTake(hedge_done, 0);      // 清掉上次等待超时后才到达的通知
+
+    portENTER_CRITICAL(&hedge_lock);
+    hedge->calls++;
+    hedge->winner = -1;
+    hedge->caller_waiting = false;
+    hedge->hedge_state = HEDGE_IDLE;
+    threshold = net_latency_percentile(&hedge->latency, hedge->percentile);
+    if (threshold > 0 && hedge_task_handle != NULL) {
+        if (hedge_busy == NULL) {
+            hedge_busy = hedge;
+            if (++hedge_seq == 0) {
+                hedge_seq = 1;      // 0表示没有等待中的项
+            }
+            item.seq = hedge_seq;
+            armed_seq = item.seq;
+            hedge->hedge_state = HEDGE_ARMED;
+            hedge->delay_ms = threshold < NET_HEDGE_MIN_DELAY_MS ? NET_HEDGE_MIN_DELAY_MS : threshold;
+        } else {
+            hedge->skipped++;
+        }
+    }
+    hedge->start_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&hedge_lock);
+
+    if (item.seq != 0) {
+        net_cancel_reset(&hedge->slot_cancel[1]);
+        hedge->slot_cancel[1].parent = cancel;
+        if (xQueueSend(hedge_queue, &item, 0) != pdTRUE) {
+            portENTER_CRITICAL(&hedge_lock);     // 队列里积压了已撤销的项，本次不对冲
+            if (armed_seq == item.seq) {
+                armed_seq = 0;
+                hedge_busy = NULL;
+                hedge->hedge_state = HEDGE_IDLE;
+                hedge->skipped++;
+            }
+            portEXIT_CRITICAL(&hedge_lock);
+        }
+    }
+
+    esp_err_t ret = hedge->run(hedge->slot_args[0], &hedge->slot_cancel[0]);
+    uint32_t took = elapsed_ms(hedge->start_us);
+
+    bool wait_hedge = false;
+    bool notify = false;
+    bool lost = false;
+    portENTER_CRITICAL(&hedge_lock);
+    if (hedge->winner == 1) {
+        lost = true;
+    } else if (ret == ESP_OK) {
+        hedge->winner = 0;
+    }
+    if (hedge->hedge_state == HEDGE_ARMED) {
+        // 撤销尚未发出的对冲，立即让出对冲任务给下一个请求
+        hedge->hedge_state = HEDGE_DONE;
+        armed_seq = 0;
+        hedge_busy = NULL;
+        notify = true;
+    } else if (hedge->hedge_state == HEDGE_RUNNING && !lost) {
+        if (ret == ESP_OK) {
+            // 落后的对冲请求在后台收尾，此后不再跟随调用方的令牌（调用方可能随即重置它）
+            mark_cancelled(&hedge->slot_cancel[1]);
+            hedge->slot_cancel[1].parent = NULL;
+        } else {
+            hedge->caller_waiting = true;       // 主请求失败，等对冲请求的结果
+            wait_hedge = true;
+        }
+    }
+    portEXIT_CRITICAL(&hedge_lock);
+
+    if (notify) {
+        xTaskNotifyGive(hedge_task_handle);
+    }
+
+    bool hedge_won = false;
+    if (wait_hedge) {
+        xSemaphoreTake(hedge_done, pdMS_TO_TICKS(NET_HEDGE_WAIT_MS));
+        bool timed_out = false;
+        portENTER_CRITICAL(&hedge_lock);
+        if (hedge->hedge_state == HEDGE_RUNNING) {
+            // 等待超时：放弃对冲，结果由对冲任务丢弃，它结束前仍占用对冲任务
+            timed_out = true;
+            hedge->hedge_state = HEDGE_DONE;
+            hedge->caller_waiting = false;
+            mark_cancelled(&hedge->slot_cancel[1]);
+            hedge->slot_cancel[1].parent = NULL;
+        }
+        hedge_won = hedge->winner == 1;
+        portEXIT_CRITICAL(&hedge_lock);
+        if (timed_out) {
+            ESP_LOGW(TAG, "%s 等待对冲结果超时", hedge->name);
+        }
+    }
+
+    if (lost || hedge_won) {
+        // 主请求被取消时已持续的时间同样计入分布，让阈值反映慢的尾部
+        record_latency(hedge, took);
+        if (ret == ESP_OK && hedge->discard != NULL) {
+            hedge->discard(hedge->slot_args[0]);
+        }
+        *winner = 1;
+        return ESP_OK;
+    }
+
+    if (ret == ESP_OK) {
+        record_latency(hedge, took);
+    }
+    *winner = 0;
+    return ret;
+}
+
+void net_hedge_wait_idle(net_hedge_t *hedge)
+{
+    while (1) {
+        portENTER_CRITICAL(&hedge_lock);
+        bool busy = hedge_busy == hedge;
+        portEXIT_CRITICAL(&hedge_lock);
+        if (!busy) {
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));     // 落后一方已被取消，通常在一个轮询周期内结束
+    }
+}
+
+void net_hedge_get_stats(net_hedge_t *hedge, net_hedge_stats_t *stats)
+{
+    portENTER_CRITICAL(&hedge_lock);
+    stats->calls = hedge->calls;
+    stats->hedges = hedge->hedges;
+    stats->hedge_wins = hedge->hedge_wins;
+    stats->skipped = hedge->skipped;
+    stats->p50_ms = net_latency_percentile(&hedge->latency, 50);
+    stats->p90_ms = net_latency_percentile(&hedge->latency, 90);
+    stats->p99_ms = net_latency_percentile(&hedge->latency, 99);
+    stats->samples = hedge->latency.total_samples;
+    portEXIT_CRITICAL(&hedge_lock);
+}
@@ -0,0 +1,129 @@
+#ifndef NET_HEDGE_H
+#define NET_HEDGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "net_service.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 对冲请求
+ *
+ * 语音一问一答串行经过ASR和GLM两次云端请求，任一连接卡住都要等到超时。
+ * 每个端点统计请求耗时分布；主请求超过该端点的分位数（默认p90）仍未返回时，
+ * 由对冲任务在另一条新连接上发出相同请求，先成功的一方胜出，另一方通过取消令牌中止。
+ *
+ * 请求函数按槽位执行：槽位0是主请求（在调用者任务中执行），槽位1是对冲请求
+ * （在对冲任务中执行），两个槽位的连接、解析状态必须互相独立。
+ * 同一时刻只有一个对冲请求，对冲任务忙（包括落后的一方尚在收尾）时本次不对冲。
+ */
+
+#define NET_LATENCY_BUCKETS         32
+#define NET_LATENCY_MIN_SAMPLES     8       // 样本不足时不对冲
+#define NET_LATENCY_DECAY_SAMPLES   256     // 样本累计到此数时全部减半，分布跟随网络变化
+#define NET_HEDGE_MIN_DELAY_MS      500     // 对冲阈值下限，避免正常抖动就加倍请求
+#define NET_HEDGE_WAIT_MS           30000   // 主请求失败后等待对冲结果的上限，超时即放弃对冲
+
+/**
+ * @brief 单个端点的耗时分布（分桶计数）
+ */
+typedef struct {
+    uint32_t counts[NET_LATENCY_BUCKETS];
+    uint32_t samples;           // counts之和，衰减后减半
+    uint32_t total_samples;
+} net_latency_t;
+
+typedef esp_err_t (*net_hedge_fn_t)(void *slot_arg, net_cancel_t *cancel);
+
+/**
+ * @brief 对冲统计
+ */
+typedef struct {
+    uint32_t calls;
+    uint32_t hedges;            // 发出对冲请求的次数
+    uint32_t hedge_wins;        // 对冲请求先成功的次数
+    uint32_t skipped;           // 达到阈值但对冲任务忙
+    uint32_t p50_ms;            // 0表示样本不足
+    uint32_t p90_ms;
+    uint32_t p99_ms;
+    uint32_t samples;
+} net_hedge_stats_t;
+
+/**
+ * @brief 一个可对冲的端点，由使用模块静态持有
+ */
+typedef struct {
+    const char *name;
+    uint8_t percentile;             // 对冲阈值取的分位数，0表示不对冲（仍统计耗时）
+    net_hedge_fn_t run;
+    void (*discard)(void *slot_arg);    // 已成功但落后的一方的结果由此释放，可为NULL
+    void *slot_args[2];             // 槽位0主请求，槽位1对冲请求
+    /* 以下为内部状态，由net_hedge.c加锁访问 */
+    net_latency_t latency;
+    net_cancel_t slot_cancel[2];
+    int8_t winner;
+    uint8_t hedge_state;
+    bool caller_waiting;
+    uint32_t delay_ms;
+    int64_t start_us;
+    int64_t hedge_start_us;
+    uint32_t calls;
+    uint32_t hedges;
+    uint32_t hedge_wins;
+    uint32_t skipped;
+} net_hedge_t;
+
+#define NET_HEDGE_INITIALIZER(hedge_name, hedge_percentile, hedge_run, hedge_discard, primary_arg, hedge_arg) { \
+    .name = (hedge_name), \
+    .percentile = (hedge_percentile), \
+    .run = (hedge_run), \
+    .discard = (hedge_discard), \
+    .slot_args = { (primary_arg), (hedge_arg) }, \
+}
+
+/**
+ * @brief 创建对冲任务，由net_service_init调用
+ */
+esp_err_t net_hedge_init(void);
+
+/**
+ * @brief 执行请求，超过分位数阈值未返回时发出对冲请求
+ *
+ * 阻塞到有一方成功，或两方都结束。落后的一方被取消，在后台收尾。
+ *
+ * @param cancel 外部取消令牌，可为NULL，取消时两个槽位一起中止
+ * @param winner 输出结果所在的槽位（失败时为0）
+ * @return 胜出一方的结果；都失败时返回主请求的结果
+ */
+esp_err_t net_hedge_call(net_hedge_t *hedge, net_cancel_t *cancel, int *winner);
+
+/**
+ * @brief 等待该端点落后的对冲请求收尾，之后才能释放槽位引用的外部缓冲区
+ */
+void net_hedge_wait_idle(net_hedge_t *hedge);
+
+/**
+ * @brief 记录一次耗时
+ */
+void net_latency_record(net_latency_t *latency, uint32_t ms);
+
+/**
+ * @brief 耗时的分位数（所在桶的上限），样本不足时返回0
+ */
+uint32_t net_latency_percentile(const net_latency_t *latency, uint8_t percent);
+
+/**
+ * @brief 复制对冲统计
+ */
+void net_hedge_get_stats(net_hedge_t *hedge, net_hedge_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_HEDGE_H
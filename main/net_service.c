@@ -0,0 +1,444 @@
+#include "net_service.h"
+#include "net_hedge.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "NET_SERVICE";
+
+#define NET_WORKER_COUNT        2
+#define NET_WORKER_STACK_SIZE   8192    // 请求函数内含TLS握手与cJSON构建
+
+typedef struct {
+    net_done_fn_t done;
+    void *ctx;
+} net_waiter_t;
+
+typedef struct {
+    bool used;
+    bool running;
+    net_request_t req;
+    uint8_t attempt;                    // 已执行的次数
+    uint32_t seq;                       // 同优先级按提交顺序出队
+    int64_t submitted_us;
+    int64_t not_before_us;              // 重试退避期内不出队
+    uint8_t waiter_count;
+    net_waiter_t waiters[NET_SERVICE_MAX_WAITERS];
+} net_job_t;
+
+typedef struct {
+    const char *host;
+    uint8_t active;
+} net_host_slot_t;
+
+/* 工作任务：前台只处理语音和校时，后台处理全部优先级 */
+static const struct {
+    const char *name;
+    net_priority_t lowest;
+    UBaseType_t task_priority;
+} worker_config[NET_WORKER_COUNT] = {
+    { "net_fg", NET_PRIORITY_TIME, 5 },
+    { "net_bg", NET_PRIORITY_BACKGROUND, 3 },
+};
+
+static SemaphoreHandle_t jobs_mutex = NULL;
+static net_job_t jobs[NET_SERVICE_MAX_JOBS];
+static net_host_slot_t hosts[NET_SERVICE_MAX_HOSTS];
+static TaskHandle_t workers[NET_WORKER_COUNT];
+static uint32_t next_seq = 0;
+static net_service_stats_t service_stats;
+
+static bool is_retryable(esp_err_t err)
+{
+    return err != ESP_ERR_INVALID_ARG &&
+           err != ESP_ERR_INVALID_RESPONSE &&
+           err != ESP_ERR_NOT_SUPPORTED;
+}
+
+/* 第n次重试等待 base*2^(n-1)，取其[1/2, 1]区间内的随机值，避免多个请求同时重试 */
+static uint32_t backoff_delay_ms(const net_request_t *req, uint8_t retry)
+{
+    uint32_t delay = req->backoff_ms;
+    for (uint8_t i = 1; i < retry && delay < NET_SERVICE_BACKOFF_MAX_MS; i++) {
+        delay *= 2;
+    }
+    if (delay > NET_SERVICE_BACKOFF_MAX_MS) {
+        delay = NET_SERVICE_BACKOFF_MAX_MS;
+    }
+    return delay / 2 + esp_random() % (delay / 2 + 1);
+}
+
+static bool is_worker_task(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < NET_WORKER_COUNT; i++) {
+        if (workers[i] == self) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void wake_workers(void)
+{
+    for (int i = 0; i < NET_WORKER_COUNT; i++) {
+        if (workers[i]) {
+            xTaskNotifyGive(workers[i]);
+        }
+    }
+}
+
+/* 以下host_*函数需持有jobs_mutex */
+static net_host_slot_t *host_slot(const char *host, bool create)
+{
+    net_host_slot_t *empty = NULL;
+    for (int i = 0; i < NET_SERVICE_MAX_HOSTS; i++) {
+        if (hosts[i].host && strcmp(hosts[i].host, host) == 0) {
+            return &hosts[i];
+        }
+        if (!hosts[i].host && !empty) {
+            empty = &hosts[i];
+        }
+    }
+    if (create && empty) {
+        empty->host = host;
+        empty->active = 0;
+    }
+    return create ? empty : NULL;
+}
+
+static bool host_available(const char *host)
+{
+    if (host == NULL) {
+        return true;
+    }
+    net_host_slot_t *slot = host_slot(host, false);
+    return slot == NULL || slot->active < NET_SERVICE_HOST_LIMIT;
+}
+
+static void host_acquire(const char *host)
+{
+    net_host_slot_t *slot = host ? host_slot(host, true) : NULL;
+    if (slot) {
+        slot->active++;
+    }
+}
+
+static void host_release(const char *host)
+{
+    net_host_slot_t *slot = host ? host_slot(host, false) : NULL;
+    if (slot && slot->active > 0 && --slot->active == 0) {
+        slot->host = NULL;      // 主机字符串由提交者持有，空闲时不再引用
+    }
+}
+
+/*
+ * 取出本工作任务可执行的最高优先级请求；没有时通过wait_ticks返回
+ * 最早一个退避期满的时间，没有退避中的请求则为portMAX_DELAY
+ */
+static net_job_t *take_job(net_priority_t lowest, TickType_t *wait_ticks)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t next_ready = INT64_MAX;
+    net_job_t *best = NULL;
+
+    xSemaphoreTake(jobs_mutex, portMAX_DELAY);
+    for (int i = 0; i < NET_SERVICE_MAX_JOBS; i++) {
+        net_job_t *job = &jobs[i];
+        if (!job->used || job->running) {
+            continue;
+        }
+        if (net_cancel_is_cancelled(job->req.cancel)) {
+            best = job;     // 已取消的请求不受优先级和主机限制，立即出队结束
+            break;
+        }
+        if (job->req.priority > lowest) {
+            continue;
+        }
+        if (job->not_before_us > now) {
+            if (job->not_before_us < next_ready) {
+                next_ready = job->not_before_us;
+            }
+            continue;
+        }
+        if (!host_available(job->req.host)) {
+            continue;   // 同主机的请求完成时会再唤醒
+        }
+        if (best == NULL || job->req.priority < best->req.priority ||
+            (job->req.priority == best->req.priority && (int32_t)(job->seq - best->seq) < 0)) {
+            best = job;
+        }
+    }
+
+    if (best) {
+        best->running = true;
+        host_acquire(best->req.host);
+        service_stats.queued--;
+        service_stats.running++;
+        if (best->attempt == 0) {
+            uint32_t waited_ms = (uint32_t)((now - best->submitted_us) / 1000);
+            if (waited_ms > service_stats.max_queue_wait_ms[best->req.priority]) {
+                service_stats.max_queue_wait_ms[best->req.priority] = waited_ms;
+            }
+        }
+    }
+    xSemaphoreGive(jobs_mutex);
+
+    if (next_ready == INT64_MAX) {
+        *wait_ticks = portMAX_DELAY;
+    } else {
+        *wait_ticks = pdMS_TO_TICKS((next_ready - now) / 1000) + 1;
+    }
+    return best;
+}
+
+static void finish_job(net_job_t *job, esp_err_t result)
+{
+    net_waiter_t waiters[NET_SERVICE_MAX_WAITERS];
+    uint8_t waiter_count = 0;
+
+    xSemaphoreTake(jobs_mutex, portMAX_DELAY);
+    host_release(job->req.host);
+    job->running = false;
+    job->attempt++;
+    service_stats.running--;
+
+    /* 取消前已完成的请求照常返回结果 */
+    bool cancelled = result != ESP_OK && net_cancel_is_cancelled(job->req.cancel);
+    if (cancelled) {
+        result = ESP_ERR_INVALID_STATE;
+    }
+
+    if (result != ESP_OK && !cancelled && is_retryable(result) && job->attempt < job->req.max_attempts) {
+        uint32_t delay = backoff_delay_ms(&job->req, job->attempt);
+        job->not_before_us = esp_timer_get_time() + (int64_t)delay * 1000;
+        service_stats.queued++;
+        service_stats.retries++;
+        ESP_LOGW(TAG, "%s 第%u次失败(%s)，%lu ms后重试",
+                 job->req.key ? job->req.key : job->req.host ? job->req.host : "请求",
+                 job->attempt, esp_err_to_name(result), (unsigned long)delay);
+        xSemaphoreGive(jobs_mutex);
+        wake_workers();
+        return;
+    }
+
+    if (result == ESP_OK) {
+        service_stats.succeeded++;
+    } else if (cancelled) {
+        service_stats.cancelled++;
+    } else {
+        service_stats.failed++;
+    }
+    waiter_count = job->waiter_count;
+    memcpy(waiters, job->waiters, sizeof(waiters[0]) * waiter_count);
+    job->used = false;
+    xSemaphoreGive(jobs_mutex);
+
+    /* 回调在锁外执行，回调内可以再次提交请求 */
+    for (uint8_t i = 0; i < waiter_count; i++) {
+        waiters[i].done(result, waiters[i].ctx);
+    }
+    wake_workers();     // 主机并发名额已释放
+}
+
+static void net_worker_task(void *arg)
+{
+    net_priority_t lowest = worker_config[(int)(intptr_t)arg].lowest;
+
+    while (1) {
+        TickType_t wait_ticks;
+        net_job_t *job = take_job(lowest, &wait_ticks);
+        if (job == NULL) {
+            ulTaskNotifyTake(pdTRUE, wait_ticks);
+            continue;
+        }
+        if (net_cancel_is_cancelled(job->req.cancel)) {
+            finish_job(job, ESP_ERR_INVALID_STATE);
+        } else {
+            finish_job(job, job->req.run(job->req.arg));
+        }
+    }
+}
+
+esp_err_t net_service_init(void)
+{
+    if (jobs_mutex) {
+        return ESP_OK;
+    }
+    jobs_mutex = xSemaphoreCreateMutex();
+    if (jobs_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < NET_WORKER_COUNT; i++) {
+        if (xTaskCreate(net_worker_task, worker_config[i].name, NET_WORKER_STACK_SIZE,
+                        (void *)(intptr_t)i, worker_config[i].task_priority, &workers[i]) != pdPASS) {
+            ESP_LOGE(TAG, "创建工作任务%s失败", worker_config[i].name);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    ESP_LOGI(TAG, "网络请求服务已启动，%d个工作任务", NET_WORKER_COUNT);
+    return net_hedge_init();
+}
+
+esp_err_t net_service_submit(const net_request_t *request)
+{
+    if (request == NULL || request->run == NULL || request->priority >= NET_PRIORITY_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (jobs_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(jobs_mutex, portMAX_DELAY);
+    service_stats.submitted++;
+
+    net_job_t *job = NULL;
+    if (request->key) {
+        for (int i = 0; i < NET_SERVICE_MAX_JOBS; i++) {
+            if (jobs[i].used && jobs[i].req.key && strcmp(jobs[i].req.key, request->key) == 0) {
+                job = &jobs[i];
+                break;
+            }
+        }
+    }
+
+    if (job && job->waiter_count < NET_SERVICE_MAX_WAITERS) {
+        /* 合并：排队中的请求按更高的优先级出队 */
+        if (request->priority < job->req.priority) {
+            job->req.priority = request->priority;
+        }
+        if (request->done) {
+            job->waiters[job->waiter_count++] = (net_waiter_t){ request->done, request->done_ctx };
+        }
+        service_stats.coalesced++;
+    } else {
+        job = NULL;
+        for (int i = 0; i < NET_SERVICE_MAX_JOBS; i++) {
+            if (!jobs[i].used) {
+                job = &jobs[i];
+                break;
+            }
+        }
+        if (job) {
+            memset(job, 0, sizeof(*job));
+            job->used = true;
+            job->req = *request;
+            job->seq = next_seq++;
+            job->submitted_us = esp_timer_get_time();
+            if (request->done) {
+                job->waiters[job->waiter_count++] = (net_waiter_t){ request->done, request->done_ctx };
+            }
+            service_stats.queued++;
+        } else {
+            service_stats.rejected++;
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    xSemaphoreGive(jobs_mutex);
+
+    if (ret == ESP_OK) {
+        wake_workers();
+    } else {
+        ESP_LOGW(TAG, "请求队列已满，丢弃 %s", request->key ? request->key : "请求");
+    }
+    return ret;
+}
+
+typedef struct {
+    SemaphoreHandle_t done_sem;
+    esp_err_t result;
+} net_call_ctx_t;
+
+static void call_done(esp_err_t result, void *ctx)
+{
+    net_call_ctx_t *call = ctx;
+    call->result = result;
+    xSemaphoreGive(call->done_sem);     // 之后不能再访问call，调用者已可返回
+}
+
+/* 在工作任务中嵌套调用，或服务未启动时，在当前任务按同样的重试规则执行 */
+static esp_err_t run_inline(const net_request_t *request)
+{
+    uint8_t attempts = request->max_attempts ? request->max_attempts : 1;
+    esp_err_t result = ESP_FAIL;
+    for (uint8_t attempt = 1; attempt <= attempts; attempt++) {
+        if (net_cancel_is_cancelled(request->cancel)) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        result = request->run(request->arg);
+        if (result == ESP_OK || !is_retryable(result) || attempt == attempts) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(backoff_delay_ms(request, attempt)));
+    }
+    return net_cancel_is_cancelled(request->cancel) && result != ESP_OK ? ESP_ERR_INVALID_STATE : result;
+}
+
+esp_err_t net_service_call(const net_request_t *request)
+{
+    if (request == NULL || request->run == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (jobs_mutex == NULL || is_worker_task()) {
+        return run_inline(request);
+    }
+
+    StaticSemaphore_t sem_buffer;
+    net_call_ctx_t call = {
+        .done_sem = xSemaphoreCreateBinaryStatic(&sem_buffer),
+        .result = ESP_FAIL,
+    };
+    net_request_t blocking = *request;
+    blocking.done = call_done;
+    blocking.done_ctx = &call;
+
+    esp_err_t ret = net_service_submit(&blocking);
+    if (ret == ESP_OK) {
+        xSemaphoreTake(call.done_sem, portMAX_DELAY);
+        ret = call.result;
+    }
+    vSemaphoreDelete(call.done_sem);
+    return ret;
+}
+
+void net_cancel_reset(net_cancel_t *token)
+{
+    token->cancelled_at_us = 0;
+    token->cancelled = false;
+}
+
+void net_cancel_request(net_cancel_t *token)
+{
+    if (token->cancelled) {
+        return;
+    }
+    token->cancelled_at_us = esp_timer_get_time();
+    token->cancelled = true;
+    wake_workers();     // 排队中的请求立即结束
+}
+
+bool net_cancel_is_cancelled(const net_cancel_t *token)
+{
+    for (; token != NULL; token = token->parent) {
+        if (token->cancelled) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void net_service_get_stats(net_service_stats_t *stats)
+{
+    if (jobs_mutex == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(jobs_mutex, portMAX_DELAY);
+    *stats = service_stats;
+    xSemaphoreGive(jobs_mutex);
+}
@@ -0,0 +1,131 @@
+#ifndef NET_SERVICE_H
+#define NET_SERVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 网络请求服务
+ *
+ * 所有云端HTTP请求排队后由固定的工作任务执行：
+ * - 按优先级出队（语音 > 校时 > 天气 > 后台），同优先级先进先出
+ * - 前台工作任务只处理语音和校时，慢的天气请求不会挡住语音
+ * - 同一主机同时只执行 NET_SERVICE_HOST_LIMIT 个请求
+ * - 相同key的请求在排队或执行中时合并，结果回调给所有提交者
+ * - 失败时按带随机抖动的指数退避重试
+ *
+ * 请求函数在工作任务中同步执行（内部照常使用esp_http_client），
+ * 返回ESP_ERR_INVALID_RESPONSE/ESP_ERR_INVALID_ARG/ESP_ERR_NOT_SUPPORTED表示重试无意义。
+ *
+ * 请求可带取消令牌：排队中的请求不再执行，执行中的请求由tls_session_perform
+ * 在上传块之间和等待响应的轮询间隙检查令牌并断开连接。取消的结果为ESP_ERR_INVALID_STATE，不重试。
+ */
+
+#define NET_SERVICE_MAX_JOBS        8       // 排队与执行中的请求总数
+#define NET_SERVICE_MAX_WAITERS     4       // 合并到同一请求的回调数
+#define NET_SERVICE_MAX_HOSTS       6
+#define NET_SERVICE_HOST_LIMIT      1       // 每个主机的并发请求数
+#define NET_SERVICE_BACKOFF_MAX_MS  60000
+
+typedef enum {
+    NET_PRIORITY_VOICE = 0,     // 语音识别、AI对话
+    NET_PRIORITY_TIME,          // 网络校时
+    NET_PRIORITY_WEATHER,
+    NET_PRIORITY_BACKGROUND,
+    NET_PRIORITY_COUNT,
+} net_priority_t;
+
+/**
+ * @brief 取消令牌，由发起方持有，一次交互（如一轮语音问答）共用一个
+ */
+typedef struct net_cancel {
+    volatile bool cancelled;
+    int64_t cancelled_at_us;    // 取消时刻，用于统计资源回收耗时
+    const struct net_cancel *parent;    // 上级令牌取消时本令牌同样视为已取消，可为NULL
+} net_cancel_t;
+
+typedef esp_err_t (*net_request_fn_t)(void *arg);
+typedef void (*net_done_fn_t)(esp_err_t result, void *ctx);
+
+/**
+ * @brief 一个网络请求
+ */
+typedef struct {
+    const char *key;            // 合并键，NULL表示不合并
+    const char *host;           // 并发限制按主机计，NULL表示不限制
+    net_priority_t priority;
+    net_request_fn_t run;       // 在工作任务中执行，返回最终结果
+    void *arg;                  // 合并时只执行第一个提交者的run/arg
+    net_done_fn_t done;         // 完成（含重试用尽）后在工作任务中回调，可为NULL
+    void *done_ctx;
+    uint8_t max_attempts;       // 含首次，0与1都表示不重试
+    uint32_t backoff_ms;        // 第一次重试前的基准等待，之后逐次翻倍
+    net_cancel_t *cancel;       // 可为NULL；合并的请求以第一个提交者的令牌为准
+} net_request_t;
+
+/**
+ * @brief 服务统计
+ */
+typedef struct {
+    uint32_t submitted;
+    uint32_t coalesced;         // 合并到已有请求的提交
+    uint32_t rejected;          // 队列已满
+    uint32_t retries;
+    uint32_t succeeded;
+    uint32_t failed;
+    uint32_t cancelled;
+    uint32_t max_queue_wait_ms[NET_PRIORITY_COUNT];     // 提交到开始执行的最长等待
+    uint8_t queued;             // 当前排队（含等待重试）
+    uint8_t running;            // 当前执行中
+} net_service_stats_t;
+
+/**
+ * @brief 创建工作任务，应在第一个请求之前调用
+ */
+esp_err_t net_service_init(void);
+
+/**
+ * @brief 异步提交请求
+ *
+ * @return ESP_OK 已入队或已合并；ESP_ERR_NO_MEM 队列已满
+ */
+esp_err_t net_service_submit(const net_request_t *request);
+
+/**
+ * @brief 提交请求并阻塞到完成（忽略request->done），返回请求函数的最终结果
+ *
+ * 在工作任务中调用时（请求内部又发起请求）直接在当前任务执行，避免互相等待。
+ */
+esp_err_t net_service_call(const net_request_t *request);
+
+/**
+ * @brief 重置令牌，开始新一次交互前调用（须确认上一次的请求已结束）
+ */
+void net_cancel_reset(net_cancel_t *token);
+
+/**
+ * @brief 取消令牌关联的全部请求，可在任意任务中调用，不等待请求结束
+ */
+void net_cancel_request(net_cancel_t *token);
+
+/**
+ * @brief 令牌或其上级是否已取消，NULL视为未取消
+ */
+bool net_cancel_is_cancelled(const net_cancel_t *token);
+
+/**
+ * @brief 复制服务统计
+ */
+void net_service_get_stats(net_service_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_SERVICE_H
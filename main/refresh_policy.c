@@ -0,0 +1,83 @@
+#include "refresh_policy.h"
+#include "civil_time.h"
+#include "esp_log.h"
+#include <stdio.h>
+
+static const char *TAG = "REFRESH";
+
+#define REFRESH_MAX_BACKOFF     8       // 退避倍数上限 2^8，实际还受max_interval_s限制
+
+int64_t refresh_policy_parse_stamp(const char *text)
+{
+    int year, month, day, hour, minute, second;
+    if (text == NULL ||
+        sscanf(text, "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) != 6) {
+        return 0;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > civil_days_in_month(year, month) ||
+        hour > 23 || minute > 59 || second > 59) {
+        return 0;
+    }
+    return civil_days_from_date(year, month, day) * CIVIL_SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+}
+
+static uint32_t clamp_interval(const refresh_policy_t *policy, int64_t interval_s)
+{
+    if (interval_s < policy->min_interval_s) {
+        return policy->min_interval_s;
+    }
+    if (interval_s > policy->max_interval_s) {
+        return policy->max_interval_s;
+    }
+    return (uint32_t)interval_s;
+}
+
+static uint32_t backoff_interval(refresh_policy_t *policy)
+{
+    if (policy->backoff < REFRESH_MAX_BACKOFF) {
+        policy->backoff++;
+    }
+    return clamp_interval(policy, (int64_t)policy->min_interval_s << (policy->backoff - 1));
+}
+
+int32_t refresh_policy_fresh_for(const refresh_policy_t *policy, int64_t stamp_s, int64_t now_s)
+{
+    if (stamp_s <= 0 || now_s <= 0) {
+        return 0;
+    }
+    int64_t due = stamp_s + policy->period_s + policy->grace_s;
+    return due > now_s ? (int32_t)(due - now_s) : 0;
+}
+
+uint32_t refresh_policy_on_data(refresh_policy_t *policy, int64_t stamp_s, int64_t now_s)
+{
+    bool changed = stamp_s != policy->stamp_s;
+    policy->stamp_s = stamp_s;
+
+    int32_t fresh_for = refresh_policy_fresh_for(policy, stamp_s, now_s);
+    if (fresh_for > 0) {
+        /* 数据是本周期的，等到下一次预计发布 */
+        policy->backoff = 0;
+        policy->interval_s = clamp_interval(policy, fresh_for);
+    } else if (stamp_s <= 0 || now_s <= 0) {
+        policy->backoff = 0;
+        policy->interval_s = policy->min_interval_s;
+    } else {
+        /* 已过预计发布时间：刚变化的数据从最小间隔开始，未变化则继续加倍 */
+        if (changed) {
+            policy->backoff = 0;
+        }
+        policy->interval_s = backoff_interval(policy);
+    }
+
+    ESP_LOGI(TAG, "%s: 数据%s，%lu 秒后刷新", policy->name, changed ? "已更新" : "未变化",
+             (unsigned long)policy->interval_s);
+    return policy->interval_s;
+}
+
+uint32_t refresh_policy_on_error(refresh_policy_t *policy)
+{
+    policy->interval_s = backoff_interval(policy);
+    ESP_LOGW(TAG, "%s: 刷新失败，%lu 秒后重试", policy->name, (unsigned long)policy->interval_s);
+    return policy->interval_s;
+}
@@ -0,0 +1,76 @@
+#ifndef REFRESH_POLICY_H
+#define REFRESH_POLICY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 按上游数据的发布时间推算下次刷新
+ *
+ * 上游按固定周期发布（如高德实况约每小时一次），数据自带发布时间：
+ * - 预计的下一次发布（发布时间 + 周期 + 延迟余量）之前不必再取，直接等到那时
+ * - 过了预计时间数据仍未变化（上游晚发），从最小间隔开始逐次加倍退避
+ * - 请求失败同样退避，避免网络异常时频繁重试
+ * 间隔始终限制在[min_interval_s, max_interval_s]内；本地时钟未建立时按最小间隔。
+ */
+
+/**
+ * @brief 刷新策略，由使用模块静态持有
+ */
+typedef struct {
+    const char *name;
+    uint32_t period_s;          // 上游发布周期
+    uint32_t grace_s;           // 发布时间之后多久上游数据才可取到
+    uint32_t min_interval_s;
+    uint32_t max_interval_s;
+    /* 以下为运行状态 */
+    int64_t stamp_s;            // 最近一次数据的发布时间（本地时间秒），0表示未知
+    uint8_t backoff;            // 连续未变化或失败的次数
+    uint32_t interval_s;        // 最近一次推算的间隔
+} refresh_policy_t;
+
+#define REFRESH_POLICY_INITIALIZER(policy_name, period, grace, min_interval, max_interval) { \
+    .name = (policy_name), \
+    .period_s = (period), \
+    .grace_s = (grace), \
+    .min_interval_s = (min_interval), \
+    .max_interval_s = (max_interval), \
+}
+
+/**
+ * @brief 解析"YYYY-MM-DD HH:MM:SS"格式的发布时间
+ *
+ * @return int64_t 本地时间（自1970-01-01起的秒数），格式不对返回0
+ */
+int64_t refresh_policy_parse_stamp(const char *text);
+
+/**
+ * @brief 取到数据后调用，推算距下次刷新的秒数
+ *
+ * @param stamp_s 本次数据的发布时间，0表示未知
+ * @param now_s 当前本地时间，0表示时钟未建立
+ * @return uint32_t 距下次刷新的秒数
+ */
+uint32_t refresh_policy_on_data(refresh_policy_t *policy, int64_t stamp_s, int64_t now_s);
+
+/**
+ * @brief 请求失败后调用，返回退避后距下次刷新的秒数
+ */
+uint32_t refresh_policy_on_error(refresh_policy_t *policy);
+
+/**
+ * @brief 按发布时间推算数据还能新鲜多久（秒），供响应缓存设定有效期
+ *
+ * @return int32_t 已过预计发布时间或无法推算时返回0
+ */
+int32_t refresh_policy_fresh_for(const refresh_policy_t *policy, int64_t stamp_s, int64_t now_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REFRESH_POLICY_H
@@ -0,0 +1,307 @@
+#include "rtc_calib.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "ds3231.h"
+
+static const char *TAG = "RTC_CALIB";
+
+#define RTC_CALIB_NVS_NAMESPACE     "rtc_calib"
+#define RTC_CALIB_NVS_KEY           "series"
+#define RTC_CALIB_VERSION           2
+
+#define RTC_CALIB_MAX_SAMPLES       16
+#define RTC_CALIB_MIN_SAMPLES       4
+#define RTC_CALIB_MIN_INTERVAL_S    (2 * 3600)      // 相邻样本至少间隔2小时，拉长序列跨度
+#define RTC_CALIB_MIN_SPAN_S        (24 * 3600)     // 至少覆盖24小时才估计漂移
+#define RTC_CALIB_MAX_STDERR_PPM    0.5f            // 标准误差低于此值才调整老化偏移
+#define RTC_CALIB_MIN_ADJUST_PPM    0.2f            // 漂移小于约2个LSB时不调整
+#define RTC_CALIB_CONVERGED_PPM     1.0f            // |漂移|+误差小于1ppm（约86ms/天）视为已校准
+#define RTC_CALIB_PPM_PER_LSB       0.1f            // DS3231老化偏移每LSB约0.1ppm，正值使时钟变慢
+#define RTC_CALIB_MAX_STEP_LSB      20              // 单次调整上限
+#define RTC_CALIB_OUTLIER_US        2000000LL       // 偏差超过2秒视为时间被改过，重新开始序列
+
+typedef struct {
+    int64_t ref_us;         // 参考时间（本地时间微秒）
+    int64_t offset_us;      // RTC - 参考，已扣除累计的已知步进量
+} rtc_calib_sample_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t count;
+    uint8_t adjustments;
+    uint8_t reserved;
+    int64_t step_us;        // 网络校时对RTC累计的已知步进量
+    rtc_calib_sample_t samples[RTC_CALIB_MAX_SAMPLES];     // 按时间从旧到新
+} rtc_calib_store_t;
+
+static rtc_calib_store_t store;
+static rtc_calib_estimate_t estimate;
+static SemaphoreHandle_t calib_mutex = NULL;
+static bool nvs_ready = false;
+static bool reset_pending = false;      // 初始化前发生的复位，加载NVS后丢弃旧序列
+
+static void rtc_calib_save(void)
+{
+    if (!nvs_ready) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(RTC_CALIB_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open failed: %s", esp_err_to_name(ret));
+        return;
+    }
+    ret = nvs_set_blob(handle, RTC_CALIB_NVS_KEY, &store, sizeof(store));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save series: %s", esp_err_to_name(ret));
+    }
+}
+
+/* 最小二乘拟合 offset = a + b * t，b即漂移率（微秒/秒 = ppm） */
+static void rtc_calib_update_estimate(void)
+{
+    int n = store.count;
+    estimate.samples = n;
+    estimate.valid = false;
+    estimate.drift_ppm = 0;
+    estimate.stderr_ppm = 0;
+    estimate.span_s = 0;
+
+    if (n < 2) {
+        return;
+    }
+
+    int64_t t0 = store.samples[0].ref_us;
+    double sx = 0, sy = 0;
+    for (int i = 0; i < n; i++) {
+        sx += (store.samples[i].ref_us - t0) / 1e6;
+        sy += (double)store.samples[i].offset_us;
+    }
+    double mx = sx / n;
+    double my = sy / n;
+
+    double sxx = 0, sxy = 0;
+    for (int i = 0; i < n; i++) {
+        double dx = (store.samples[i].ref_us - t0) / 1e6 - mx;
+        double dy = (double)store.samples[i].offset_us - my;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+    if (sxx <= 0) {
+        return;
+    }
+
+    double slope = sxy / sxx;
+    estimate.drift_ppm = (float)slope;
+    estimate.span_s = (uint32_t)((store.samples[n - 1].ref_us - t0) / 1000000LL);
+
+    if (n > 2) {
+        double sse = 0;
+        for (int i = 0; i < n; i++) {
+            double dx = (store.samples[i].ref_us - t0) / 1e6 - mx;
+            double r = (double)store.samples[i].offset_us - my - slope * dx;
+            sse += r * r;
+        }
+        estimate.stderr_ppm = (float)sqrt(sse / (n - 2) / sxx);
+    }
+
+    estimate.valid = (n >= RTC_CALIB_MIN_SAMPLES && estimate.span_s >= RTC_CALIB_MIN_SPAN_S);
+}
+
+/* 漂移估计足够可靠时按ppm调整老化偏移，并以最新样本为起点开始新序列 */
+static void rtc_calib_maybe_adjust(void)
+{
+    if (!estimate.valid || estimate.stderr_ppm > RTC_CALIB_MAX_STDERR_PPM ||
+        fabsf(estimate.drift_ppm) < RTC_CALIB_MIN_ADJUST_PPM) {
+        return;
+    }
+
+    int8_t aging;
+    if (ds3231_get_aging_offset(&aging) != ESP_OK) {
+        return;
+    }
+
+    int step = (int)lroundf(estimate.drift_ppm / RTC_CALIB_PPM_PER_LSB);
+    if (step > RTC_CALIB_MAX_STEP_LSB) {
+        step = RTC_CALIB_MAX_STEP_LSB;
+    } else if (step < -RTC_CALIB_MAX_STEP_LSB) {
+        step = -RTC_CALIB_MAX_STEP_LSB;
+    }
+    int new_aging = aging + step;
+    if (new_aging > 127) {
+        new_aging = 127;
+    } else if (new_aging < -128) {
+        new_aging = -128;
+    }
+    if (new_aging == aging) {
+        return;
+    }
+
+    if (ds3231_set_aging_offset((int8_t)new_aging) != ESP_OK) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Drift %.2f ppm (±%.2f), aging offset %d -> %d",
+             estimate.drift_ppm, estimate.stderr_ppm, aging, new_aging);
+
+    /* 频率已改变，旧样本不再代表当前漂移；时间是连续的，最新样本可作为新序列的起点 */
+    store.samples[0] = store.samples[store.count - 1];
+    store.count = 1;
+    if (store.adjustments < UINT8_MAX) {
+        store.adjustments++;
+    }
+    estimate.aging = (int8_t)new_aging;
+    rtc_calib_update_estimate();
+}
+
+esp_err_t rtc_calib_init(void)
+{
+    if (!calib_mutex) {
+        calib_mutex = xSemaphoreCreateMutex();
+        if (!calib_mutex) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    xSemaphoreTake(calib_mutex, portMAX_DELAY);
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(RTC_CALIB_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret == ESP_OK) {
+        rtc_calib_store_t loaded;
+        size_t size = sizeof(loaded);
+        if (nvs_get_blob(handle, RTC_CALIB_NVS_KEY, &loaded, &size) == ESP_OK &&
+            size == sizeof(loaded) && loaded.version == RTC_CALIB_VERSION &&
+            loaded.count <= RTC_CALIB_MAX_SAMPLES) {
+            store = loaded;
+        }
+        nvs_close(handle);
+    }
+    store.version = RTC_CALIB_VERSION;
+    nvs_ready = true;
+
+    if (reset_pending) {
+        store.count = 0;
+        store.step_us = 0;
+        reset_pending = false;
+        rtc_calib_save();
+    }
+
+    int8_t aging = 0;
+    if (ds3231_get_aging_offset(&aging) == ESP_OK) {
+        estimate.aging = aging;
+    }
+    estimate.adjustments = store.adjustments;
+    rtc_calib_update_estimate();
+    xSemaphoreGive(calib_mutex);
+
+    ESP_LOGI(TAG, "Loaded %d samples, drift %.2f ppm (±%.2f), aging %d",
+             store.count, estimate.drift_ppm, estimate.stderr_ppm, estimate.aging);
+    return ESP_OK;
+}
+
+esp_err_t rtc_calib_add_sample(int64_t rtc_us, int64_t ref_us)
+{
+    if (!calib_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(calib_mutex, portMAX_DELAY);
+    /* 扣除已知步进量，得到振荡器自由运行的偏差 */
+    int64_t offset_us = rtc_us - ref_us - store.step_us;
+
+    if (store.count > 0) {
+        rtc_calib_sample_t *last = &store.samples[store.count - 1];
+
+        /* 与上一个样本相比出现秒级跳变，说明时间被外部修改过 */
+        int64_t predicted = last->offset_us +
+                            (int64_t)(estimate.drift_ppm * (ref_us - last->ref_us) / 1e6);
+        if (ref_us <= last->ref_us || llabs(offset_us - predicted) > RTC_CALIB_OUTLIER_US) {
+            ESP_LOGW(TAG, "Discontinuity detected, restarting series");
+            store.count = 0;
+            store.step_us = 0;
+            offset_us = rtc_us - ref_us;
+        } else if (ref_us - last->ref_us < RTC_CALIB_MIN_INTERVAL_S * 1000000LL) {
+            xSemaphoreGive(calib_mutex);
+            return ESP_OK;
+        }
+    }
+
+    if (store.count == RTC_CALIB_MAX_SAMPLES) {
+        memmove(&store.samples[0], &store.samples[1], sizeof(store.samples[0]) * (RTC_CALIB_MAX_SAMPLES - 1));
+        store.count--;
+    }
+    store.samples[store.count].ref_us = ref_us;
+    store.samples[store.count].offset_us = offset_us;
+    store.count++;
+
+    rtc_calib_update_estimate();
+    rtc_calib_maybe_adjust();
+    estimate.adjustments = store.adjustments;
+    rtc_calib_save();
+    xSemaphoreGive(calib_mutex);
+
+    ESP_LOGI(TAG, "Sample %d: offset %lld ms, drift %.2f ppm (±%.2f) over %lu s",
+             store.count, (long long)(offset_us / 1000), estimate.drift_ppm,
+             estimate.stderr_ppm, (unsigned long)estimate.span_s);
+    return ESP_OK;
+}
+
+void rtc_calib_reset(void)
+{
+    if (!calib_mutex) {
+        reset_pending = true;
+        return;
+    }
+
+    xSemaphoreTake(calib_mutex, portMAX_DELAY);
+    store.count = 0;
+    store.step_us = 0;
+    rtc_calib_update_estimate();
+    rtc_calib_save();
+    xSemaphoreGive(calib_mutex);
+}
+
+void rtc_calib_note_step(int64_t delta_us)
+{
+    if (!calib_mutex) {
+        return;
+    }
+
+    xSemaphoreTake(calib_mutex, portMAX_DELAY);
+    if (store.count > 0) {
+        store.step_us += delta_us;
+    }
+    rtc_calib_save();
+    xSemaphoreGive(calib_mutex);
+}
+
+void rtc_calib_get_estimate(rtc_calib_estimate_t *out)
+{
+    if (!calib_mutex) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+
+    xSemaphoreTake(calib_mutex, portMAX_DELAY);
+    *out = estimate;
+    xSemaphoreGive(calib_mutex);
+}
+
+bool rtc_calib_is_converged(void)
+{
+    rtc_calib_estimate_t est;
+    rtc_calib_get_estimate(&est);
+    return est.valid && fabsf(est.drift_ppm) + est.stderr_ppm < RTC_CALIB_CONVERGED_PPM;
+}
@@ -0,0 +1,69 @@
+#ifndef RTC_CALIB_H
+#define RTC_CALIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief RTC漂移估计结果
+ */
+typedef struct {
+    uint8_t samples;        // 当前序列中的样本数
+    uint32_t span_s;        // 序列覆盖的时间跨度（秒）
+    float drift_ppm;        // 漂移率，正值表示RTC走快
+    float stderr_ppm;       // 漂移率的标准误差（置信度）
+    int8_t aging;           // 当前老化偏移寄存器值
+    uint8_t adjustments;    // 已自动调整老化偏移的次数
+    bool valid;             // 样本足够，估计可用
+} rtc_calib_estimate_t;
+
+/**
+ * @brief 初始化RTC校准模块，从NVS加载历史样本（须在nvs_flash_init之后调用）
+ *
+ * @return esp_err_t 成功返回ESP_OK
+ */
+esp_err_t rtc_calib_init(void);
+
+/**
+ * @brief 记录一次网络同步的 (RTC时间, 参考时间) 对，必要时调整DS3231老化偏移
+ *
+ * @param rtc_us 同一时刻RTC给出的本地时间（微秒）
+ * @param ref_us 同一时刻的参考本地时间（微秒）
+ * @return esp_err_t 成功返回ESP_OK
+ */
+esp_err_t rtc_calib_add_sample(int64_t rtc_us, int64_t ref_us);
+
+/**
+ * @brief RTC时间被步进到未知时间（如手动设置）后调用，丢弃当前样本序列
+ */
+void rtc_calib_reset(void);
+
+/**
+ * @brief 记录一次已知量的RTC步进（网络校时写入），样本序列继续有效
+ *
+ * @param delta_us 步进量，新时间减旧时间
+ */
+void rtc_calib_note_step(int64_t delta_us);
+
+/**
+ * @brief 获取当前漂移估计
+ *
+ * @param estimate 输出估计结果
+ */
+void rtc_calib_get_estimate(rtc_calib_estimate_t *estimate);
+
+/**
+ * @brief 漂移是否已校准到可以放宽网络同步间隔
+ */
+bool rtc_calib_is_converged(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTC_CALIB_H */
@@ -4,7 +4,15 @@
 #include "esp_http_client.h"
 #include "esp_crt_bundle.h"
 #include "esp_heap_caps.h"
-#include "esp_sntp.h"
+#include "time_service.h"
+#include "tls_session.h"
+#include "json_stream.h"
+#include "json_arena.h"
+#include "net_service.h"
+#include "net_hedge.h"
+#include "wifi_manager.h"
+#include "esp_timer.h"
+#include "civil_time.h"
 #include "cJSON.h"
 #include "mbedtls/base64.h"
 #include "mbedtls/md.h"
@@ -14,6 +22,7 @@
 #include "freertos/semphr.h"
 #include "driver/i2s_std.h"
 #include <string.h>
+#include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
 #include <inttypes.h>
@@ -31,8 +40,21 @@
 #define I2S_DMA_BUF_COUNT   6       // 减少DMA缓冲区数量，提高稳定性
 #define I2S_DMA_BUF_LEN     512     // 减少DMA缓冲区长度，降低延迟
 
+#define SPEECH_CANCEL_WAIT_MS   2000    // 新一轮录音或释放I2S前等待上一轮取消完成的上限
+
 static const char *TAG = "SPEECH_REC";
 
+static tls_session_t asr_session = TLS_SESSION_INITIALIZER("ASR");  // 跨请求复用TLS会话
+static tls_session_t asr_hedge_session = TLS_SESSION_INITIALIZER("ASR对冲");  // 对冲请求的独立连接
+static json_arena_t asr_arena = JSON_ARENA_INITIALIZER("ASR");      // 请求JSON的cJSON节点
+static json_arena_t asr_hedge_arena = JSON_ARENA_INITIALIZER("ASR对冲");
+static volatile bool g_prewarm_running = false;
+static volatile bool g_page_active = false;     // AI助手页面是否打开，离开后预热任务不再保持连接
+static int32_t g_last_reply_latency_ms = -1;    // 录音结束到AI回复首字节，-1表示尚无数据
+static net_cancel_t g_speech_cancel;            // 本轮录音、识别和AI请求共用，离开页面时取消
+static volatile bool g_task_running = false;    // 录音任务存在（含取消后正在收尾）
+static int32_t g_last_cancel_reclaim_ms = -1;   // 取消到缓冲区释放完毕的耗时，-1表示尚无数据
+
 // 全局变量
 static speech_recognition_result_t g_speech_result = {
     .result_text = "",
@@ -46,65 +68,59 @@ static speech_recognition_result_t g_speech_result = {
 static bool g_speech_active = false;
 static TaskHandle_t g_speech_task_handle = NULL;
 static SemaphoreHandle_t g_speech_mutex = NULL;
-static bool g_time_synced = false;
 
 // 音频缓冲区 - 使用动态分配以节省内存
 static int32_t *g_raw_audio_buffer = NULL;  // 32位原始I2S数据缓冲区
 static int16_t *g_audio_buffer = NULL;      // 16位PCM数据缓冲区
 static char *g_base64_buffer = NULL;
-static char *g_http_response_buffer = NULL;
 
-// I2S通道句柄
-static i2s_chan_handle_t g_rx_handle = NULL;
-static bool g_i2s_initialized = false;
+// ASR响应流式解析，识别结果直接写入定长缓冲区
+// 主请求与对冲请求各用一个槽位，连接、分配池和解析状态互不共享
+enum { ASR_FIELD_RESPONSE, ASR_FIELD_ERROR, ASR_FIELD_ERROR_CODE, ASR_FIELD_ERROR_MESSAGE,
+       ASR_FIELD_RESULT, ASR_FIELD_DURATION, ASR_FIELD_COUNT };
 
-// SNTP时间同步回调
-static void time_sync_notification_cb(struct timeval *tv)
-{
-    ESP_LOGI(TAG, "Time synchronized via SNTP");
-    g_time_synced = true;
-}
+typedef struct {
+    tls_session_t *session;
+    json_arena_t *arena;
+    http_decoder_t decoder;         // 压缩传输时边解压边交给stream
+    json_stream_t stream;
+    char result[sizeof(g_speech_result.result_text)];
+    char error_code[64];
+    char error_message[160];
+    char duration[16];
+    json_stream_field_t fields[ASR_FIELD_COUNT];
+    int status_code;                // 0表示没有收到响应
+    const char *audio_data_base64;
+    size_t data_len;
+} asr_slot_t;
 
-// 初始化并同步时间
-static esp_err_t sync_time_with_ntp(void)
-{
-    if (g_time_synced) {
-        return ESP_OK;  // 已经同步过了
-    }
-    
-    ESP_LOGI(TAG, "Initializing SNTP for time synchronization...");
-    
-    // 设置时区为UTC
-    setenv("TZ", "UTC", 1);
-    tzset();
-    
-    // 初始化SNTP
-    esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    esp_sntp_setservername(0, "pool.ntp.org");
-    esp_sntp_setservername(1, "time.nist.gov");
-    esp_sntp_set_time_sync_notification_cb(time_sync_notification_cb);
-    esp_sntp_init();
-    
-    // 等待时间同步，最多等待10秒
-    int retry = 0;
-    const int retry_count = 100;  // 10秒，每100ms检查一次
-    
-    while (!g_time_synced && ++retry < retry_count) {
-        ESP_LOGI(TAG, "Waiting for time sync... (%d/%d)", retry, retry_count);
-        vTaskDelay(pdMS_TO_TICKS(100));
-    }
-    
-    if (g_time_synced) {
-        time_t now;
-        time(&now);
-        ESP_LOGI(TAG, "Time synchronized successfully. Current time: %lld", (long long)now);
-        return ESP_OK;
-    } else {
-        ESP_LOGW(TAG, "Time sync timeout, using fallback time");
-        return ESP_ERR_TIMEOUT;
-    }
+#define ASR_SLOT_INITIALIZER(slot, slot_session, slot_arena) { \
+    .session = (slot_session), \
+    .arena = (slot_arena), \
+    .fields = { \
+        JSON_STREAM_PRESENCE("Response"), \
+        JSON_STREAM_PRESENCE("Response.Error"), \
+        JSON_STREAM_FIELD("Response.Error.Code", (slot).error_code, sizeof((slot).error_code)), \
+        JSON_STREAM_FIELD("Response.Error.Message", (slot).error_message, sizeof((slot).error_message)), \
+        JSON_STREAM_FIELD("Response.Result", (slot).result, sizeof((slot).result)), \
+        JSON_STREAM_FIELD("Response.AudioDuration", (slot).duration, sizeof((slot).duration)), \
+    }, \
 }
 
+static http_decode_endpoint_t asr_decode = HTTP_DECODE_ENDPOINT_INITIALIZER("ASR");
+
+static asr_slot_t asr_primary = ASR_SLOT_INITIALIZER(asr_primary, &asr_session, &asr_arena);
+static asr_slot_t asr_hedge_slot = ASR_SLOT_INITIALIZER(asr_hedge_slot, &asr_hedge_session, &asr_hedge_arena);
+
+static esp_err_t run_recognition_attempt(void *arg, net_cancel_t *cancel);
+static net_hedge_t asr_hedge = NET_HEDGE_INITIALIZER("ASR", SPEECH_ASR_HEDGE_PERCENTILE,
+                                                     run_recognition_attempt, NULL,
+                                                     &asr_primary, &asr_hedge_slot);
+
+// I2S通道句柄
+static i2s_chan_handle_t g_rx_handle = NULL;
+static bool g_i2s_initialized = false;
+
 // Base64编码函数
 // WAV文件头结构
 typedef struct {
@@ -514,73 +530,96 @@ static esp_err_t generate_tc3_signature(const char *payload, const char *timesta
     return ESP_OK;
 }
 
-// HTTP事件处理器
+static void feed_response(const char *data, int len, void *ctx)
+{
+    json_stream_feed(ctx, data, len);
+}
+
+// HTTP事件处理器，user_data为所属槽位（预热请求没有user_data，只发生在主连接上）
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
-    switch (evt->event_id) {
-        case HTTP_EVENT_ON_DATA:
-            if (evt->data_len > 0 && g_http_response_buffer) {
-                size_t current_len = strlen(g_http_response_buffer);
-                size_t remaining = HTTP_RESPONSE_BUFFER_SIZE - current_len - 1;
-                size_t copy_len = (evt->data_len < remaining) ? evt->data_len : remaining;
-                
-                if (copy_len > 0) {
-                    strncat(g_http_response_buffer, (char*)evt->data, copy_len);
-                }
-            }
-            break;
-        default:
-            break;
-    }
+    asr_slot_t *slot = evt->user_data != NULL ? evt->user_data : &asr_primary;
+    tls_session_on_event(slot->session, evt);
+    
+    // 预热的HEAD请求没有响应体，解码器在下次请求开始时重置
+    http_decoder_on_event(&slot->decoder, evt);
     return ESP_OK;
 }
 
-// 解析API响应
-static esp_err_t parse_api_response(const char *response)
+// 腾讯云ASR客户端配置（请求与预热共用）
+static void asr_client_config(esp_http_client_config_t *config, asr_slot_t *slot)
 {
-    cJSON *json = cJSON_Parse(response);
-    if (!json) {
-        ESP_LOGE(TAG, "Failed to parse JSON response");
-        return ESP_FAIL;
+    *config = (esp_http_client_config_t) {
+        .host = TENCENT_ASR_HOST,
+        .path = "/",
+        .port = 443,
+        .transport_type = HTTP_TRANSPORT_OVER_SSL,
+        .event_handler = http_event_handler,
+        .user_data = slot,
+        .timeout_ms = 30000,
+        .skip_cert_common_name_check = true,    // 跳过证书通用名检查
+        .crt_bundle_attach = esp_crt_bundle_attach,  // 使用证书包而不是全局CA存储
+    };
+}
+
+// 连接预热任务：提前完成到ASR和GLM的握手，录音结束后直接在热连接上发送
+static void prewarm_task(void *arg)
+{
+    esp_http_client_config_t config;
+    asr_client_config(&config, NULL);
+    tls_session_prewarm(&asr_session, &config);
+    if (g_page_active) {
+        ai_chat_prewarm();
+    }
+    
+    // 预热期间已离开页面：补关连接
+    if (!g_page_active) {
+        tls_session_close_idle(&asr_session);
+        ai_chat_close_idle();
+    }
+    g_prewarm_running = false;
+    vTaskDelete(NULL);
+}
+
+static void start_prewarm(void)
+{
+    if (g_prewarm_running || wifi_get_status() != WIFI_STATUS_CONNECTED) {
+        return;
+    }
+    g_prewarm_running = true;
+    if (xTaskCreate(prewarm_task, "net_prewarm", 8192, NULL, 4, NULL) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create prewarm task");
+        g_prewarm_running = false;
     }
+}
+
+// 检查流式解析得到的API响应（胜出槽位的解析已结束）
+static esp_err_t parse_api_response(asr_slot_t *slot)
+{
+    const json_stream_field_t *fields = slot->fields;
     
-    cJSON *response_obj = cJSON_GetObjectItem(json, "Response");
-    if (!response_obj) {
+    if (fields[ASR_FIELD_RESPONSE].type == JSON_STREAM_NONE) {
         ESP_LOGE(TAG, "No Response object in JSON");
-        cJSON_Delete(json);
-        return ESP_FAIL;
+        return ESP_ERR_INVALID_RESPONSE;
     }
     
     // 检查是否有错误
-    cJSON *error_obj = cJSON_GetObjectItem(response_obj, "Error");
-    if (error_obj) {
-        cJSON *code = cJSON_GetObjectItem(error_obj, "Code");
-        cJSON *message = cJSON_GetObjectItem(error_obj, "Message");
-        
+    if (fields[ASR_FIELD_ERROR].type != JSON_STREAM_NONE) {
         snprintf(g_speech_result.error_message, sizeof(g_speech_result.error_message),
                 "API Error: %s - %s",
-                code ? code->valuestring : "Unknown",
-                message ? message->valuestring : "Unknown error");
+                fields[ASR_FIELD_ERROR_CODE].type != JSON_STREAM_NONE ? slot->error_code : "Unknown",
+                fields[ASR_FIELD_ERROR_MESSAGE].type != JSON_STREAM_NONE ? slot->error_message : "Unknown error");
         
         g_speech_result.state = SPEECH_STATE_ERROR;
-        cJSON_Delete(json);
-        return ESP_FAIL;
+        return ESP_ERR_INVALID_RESPONSE;   // 签名、鉴权等错误，重试无意义
     }
     
-    // 获取识别结果
-    cJSON *result = cJSON_GetObjectItem(response_obj, "Result");
-    if (result && result->valuestring) {
-        strncpy(g_speech_result.result_text, result->valuestring, sizeof(g_speech_result.result_text) - 1);
-        g_speech_result.result_text[sizeof(g_speech_result.result_text) - 1] = '\0';
-    } else {
-        // 结果为空
-        g_speech_result.result_text[0] = '\0';
-    }
+    // 获取识别结果（缺失时为空串）
+    memcpy(g_speech_result.result_text, slot->result, sizeof(g_speech_result.result_text));
     
     // 获取音频时长
-    cJSON *duration = cJSON_GetObjectItem(response_obj, "AudioDuration");
-    if (duration) {
-        g_speech_result.audio_duration = duration->valueint;
+    if (fields[ASR_FIELD_DURATION].type == JSON_STREAM_LITERAL) {
+        g_speech_result.audio_duration = atoi(slot->duration);
     }
     
     // 检查是否有有效的识别结果
@@ -593,7 +632,7 @@ static esp_err_t parse_api_response(const char *response)
         ESP_LOGI(TAG, "Sending to GLM-4-Flash AI: '%s'", g_speech_result.result_text);
         
         ai_chat_response_t ai_response;
-        esp_err_t ai_ret = ai_chat_send_message(g_speech_result.result_text, &ai_response);
+        esp_err_t ai_ret = ai_chat_send_message(g_speech_result.result_text, &ai_response, &g_speech_cancel);
         
         if (ai_ret == ESP_OK && ai_response.success) {
             ESP_LOGI(TAG, "=== AI回复开始 ===");
@@ -722,19 +761,17 @@ static esp_err_t parse_api_response(const char *response)
         ESP_LOGW(TAG, "No speech detected in audio");
     }
     
-    cJSON_Delete(json);
     return ESP_OK;
 }
 
-// 发送API请求
-static esp_err_t send_api_request(const char *audio_data_base64, size_t data_len)
+// 在槽位的连接上构建请求体并发送，收到完整的200响应即为成功，识别结果在parse_api_response中处理
+static esp_err_t post_recognition_request(asr_slot_t *slot, net_cancel_t *cancel)
 {
+    const char *audio_data_base64 = slot->audio_data_base64;
+    size_t data_len = slot->data_len;
     esp_err_t ret = ESP_FAIL;
     
-    // 清空响应缓冲区
-    if (g_http_response_buffer) {
-        memset(g_http_response_buffer, 0, HTTP_RESPONSE_BUFFER_SIZE);
-    }
+    slot->status_code = 0;
     
     // 构建请求体 - 按照腾讯云语音识别API的正确格式
     cJSON *json = cJSON_CreateObject();
@@ -742,7 +779,7 @@ static esp_err_t send_api_request(const char *audio_data_base64, size_t data_len
     cJSON *source_type = cJSON_CreateNumber(1);
     cJSON *voice_format = cJSON_CreateString("wav");
     cJSON *usr_audio_key = cJSON_CreateString("esp32-speech-recognition");
-    cJSON *data = cJSON_CreateString(audio_data_base64);
+    cJSON *data = cJSON_CreateStringReference(audio_data_base64);  // 引用Base64缓冲区，不再复制一份
     cJSON *data_len_json = cJSON_CreateNumber(data_len);
     
     cJSON_AddItemToObject(json, "EngSerViceType", eng_service_type);
@@ -760,39 +797,32 @@ static esp_err_t send_api_request(const char *audio_data_base64, size_t data_len
     }
     
     // 配置HTTP客户端
-    esp_http_client_config_t config = {
-        .host = TENCENT_ASR_HOST,
-        .path = "/",
-        .port = 443,
-        .transport_type = HTTP_TRANSPORT_OVER_SSL,
-        .event_handler = http_event_handler,
-        .timeout_ms = 30000,
-        .skip_cert_common_name_check = true,    // 跳过证书通用名检查
-        .crt_bundle_attach = esp_crt_bundle_attach,  // 使用证书包而不是全局CA存储
-    };
+    esp_http_client_config_t config;
+    asr_client_config(&config, slot);
     
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    esp_http_client_handle_t client = tls_session_acquire(slot->session, &config);
     if (!client) {
         ESP_LOGE(TAG, "Failed to initialize HTTP client");
-        free(json_string);
+        cJSON_free(json_string);
         cJSON_Delete(json);
         return ESP_FAIL;
     }
     
+    // 句柄空闲后再清空上次的解析结果（预热请求结束前不能动解析器）
+    json_stream_init(&slot->stream, slot->fields, ASR_FIELD_COUNT);
+    http_decoder_begin(&slot->decoder, &asr_decode, feed_response, &slot->stream);
+    
     // 设置请求头
     esp_http_client_set_method(client, HTTP_METHOD_POST);
     esp_http_client_set_header(client, "Content-Type", "application/json; charset=utf-8");
     esp_http_client_set_header(client, "Host", TENCENT_ASR_HOST);
+    http_decode_accept(client);
     
-    // 尝试同步时间
-    esp_err_t sync_ret = sync_time_with_ntp();
-    
-    // 获取当前时间戳
-    time_t now;
-    time(&now);
+    // 从时间服务获取UTC时间戳（不阻塞，由后台SNTP校时）
+    time_t now = (time_t)time_service_get_utc_seconds();
     
-    // 如果时间同步失败或时间看起来不合理，使用合理的时间戳
-    if (sync_ret != ESP_OK || now < 1577836800) {  // 2020-01-01 00:00:00 UTC
+    // 如果时钟尚未建立或时间看起来不合理，使用合理的时间戳
+    if (now < 1577836800) {  // 2020-01-01 00:00:00 UTC
         // 使用一个基于当前日期的合理时间戳（2025年6月15日 15:30:00 UTC）
         now = 1749972600;  // 稍微调整时间，避免过期
         ESP_LOGW(TAG, "Using fallback time: %lld", (long long)now);
@@ -804,9 +834,10 @@ static esp_err_t send_api_request(const char *audio_data_base64, size_t data_len
     snprintf(timestamp_str, sizeof(timestamp_str), "%lld", (long long)now);
     
     // 生成当前日期字符串
-    struct tm *timeinfo = gmtime(&now);
+    civil_time_t utc_date;
+    civil_from_epoch(now, 0, &utc_date);
     char date_str[16];
-    strftime(date_str, sizeof(date_str), "%Y-%m-%d", timeinfo);
+    snprintf(date_str, sizeof(date_str), "%04d-%02d-%02d", utc_date.year, utc_date.month, utc_date.day);
     
     // 设置腾讯云API必需的请求头
     esp_http_client_set_header(client, "X-TC-Action", TENCENT_ASR_ACTION);
@@ -833,33 +864,107 @@ static esp_err_t send_api_request(const char *audio_data_base64, size_t data_len
     esp_http_client_set_post_field(client, json_string, strlen(json_string));
     
     // 发送请求
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        ESP_LOGI(TAG, "HTTP Status = %d", status_code);
+    esp_err_t err = tls_session_perform(slot->session, client, cancel);
+    esp_err_t decode_err = http_decoder_finish(&slot->decoder);
+    if (err == ESP_OK && decode_err != ESP_OK) {
+        ret = decode_err;   // 响应已收完但压缩数据损坏，重试无意义
+    } else if (err == ESP_OK) {
+        slot->status_code = esp_http_client_get_status_code(client);
+        ESP_LOGI(TAG, "%s HTTP Status = %d", slot->session->name, slot->status_code);
         
-        if (status_code == 200 && g_http_response_buffer) {
-            ESP_LOGI(TAG, "API Response: %s", g_http_response_buffer);
-            ret = parse_api_response(g_http_response_buffer);
+        if (slot->status_code == 200) {
+            ESP_LOGI(TAG, "API Response: %u bytes, Result: %s", (unsigned)slot->stream.bytes, slot->result);
+            ret = ESP_OK;
+            if (json_stream_finish(&slot->stream) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to parse JSON response");
+                ret = ESP_ERR_INVALID_RESPONSE;
+            }
         } else {
-            snprintf(g_speech_result.error_message, sizeof(g_speech_result.error_message),
-                    "HTTP Error: Status %d", status_code);
-            g_speech_result.state = SPEECH_STATE_ERROR;
+            // 只有服务端繁忙才值得重试
+            ret = (slot->status_code >= 500 || slot->status_code == 429) ? ESP_FAIL : ESP_ERR_INVALID_RESPONSE;
         }
+    } else if (net_cancel_is_cancelled(cancel)) {
+        ESP_LOGW(TAG, "%s request cancelled", slot->session->name);
+        ret = ESP_ERR_INVALID_STATE;
     } else {
-        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
-        snprintf(g_speech_result.error_message, sizeof(g_speech_result.error_message),
-                "HTTP Request Failed: %s", esp_err_to_name(err));
-        g_speech_result.state = SPEECH_STATE_ERROR;
+        ESP_LOGE(TAG, "%s HTTP request failed: %s", slot->session->name, esp_err_to_name(err));
+        ret = err;
     }
     
-    esp_http_client_cleanup(client);
-    free(json_string);
+    // 成功时保留客户端和TLS会话供下次复用
+    tls_session_release(slot->session, err);
+    cJSON_free(json_string);
     cJSON_Delete(json);
     
     return ret;
 }
 
+typedef struct {
+    const char *audio_data_base64;
+    size_t data_len;
+} asr_request_args_t;
+
+// 一次识别请求，主请求在工作任务中执行，对冲请求在对冲任务中执行
+static esp_err_t run_recognition_attempt(void *arg, net_cancel_t *cancel)
+{
+    asr_slot_t *slot = arg;
+    // 请求体的cJSON节点和打印结果在请求结束时一次性释放（AI对话使用自己的分配池）
+    json_arena_begin(slot->arena);
+    esp_err_t ret = post_recognition_request(slot, cancel);
+    json_arena_end(slot->arena);
+    return ret;
+}
+
+// 在网络服务的工作任务中执行，慢于p90时在另一条连接上对冲
+static esp_err_t run_recognition_request(void *arg)
+{
+    const asr_request_args_t *args = arg;
+    asr_primary.audio_data_base64 = args->audio_data_base64;
+    asr_primary.data_len = args->data_len;
+    asr_hedge_slot.audio_data_base64 = args->audio_data_base64;
+    asr_hedge_slot.data_len = args->data_len;
+    
+    int winner = 0;
+    esp_err_t ret = net_hedge_call(&asr_hedge, &g_speech_cancel, &winner);
+    asr_slot_t *slot = winner ? &asr_hedge_slot : &asr_primary;
+    if (ret == ESP_OK) {
+        return parse_api_response(slot);
+    }
+    
+    g_speech_result.state = SPEECH_STATE_ERROR;
+    if (net_cancel_is_cancelled(&g_speech_cancel)) {
+        strcpy(g_speech_result.error_message, "Cancelled");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (slot->status_code != 0 && slot->status_code != 200) {
+        snprintf(g_speech_result.error_message, sizeof(g_speech_result.error_message),
+                "HTTP Error: Status %d", slot->status_code);
+    } else if (slot->status_code == 0) {
+        snprintf(g_speech_result.error_message, sizeof(g_speech_result.error_message),
+                "HTTP Request Failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+// 发送API请求，语音优先级排在天气等后台请求之前
+static esp_err_t send_api_request(const char *audio_data_base64, size_t data_len)
+{
+    asr_request_args_t args = {
+        .audio_data_base64 = audio_data_base64,
+        .data_len = data_len,
+    };
+    net_request_t request = {
+        .host = TENCENT_ASR_HOST,
+        .priority = NET_PRIORITY_VOICE,
+        .run = run_recognition_request,
+        .arg = &args,
+        .max_attempts = 2,          // 连接被对端关闭等瞬时错误重试一次
+        .backoff_ms = 300,
+        .cancel = &g_speech_cancel,
+    };
+    return net_service_call(&request);
+}
+
 // 录音任务
 static void speech_recognition_task(void *arg)
 {
@@ -870,11 +975,11 @@ static void speech_recognition_task(void *arg)
     size_t min_heap = esp_get_minimum_free_heap_size();
     ESP_LOGI(TAG, "Free heap: %zu bytes, Min free heap: %zu bytes", free_heap, min_heap);
     
-    // 估算需要的内存 (32位原始缓冲区 + 16位PCM缓冲区 + HTTP缓冲区)
+    // 估算需要的内存 (32位原始缓冲区 + 16位PCM缓冲区)
     size_t raw_buffer_size = SPEECH_BUFFER_SIZE * 2;  // 32位数据需要2倍空间
-    size_t required_memory = raw_buffer_size + SPEECH_BUFFER_SIZE + HTTP_RESPONSE_BUFFER_SIZE + 8192;
-    ESP_LOGI(TAG, "Required memory: %zu bytes (raw:%zu + pcm:%d + http:%d)", 
-             required_memory, raw_buffer_size, SPEECH_BUFFER_SIZE, HTTP_RESPONSE_BUFFER_SIZE);
+    size_t required_memory = raw_buffer_size + SPEECH_BUFFER_SIZE + 8192;
+    ESP_LOGI(TAG, "Required memory: %zu bytes (raw:%zu + pcm:%d)", 
+             required_memory, raw_buffer_size, SPEECH_BUFFER_SIZE);
     
     if (free_heap < required_memory) {
         ESP_LOGE(TAG, "Insufficient memory: need %zu, have %zu", required_memory, free_heap);
@@ -915,19 +1020,8 @@ static void speech_recognition_task(void *arg)
         ESP_LOGI(TAG, "PCM audio buffer allocated in PSRAM: %d bytes", SPEECH_BUFFER_SIZE);
     }
     
-    // HTTP响应缓冲区
-    g_http_response_buffer = malloc(HTTP_RESPONSE_BUFFER_SIZE);
-    if (!g_http_response_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate HTTP response buffer (%d bytes)", HTTP_RESPONSE_BUFFER_SIZE);
-        g_speech_result.state = SPEECH_STATE_ERROR;
-        strcpy(g_speech_result.error_message, "HTTP buffer allocation failed");
-        goto cleanup;
-    }
-    ESP_LOGI(TAG, "HTTP response buffer allocated: %d bytes", HTTP_RESPONSE_BUFFER_SIZE);
-    
     memset(g_raw_audio_buffer, 0, raw_buffer_size);
     memset(g_audio_buffer, 0, SPEECH_BUFFER_SIZE);
-    memset(g_http_response_buffer, 0, HTTP_RESPONSE_BUFFER_SIZE);
     
     // 初始化I2S
     if (i2s_mic_init() != ESP_OK) {
@@ -969,7 +1063,8 @@ static void speech_recognition_task(void *arg)
     uint32_t successful_reads = 0;
     
     while (total_bytes_read < raw_buffer_size && 
-           (xTaskGetTickCount() - start_time) < timeout_ticks) {
+           (xTaskGetTickCount() - start_time) < timeout_ticks &&
+           !net_cancel_is_cancelled(&g_speech_cancel)) {
         
         size_t remaining = raw_buffer_size - total_bytes_read;
         size_t read_size = (remaining > 1024) ? 1024 : remaining; // 优化读取块大小
@@ -1000,7 +1095,8 @@ static void speech_recognition_task(void *arg)
         }
     }
     
-        ESP_LOGI(TAG, "I2S read completed: %"PRIu32" attempts, %"PRIu32" successful, %zu bytes total",
+    int64_t recording_end_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "I2S read completed: %"PRIu32" attempts, %"PRIu32" successful, %zu bytes total",
              read_attempts, successful_reads, total_bytes_read);
     
     ESP_LOGI(TAG, "Raw audio recording completed, read %zu bytes (32-bit)", total_bytes_read);
@@ -1027,6 +1123,11 @@ static void speech_recognition_task(void *arg)
         ESP_LOGW(TAG, "Failed to disable I2S channel: %s", esp_err_to_name(disable_ret));
     }
     
+    if (net_cancel_is_cancelled(&g_speech_cancel)) {
+        ESP_LOGW(TAG, "Recording cancelled");
+        goto cleanup;
+    }
+    
     if (total_bytes_read == 0 || sample_count == 0) {
         ESP_LOGE(TAG, "No audio data recorded");
         g_speech_result.state = SPEECH_STATE_ERROR;
@@ -1100,6 +1201,10 @@ static void speech_recognition_task(void *arg)
         wav_data = NULL;
     }
     
+    if (net_cancel_is_cancelled(&g_speech_cancel)) {
+        goto cleanup;
+    }
+    
     // 发送API请求
     ESP_LOGI(TAG, "Sending API request to Tencent Cloud");
     if (send_api_request(g_base64_buffer, wav_len) != ESP_OK) {
@@ -1110,6 +1215,15 @@ static void speech_recognition_task(void *arg)
         }
     }
     
+    if (g_speech_result.has_ai_reply) {
+        tls_session_stats_t glm_stats;
+        ai_chat_get_tls_stats(&glm_stats);
+        if (glm_stats.last_first_byte_at_us > recording_end_us) {
+            g_last_reply_latency_ms = (int32_t)((glm_stats.last_first_byte_at_us - recording_end_us) / 1000);
+            ESP_LOGI(TAG, "录音结束到AI回复首字节: %ld ms", (long)g_last_reply_latency_ms);
+        }
+    }
+    
 cleanup:
     // 释放内存
     if (g_raw_audio_buffer) {
@@ -1121,23 +1235,41 @@ cleanup:
         g_audio_buffer = NULL;
     }
     if (g_base64_buffer) {
+        // 落后的对冲请求可能还在读取音频数据
+        net_hedge_wait_idle(&asr_hedge);
         free(g_base64_buffer);
         g_base64_buffer = NULL;
     }
-    if (g_http_response_buffer) {
-        free(g_http_response_buffer);
-        g_http_response_buffer = NULL;
-    }
     
     // I2S保持初始化状态以供下次使用
     
+    if (net_cancel_is_cancelled(&g_speech_cancel)) {
+        g_last_cancel_reclaim_ms = (int32_t)((esp_timer_get_time() - g_speech_cancel.cancelled_at_us) / 1000);
+        ESP_LOGI(TAG, "取消后 %ld ms 释放完毕，PSRAM空闲 %u 字节",
+                 (long)g_last_cancel_reclaim_ms, (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    }
+    
     g_speech_active = false;
     g_speech_task_handle = NULL;
+    g_task_running = false;
     
     ESP_LOGI(TAG, "Speech recognition task completed");
     vTaskDelete(NULL);
 }
 
+// 等待录音任务退出，超时返回false
+static bool wait_task_exit(uint32_t timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (g_task_running) {
+        if ((xTaskGetTickCount() - start) >= pdMS_TO_TICKS(timeout_ms)) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+}
+
 // 公共函数实现
 esp_err_t speech_recognition_init(void)
 {
@@ -1160,6 +1292,10 @@ esp_err_t speech_recognition_init(void)
         return ai_ret;
     }
     
+    // 进入AI助手页面即预热到云端的连接
+    g_page_active = true;
+    start_prewarm();
+    
     ESP_LOGI(TAG, "Speech recognition initialized");
     return ESP_OK;
 }
@@ -1176,15 +1312,25 @@ esp_err_t speech_recognition_start(void)
         return ESP_ERR_INVALID_STATE;
     }
     
+    // 上一轮被取消后仍在断开连接、释放缓冲区，稍等其结束
+    if (!wait_task_exit(SPEECH_CANCEL_WAIT_MS)) {
+        xSemaphoreGive(g_speech_mutex);
+        ESP_LOGW(TAG, "Previous recognition still finishing");
+        return ESP_ERR_INVALID_STATE;
+    }
+    net_cancel_reset(&g_speech_cancel);
+    
     // 重置结果
     memset(&g_speech_result, 0, sizeof(g_speech_result));
     g_speech_result.state = SPEECH_STATE_IDLE;
     
     // 创建任务 - 减少栈大小
+    g_task_running = true;
     BaseType_t ret = xTaskCreate(speech_recognition_task, "speech_rec", 
                                 8192, NULL, 5, &g_speech_task_handle);
     
     if (ret != pdPASS) {
+        g_task_running = false;
         xSemaphoreGive(g_speech_mutex);
         ESP_LOGE(TAG, "Failed to create speech recognition task");
         return ESP_FAIL;
@@ -1193,6 +1339,9 @@ esp_err_t speech_recognition_start(void)
     g_speech_active = true;
     xSemaphoreGive(g_speech_mutex);
     
+    // 录音期间补做预热（页面停留较久时连接可能已被服务器关闭）
+    start_prewarm();
+    
     ESP_LOGI(TAG, "Speech recognition started");
     return ESP_OK;
 }
@@ -1205,9 +1354,12 @@ esp_err_t speech_recognition_stop(void)
     
     g_speech_active = false;
     
-    // 等待任务结束
+    // 中止进行中的录音和请求，任务断开连接、释放缓冲区后自行删除
+    if (g_task_running) {
+        net_cancel_request(&g_speech_cancel);
+    }
+    
     if (g_speech_task_handle != NULL) {
-        // 任务会自动删除自己
         g_speech_task_handle = NULL;
     }
     
@@ -1226,8 +1378,19 @@ void speech_recognition_deinit(void)
 {
     speech_recognition_stop();
     
-    // 清理I2S资源
-    i2s_mic_deinit();
+    // 录音任务可能仍在读I2S，等它退出后再释放
+    if (!wait_task_exit(SPEECH_CANCEL_WAIT_MS)) {
+        ESP_LOGW(TAG, "Recognition task still running, I2S left initialized");
+    } else {
+        // 清理I2S资源
+        i2s_mic_deinit();
+    }
+    
+    // 离开页面关闭保持的连接，TLS会话票据保留
+    g_page_active = false;
+    tls_session_close_idle(&asr_session);
+    tls_session_close_idle(&asr_hedge_session);
+    ai_chat_close_idle();
     
     if (g_speech_mutex != NULL) {
         vSemaphoreDelete(g_speech_mutex);
@@ -1240,4 +1403,34 @@ void speech_recognition_deinit(void)
 bool speech_recognition_is_active(void)
 {
     return g_speech_active;
-} 
\ No newline at end of file
+}
+
+void speech_recognition_get_tls_stats(tls_session_stats_t *stats)
+{
+    tls_session_get_stats(&asr_session, stats);
+}
+
+int32_t speech_recognition_get_reply_latency_ms(void)
+{
+    return g_last_reply_latency_ms;
+} 
+
+int32_t speech_recognition_get_cancel_reclaim_ms(void)
+{
+    return g_last_cancel_reclaim_ms;
+}
+
+void speech_recognition_get_hedge_stats(net_hedge_stats_t *stats)
+{
+    net_hedge_get_stats(&asr_hedge, stats);
+}
+
+void speech_recognition_get_decode_stats(http_decode_stats_t *stats)
+{
+    http_decode_get_stats(&asr_decode, stats);
+}
+
+void speech_recognition_get_json_arena_stats(json_arena_stats_t *stats)
+{
+    json_arena_get_stats(&asr_arena, stats);
+}
@@ -5,6 +5,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "secrets.h"
+#include "tls_session.h"
+#include "json_arena.h"
+#include "net_hedge.h"
+#include "http_decode.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,6 +25,7 @@ extern "C" {
 #define TENCENT_ASR_ACTION      "SentenceRecognition"
 #define TENCENT_ASR_VERSION     "2019-06-14"
 #define TENCENT_ASR_REGION      ""  // 留空使用就近地域
+#define SPEECH_ASR_HEDGE_PERCENTILE 90  // 超过该分位耗时未返回时在新连接上重发，0关闭对冲
 
 // 音频配置 - 启用PSRAM后恢复正常配置
 #define SPEECH_SAMPLE_RATE      16000
@@ -35,9 +40,6 @@ extern "C" {
 // Base64编码后的大小估算 (WAV数据大小 * 4/3 + 填充 + 余量)
 #define SPEECH_BASE64_SIZE      (((SPEECH_BUFFER_SIZE + WAV_HEADER_SIZE) * 4 + 2) / 3 + 100)
 
-// HTTP响应缓冲区大小
-#define HTTP_RESPONSE_BUFFER_SIZE   4096
-
 // 语音识别状态
 typedef enum {
     SPEECH_STATE_IDLE,
@@ -66,6 +68,12 @@ speech_recognition_result_t* speech_recognition_get_result(void);
 void speech_recognition_deinit(void);
 bool speech_recognition_is_active(void);
 bool is_speech_recognition_running(void);
+void speech_recognition_get_tls_stats(tls_session_stats_t *stats);  // 腾讯云ASR连接的TLS握手统计
+int32_t speech_recognition_get_reply_latency_ms(void);  // 上次录音结束到AI回复首字节的耗时，-1表示尚无数据
+int32_t speech_recognition_get_cancel_reclaim_ms(void);  // 上次取消到缓冲区、连接释放完毕的耗时，-1表示尚无数据
+void speech_recognition_get_json_arena_stats(json_arena_stats_t *stats);  // ASR请求JSON的cJSON分配池统计
+void speech_recognition_get_hedge_stats(net_hedge_stats_t *stats);  // ASR耗时分布与对冲统计
+void speech_recognition_get_decode_stats(http_decode_stats_t *stats);  // ASR响应的线上字节与解压后字节
 
 #ifdef __cplusplus
 }
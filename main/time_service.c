@@ -0,0 +1,810 @@
+#include "time_service.h"
+#include "rtc_calib.h"
+#include "civil_time.h"
+#include "wifi_manager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_netif_sntp.h"
+#include "esp_http_client.h"
+#include "json_stream.h"
+#include "net_service.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+
+static const char *TAG = "TIME_SERVICE";
+
+#define US_PER_SECOND                   1000000LL
+#define TIME_SERVICE_VERIFY_INTERVAL_S  600     // 硬件秒边沿模式下每10分钟与RTC核对一次
+#define TIME_SERVICE_FALLBACK_VERIFY_S  60      // 软件秒边沿模式下每分钟核对一次
+#define TIME_SERVICE_MAX_TICK_CB        4
+#define TIME_SERVICE_EDGE_TIMEOUT_MS    1500    // 超过此时长没有秒中断即改用软件秒边沿，中断恢复后切回
+
+/* 网络校时 */
+#define TIME_SNTP_SERVER_PRIMARY        "ntp.aliyun.com"
+#define TIME_SNTP_SERVER_SECONDARY      "pool.ntp.org"
+#define TIME_SNTP_INTERVAL_MS           3600000             // 默认每小时一次SNTP
+#define TIME_SNTP_MAX_INTERVAL_MS       (24 * 3600000)      // RTC漂移校准完成后按漂移推算，最长一天一次
+#define TIME_DRIFT_BUDGET_US            TIME_STEP_THRESHOLD_US  // 两次校时之间允许RTC累积的误差
+#define TIME_HTTP_FALLBACK_HOST         "f.m.suning.com"
+#define TIME_HTTP_FALLBACK_URL          "http://" TIME_HTTP_FALLBACK_HOST "/api/ct.do"
+#define TIME_HTTP_FALLBACK_AFTER_S      120                 // WiFi连接后SNTP迟迟未同步时改用HTTP
+#define TIME_HTTP_STALE_MARGIN_S        3600                // 超过SNTP间隔再1小时仍没有成功时改用HTTP
+#define TIME_STEP_THRESHOLD_US          50000LL             // RTC偏差超过50ms才重写
+#define TIME_ALIGN_MIN_LEAD_US          20000LL             // 距整秒不足20ms时顺延到下一秒
+#define TIME_ALIGN_SPIN_US              3000LL              // 整秒前最后3ms忙等
+#define TIME_WRITE_LEAD_US              120LL               // I2C写入从发起到秒寄存器字节落地的时间（400kHz）
+#define TIME_SYNC_TASK_PERIOD_MS        30000
+
+static portMUX_TYPE time_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t base_local_s = 0;    // 最近一个秒边沿对应的本地时间（自1970-01-01起的秒数）
+static int64_t base_us = 0;         // 该秒边沿的esp_timer时间
+static bool time_valid = false;
+static bool edge_locked = false;    // base_us是否对齐到RTC秒边沿
+static volatile bool edge_driven = false;  // 当前由RTC秒中断驱动（否则为esp_timer软件秒边沿）
+static uint32_t seconds_since_verify = 0;
+
+static ds3231_regs_t rtc_regs;          // 最近一次核对时读取的RTC寄存器
+static bool rtc_regs_valid = false;
+
+static time_service_tick_cb_t tick_callbacks[TIME_SERVICE_MAX_TICK_CB];
+static int tick_callback_count = 0;
+static esp_timer_handle_t soft_tick_timer = NULL;
+static esp_timer_handle_t edge_watchdog_timer = NULL;
+
+/* 网络校时状态 */
+static TaskHandle_t sync_task_handle = NULL;
+static portMUX_TYPE sync_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool sntp_pending = false;       // SNTP回调中采集的时间对待处理
+static int64_t sntp_esp_us = 0;
+static int64_t sntp_ref_us = 0;
+static bool network_enabled = true;
+static time_sync_info_t sync_info = {0};
+static int64_t last_sync_uptime_us = 0; // 最近一次成功校时的esp_timer时间
+static uint32_t sntp_interval_ms = TIME_SNTP_INTERVAL_MS;
+static int64_t residual_edge_expected_us = 0;  // 对齐写入后预期的下一个秒中断时刻
+
+static int64_t time_to_seconds(const ds3231_time_t *time)
+{
+    return civil_days_from_date(time->year, time->month, time->date) * CIVIL_SECONDS_PER_DAY +
+           time->hour * 3600 + time->minute * 60 + time->second;
+}
+
+/* RTC保存本地时间，这里以偏移0把本地秒数展开为日期 */
+static void seconds_to_time(int64_t seconds, ds3231_time_t *time)
+{
+    civil_time_t civil;
+
+    civil_from_epoch(seconds, 0, &civil);
+    time->year = civil.year;
+    time->month = civil.month;
+    time->date = civil.day;
+    time->hour = civil.hour;
+    time->minute = civil.minute;
+    time->second = civil.second;
+    time->day_of_week = civil.day_of_week;
+}
+
+static void time_service_rebase(int64_t local_s, int64_t edge_us, bool locked)
+{
+    portENTER_CRITICAL(&time_lock);
+    base_local_s = local_s;
+    base_us = edge_us;
+    time_valid = true;
+    edge_locked = locked;
+    portEXIT_CRITICAL(&time_lock);
+    seconds_since_verify = 0;
+}
+
+/* 用本地时间设置系统时钟（UTC），供TLS证书校验等依赖time()的组件使用 */
+static void time_service_seed_system_clock(int64_t local_us)
+{
+    int64_t utc_us = local_us - (int64_t)TIME_SERVICE_UTC_OFFSET_S * US_PER_SECOND;
+    struct timeval tv = {
+        .tv_sec = utc_us / US_PER_SECOND,
+        .tv_usec = utc_us % US_PER_SECOND,
+    };
+    settimeofday(&tv, NULL);
+}
+
+/* RTC整块读取完成：比较秒数，并缓存温度/控制/状态寄存器 */
+static void time_service_verify_done(esp_err_t result, const ds3231_regs_t *regs, void *arg)
+{
+    if (result != ESP_OK) {
+        return;
+    }
+
+    int64_t rtc_s = time_to_seconds(&regs->time);
+    portENTER_CRITICAL(&time_lock);
+    rtc_regs = *regs;
+    rtc_regs_valid = true;
+    int64_t diff = 0;
+    if (time_valid) {
+        int64_t mem_s = base_local_s + (esp_timer_get_time() - base_us) / US_PER_SECOND;
+        diff = rtc_s - mem_s;
+        base_local_s += diff;
+    }
+    portEXIT_CRITICAL(&time_lock);
+
+    if (diff != 0) {
+        ESP_LOGW(TAG, "Memory clock off by %lld s, resynced to RTC", (long long)diff);
+    }
+}
+
+/* 与RTC核对：秒边沿刚过时异步读取，不阻塞秒边沿处理 */
+static void time_service_verify(void)
+{
+    seconds_since_verify = 0;
+    if (ds3231_read_all_async(time_service_verify_done, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "RTC verify request dropped");
+    }
+}
+
+static void time_service_dispatch_tick(void)
+{
+    for (int i = 0; i < tick_callback_count; i++) {
+        tick_callbacks[i]();
+    }
+}
+
+static void time_service_schedule_soft_tick(void);
+
+/* 秒中断停止：改用软件秒边沿，已在软件模式时不重复安排 */
+static void time_service_use_soft_tick(void)
+{
+    portENTER_CRITICAL(&time_lock);
+    bool was_edge_driven = edge_driven;
+    edge_driven = false;
+    portEXIT_CRITICAL(&time_lock);
+
+    if (was_edge_driven) {
+        ESP_LOGW(TAG, "No RTC 1 Hz interrupt for %d ms, switching to esp_timer ticks", TIME_SERVICE_EDGE_TIMEOUT_MS);
+        time_service_schedule_soft_tick();
+    }
+}
+
+static void time_service_edge_watchdog_callback(void *arg)
+{
+    time_service_use_soft_tick();
+}
+
+/* 驱动判定INT引脚未接线，中断不会再来 */
+static void time_service_int_lost(void)
+{
+    esp_timer_stop(edge_watchdog_timer);
+    time_service_use_soft_tick();
+}
+
+/* DS3231闹钟1每秒中断：RTC秒寄存器刚递增 */
+static void time_service_edge_callback(uint8_t alarm, int64_t edge_us)
+{
+    esp_timer_stop(edge_watchdog_timer);
+    esp_timer_start_once(edge_watchdog_timer, TIME_SERVICE_EDGE_TIMEOUT_MS * 1000LL);
+    if (!edge_driven) {
+        /* 看门狗超时后中断又恢复：停掉软件秒边沿，本次中断照常处理 */
+        esp_timer_stop(soft_tick_timer);
+        edge_driven = true;
+        ESP_LOGI(TAG, "RTC 1 Hz interrupt resumed");
+    }
+
+    portENTER_CRITICAL(&time_lock);
+    int64_t elapsed = edge_us - base_us;
+    int64_t seconds;
+    if (edge_locked) {
+        /* 已对齐：按最近整秒计，漏掉的中断也能补上 */
+        seconds = (elapsed + US_PER_SECOND / 2) / US_PER_SECOND;
+    } else {
+        /* 启动时在任意相位读取RTC，之后的第一个边沿即下一秒 */
+        seconds = elapsed / US_PER_SECOND + 1;
+    }
+    if (seconds < 1) {
+        seconds = 1;
+    }
+    base_local_s += seconds;
+    base_us = edge_us;
+    edge_locked = true;
+    portEXIT_CRITICAL(&time_lock);
+
+    /* 对齐写入后的第一个秒中断：实测RTC秒边沿相对参考整秒的残差 */
+    if (residual_edge_expected_us != 0) {
+        int64_t residual_us = edge_us - residual_edge_expected_us;
+        residual_edge_expected_us = 0;
+        portENTER_CRITICAL(&sync_lock);
+        sync_info.last_residual_us = residual_us;
+        portEXIT_CRITICAL(&sync_lock);
+        ESP_LOGI(TAG, "RTC phase residual %lld us", (long long)residual_us);
+    }
+
+    seconds_since_verify += seconds;
+    if (seconds_since_verify >= TIME_SERVICE_VERIFY_INTERVAL_S) {
+        time_service_verify();
+    }
+
+    time_service_dispatch_tick();
+}
+
+/* 软件秒边沿：按内存时钟安排到下一个整秒 */
+static void time_service_schedule_soft_tick(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&time_lock);
+    int64_t next = base_us + ((now - base_us) / US_PER_SECOND + 1) * US_PER_SECOND;
+    portEXIT_CRITICAL(&time_lock);
+    esp_timer_start_once(soft_tick_timer, next - now);
+}
+
+static void time_service_soft_tick_callback(void *arg)
+{
+    if (edge_driven) {
+        return;     // 秒中断已恢复
+    }
+    seconds_since_verify++;
+    if (seconds_since_verify >= TIME_SERVICE_FALLBACK_VERIFY_S) {
+        time_service_verify();
+    }
+
+    time_service_dispatch_tick();
+    time_service_schedule_soft_tick();
+}
+
+/* 轮询等待RTC秒数变化，得到秒边沿的近似时刻（误差约10ms） */
+static esp_err_t time_service_find_edge(void)
+{
+    ds3231_time_t first;
+    ds3231_time_t now;
+    esp_err_t ret = ds3231_get_time(&first);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    for (int i = 0; i < 120; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        ret = ds3231_get_time(&now);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (now.second != first.second) {
+            time_service_rebase(time_to_seconds(&now), esp_timer_get_time(), true);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t time_service_init(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* 时区由时间服务统一设置，RTC中保存的是本地时间 */
+    setenv("TZ", TIME_SERVICE_TZ, 1);
+    tzset();
+
+    /* 软件秒边沿的定时器总是创建：秒中断模式下中断停止时也要切换过去 */
+    const esp_timer_create_args_t timer_args = {
+        .callback = time_service_soft_tick_callback,
+        .name = "time_tick",
+    };
+    const esp_timer_create_args_t watchdog_args = {
+        .callback = time_service_edge_watchdog_callback,
+        .name = "time_edge_wdt",
+    };
+    ret = esp_timer_create(&timer_args, &soft_tick_timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_create(&watchdog_args, &edge_watchdog_timer);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create tick timer");
+        return ret;
+    }
+
+    if (ds3231_alarm_int_init() == ESP_OK &&
+        ds3231_register_alarm_callback(DS3231_ALARM1, time_service_edge_callback) == ESP_OK &&
+        ds3231_set_alarm1_every_second() == ESP_OK &&
+        ds3231_set_alarm_enabled(DS3231_ALARM1, true) == ESP_OK) {
+        edge_driven = true;
+        ds3231_register_int_lost_callback(time_service_int_lost);
+        esp_timer_start_once(edge_watchdog_timer, TIME_SERVICE_EDGE_TIMEOUT_MS * 1000LL);
+
+        /* 读取一次RTC，第一个中断到来时对齐秒边沿 */
+        ds3231_time_t time;
+        ret = ds3231_get_time(&time);
+        if (ret == ESP_OK) {
+            time_service_rebase(time_to_seconds(&time), esp_timer_get_time(), false);
+        }
+        ESP_LOGI(TAG, "Time service running on DS3231 1 Hz interrupt");
+    } else {
+        edge_driven = false;
+
+        ret = time_service_find_edge();
+        if (ret != ESP_OK) {
+            /* 未找到秒边沿时仍以当前时刻为基准 */
+            ds3231_time_t time;
+            if (ds3231_get_time(&time) == ESP_OK) {
+                time_service_rebase(time_to_seconds(&time), esp_timer_get_time(), true);
+                ret = ESP_OK;
+            }
+        }
+        time_service_schedule_soft_tick();
+        ESP_LOGW(TAG, "Time service running on esp_timer, RTC verified every %d s", TIME_SERVICE_FALLBACK_VERIFY_S);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read RTC: %s", esp_err_to_name(ret));
+    } else {
+        time_service_seed_system_clock(time_service_get_local_us());
+        /* 读取一次温度和控制/状态寄存器供状态接口使用 */
+        ds3231_read_all_async(time_service_verify_done, NULL);
+    }
+    return ret;
+}
+
+int64_t time_service_get_local_us(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&time_lock);
+    if (!time_valid) {
+        portEXIT_CRITICAL(&time_lock);
+        return 0;
+    }
+    int64_t local_us = base_local_s * US_PER_SECOND + (now - base_us);
+    portEXIT_CRITICAL(&time_lock);
+
+    return local_us;
+}
+
+esp_err_t time_service_get_time(ds3231_time_t *time)
+{
+    int64_t local_us = time_service_get_local_us();
+    if (local_us <= 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    seconds_to_time(local_us / US_PER_SECOND, time);
+    return ESP_OK;
+}
+
+esp_err_t time_service_set_time(const ds3231_time_t *time)
+{
+    esp_err_t ret = ds3231_set_time(time);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    /* 写秒寄存器会复位DS3231分频链，下一个秒边沿在1秒后到来 */
+    time_service_rebase(time_to_seconds(time), esp_timer_get_time(), true);
+    /* 时间被步进到未知位置，之前的漂移样本序列失效 */
+    rtc_calib_reset();
+    time_service_seed_system_clock(time_service_get_local_us());
+    if (soft_tick_timer) {
+        esp_timer_stop(soft_tick_timer);
+        time_service_schedule_soft_tick();
+    }
+    return ESP_OK;
+}
+
+esp_err_t time_service_register_tick(time_service_tick_cb_t cb)
+{
+    if (tick_callback_count >= TIME_SERVICE_MAX_TICK_CB) {
+        return ESP_ERR_NO_MEM;
+    }
+    tick_callbacks[tick_callback_count++] = cb;
+    return ESP_OK;
+}
+
+esp_err_t time_service_get_rtc_regs(ds3231_regs_t *regs)
+{
+    portENTER_CRITICAL(&time_lock);
+    bool valid = rtc_regs_valid;
+    if (valid) {
+        *regs = rtc_regs;
+    }
+    portEXIT_CRITICAL(&time_lock);
+    return valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+bool time_service_is_edge_driven(void)
+{
+    return edge_driven;
+}
+
+int64_t time_service_get_utc_seconds(void)
+{
+    int64_t local_us = time_service_get_local_us();
+    if (local_us <= 0) {
+        return 0;
+    }
+    return local_us / US_PER_SECOND - TIME_SERVICE_UTC_OFFSET_S;
+}
+
+/* 指定esp_timer时刻的内存时钟本地时间 */
+static int64_t time_service_local_us_at(int64_t esp_us)
+{
+    portENTER_CRITICAL(&time_lock);
+    if (!time_valid) {
+        portEXIT_CRITICAL(&time_lock);
+        return 0;
+    }
+    int64_t local_us = base_local_s * US_PER_SECOND + (esp_us - base_us);
+    portEXIT_CRITICAL(&time_lock);
+    return local_us;
+}
+
+/*
+ * 在参考时间的下一个整秒写入RTC。
+ * 写秒寄存器会复位DS3231的分频链，因此写入时刻即新秒的起点；提前
+ * TIME_WRITE_LEAD_US发起I2C事务，使秒寄存器字节正好在整秒落地。
+ * ref_offset_us = 参考本地时间 - esp_timer时间。
+ */
+static esp_err_t time_service_write_aligned(int64_t ref_offset_us)
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t target_s = (now_us + ref_offset_us) / US_PER_SECOND + 1;
+    int64_t boundary_us = target_s * US_PER_SECOND - ref_offset_us;
+    if (boundary_us - now_us < TIME_ALIGN_MIN_LEAD_US) {
+        target_s++;
+        boundary_us += US_PER_SECOND;
+    }
+
+    ds3231_time_t target;
+    seconds_to_time(target_s, &target);
+
+    /* 先让出CPU，最后几毫秒忙等 */
+    int64_t sleep_us = boundary_us - TIME_ALIGN_SPIN_US - esp_timer_get_time();
+    if (sleep_us > 0) {
+        vTaskDelay(pdMS_TO_TICKS(sleep_us / 1000));
+    }
+    int64_t write_at_us = boundary_us - TIME_WRITE_LEAD_US;
+    while (esp_timer_get_time() < write_at_us) {
+    }
+
+    int64_t before_us = time_service_local_us_at(boundary_us);
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = ds3231_set_time(&target);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    /* 按计划的整秒时刻作为新基准，下一个秒边沿在1秒后 */
+    time_service_rebase(target_s, boundary_us, true);
+    if (soft_tick_timer) {
+        esp_timer_stop(soft_tick_timer);
+        time_service_schedule_soft_tick();
+    }
+    if (before_us > 0) {
+        rtc_calib_note_step(target_s * US_PER_SECOND - before_us);
+    }
+
+    /* 残差：发起写入的调度误差；硬件秒边沿模式下再由下一个中断实测 */
+    int64_t residual_us = start_us - write_at_us;
+    portENTER_CRITICAL(&sync_lock);
+    sync_info.last_residual_us = residual_us;
+    portEXIT_CRITICAL(&sync_lock);
+    if (edge_driven) {
+        residual_edge_expected_us = boundary_us + US_PER_SECOND;
+    }
+    return ESP_OK;
+}
+
+/*
+ * 处理一次参考时间：ref_us是esp_us时刻的参考本地时间（已扣除单程延迟）。
+ * 记录漂移样本，偏差超过阈值时在整秒处重写RTC。
+ */
+static void time_service_apply_reference(int64_t esp_us, int64_t ref_us, int64_t rtt_us,
+                                         time_sync_source_t source)
+{
+    int64_t rtc_us = time_service_local_us_at(esp_us);
+    int64_t offset_us = rtc_us - ref_us;
+    time_sync_state_t state;
+
+    if (rtc_us <= 0) {
+        /* 内存时钟无效，直接按参考时间设置 */
+        offset_us = 0;
+        if (time_service_write_aligned(ref_us - esp_us) == ESP_OK) {
+            state = TIME_SYNC_STATE_SYNCED;
+            rtc_calib_reset();
+        } else {
+            state = TIME_SYNC_STATE_FAILED;
+        }
+    } else {
+        rtc_calib_add_sample(rtc_us, ref_us);
+        if (llabs(offset_us) >= TIME_STEP_THRESHOLD_US) {
+            state = (time_service_write_aligned(ref_us - esp_us) == ESP_OK) ?
+                    TIME_SYNC_STATE_SYNCED : TIME_SYNC_STATE_FAILED;
+        } else {
+            state = TIME_SYNC_STATE_CHECKED;
+        }
+    }
+    if (state == TIME_SYNC_STATE_SYNCED) {
+        time_service_seed_system_clock(time_service_get_local_us());
+    }
+
+    ESP_LOGI(TAG, "%s reference: RTC offset %lld ms, RTT %lld ms, state %d",
+             source == TIME_SYNC_SOURCE_SNTP ? "SNTP" : "HTTP", (long long)(offset_us / 1000),
+             (long long)(rtt_us / 1000), state);
+
+    portENTER_CRITICAL(&sync_lock);
+    sync_info.state = state;
+    sync_info.source = source;
+    sync_info.last_offset_us = offset_us;
+    sync_info.last_rtt_us = rtt_us;
+    if (state != TIME_SYNC_STATE_SYNCED) {
+        sync_info.last_residual_us = offset_us;
+    }
+    sync_info.sync_count++;
+    portEXIT_CRITICAL(&sync_lock);
+    if (state != TIME_SYNC_STATE_FAILED) {
+        last_sync_uptime_us = esp_timer_get_time();
+    }
+}
+
+static void time_service_mark_failed(void)
+{
+    portENTER_CRITICAL(&sync_lock);
+    sync_info.state = TIME_SYNC_STATE_FAILED;
+    portEXIT_CRITICAL(&sync_lock);
+}
+
+/* SNTP同步回调（lwIP上下文）：只采集时间对，处理交给校时任务。lwIP已按往返时延补偿 */
+static void time_service_sntp_callback(struct timeval *tv)
+{
+    int64_t esp_us = esp_timer_get_time();
+    int64_t ref_us = ((int64_t)tv->tv_sec + TIME_SERVICE_UTC_OFFSET_S) * US_PER_SECOND + tv->tv_usec;
+
+    portENTER_CRITICAL(&sync_lock);
+    sntp_esp_us = esp_us;
+    sntp_ref_us = ref_us;
+    sntp_pending = true;
+    portEXIT_CRITICAL(&sync_lock);
+
+    if (sync_task_handle) {
+        xTaskNotifyGive(sync_task_handle);
+    }
+}
+
+typedef struct {
+    json_stream_t stream;
+    json_stream_field_t fields[2];
+    char current_time[24];  // 毫秒时间戳原文
+    char code[8];
+    int64_t sent_us;        // 请求头发出的时刻
+    int64_t first_byte_us;  // 收到第一个响应头的时刻
+} time_http_response_t;
+
+static esp_err_t time_http_event_handler(esp_http_client_event_t *evt)
+{
+    time_http_response_t *resp = (time_http_response_t *)evt->user_data;
+    if (!resp) {
+        return ESP_OK;
+    }
+
+    switch (evt->event_id) {
+        case HTTP_EVENT_HEADERS_SENT:
+            resp->sent_us = esp_timer_get_time();
+            break;
+        case HTTP_EVENT_ON_HEADER:
+            if (resp->first_byte_us == 0) {
+                resp->first_byte_us = esp_timer_get_time();
+            }
+            break;
+        case HTTP_EVENT_ON_DATA:
+            json_stream_feed(&resp->stream, evt->data, evt->data_len);
+            break;
+        default:
+            break;
+    }
+    return ESP_OK;
+}
+
+/* HTTP备用时间源取得的时间对，由校时任务处理 */
+typedef struct {
+    int64_t esp_us;     // esp_timer时刻
+    int64_t ref_us;     // 该时刻的参考本地时间
+    int64_t rtt_us;
+} time_http_reference_t;
+
+/*
+ * HTTP备用时间源的一次请求，在网络服务的工作任务中执行。
+ * 只采集时间对：对齐写入RTC要等到整秒，不能占用与语音请求共用的工作任务
+ */
+static esp_err_t time_http_request(void *arg)
+{
+    time_http_reference_t *reference = arg;
+    time_http_response_t resp = {0};
+    resp.fields[0] = (json_stream_field_t)JSON_STREAM_FIELD("currentTime", resp.current_time, sizeof(resp.current_time));
+    resp.fields[1] = (json_stream_field_t)JSON_STREAM_FIELD("code", resp.code, sizeof(resp.code));
+    json_stream_init(&resp.stream, resp.fields, 2);
+
+    esp_http_client_config_t config = {
+        .url = TIME_HTTP_FALLBACK_URL,
+        .event_handler = time_http_event_handler,
+        .user_data = &resp,
+        .timeout_ms = 5000,
+    };
+
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (!client) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = esp_http_client_perform(client);
+    int status_code = esp_http_client_get_status_code(client);
+    esp_http_client_cleanup(client);
+
+    if (err != ESP_OK || status_code != 200 || resp.sent_us == 0 || resp.first_byte_us == 0) {
+        ESP_LOGE(TAG, "HTTP time request failed: %s, status %d", esp_err_to_name(err), status_code);
+        return err != ESP_OK ? err : ESP_FAIL;
+    }
+
+    if (json_stream_finish(&resp.stream) != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP time response parse failed");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    char *end = NULL;
+    int64_t server_ms = strtoll(resp.current_time, &end, 10);
+    if (resp.fields[0].type != JSON_STREAM_LITERAL || end == resp.current_time || *end != '\0' ||
+        resp.fields[1].type != JSON_STREAM_STRING || strcmp(resp.code, "1") != 0) {
+        ESP_LOGE(TAG, "HTTP time response invalid");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    /*
+     * 服务器时间戳取自请求到达与响应发出之间，按对称路径估计为往返的中点；
+     * 毫秒时间戳是截断值，补半毫秒。
+     */
+    int64_t rtt_us = resp.first_byte_us - resp.sent_us;
+    int64_t esp_mid_us = resp.sent_us + rtt_us / 2;
+    reference->esp_us = esp_mid_us;
+    reference->ref_us = (server_ms + (int64_t)TIME_SERVICE_UTC_OFFSET_S * 1000) * 1000 + 500;
+    reference->rtt_us = rtt_us;
+    return ESP_OK;
+}
+
+/*
+ * HTTP备用时间源：SNTP不可用时使用；往返时间在请求内测量，排队等待不影响精度。
+ * 请求完成后在校时任务中处理时间对（含对齐写入RTC）
+ */
+static esp_err_t time_service_sync_http(void)
+{
+    time_http_reference_t reference = {0};
+    net_request_t request = {
+        .key = "time",
+        .host = TIME_HTTP_FALLBACK_HOST,
+        .priority = NET_PRIORITY_TIME,
+        .run = time_http_request,
+        .arg = &reference,
+        .max_attempts = 2,
+        .backoff_ms = 1000,
+    };
+    esp_err_t ret = net_service_call(&request);
+    if (ret == ESP_OK && reference.esp_us != 0) {   // 与其他请求合并时时间对由对方采集
+        time_service_apply_reference(reference.esp_us, reference.ref_us, reference.rtt_us,
+                                     TIME_SYNC_SOURCE_HTTP);
+    }
+    return ret;
+}
+
+/*
+ * 按实测漂移推算SNTP间隔：RTC累积误差达到预算之前校一次。
+ * 漂移未校准时用默认间隔；按整小时向下取整，避免估计值的小波动反复重启SNTP。
+ */
+static uint32_t sntp_interval_from_drift(void)
+{
+    if (!rtc_calib_is_converged()) {
+        return TIME_SNTP_INTERVAL_MS;
+    }
+    rtc_calib_estimate_t est;
+    rtc_calib_get_estimate(&est);
+    float ppm = fabsf(est.drift_ppm) + est.stderr_ppm;     // 1ppm即每秒1us
+    uint64_t interval_ms = ppm > 0.0f ? (uint64_t)(TIME_DRIFT_BUDGET_US / ppm) * 1000 : TIME_SNTP_MAX_INTERVAL_MS;
+    interval_ms -= interval_ms % 3600000;
+    if (interval_ms < TIME_SNTP_INTERVAL_MS) {
+        return TIME_SNTP_INTERVAL_MS;
+    }
+    return interval_ms > TIME_SNTP_MAX_INTERVAL_MS ? TIME_SNTP_MAX_INTERVAL_MS : (uint32_t)interval_ms;
+}
+
+/* 校时任务：处理SNTP结果，必要时回退到HTTP，并按实测漂移调整SNTP间隔 */
+static void time_service_sync_task(void *arg)
+{
+    int64_t connected_since_us = 0;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TIME_SYNC_TASK_PERIOD_MS));
+
+        bool pending;
+        int64_t esp_us, ref_us;
+        portENTER_CRITICAL(&sync_lock);
+        pending = sntp_pending;
+        esp_us = sntp_esp_us;
+        ref_us = sntp_ref_us;
+        sntp_pending = false;
+        portEXIT_CRITICAL(&sync_lock);
+
+        if (!network_enabled) {
+            continue;
+        }
+
+        if (pending) {
+            time_service_apply_reference(esp_us, ref_us, 0, TIME_SYNC_SOURCE_SNTP);
+        }
+
+        /* SNTP长时间无结果时使用HTTP备用源 */
+        int64_t now_us = esp_timer_get_time();
+        if (wifi_get_status() != WIFI_STATUS_CONNECTED) {
+            connected_since_us = 0;
+        } else {
+            if (connected_since_us == 0) {
+                connected_since_us = now_us;
+            }
+            bool never_synced = (last_sync_uptime_us == 0) &&
+                                now_us - connected_since_us >= TIME_HTTP_FALLBACK_AFTER_S * US_PER_SECOND;
+            int64_t stale_after_s = sntp_interval_ms / 1000 + TIME_HTTP_STALE_MARGIN_S;
+            bool stale = (last_sync_uptime_us != 0) &&
+                         now_us - last_sync_uptime_us >= stale_after_s * US_PER_SECOND;
+            if (never_synced || stale) {
+                ESP_LOGW(TAG, "SNTP unavailable, using HTTP time source");
+                if (time_service_sync_http() != ESP_OK) {
+                    time_service_mark_failed();
+                    /* 失败后等待一个周期再试，避免频繁请求 */
+                    last_sync_uptime_us = now_us - (stale_after_s - 600) * US_PER_SECOND;
+                }
+            }
+        }
+
+        /* RTC漂移校准完成后按漂移放宽SNTP间隔 */
+        uint32_t interval = sntp_interval_from_drift();
+        if (interval != sntp_interval_ms) {
+            sntp_interval_ms = interval;
+            esp_sntp_set_sync_interval(interval);
+            esp_sntp_restart();
+            ESP_LOGI(TAG, "SNTP interval set to %lu s", (unsigned long)(interval / 1000));
+        }
+    }
+}
+
+esp_err_t time_service_start_network(void)
+{
+    if (sync_task_handle) {
+        return ESP_OK;
+    }
+
+    if (xTaskCreate(time_service_sync_task, "time_sync", 4096, NULL, 3, &sync_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sync task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* 平滑模式：偏差较小时用adjtime逐步调整系统时钟 */
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG_MULTIPLE(2,
+                                   ESP_SNTP_SERVER_LIST(TIME_SNTP_SERVER_PRIMARY, TIME_SNTP_SERVER_SECONDARY));
+    config.smooth_sync = true;
+    config.sync_cb = time_service_sntp_callback;
+    esp_err_t ret = esp_netif_sntp_init(&config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SNTP init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    esp_sntp_set_sync_interval(sntp_interval_ms);
+
+    ESP_LOGI(TAG, "SNTP started (%s, %s)", TIME_SNTP_SERVER_PRIMARY, TIME_SNTP_SERVER_SECONDARY);
+    return ESP_OK;
+}
+
+void time_service_set_network_enabled(bool enabled)
+{
+    network_enabled = enabled;
+    if (enabled && sync_task_handle) {
+        xTaskNotifyGive(sync_task_handle);
+    }
+}
+
+void time_service_get_sync_info(time_sync_info_t *info)
+{
+    portENTER_CRITICAL(&sync_lock);
+    *info = sync_info;
+    portEXIT_CRITICAL(&sync_lock);
+    info->enabled = network_enabled;
+}
@@ -0,0 +1,133 @@
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "ds3231.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 时区由时间服务统一管理，RTC保存本地时间 */
+#define TIME_SERVICE_TZ             "CST-8"
+#define TIME_SERVICE_UTC_OFFSET_S   (8 * 3600)
+
+/**
+ * @brief 网络校时结果
+ */
+typedef enum {
+    TIME_SYNC_STATE_NONE,       // 尚未校时
+    TIME_SYNC_STATE_SYNCED,     // 已按网络时间改写RTC
+    TIME_SYNC_STATE_CHECKED,    // RTC偏差在允许范围内，未改写
+    TIME_SYNC_STATE_FAILED      // 最近一次校时失败
+} time_sync_state_t;
+
+typedef enum {
+    TIME_SYNC_SOURCE_NONE,
+    TIME_SYNC_SOURCE_SNTP,
+    TIME_SYNC_SOURCE_HTTP
+} time_sync_source_t;
+
+typedef struct {
+    time_sync_state_t state;
+    time_sync_source_t source;
+    int64_t last_offset_us;     // 最近一次校时时RTC相对参考时间的偏差
+    int64_t last_rtt_us;        // 最近一次请求的往返时延（SNTP由lwIP补偿，记为0）
+    int64_t last_residual_us;   // 校时后RTC秒边沿相对参考整秒的残差
+    uint32_t sync_count;
+    bool enabled;
+} time_sync_info_t;
+
+/**
+ * @brief 秒边沿回调，在DS3231驱动任务或esp_timer任务中执行，应尽快返回
+ */
+typedef void (*time_service_tick_cb_t)(void);
+
+/**
+ * @brief 初始化时间服务
+ *
+ * 启动时读取一次DS3231，之后由DS3231闹钟1的每秒中断推进内存时钟，
+ * 秒内精度由esp_timer补足；INT引脚未接线时退化为esp_timer软件秒边沿。
+ * 须在 ds3231_init 之后调用。
+ *
+ * @return esp_err_t 成功返回ESP_OK；读取RTC失败时仍返回错误码，可随后用 time_service_set_time 设置时间
+ */
+esp_err_t time_service_init(void);
+
+/**
+ * @brief 从内存时钟读取当前本地时间，不访问I2C
+ *
+ * @param time 输出时间
+ * @return esp_err_t 时钟尚未建立时返回ESP_ERR_INVALID_STATE
+ */
+esp_err_t time_service_get_time(ds3231_time_t *time);
+
+/**
+ * @brief 获取当前本地时间（自1970-01-01 00:00:00起的微秒数）
+ *
+ * @return int64_t 时钟尚未建立时返回0
+ */
+int64_t time_service_get_local_us(void);
+
+/**
+ * @brief 获取当前UTC时间（秒），供签名等需要可信时钟的场景使用，不阻塞
+ *
+ * @return int64_t 时钟尚未建立时返回0
+ */
+int64_t time_service_get_utc_seconds(void);
+
+/**
+ * @brief 设置时间：写入DS3231并同步内存时钟
+ *
+ * @param time 新的本地时间
+ * @return esp_err_t 成功返回ESP_OK
+ */
+esp_err_t time_service_set_time(const ds3231_time_t *time);
+
+/**
+ * @brief 注册秒边沿回调
+ *
+ * @param cb 回调函数
+ * @return esp_err_t 回调数量已满返回ESP_ERR_NO_MEM
+ */
+esp_err_t time_service_register_tick(time_service_tick_cb_t cb);
+
+/**
+ * @brief 获取最近一次核对时整块读取的RTC寄存器（温度、控制/状态、老化偏移）
+ *
+ * @param regs 输出寄存器快照
+ * @return esp_err_t 尚未读取过时返回ESP_ERR_INVALID_STATE
+ */
+esp_err_t time_service_get_rtc_regs(ds3231_regs_t *regs);
+
+/**
+ * @brief 秒边沿是否来自DS3231硬件中断
+ */
+bool time_service_is_edge_driven(void);
+
+/**
+ * @brief 启动后台网络校时（SNTP平滑调整系统时钟，结果写回DS3231；SNTP不可用时回退到HTTP时间源）
+ *
+ * 须在WiFi/esp_netif初始化之后调用。
+ *
+ * @return esp_err_t 成功返回ESP_OK
+ */
+esp_err_t time_service_start_network(void);
+
+/**
+ * @brief 启用或停用网络校时（停用时保持RTC时间）
+ */
+void time_service_set_network_enabled(bool enabled);
+
+/**
+ * @brief 获取网络校时状态
+ */
+void time_service_get_sync_info(time_sync_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIME_SERVICE_H */
@@ -0,0 +1,329 @@
+#include "tls_session.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <errno.h>
+#include <string.h>
+
+static const char *TAG = "TLS_SESSION";
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void sample_heap(tls_session_t *session)
+{
+    size_t free_now = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    if (free_now < session->free_min) {
+        session->free_min = free_now;
+    }
+}
+
+/* 会话锁在首次使用时创建（会话本身是静态初始化的） */
+static bool session_lock(tls_session_t *session, TickType_t wait)
+{
+    if (session->lock == NULL) {
+        SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+        if (lock == NULL) {
+            return false;
+        }
+        portENTER_CRITICAL(&stats_lock);
+        if (session->lock == NULL) {
+            session->lock = lock;
+            lock = NULL;
+        }
+        portEXIT_CRITICAL(&stats_lock);
+        if (lock) {
+            vSemaphoreDelete(lock);
+        }
+    }
+    return xSemaphoreTake(session->lock, wait) == pdTRUE;
+}
+
+/* 把配置改为连接本地替身服务器，url_buf须在esp_http_client_init返回前有效 */
+static void apply_stub_host(esp_http_client_config_t *cfg, char *url_buf, size_t size)
+{
+    const char *path = cfg->path != NULL ? cfg->path : "/";
+    if (cfg->url != NULL) {
+        const char *host = strstr(cfg->url, "://");
+        const char *slash = host != NULL ? strchr(host + 3, '/') : NULL;
+        path = slash != NULL ? slash : "/";
+    }
+    snprintf(url_buf, size, "http://%s:%d%s", TLS_SESSION_STUB_HOST, TLS_SESSION_STUB_PORT, path);
+    cfg->url = url_buf;
+    cfg->host = NULL;
+    cfg->path = NULL;
+    cfg->port = 0;
+    cfg->transport_type = HTTP_TRANSPORT_OVER_TCP;
+    cfg->crt_bundle_attach = NULL;
+}
+
+esp_http_client_handle_t tls_session_acquire(tls_session_t *session, const esp_http_client_config_t *config)
+{
+    if (!session_lock(session, portMAX_DELAY)) {
+        ESP_LOGE(TAG, "%s: 无法创建会话锁", session->name);
+        return NULL;
+    }
+
+    session->start_us = esp_timer_get_time();
+    session->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : 5000;   // esp_http_client的默认值
+    session->handshake_us = 0;
+    session->first_byte_at_us = 0;
+    session->free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    session->free_min = session->free_before;
+
+    if (session->client && TLS_SESSION_CACHE_ENABLED) {
+        esp_http_client_set_user_data(session->client, config->user_data);
+        session->resuming = session->has_session;
+        return session->client;
+    }
+
+    esp_http_client_config_t cfg = *config;
+#if TLS_SESSION_CACHE_ENABLED
+    cfg.save_client_session = true;
+    cfg.keep_alive_enable = true;       // TCP keepalive，保持连接时及时发现对端已断开
+#endif
+    char stub_url[128];
+    if (TLS_SESSION_STUB_HOST[0] != '\0') {
+        apply_stub_host(&cfg, stub_url, sizeof(stub_url));
+        ESP_LOGW(TAG, "%s: 使用替身服务器 %s", session->name, stub_url);
+    }
+    session->client = esp_http_client_init(&cfg);
+    session->has_session = false;
+    session->resuming = false;
+    if (session->client == NULL) {
+        ESP_LOGE(TAG, "%s: 客户端初始化失败", session->name);
+        xSemaphoreGive(session->lock);
+    }
+    return session->client;
+}
+
+/* 读返回0时区分超时和连接已断开：超时的errno为EAGAIN/ETIMEDOUT或未设置 */
+static bool connection_failed(esp_http_client_handle_t client)
+{
+    int err = esp_http_client_get_errno(client);
+    return err != 0 && err != EAGAIN && err != EWOULDBLOCK && err != ETIMEDOUT && err != EINPROGRESS;
+}
+
+/*
+ * 可取消的请求：esp_http_client_perform内部整段阻塞（上传几百KB、等待服务端处理），
+ * 这里拆成open/write/fetch_headers/read，在块与块之间、每个轮询间隔检查取消。
+ * 读到的数据已由事件回调处理，本地缓冲区只用来推进读取。
+ */
+static esp_err_t perform_cancellable(tls_session_t *session, esp_http_client_handle_t client, net_cancel_t *cancel)
+{
+    char *body = NULL;
+    int body_len = esp_http_client_get_post_field(client, &body);
+    esp_err_t err = esp_http_client_open(client, body_len);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    for (int written = 0; written < body_len; ) {
+        if (net_cancel_is_cancelled(cancel)) {
+            err = ESP_ERR_INVALID_STATE;
+            goto done;
+        }
+        int chunk = body_len - written < TLS_SESSION_UPLOAD_CHUNK ? body_len - written : TLS_SESSION_UPLOAD_CHUNK;
+        int sent = esp_http_client_write(client, body + written, chunk);
+        if (sent <= 0) {
+            err = ESP_ERR_HTTP_WRITE_DATA;
+            goto done;
+        }
+        written += sent;
+    }
+
+    /* 等待响应时缩短socket超时，超时只表示数据还没到，总时长仍按配置的超时计算 */
+    esp_http_client_set_timeout_ms(client, TLS_SESSION_CANCEL_POLL_MS);
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)session->timeout_ms * 1000;
+
+    int64_t content_length;
+    while ((content_length = esp_http_client_fetch_headers(client)) == -ESP_ERR_HTTP_EAGAIN) {
+        if (net_cancel_is_cancelled(cancel)) {
+            err = ESP_ERR_INVALID_STATE;
+            goto done;
+        }
+        if (esp_timer_get_time() > deadline_us) {
+            err = ESP_ERR_HTTP_EAGAIN;
+            goto done;
+        }
+    }
+    if (content_length < 0) {
+        err = ESP_ERR_HTTP_FETCH_HEADER;
+        goto done;
+    }
+
+    char scratch[256];
+    while (!esp_http_client_is_complete_data_received(client)) {
+        int received = esp_http_client_read(client, scratch, sizeof(scratch));
+        if (net_cancel_is_cancelled(cancel)) {
+            err = ESP_ERR_INVALID_STATE;
+            goto done;
+        }
+        /*
+         * IDF 5.x中传输层读超时返回0而不是-ESP_ERR_HTTP_EAGAIN，与EAGAIN一样只表示数据还没到；
+         * 只有负值或者连接已出错时的0才是对端在响应结束前关闭了连接
+         */
+        if (received == -ESP_ERR_HTTP_EAGAIN || (received == 0 && !connection_failed(client))) {
+            if (esp_timer_get_time() > deadline_us) {
+                err = ESP_ERR_HTTP_EAGAIN;
+                goto done;
+            }
+            continue;
+        }
+        if (received <= 0) {
+            err = ESP_FAIL;
+            goto done;
+        }
+        deadline_us = esp_timer_get_time() + (int64_t)session->timeout_ms * 1000;
+    }
+
+done:
+    esp_http_client_set_timeout_ms(client, session->timeout_ms);
+    if (err == ESP_ERR_INVALID_STATE) {
+        /* 不再读完剩余数据，直接断开；release按失败处理，TLS上下文随句柄一起释放 */
+        esp_http_client_close(client);
+        ESP_LOGW(TAG, "%s: 请求已取消，连接已断开", session->name);
+    }
+    return err;
+}
+
+static esp_err_t perform_once(tls_session_t *session, esp_http_client_handle_t client, net_cancel_t *cancel)
+{
+    if (cancel == NULL) {
+        return esp_http_client_perform(client);
+    }
+    if (net_cancel_is_cancelled(cancel)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return perform_cancellable(session, client, cancel);
+}
+
+esp_err_t tls_session_perform(tls_session_t *session, esp_http_client_handle_t client, net_cancel_t *cancel)
+{
+    esp_err_t err = perform_once(session, client, cancel);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE && session->handshake_us == 0 && session->keep_open) {
+        /* 没有经过ON_CONNECTED说明用的是保持的旧连接，可能已被服务器关闭 */
+        ESP_LOGW(TAG, "%s: 保持的连接已失效(%s)，重新连接", session->name, esp_err_to_name(err));
+        esp_http_client_close(client);
+        session->start_us = esp_timer_get_time();
+        err = perform_once(session, client, cancel);
+    }
+    return err;
+}
+
+void tls_session_on_event(tls_session_t *session, const esp_http_client_event_t *evt)
+{
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            /* TCP连接+TLS握手完成，此时TLS上下文占用的内存最多 */
+            session->handshake_us = esp_timer_get_time() - session->start_us;
+            sample_heap(session);
+            break;
+        case HTTP_EVENT_ON_DATA:
+            if (session->first_byte_at_us == 0) {
+                session->first_byte_at_us = esp_timer_get_time();
+            }
+            sample_heap(session);
+            break;
+        case HTTP_EVENT_ON_FINISH:
+            sample_heap(session);
+            break;
+        default:
+            break;
+    }
+}
+
+void tls_session_release(tls_session_t *session, esp_err_t result)
+{
+    size_t heap_peak = session->free_before > session->free_min ? session->free_before - session->free_min : 0;
+
+    portENTER_CRITICAL(&stats_lock);
+    tls_session_stats_t *stats = &session->stats;
+    stats->requests++;
+    stats->last_handshake_us = session->handshake_us;
+    stats->last_first_byte_at_us = session->first_byte_at_us;
+    stats->last_heap_peak = heap_peak;
+    if (session->handshake_us == 0) {
+        stats->warm_reuses++;
+    } else if (session->resuming) {
+        stats->resumed_handshakes++;
+        stats->resumed_handshake_us_total += session->handshake_us;
+        if (heap_peak > stats->resumed_heap_peak_max) {
+            stats->resumed_heap_peak_max = heap_peak;
+        }
+    } else {
+        stats->full_handshakes++;
+        stats->full_handshake_us_total += session->handshake_us;
+        if (heap_peak > stats->full_heap_peak_max) {
+            stats->full_heap_peak_max = heap_peak;
+        }
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    ESP_LOGI(TAG, "%s: 握手 %lld ms (%s), 内部RAM峰值占用 %u 字节, 总耗时 %lld ms",
+             session->name, (long long)(session->handshake_us / 1000),
+             session->handshake_us == 0 ? "沿用连接" : (session->resuming ? "会话复用" : "完整握手"),
+             (unsigned)heap_peak, (long long)((esp_timer_get_time() - session->start_us) / 1000));
+
+    if (!TLS_SESSION_CACHE_ENABLED || result != ESP_OK || session->client == NULL) {
+        /* 失败时丢弃会话，避免带着失效票据反复重试 */
+        tls_session_reset(session);
+    } else {
+        /* 保持连接模式下socket留给下一个请求，否则只关闭socket，会话票据保留在句柄中 */
+        if (!session->keep_open) {
+            esp_http_client_close(session->client);
+        }
+        session->has_session = true;
+    }
+    xSemaphoreGive(session->lock);
+}
+
+esp_err_t tls_session_prewarm(tls_session_t *session, const esp_http_client_config_t *config)
+{
+    esp_http_client_config_t cfg = *config;
+    cfg.user_data = NULL;
+    session->keep_open = true;
+
+    esp_http_client_handle_t client = tls_session_acquire(session, &cfg);
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+
+    /* 连接已保持时HEAD只是一次轻量往返，顺便确认连接仍可用 */
+    esp_http_client_set_method(client, HTTP_METHOD_HEAD);
+    esp_http_client_set_post_field(client, NULL, 0);
+    esp_err_t err = tls_session_perform(session, client, NULL);
+    ESP_LOGI(TAG, "%s: 连接预热%s, HTTP %d", session->name, err == ESP_OK ? "完成" : "失败",
+             esp_http_client_get_status_code(client));
+    tls_session_release(session, err);
+    return err;
+}
+
+void tls_session_close_idle(tls_session_t *session)
+{
+    session->keep_open = false;
+    if (!session_lock(session, 0)) {
+        return;     // 请求进行中，结束时按keep_open=false关闭
+    }
+    if (session->client) {
+        esp_http_client_close(session->client);
+        ESP_LOGI(TAG, "%s: 关闭空闲连接", session->name);
+    }
+    xSemaphoreGive(session->lock);
+}
+
+void tls_session_reset(tls_session_t *session)
+{
+    if (session->client) {
+        esp_http_client_cleanup(session->client);
+        session->client = NULL;
+    }
+    session->has_session = false;
+    session->resuming = false;
+}
+
+void tls_session_get_stats(const tls_session_t *session, tls_session_stats_t *stats)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *stats = session->stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
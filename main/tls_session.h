@@ -0,0 +1,132 @@
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "net_service.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 云端HTTPS会话复用
+ *
+ * 每个主机保留一个esp_http_client句柄并开启save_client_session，
+ * 请求结束只关闭socket，esp-tls保存的会话票据留在句柄里，
+ * 下次连接走简化握手（不再验证证书链、不做完整ECDHE）。
+ * 依赖 CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS。
+ *
+ * 保持连接模式（tls_session_prewarm开启）下请求结束不关闭socket，
+ * 下一个请求直接在已握手的连接上发送；连接被服务器关闭时自动重连一次。
+ */
+
+#define TLS_SESSION_CACHE_ENABLED   1   // 置0则每次请求新建客户端（完整握手），用于对比
+#define TLS_SESSION_UPLOAD_CHUNK    4096    // 可取消的请求按块上传，块之间检查取消
+#define TLS_SESSION_CANCEL_POLL_MS  200     // 可取消的请求等待响应时的轮询间隔
+
+/* 本地替身服务器（仓库根目录cloud_stall_server.py）：非空时新建的句柄一律改为明文HTTP连到该地址，
+ * 路径保持不变，用于注入卡顿、验证对冲与取消 */
+#define TLS_SESSION_STUB_HOST       ""
+#define TLS_SESSION_STUB_PORT       8080
+
+/**
+ * @brief 握手统计，按完整握手与复用会话分开累计
+ */
+typedef struct {
+    uint32_t requests;
+    uint32_t full_handshakes;           // 新句柄上的握手
+    uint32_t resumed_handshakes;        // 已有会话票据的句柄上的握手
+    uint32_t warm_reuses;               // 沿用预热/保持的连接，无握手
+    int64_t full_handshake_us_total;
+    int64_t resumed_handshake_us_total;
+    int64_t last_handshake_us;          // 0表示上次请求沿用了已打开的连接
+    int64_t last_first_byte_at_us;      // 上次请求收到首个响应数据的esp_timer时刻
+    size_t last_heap_peak;              // 上次请求期间内部RAM的最大占用（字节）
+    size_t full_heap_peak_max;
+    size_t resumed_heap_peak_max;
+} tls_session_stats_t;
+
+/**
+ * @brief 单个主机的会话，由调用模块静态持有
+ */
+typedef struct {
+    const char *name;                   // 日志和状态接口中的名称
+    esp_http_client_handle_t client;
+    SemaphoreHandle_t lock;             // 同一时刻只有一个请求（含预热）使用句柄
+    bool has_session;                   // 句柄上已有成功握手留下的会话
+    bool resuming;                      // 本次请求是否在复用会话
+    bool keep_open;                     // 保持连接模式
+    int timeout_ms;                     // 配置的网络超时，可取消的请求轮询时据此判断超时
+    int64_t start_us;
+    int64_t handshake_us;
+    int64_t first_byte_at_us;
+    size_t free_before;
+    size_t free_min;
+    tls_session_stats_t stats;
+} tls_session_t;
+
+#define TLS_SESSION_INITIALIZER(session_name) { .name = (session_name) }
+
+/**
+ * @brief 取得本次请求使用的客户端（阻塞到句柄空闲）
+ *
+ * 首次调用按config创建句柄，之后复用同一句柄并更新user_data。
+ * 请求头、方法、请求体由调用者每次重新设置。
+ * 返回非NULL时必须调用tls_session_release。
+ */
+esp_http_client_handle_t tls_session_acquire(tls_session_t *session, const esp_http_client_config_t *config);
+
+/**
+ * @brief 执行请求；沿用的连接已被服务器关闭时重连重试一次
+ *
+ * cancel非NULL时不用esp_http_client_perform，改为分块上传请求体、短超时轮询响应，
+ * 每块/每个轮询间隔检查一次取消，取消后关闭连接并返回ESP_ERR_INVALID_STATE。
+ * 响应数据仍通过HTTP_EVENT_ON_DATA交给事件回调（不产生HTTP_EVENT_ON_FINISH）。
+ */
+esp_err_t tls_session_perform(tls_session_t *session, esp_http_client_handle_t client, net_cancel_t *cancel);
+
+/**
+ * @brief 在调用模块的HTTP事件处理函数开头调用，记录握手耗时与内存
+ */
+void tls_session_on_event(tls_session_t *session, const esp_http_client_event_t *evt);
+
+/**
+ * @brief 请求结束：记录统计，成功时保留句柄和会话，失败时销毁句柄
+ */
+void tls_session_release(tls_session_t *session, esp_err_t result);
+
+/**
+ * @brief 进入保持连接模式并提前完成TCP+TLS握手（发送一个HEAD请求）
+ *
+ * 会阻塞到握手完成，应在后台任务中调用。
+ */
+esp_err_t tls_session_prewarm(tls_session_t *session, const esp_http_client_config_t *config);
+
+/**
+ * @brief 退出保持连接模式并关闭空闲连接，会话票据保留
+ *
+ * 有请求进行中时不等待，由该请求结束时关闭。
+ */
+void tls_session_close_idle(tls_session_t *session);
+
+/**
+ * @brief 立即销毁句柄和会话（调用者需保证没有进行中的请求）
+ */
+void tls_session_reset(tls_session_t *session);
+
+/**
+ * @brief 复制统计信息
+ */
+void tls_session_get_stats(const tls_session_t *session, tls_session_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TLS_SESSION_H
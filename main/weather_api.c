@@ -2,22 +2,165 @@
 #include "esp_log.h"
 #include "esp_http_client.h"
 #include "esp_crt_bundle.h"
-#include "cJSON.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "json_stream.h"
+#include "http_cache.h"
+#include "http_decode.h"
+#include "refresh_policy.h"
+#include "time_service.h"
 #include "wifi_manager.h"
+#include "nvs.h"
+#include "civil_time.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "secrets.h"
 
 static const char *TAG = "WeatherAPI";
 
 // 高德天气API配置
-#define MAX_HTTP_RECV_BUFFER 2048
-
-static char http_response_buffer[MAX_HTTP_RECV_BUFFER];
-static int response_len = 0;
-
-/* HTTP事件处理函数 */
+#define WEATHER_API_URL         "http://" WEATHER_API_HOST "/v3/weather/weatherInfo"
+
+/* 接口原文只在解析时存在：先流式解析到这里，转为编码后再提交到快照 */
+typedef struct {
+    char city[32];
+    char weather[32];
+    char temperature[8];
+    char winddirection[16];
+    char windpower[8];
+    char humidity[8];
+    char reporttime[32];
+} amap_live_text_t;
+
+typedef struct {
+    char date[16];
+    char dayweather[32];
+    char nightweather[32];
+    char daytemp[8];
+    char nighttemp[8];
+    char daywind[16];
+    char nightwind[16];
+    char daypower[8];
+    char nightpower[8];
+} amap_cast_text_t;
+
+static amap_live_text_t live_text;
+static struct {
+    amap_cast_text_t casts[WEATHER_FORECAST_DAYS];
+    char city[32];
+    char reporttime[32];
+} forecast_text;
+static weather_info_t live_scratch;
+static weather_report_t forecast_scratch;
+static char amap_status[4];
+static SemaphoreHandle_t report_mutex = NULL;
+
+#define WEATHER_NVS_NAMESPACE       "weather"
+#define WEATHER_NVS_CITIES_KEY      "cities"
+#define WEATHER_NVS_SNAPSHOT_FMT    "snap_%s"   // 每个城市一份快照，按adcode区分
+#define WEATHER_SNAPSHOT_VERSION    2       // 2: 天气现象、风向改为编码
+#define WEATHER_CITIES_VERSION      1
+
+/* NVS中保存的城市列表 */
+typedef struct {
+    uint8_t version;
+    uint8_t count;
+    weather_city_t cities[WEATHER_MAX_CITIES];
+} weather_city_config_t;
+
+/* NVS中保存的快照，只含显示所需的内容 */
+typedef struct {
+    uint8_t version;
+    bool live_valid;
+    bool forecast_valid;
+    uint8_t cast_count;
+    int64_t live_fetched_at;
+    int64_t forecast_fetched_at;
+    int64_t live_reporttime;
+    int64_t forecast_reporttime;
+    weather_info_t live;
+    weather_forecast_t casts[WEATHER_FORECAST_DAYS];
+    char city[32];
+} weather_snapshot_t;
+
+/*
+ * 每个关注的城市一个槽位，按配置顺序排列，均由report_mutex保护。
+ * 刷新在锁外进行，提交结果时再按adcode找回槽位，城市列表中途改动也不会写错城市。
+ */
+typedef struct {
+    weather_city_t city;
+    weather_report_t report;            // 合并后的快照
+    refresh_policy_t live_refresh;
+    refresh_policy_t forecast_refresh;
+    weather_snapshot_t saved;           // 最近一次写入NVS的内容，发布时间未变时不重复写
+    weather_city_stats_t stats;
+} weather_slot_t;
+
+static weather_slot_t slots[WEATHER_MAX_CITIES];
+static weather_slot_t next_slots[WEATHER_MAX_CITIES];  // 修改城市列表时的临时区
+static uint8_t city_count;
+static int64_t boot_snapshot_us = -1;
+static int64_t boot_live_us = -1;
+
+/* 响应缓存所有城市共用，按adcode区分缓存键 */
+static http_cache_policy_t live_cache = HTTP_CACHE_POLICY_INITIALIZER("weather_live", WEATHER_LIVE_CACHE_TTL_S);
+static http_cache_policy_t forecast_cache = HTTP_CACHE_POLICY_INITIALIZER("weather_forecast",
+                                                                          WEATHER_FORECAST_CACHE_TTL_S);
+static const refresh_policy_t live_refresh_template = REFRESH_POLICY_INITIALIZER("weather_live",
+    WEATHER_LIVE_PERIOD_S, WEATHER_LIVE_GRACE_S, WEATHER_LIVE_MIN_INTERVAL_S, WEATHER_LIVE_MAX_INTERVAL_S);
+static const refresh_policy_t forecast_refresh_template = REFRESH_POLICY_INITIALIZER("weather_forecast",
+    WEATHER_FORECAST_PERIOD_S, WEATHER_FORECAST_GRACE_S, WEATHER_FORECAST_MIN_INTERVAL_S,
+    WEATHER_FORECAST_MAX_INTERVAL_S);
+
+/* 响应体（压缩传输时先解压）直接流式解析到下面的字段表，不再整体缓存 */
+static json_stream_t response_stream;
+static http_decoder_t response_decoder;
+static http_decode_endpoint_t live_decode = HTTP_DECODE_ENDPOINT_INITIALIZER("weather_live");
+static http_decode_endpoint_t forecast_decode = HTTP_DECODE_ENDPOINT_INITIALIZER("weather_forecast");
+
+#define LIVE_FIELD(name) \
+    JSON_STREAM_FIELD("lives[0]." #name, live_text.name, sizeof(live_text.name))
+
+static json_stream_field_t live_fields[] = {
+    JSON_STREAM_FIELD("status", amap_status, sizeof(amap_status)),
+    JSON_STREAM_PRESENCE("lives[0]"),
+    LIVE_FIELD(city), LIVE_FIELD(weather), LIVE_FIELD(temperature), LIVE_FIELD(winddirection),
+    LIVE_FIELD(windpower), LIVE_FIELD(humidity), LIVE_FIELD(reporttime),
+};
+
+#define CAST_FIELD(i, name) \
+    JSON_STREAM_FIELD("forecasts[0].casts[" #i "]." #name, forecast_text.casts[i].name, \
+                      sizeof(forecast_text.casts[i].name))
+#define CAST_FIELDS(i) \
+    CAST_FIELD(i, date), CAST_FIELD(i, dayweather), CAST_FIELD(i, nightweather), \
+    CAST_FIELD(i, daytemp), CAST_FIELD(i, nighttemp), CAST_FIELD(i, daywind), CAST_FIELD(i, nightwind), \
+    CAST_FIELD(i, daypower), CAST_FIELD(i, nightpower)
+
+// 与WEATHER_FORECAST_DAYS一致，每天一组
+static json_stream_field_t forecast_fields[] = {
+    JSON_STREAM_FIELD("status", amap_status, sizeof(amap_status)),
+    JSON_STREAM_PRESENCE("forecasts[0].casts"),
+    JSON_STREAM_FIELD("forecasts[0].city", forecast_text.city, sizeof(forecast_text.city)),
+    JSON_STREAM_FIELD("forecasts[0].reporttime", forecast_text.reporttime, sizeof(forecast_text.reporttime)),
+    CAST_FIELDS(0), CAST_FIELDS(1), CAST_FIELDS(2), CAST_FIELDS(3),
+};
+
+#define FORECAST_CAST_FIELD_BASE    4       // forecast_fields中第一个casts字段的下标
+#define FORECAST_FIELDS_PER_CAST    9
+_Static_assert(sizeof(forecast_fields) / sizeof(forecast_fields[0]) ==
+               FORECAST_CAST_FIELD_BASE + WEATHER_FORECAST_DAYS * FORECAST_FIELDS_PER_CAST,
+               "forecast_fields与WEATHER_FORECAST_DAYS不一致");
+
+/* HTTP事件处理函数，user_data为本次请求的缓存事务 */
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
+    if (evt->user_data != NULL) {
+        http_cache_on_event(evt->user_data, evt);
+    }
+    http_decoder_on_event(&response_decoder, evt);
+    
     switch(evt->event_id) {
         case HTTP_EVENT_ERROR:
             ESP_LOGE(TAG, "HTTP_EVENT_ERROR");
@@ -25,204 +168,753 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
         case HTTP_EVENT_ON_CONNECTED:
             ESP_LOGI(TAG, "HTTP_EVENT_ON_CONNECTED");
             break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT");
-            break;
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-            break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            if (!esp_http_client_is_chunked_response(evt->client)) {
-                if (response_len + evt->data_len < MAX_HTTP_RECV_BUFFER) {
-                    memcpy(http_response_buffer + response_len, evt->data, evt->data_len);
-                    response_len += evt->data_len;
-                }
-            }
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH");
-            http_response_buffer[response_len] = '\0';
-            break;
         case HTTP_EVENT_DISCONNECTED:
             ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
             break;
-        case HTTP_EVENT_REDIRECT:
-            ESP_LOGI(TAG, "HTTP_EVENT_REDIRECT");
+        default:
             break;
     }
     return ESP_OK;
 }
 
-/* 解析天气JSON响应 */
-static esp_err_t parse_weather_response(const char* json_string, weather_info_t* weather_info)
+/* 检查status字段 */
+static esp_err_t check_amap_status(void)
 {
-    cJSON *json = cJSON_Parse(json_string);
-    if (json == NULL) {
-        ESP_LOGE(TAG, "Failed to parse JSON");
+    if (strcmp(amap_status, "1") != 0) {
+        ESP_LOGE(TAG, "API returned error status");
         return ESP_FAIL;
     }
+    return ESP_OK;
+}
 
-    // 检查status字段
-    cJSON *status = cJSON_GetObjectItem(json, "status");
-    if (status == NULL || !cJSON_IsString(status) || strcmp(status->valuestring, "1") != 0) {
-        ESP_LOGE(TAG, "API returned error status");
-        cJSON_Delete(json);
+static int8_t parse_temperature(const char *text)
+{
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value < -100 || value > 100) {
+        return WEATHER_TEMP_UNKNOWN;
+    }
+    return (int8_t)value;
+}
+
+static uint8_t parse_humidity(const char *text)
+{
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || value < 0 || value > 100) {
+        return WEATHER_HUMIDITY_UNKNOWN;
+    }
+    return (uint8_t)value;
+}
+
+/* "YYYY-MM-DD"转为1970-01-01起的天数，格式不对返回0 */
+static uint16_t parse_date(const char *text)
+{
+    int year, month, day;
+    if (sscanf(text, "%d-%d-%d", &year, &month, &day) != 3 || !civil_date_is_valid(year, month, day)) {
+        return 0;
+    }
+    int64_t days = civil_days_from_date(year, month, day);
+    return days > 0 && days <= UINT16_MAX ? (uint16_t)days : 0;
+}
+
+/* 未收录的描述记为UNKNOWN，并记下原文以便补充weather_codes中的表 */
+static uint8_t parse_weather(const char *text)
+{
+    weather_code_t code = weather_code_from_text(text);
+    if (code == WEATHER_UNKNOWN && text[0] != '\0') {
+        ESP_LOGW(TAG, "未收录的天气现象: %s", text);
+    }
+    return code;
+}
+
+static uint8_t parse_wind(const char *text)
+{
+    weather_wind_t wind = weather_wind_from_text(text);
+    if (wind == WEATHER_WIND_UNKNOWN && text[0] != '\0') {
+        ESP_LOGW(TAG, "未收录的风向: %s", text);
+    }
+    return wind;
+}
+
+/* 实况（extensions=base 的 lives[0]）已解析到live_text，转为编码写入live_scratch */
+static esp_err_t parse_live_response(void)
+{
+    if (check_amap_status() != ESP_OK) {
         return ESP_FAIL;
     }
+    if (live_fields[1].type != JSON_STREAM_CONTAINER) {
+        ESP_LOGE(TAG, "No live data found");
+        return ESP_FAIL;
+    }
+    live_scratch = (weather_info_t) {
+        .weather = parse_weather(live_text.weather),
+        .temperature = parse_temperature(live_text.temperature),
+        .winddirection = parse_wind(live_text.winddirection),
+        .windpower = weather_power_from_text(live_text.windpower),
+        .humidity = parse_humidity(live_text.humidity),
+    };
+    ESP_LOGI(TAG, "城市: %s, 天气: %s, 温度: %s°C", live_text.city, live_text.weather, live_text.temperature);
+    return ESP_OK;
+}
 
-    // 获取lives数组
-    cJSON *lives = cJSON_GetObjectItem(json, "lives");
-    if (lives == NULL || !cJSON_IsArray(lives)) {
-        ESP_LOGE(TAG, "No lives array found");
-        cJSON_Delete(json);
+/* 预报（extensions=all 的 forecasts[0].casts）已解析到forecast_text，转为编码写入forecast_scratch */
+static esp_err_t parse_forecast_response(void)
+{
+    if (check_amap_status() != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (forecast_fields[1].type != JSON_STREAM_CONTAINER) {
+        ESP_LOGE(TAG, "No forecast data found");
         return ESP_FAIL;
     }
 
-    cJSON *live_data = cJSON_GetArrayItem(lives, 0);
-    if (live_data == NULL) {
-        ESP_LOGE(TAG, "No live data found");
-        cJSON_Delete(json);
+    int count = 0;
+    while (count < WEATHER_FORECAST_DAYS &&
+           forecast_fields[FORECAST_CAST_FIELD_BASE + count * FORECAST_FIELDS_PER_CAST].type != JSON_STREAM_NONE) {
+        count++;
+    }
+    forecast_scratch.cast_count = (uint8_t)count;
+    memset(forecast_scratch.casts, 0, sizeof(forecast_scratch.casts));
+    for (int i = 0; i < count; i++) {
+        const amap_cast_text_t *text = &forecast_text.casts[i];
+        forecast_scratch.casts[i] = (weather_forecast_t) {
+            .date = parse_date(text->date),
+            .dayweather = parse_weather(text->dayweather),
+            .nightweather = parse_weather(text->nightweather),
+            .daytemp = parse_temperature(text->daytemp),
+            .nighttemp = parse_temperature(text->nighttemp),
+            .daywind = parse_wind(text->daywind),
+            .nightwind = parse_wind(text->nightwind),
+            .daypower = weather_power_from_text(text->daypower),
+            .nightpower = weather_power_from_text(text->nightpower),
+        };
+    }
+
+    ESP_LOGI(TAG, "预报: %s %d天, 发布时间 %s", forecast_text.city, count, forecast_text.reporttime);
+    return ESP_OK;
+}
+
+static void feed_cached_body(const char *data, int len, void *ctx)
+{
+    json_stream_feed(&response_stream, data, len);
+}
+
+/* 解码后的响应体：分块与非分块响应都按顺序喂给解析器（语法错误在请求结束时报告），同时交给缓存 */
+static void feed_decoded_body(const char *data, int len, void *ctx)
+{
+    json_stream_feed(&response_stream, data, len);
+    http_cache_append(ctx, data, len);
+}
+
+/* 把缓存的响应体当作本次响应解析 */
+static esp_err_t replay_cached(http_cache_txn_t *cache)
+{
+    if (http_cache_replay(cache, feed_cached_body, NULL) != ESP_OK ||
+        json_stream_finish(&response_stream) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to parse cached response");
         return ESP_FAIL;
     }
+    return ESP_OK;
+}
 
-    // 解析各个字段
-    cJSON *province = cJSON_GetObjectItem(live_data, "province");
-    cJSON *city = cJSON_GetObjectItem(live_data, "city");
-    cJSON *adcode = cJSON_GetObjectItem(live_data, "adcode");
-    cJSON *weather = cJSON_GetObjectItem(live_data, "weather");
-    cJSON *temperature = cJSON_GetObjectItem(live_data, "temperature");
-    cJSON *winddirection = cJSON_GetObjectItem(live_data, "winddirection");
-    cJSON *windpower = cJSON_GetObjectItem(live_data, "windpower");
-    cJSON *humidity = cJSON_GetObjectItem(live_data, "humidity");
-    cJSON *reporttime = cJSON_GetObjectItem(live_data, "reporttime");
+/*
+ * 取一个接口的响应，响应体边接收边解析到fields：
+ * 缓存未过期时直接回放不联网；已过期时带条件头请求，304时回放缓存。
+ * 连接在第一次需要联网时才建立，两次请求共用一个客户端（第二次复用keep-alive连接）。
+ * status_code输出本次的HTTP状态，0表示使用了未过期的缓存，-1表示请求失败。
+ */
+static esp_err_t fetch_json(esp_http_client_handle_t *client, const char *url, http_cache_txn_t *cache,
+                            http_decode_endpoint_t *endpoint, int *status_code,
+                            json_stream_field_t *fields, size_t field_count)
+{
+    json_stream_init(&response_stream, fields, field_count);
+    *status_code = -1;
 
-    // 填充天气信息结构体
-    if (province && cJSON_IsString(province)) {
-        strncpy(weather_info->province, province->valuestring, sizeof(weather_info->province) - 1);
-        weather_info->province[sizeof(weather_info->province) - 1] = '\0';
+    if (cache->state == HTTP_CACHE_FRESH) {
+        *status_code = 0;
+        return replay_cached(cache);
     }
 
-    if (city && cJSON_IsString(city)) {
-        strncpy(weather_info->city, city->valuestring, sizeof(weather_info->city) - 1);
-        weather_info->city[sizeof(weather_info->city) - 1] = '\0';
+    if (wifi_get_status() != WIFI_STATUS_CONNECTED) {
+        ESP_LOGW(TAG, "WiFi not connected, cannot get weather info");
+        return ESP_ERR_WIFI_NOT_CONNECT;
     }
 
-    if (adcode && cJSON_IsString(adcode)) {
-        strncpy(weather_info->adcode, adcode->valuestring, sizeof(weather_info->adcode) - 1);
-        weather_info->adcode[sizeof(weather_info->adcode) - 1] = '\0';
+    if (*client == NULL) {
+        esp_http_client_config_t config = {
+            .url = url,
+            .event_handler = http_event_handler,
+            .timeout_ms = 10000,
+            .keep_alive_enable = true,
+        };
+        *client = esp_http_client_init(&config);
+        if (*client == NULL) {
+            ESP_LOGE(TAG, "Failed to initialize HTTP client");
+            return ESP_FAIL;
+        }
+        http_decode_accept(*client);
     }
 
-    if (weather && cJSON_IsString(weather)) {
-        strncpy(weather_info->weather, weather->valuestring, sizeof(weather_info->weather) - 1);
-        weather_info->weather[sizeof(weather_info->weather) - 1] = '\0';
+    esp_err_t err = esp_http_client_set_url(*client, url);
+    if (err == ESP_OK) {
+        http_cache_prepare_request(cache, *client);
+        http_decoder_begin(&response_decoder, endpoint, feed_decoded_body, cache);
+        esp_http_client_set_user_data(*client, cache);
+        err = esp_http_client_perform(*client);
+        esp_http_client_set_user_data(*client, NULL);
+        esp_err_t decode_err = http_decoder_finish(&response_decoder);
+        if (err == ESP_OK) {
+            err = decode_err;
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+        return err;
     }
 
-    if (temperature && cJSON_IsString(temperature)) {
-        strncpy(weather_info->temperature, temperature->valuestring, sizeof(weather_info->temperature) - 1);
-        weather_info->temperature[sizeof(weather_info->temperature) - 1] = '\0';
+    *status_code = esp_http_client_get_status_code(*client);
+    ESP_LOGI(TAG, "HTTP GET Status = %d, len = %u", *status_code, (unsigned)response_stream.bytes);
+    if (*status_code == 304 && cache->state == HTTP_CACHE_STALE) {
+        return replay_cached(cache);
+    }
+    if (*status_code != 200 || response_stream.bytes == 0) {
+        ESP_LOGE(TAG, "HTTP request failed with status %d", *status_code);
+        return ESP_FAIL;
+    }
+    if (json_stream_finish(&response_stream) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to parse JSON");
+        return ESP_FAIL;
     }
+    return ESP_OK;
+}
 
-    if (winddirection && cJSON_IsString(winddirection)) {
-        strncpy(weather_info->winddirection, winddirection->valuestring, sizeof(weather_info->winddirection) - 1);
-        weather_info->winddirection[sizeof(weather_info->winddirection) - 1] = '\0';
+/* 快照超过最大时长（或取得时间未知而时钟已建立时）丢弃 */
+static bool snapshot_part_usable(bool valid, int64_t fetched_at, int64_t now)
+{
+    if (!valid) {
+        return false;
     }
+    if (now <= 0) {
+        return true;        // 时钟未建立，无法判断，照常显示为旧数据
+    }
+    return fetched_at > 0 && now >= fetched_at && now - fetched_at <= WEATHER_SNAPSHOT_MAX_AGE_S;
+}
 
-    if (windpower && cJSON_IsString(windpower)) {
-        strncpy(weather_info->windpower, windpower->valuestring, sizeof(weather_info->windpower) - 1);
-        weather_info->windpower[sizeof(weather_info->windpower) - 1] = '\0';
+/* 按adcode找槽位，须持有report_mutex */
+static weather_slot_t *find_slot(const char *adcode)
+{
+    for (int i = 0; i < city_count; i++) {
+        if (strcmp(slots[i].city.adcode, adcode) == 0) {
+            return &slots[i];
+        }
     }
+    return NULL;
+}
 
-    if (humidity && cJSON_IsString(humidity)) {
-        strncpy(weather_info->humidity, humidity->valuestring, sizeof(weather_info->humidity) - 1);
-        weather_info->humidity[sizeof(weather_info->humidity) - 1] = '\0';
+static void snapshot_key(const char *adcode, char *key, size_t size)
+{
+    snprintf(key, size, WEATHER_NVS_SNAPSHOT_FMT, adcode);
+}
+
+/* 从NVS恢复一个城市的快照，写入尚未被其他任务看到的槽位 */
+static void load_snapshot(weather_slot_t *slot)
+{
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    nvs_handle_t handle;
+    if (nvs_open(WEATHER_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;     // 从未保存过
+    }
+    snapshot_key(slot->city.adcode, key, sizeof(key));
+    size_t size = sizeof(slot->saved);
+    esp_err_t ret = nvs_get_blob(handle, key, &slot->saved, &size);
+    nvs_close(handle);
+    if (ret != ESP_OK || size != sizeof(slot->saved) || slot->saved.version != WEATHER_SNAPSHOT_VERSION ||
+        slot->saved.cast_count > WEATHER_FORECAST_DAYS) {
+        memset(&slot->saved, 0, sizeof(slot->saved));
+        return;
     }
 
-    if (reporttime && cJSON_IsString(reporttime)) {
-        strncpy(weather_info->reporttime, reporttime->valuestring, sizeof(weather_info->reporttime) - 1);
-        weather_info->reporttime[sizeof(weather_info->reporttime) - 1] = '\0';
+    int64_t now = time_service_get_utc_seconds();
+    const weather_snapshot_t *snap = &slot->saved;
+    weather_report_t *report = &slot->report;
+    memcpy(report->city, snap->city, sizeof(report->city));
+    if (snapshot_part_usable(snap->live_valid, snap->live_fetched_at, now)) {
+        report->live = snap->live;
+        report->live_reporttime = snap->live_reporttime;
+        report->live_valid = true;
+        report->live_stale = true;
+        report->live_fetched_at = snap->live_fetched_at;
+    }
+    if (snapshot_part_usable(snap->forecast_valid, snap->forecast_fetched_at, now)) {
+        memcpy(report->casts, snap->casts, sizeof(report->casts));
+        report->cast_count = snap->cast_count;
+        report->forecast_reporttime = snap->forecast_reporttime;
+        report->forecast_valid = true;
+        report->forecast_stale = true;
+        report->forecast_fetched_at = snap->forecast_fetched_at;
     }
+    if (report->live_valid || report->forecast_valid) {
+        ESP_LOGI(TAG, "已恢复天气快照: %s %s%s", report->city,
+                 weather_code_name(report->live.weather), report->forecast_valid ? "，含预报" : "");
+    } else {
+        ESP_LOGI(TAG, "%s 的天气快照已过期，不再显示", slot->city.adcode);
+    }
+}
 
-    cJSON_Delete(json);
-    ESP_LOGI(TAG, "Weather data parsed successfully");
-    ESP_LOGI(TAG, "城市: %s, 天气: %s, 温度: %s°C", weather_info->city, weather_info->weather, weather_info->temperature);
+/* 发布时间有变化时把该城市的快照写入NVS，同一份数据的反复验证不写闪存 */
+static void save_snapshot(const char *adcode)
+{
+    weather_snapshot_t snap = {
+        .version = WEATHER_SNAPSHOT_VERSION,
+    };
+    weather_snapshot_t saved;
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    weather_slot_t *slot = find_slot(adcode);
+    if (slot == NULL) {
+        xSemaphoreGive(report_mutex);
+        return;     // 刷新期间已从列表中移除
+    }
+    const weather_report_t *report = &slot->report;
+    snap.live_valid = report->live_valid && !report->live_stale;
+    snap.forecast_valid = report->forecast_valid && !report->forecast_stale;
+    memcpy(snap.city, report->city, sizeof(snap.city));
+    snap.live = report->live;
+    snap.live_reporttime = report->live_reporttime;
+    snap.live_fetched_at = report->live_fetched_at;
+    memcpy(snap.casts, report->casts, sizeof(snap.casts));
+    snap.cast_count = report->cast_count;
+    snap.forecast_reporttime = report->forecast_reporttime;
+    snap.forecast_fetched_at = report->forecast_fetched_at;
+    saved = slot->saved;
+    xSemaphoreGive(report_mutex);
+
+    /* 开机恢复后尚未刷新的部分沿用旧快照 */
+    if (!snap.live_valid && saved.live_valid) {
+        snap.live_valid = true;
+        snap.live = saved.live;
+        snap.live_reporttime = saved.live_reporttime;
+        snap.live_fetched_at = saved.live_fetched_at;
+    }
+    if (!snap.forecast_valid && saved.forecast_valid) {
+        snap.forecast_valid = true;
+        memcpy(snap.casts, saved.casts, sizeof(snap.casts));
+        snap.cast_count = saved.cast_count;
+        snap.forecast_reporttime = saved.forecast_reporttime;
+        snap.forecast_fetched_at = saved.forecast_fetched_at;
+    }
 
-    return ESP_OK;
+    if (snap.live_valid == saved.live_valid && snap.forecast_valid == saved.forecast_valid &&
+        snap.live_reporttime == saved.live_reporttime &&
+        snap.forecast_reporttime == saved.forecast_reporttime) {
+        return;
+    }
+
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    snapshot_key(adcode, key, sizeof(key));
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(WEATHER_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, key, &snap, sizeof(snap));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save weather snapshot: %s", esp_err_to_name(ret));
+        return;
+    }
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    slot = find_slot(adcode);
+    if (slot != NULL) {
+        slot->saved = snap;
+    }
+    xSemaphoreGive(report_mutex);
+    ESP_LOGI(TAG, "%s 天气快照已保存 (%u 字节)", adcode, (unsigned)sizeof(snap));
+}
+
+/* 槽位置为新城市的初始状态：没有数据，立即到期 */
+static void init_slot(weather_slot_t *slot, const weather_city_t *city)
+{
+    memset(slot, 0, sizeof(*slot));
+    slot->city = *city;
+    slot->live_refresh = live_refresh_template;
+    slot->forecast_refresh = forecast_refresh_template;
+}
+
+/* 6位数字的区域编码 */
+static bool adcode_is_valid(const char *adcode)
+{
+    size_t len = strlen(adcode);
+    if (len != 6) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (adcode[i] < '0' || adcode[i] > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool city_config_is_valid(const weather_city_t *cities, int count)
+{
+    if (count < 1 || count > WEATHER_MAX_CITIES) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (strnlen(cities[i].adcode, sizeof(cities[i].adcode)) == sizeof(cities[i].adcode) ||
+            strnlen(cities[i].name, sizeof(cities[i].name)) == sizeof(cities[i].name) ||
+            !adcode_is_valid(cities[i].adcode)) {
+            return false;
+        }
+        for (int j = 0; j < i; j++) {
+            if (strcmp(cities[i].adcode, cities[j].adcode) == 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* 读取NVS中的城市列表，没有或无效时使用默认城市 */
+static void load_cities(void)
+{
+    static const weather_city_t default_city = {
+        .adcode = WEATHER_DEFAULT_ADCODE,
+        .name = WEATHER_DEFAULT_CITY_NAME,
+    };
+    weather_city_config_t config = {0};
+    nvs_handle_t handle;
+    if (nvs_open(WEATHER_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        size_t size = sizeof(config);
+        if (nvs_get_blob(handle, WEATHER_NVS_CITIES_KEY, &config, &size) != ESP_OK || size != sizeof(config)) {
+            config.version = 0;
+        }
+        nvs_close(handle);
+    }
+    if (config.version != WEATHER_CITIES_VERSION || !city_config_is_valid(config.cities, config.count)) {
+        config.count = 1;
+        config.cities[0] = default_city;
+    }
+
+    city_count = config.count;
+    for (int i = 0; i < city_count; i++) {
+        init_slot(&slots[i], &config.cities[i]);
+        load_snapshot(&slots[i]);
+    }
+    if (slots[0].report.live_valid || slots[0].report.forecast_valid) {
+        boot_snapshot_us = esp_timer_get_time();
+    }
+    ESP_LOGI(TAG, "关注城市 %d 个，本地: %s (%s)", city_count, slots[0].city.name, slots[0].city.adcode);
 }
 
 /* 初始化天气API客户端 */
 esp_err_t weather_api_init(void)
 {
     ESP_LOGI(TAG, "Initializing weather API client");
+    if (report_mutex == NULL) {
+        report_mutex = xSemaphoreCreateMutex();
+        if (report_mutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create mutex");
+            return ESP_ERR_NO_MEM;
+        }
+        load_cities();
+    }
     return ESP_OK;
 }
 
-/* 获取天气信息 */
-esp_err_t weather_api_get_weather(const char* city_code, weather_info_t* weather_info)
+esp_err_t weather_api_set_cities(const weather_city_t *cities, int count)
 {
-    if (weather_info == NULL) {
-        ESP_LOGE(TAG, "Weather info pointer is NULL");
+    if (cities == NULL || report_mutex == NULL || !city_config_is_valid(cities, count)) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    // 检查WiFi连接状态
-    wifi_status_t wifi_status = wifi_get_status();
-    if (wifi_status != WIFI_STATUS_CONNECTED) {
-        ESP_LOGW(TAG, "WiFi not connected, cannot get weather info");
-        return ESP_ERR_WIFI_NOT_CONNECT;
+    weather_city_config_t config = {
+        .version = WEATHER_CITIES_VERSION,
+        .count = (uint8_t)count,
+    };
+    memcpy(config.cities, cities, count * sizeof(cities[0]));
+
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(WEATHER_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(handle, WEATHER_NVS_CITIES_KEY, &config, sizeof(config));
+        /* 移出列表的城市不再需要快照 */
+        for (int i = 0; ret == ESP_OK && i < city_count; i++) {
+            bool kept = false;
+            for (int j = 0; j < count; j++) {
+                kept = kept || strcmp(slots[i].city.adcode, cities[j].adcode) == 0;
+            }
+            if (!kept) {
+                char key[NVS_KEY_NAME_MAX_SIZE];
+                snapshot_key(slots[i].city.adcode, key, sizeof(key));
+                esp_err_t erase_ret = nvs_erase_key(handle, key);
+                if (erase_ret != ESP_OK && erase_ret != ESP_ERR_NVS_NOT_FOUND) {
+                    ret = erase_ret;
+                }
+            }
+        }
+        if (ret == ESP_OK) {
+            ret = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (ret != ESP_OK) {
+        xSemaphoreGive(report_mutex);
+        ESP_LOGE(TAG, "Failed to save weather cities: %s", esp_err_to_name(ret));
+        return ret;
     }
 
-    // 构建请求URL
-    char url[256];
-    snprintf(url, sizeof(url), "http://restapi.amap.com/v3/weather/weatherInfo?city=%s&key=%s&extensions=all&output=json",
-             city_code, WEATHER_API_KEY);
+    /* 仍在列表中的城市保留数据、刷新计划和统计，只更新显示名 */
+    for (int i = 0; i < count; i++) {
+        weather_slot_t *old = find_slot(cities[i].adcode);
+        if (old != NULL) {
+            next_slots[i] = *old;
+            next_slots[i].city = cities[i];
+        } else {
+            init_slot(&next_slots[i], &cities[i]);
+            load_snapshot(&next_slots[i]);
+        }
+    }
+    memcpy(slots, next_slots, count * sizeof(slots[0]));
+    city_count = (uint8_t)count;
+    xSemaphoreGive(report_mutex);
 
-    ESP_LOGI(TAG, "Requesting weather info from: %s", url);
+    ESP_LOGI(TAG, "关注城市已更新为 %d 个", count);
+    return ESP_OK;
+}
 
-    // 重置响应缓冲区
-    response_len = 0;
-    memset(http_response_buffer, 0, sizeof(http_response_buffer));
+int weather_api_get_cities(weather_city_t *cities, int max_count)
+{
+    if (cities == NULL || report_mutex == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    int count = city_count < max_count ? city_count : max_count;
+    for (int i = 0; i < count; i++) {
+        cities[i] = slots[i].city;
+    }
+    xSemaphoreGive(report_mutex);
+    return count;
+}
 
-    // 配置HTTP客户端
-    esp_http_client_config_t config = {
-        .url = url,
-        .event_handler = http_event_handler,
-        .timeout_ms = 10000,
-    };
+bool weather_api_next_due(int64_t now_us, weather_city_t *city, bool *include_forecast)
+{
+    if (report_mutex == NULL) {
+        return false;
+    }
+    weather_slot_t *due = NULL;
+    int64_t due_us = 0;
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    for (int i = 0; i < city_count; i++) {
+        const weather_report_t *report = &slots[i].report;
+        int64_t next_us = report->live_next_us < report->forecast_next_us ?
+                          report->live_next_us : report->forecast_next_us;
+        if (next_us <= now_us && (due == NULL || next_us < due_us)) {
+            due = &slots[i];
+            due_us = next_us;
+        }
+    }
+    if (due != NULL) {
+        *city = due->city;
+        *include_forecast = now_us >= due->report.forecast_next_us;
+    }
+    xSemaphoreGive(report_mutex);
+    return due != NULL;
+}
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client");
-        return ESP_FAIL;
+static int64_t local_now_s(void)
+{
+    return time_service_get_local_us() / 1000000;
+}
+
+/* 本次请求的来源：联网取回、缓存命中（未过期或304）或失败 */
+static void count_fetch(weather_city_stats_t *stats, esp_err_t err, int status_code)
+{
+    if (err != ESP_OK) {
+        stats->errors++;
+    } else if (status_code == 200) {
+        stats->fetches++;
+    } else {
+        stats->cache_hits++;
+    }
+}
+
+/* 缓存有效期不超过预计的下次发布，之后的刷新一定会联网验证 */
+static void limit_cache_to_stamp(http_cache_txn_t *cache, const refresh_policy_t *policy, int64_t stamp)
+{
+    int64_t now = local_now_s();
+    if (stamp > 0 && now > 0) {
+        http_cache_limit_max_age(cache, refresh_policy_fresh_for(policy, stamp, now));
     }
+}
 
-    ESP_LOGI(TAG, "Starting HTTP request to API...");
+/* 按本次结果推算下次刷新的esp_timer时间 */
+static int64_t next_refresh_us(refresh_policy_t *policy, esp_err_t err, int64_t stamp)
+{
+    uint32_t interval_s = err == ESP_OK ?
+        refresh_policy_on_data(policy, stamp, local_now_s()) :
+        refresh_policy_on_error(policy);
+    return esp_timer_get_time() + (int64_t)interval_s * 1000000;
+}
 
-    // 执行HTTP GET请求
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        int content_length = esp_http_client_get_content_length(client);
-        
-        ESP_LOGI(TAG, "HTTP GET Status = %d, content_length = %d", status_code, content_length);
-        
-        if (status_code == 200 && response_len > 0) {
-            ESP_LOGI(TAG, "HTTP response: %s", http_response_buffer);
-            err = parse_weather_response(http_response_buffer, weather_info);
-        } else {
-            ESP_LOGE(TAG, "HTTP request failed with status %d", status_code);
-            err = ESP_FAIL;
+esp_err_t weather_api_refresh(const char *city_code, bool include_forecast)
+{
+    if (city_code == NULL || report_mutex == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    bool configured = find_slot(city_code) != NULL;
+    xSemaphoreGive(report_mutex);
+    if (!configured) {
+        ESP_LOGW(TAG, "城市 %s 不在关注列表中", city_code);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_http_client_handle_t client = NULL;     // 缓存都未过期时不建立连接
+    http_cache_txn_t cache;
+    int status_code;
+    char url[256];
+    char cache_key[HTTP_CACHE_KEY_LEN];
+
+    snprintf(url, sizeof(url), WEATHER_API_URL "?city=%s&key=%s&extensions=base&output=json",
+             city_code, WEATHER_API_KEY);
+    snprintf(cache_key, sizeof(cache_key), "weather/base/%s", city_code);
+    http_cache_begin(&cache, &live_cache, cache_key);
+
+    esp_err_t live_err = fetch_json(&client, url, &cache, &live_decode, &status_code,
+                                    live_fields, sizeof(live_fields) / sizeof(live_fields[0]));
+    if (live_err == ESP_OK) {
+        live_err = parse_live_response();
+    }
+    int64_t live_stamp = refresh_policy_parse_stamp(live_text.reporttime);
+    if (live_err == ESP_OK) {
+        limit_cache_to_stamp(&cache, &live_refresh_template, live_stamp);
+    }
+    http_cache_finish(&cache, status_code, live_err == ESP_OK);
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    weather_slot_t *slot = find_slot(city_code);
+    if (slot != NULL) {
+        weather_report_t *report = &slot->report;
+        count_fetch(&slot->stats, live_err, status_code);
+        if (live_err == ESP_OK) {
+            report->live = live_scratch;
+            report->live_reporttime = live_stamp;
+            if (live_text.city[0] != '\0') {
+                memcpy(report->city, live_text.city, sizeof(report->city));
+            }
+            report->live_valid = true;
+            report->live_stale = false;
+            report->live_updated_us = esp_timer_get_time();
+            report->live_fetched_at = time_service_get_utc_seconds();
+            if (boot_live_us < 0 && slot == &slots[0]) {
+                boot_live_us = report->live_updated_us;
+            }
         }
-    } else {
-        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+        report->live_next_us = next_refresh_us(&slot->live_refresh, live_err, live_stamp);
+    }
+    xSemaphoreGive(report_mutex);
+
+    esp_err_t forecast_err = ESP_OK;
+    if (include_forecast) {
+        snprintf(url, sizeof(url), WEATHER_API_URL "?city=%s&key=%s&extensions=all&output=json",
+                 city_code, WEATHER_API_KEY);
+        snprintf(cache_key, sizeof(cache_key), "weather/all/%s", city_code);
+        http_cache_begin(&cache, &forecast_cache, cache_key);
+        forecast_err = fetch_json(&client, url, &cache, &forecast_decode, &status_code, forecast_fields,
+                                  sizeof(forecast_fields) / sizeof(forecast_fields[0]));
+        if (forecast_err == ESP_OK) {
+            forecast_err = parse_forecast_response();
+        }
+        int64_t forecast_stamp = refresh_policy_parse_stamp(forecast_text.reporttime);
+        if (forecast_err == ESP_OK) {
+            limit_cache_to_stamp(&cache, &forecast_refresh_template, forecast_stamp);
+        }
+        http_cache_finish(&cache, status_code, forecast_err == ESP_OK);
+        xSemaphoreTake(report_mutex, portMAX_DELAY);
+        slot = find_slot(city_code);
+        if (slot != NULL) {
+            weather_report_t *report = &slot->report;
+            count_fetch(&slot->stats, forecast_err, status_code);
+            if (forecast_err == ESP_OK) {
+                memcpy(report->casts, forecast_scratch.casts, sizeof(report->casts));
+                report->cast_count = forecast_scratch.cast_count;
+                report->forecast_reporttime = forecast_stamp;
+                if (forecast_text.city[0] != '\0') {
+                    memcpy(report->city, forecast_text.city, sizeof(report->city));
+                }
+                report->forecast_valid = true;
+                report->forecast_stale = false;
+                report->forecast_updated_us = esp_timer_get_time();
+                report->forecast_fetched_at = time_service_get_utc_seconds();
+            }
+            report->forecast_next_us = next_refresh_us(&slot->forecast_refresh, forecast_err, forecast_stamp);
+        }
+        xSemaphoreGive(report_mutex);
     }
 
-    esp_http_client_cleanup(client);
-    return err;
+    if (client != NULL) {
+        esp_http_client_cleanup(client);
+    }
+    if (live_err == ESP_OK || (include_forecast && forecast_err == ESP_OK)) {
+        save_snapshot(city_code);
+    }
+    return live_err != ESP_OK ? live_err : forecast_err;
+}
+
+esp_err_t weather_api_get_report(int city, weather_report_t *report)
+{
+    if (report == NULL || report_mutex == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    if (city < 0 || city >= city_count) {
+        xSemaphoreGive(report_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    *report = slots[city].report;
+    xSemaphoreGive(report_mutex);
+    return ESP_OK;
+}
+
+esp_err_t weather_api_get_city_stats(int city, weather_city_stats_t *stats)
+{
+    if (stats == NULL || report_mutex == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(report_mutex, portMAX_DELAY);
+    if (city < 0 || city >= city_count) {
+        xSemaphoreGive(report_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    *stats = slots[city].stats;
+    xSemaphoreGive(report_mutex);
+    return ESP_OK;
+}
+
+void weather_api_get_cache_stats(http_cache_stats_t *live, http_cache_stats_t *forecast)
+{
+    http_cache_get_stats(&live_cache, live);
+    http_cache_get_stats(&forecast_cache, forecast);
+}
+
+void weather_api_get_decode_stats(http_decode_stats_t *live, http_decode_stats_t *forecast)
+{
+    http_decode_get_stats(&live_decode, live);
+    http_decode_get_stats(&forecast_decode, forecast);
+}
+
+void weather_api_get_boot_timing(int32_t *snapshot_ms, int32_t *live_ms)
+{
+    *snapshot_ms = boot_snapshot_us < 0 ? -1 : (int32_t)(boot_snapshot_us / 1000);
+    *live_ms = boot_live_us < 0 ? -1 : (int32_t)(boot_live_us / 1000);
 }
 
 /* 释放天气API客户端资源 */
 void weather_api_deinit(void)
 {
     ESP_LOGI(TAG, "Weather API client deinitialized");
-} 
\ No newline at end of file
+}
@@ -1,30 +1,166 @@
 #ifndef WEATHER_API_H
 #define WEATHER_API_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
+#include "http_cache.h"
+#include "http_decode.h"
+#include "weather_codes.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* 天气信息结构体 */
+#define WEATHER_FORECAST_DAYS   4   // 高德预报返回当天起4天
+#define WEATHER_API_HOST        "restapi.amap.com"
+
+// 响应缓存有效期上限（秒），有效期内的刷新直接使用缓存，过期后条件请求
+#define WEATHER_LIVE_CACHE_TTL_S        900     // 高德实况约每小时更新一次
+#define WEATHER_FORECAST_CACHE_TTL_S    3600
+
+// 关注的城市列表保存在NVS，可通过网页接口修改；第一个为本地城市（桌面1显示、闹钟前预取）
+#define WEATHER_MAX_CITIES              4
+#define WEATHER_CITY_NAME_LEN           16      // 显示名（UTF-8），须为字库中有的字
+#define WEATHER_DEFAULT_ADCODE          "370215"
+#define WEATHER_DEFAULT_CITY_NAME       "即墨"
+
+// 最近一次成功的天气快照保存在NVS，开机立即显示（标记为旧数据），联网后重新验证
+#define WEATHER_SNAPSHOT_MAX_AGE_S      (12 * 3600)     // 超过此时长的快照开机时丢弃
+
+// 按reporttime推算刷新时间（秒）：预计下次发布之后再取，上游未更新时从最小间隔加倍退避
+#define WEATHER_LIVE_PERIOD_S           3600
+#define WEATHER_LIVE_GRACE_S            300     // 发布时间之后约几分钟接口才返回新数据
+#define WEATHER_LIVE_MIN_INTERVAL_S     600
+#define WEATHER_LIVE_MAX_INTERVAL_S     3600
+#define WEATHER_FORECAST_PERIOD_S       (3 * 3600)  // 预报每天发布数次
+#define WEATHER_FORECAST_GRACE_S        600
+#define WEATHER_FORECAST_MIN_INTERVAL_S 1800
+#define WEATHER_FORECAST_MAX_INTERVAL_S (6 * 3600)
+
+/* 关注的城市 */
 typedef struct {
-    char province[32];      // 省份名
-    char city[32];          // 城市名
-    char adcode[16];        // 区域编码
-    char weather[32];       // 天气现象（汉字描述）
-    char temperature[8];    // 实时气温，单位：摄氏度
-    char winddirection[16]; // 风向描述
-    char windpower[8];      // 风力级别，单位：级
-    char humidity[8];       // 空气湿度
-    char reporttime[32];    // 数据发布的时间
+    char adcode[8];                     // 高德区域编码（6位数字）
+    char name[WEATHER_CITY_NAME_LEN];   // 显示名
+} weather_city_t;
+
+/* 单个城市的请求统计，实况与预报各算一次 */
+typedef struct {
+    uint32_t fetches;       // 联网取回完整响应（200）
+    uint32_t cache_hits;    // 缓存未过期直接使用，或条件请求得到304
+    uint32_t errors;
+} weather_city_stats_t;
+
+#define WEATHER_TEMP_UNKNOWN        INT8_MIN    // 气温缺失
+#define WEATHER_HUMIDITY_UNKNOWN    0xFF        // 湿度缺失
+
+/* 天气实况，解析时由接口的文本转为编码和整数，显示时查weather_codes中的表 */
+typedef struct {
+    uint8_t weather;        // 天气现象，weather_code_t
+    int8_t temperature;     // 实时气温，单位：摄氏度
+    uint8_t winddirection;  // 风向，weather_wind_t
+    uint8_t windpower;      // 风力级别范围，见WEATHER_POWER
+    uint8_t humidity;       // 空气湿度，单位：%
 } weather_info_t;
 
-/* 初始化天气API客户端 */
+/* 单日预报 */
+typedef struct {
+    uint16_t date;          // 日期，1970-01-01起的天数，星期由civil_weekday算出
+    uint8_t dayweather;     // 白天天气，weather_code_t
+    uint8_t nightweather;   // 晚上天气
+    int8_t daytemp;         // 白天温度
+    int8_t nighttemp;       // 晚上温度
+    uint8_t daywind;        // 白天风向，weather_wind_t
+    uint8_t nightwind;      // 晚上风向
+    uint8_t daypower;       // 白天风力，见WEATHER_POWER
+    uint8_t nightpower;     // 晚上风力
+} weather_forecast_t;
+
+/**
+ * @brief 实况与预报的合并快照，桌面1和桌面4都从这里读取
+ */
+typedef struct {
+    weather_info_t live;
+    weather_forecast_t casts[WEATHER_FORECAST_DAYS];
+    uint8_t cast_count;
+    char city[32];                  // 城市名（实况与预报相同）
+    int64_t live_reporttime;        // 数据发布时间（本地时间秒），0表示未知
+    int64_t forecast_reporttime;
+    bool live_valid;
+    bool forecast_valid;
+    int64_t live_updated_us;        // esp_timer时间，0表示从未成功
+    int64_t forecast_updated_us;
+    int64_t live_next_us;           // 按发布时间推算的下次刷新（esp_timer时间），0表示立即
+    int64_t forecast_next_us;
+    int64_t live_fetched_at;        // 取得该实况时的UTC秒，0表示未知；随快照保存
+    int64_t forecast_fetched_at;
+    bool live_stale;                // 开机从快照恢复，尚未联网验证
+    bool forecast_stale;
+} weather_report_t;
+
+/* 初始化天气API客户端，并从NVS恢复上次保存的快照（须在nvs_flash_init之后调用） */
 esp_err_t weather_api_init(void);
 
-/* 获取天气信息 */
-esp_err_t weather_api_get_weather(const char* city_code, weather_info_t* weather_info);
+/**
+ * @brief 刷新一次天气快照
+ *
+ * 在同一个HTTP连接上先请求实况（extensions=base），include_forecast时
+ * 再请求预报（extensions=all），成功的部分写入快照。
+ * 无论成败都按发布时间或退避更新快照中的live_next_us/forecast_next_us。
+ *
+ * @param city_code 高德城市编码（adcode），须在关注列表中
+ * @param include_forecast 是否同时刷新预报
+ * @return esp_err_t 实况与预报都成功才返回ESP_OK，不在关注列表中返回ESP_ERR_NOT_FOUND
+ */
+esp_err_t weather_api_refresh(const char *city_code, bool include_forecast);
+
+/**
+ * @brief 复制一个城市的天气快照，只读内存，不触发请求
+ *
+ * @param city 关注列表中的序号，0为本地城市
+ */
+esp_err_t weather_api_get_report(int city, weather_report_t *report);
+
+/**
+ * @brief 找出最早到期的城市，供调用者逐个提交刷新（不集中发起）
+ *
+ * @return bool 有城市到期时返回true，并给出城市和是否需要同时刷新预报
+ */
+bool weather_api_next_due(int64_t now_us, weather_city_t *city, bool *include_forecast);
+
+/**
+ * @brief 设置关注的城市并保存到NVS
+ *
+ * 仍在列表中的城市保留已有数据和刷新计划，新加入的城市立即到期，移出的城市删除其快照。
+ *
+ * @return esp_err_t 数量不在1~WEATHER_MAX_CITIES、编码不是6位数字或重复时返回ESP_ERR_INVALID_ARG
+ */
+esp_err_t weather_api_set_cities(const weather_city_t *cities, int count);
+
+/**
+ * @brief 复制关注的城市列表，返回城市数
+ */
+int weather_api_get_cities(weather_city_t *cities, int max_count);
+
+/**
+ * @brief 复制一个城市的请求统计
+ */
+esp_err_t weather_api_get_city_stats(int city, weather_city_stats_t *stats);
+
+/**
+ * @brief 复制实况与预报两个接口的响应缓存统计
+ */
+void weather_api_get_cache_stats(http_cache_stats_t *live, http_cache_stats_t *forecast);
+
+/**
+ * @brief 复制实况与预报两个接口的传输统计（线上字节与解压后字节）
+ */
+void weather_api_get_decode_stats(http_decode_stats_t *live, http_decode_stats_t *forecast);
+
+/**
+ * @brief 开机计时：快照恢复、首次联网刷新成功距上电的毫秒数，-1表示本次开机尚未发生
+ */
+void weather_api_get_boot_timing(int32_t *snapshot_ms, int32_t *live_ms);
 
 /* 释放天气API客户端资源 */
 void weather_api_deinit(void);
@@ -33,4 +169,4 @@ void weather_api_deinit(void);
 }
 #endif
 
-#endif // WEATHER_API_H 
\ No newline at end of file
+#endif // WEATHER_API_H
@@ -0,0 +1,228 @@
+#include "weather_codes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    uint8_t icon;           // weather_icon_t
+} weather_code_entry_t;
+
+/* 下标即weather_code_t，名称须与高德返回的描述逐字一致（改动后重新运行weather_codes_tool.py） */
+static const weather_code_entry_t weather_entries[WEATHER_CODE_COUNT] = {
+    {"未知", WEATHER_ICON_UNKNOWN},
+    {"晴", WEATHER_ICON_CLEAR},
+    {"少云", WEATHER_ICON_PARTLY_CLOUDY},
+    {"晴间多云", WEATHER_ICON_PARTLY_CLOUDY},
+    {"多云", WEATHER_ICON_CLOUDY},
+    {"阴", WEATHER_ICON_OVERCAST},
+    {"有风", WEATHER_ICON_WIND},
+    {"平静", WEATHER_ICON_CLEAR},
+    {"微风", WEATHER_ICON_WIND},
+    {"和风", WEATHER_ICON_WIND},
+    {"清风", WEATHER_ICON_WIND},
+    {"强风/劲风", WEATHER_ICON_WIND},
+    {"疾风", WEATHER_ICON_WIND},
+    {"大风", WEATHER_ICON_WIND},
+    {"烈风", WEATHER_ICON_WIND},
+    {"风暴", WEATHER_ICON_WIND},
+    {"狂爆风", WEATHER_ICON_WIND},
+    {"飓风", WEATHER_ICON_WIND},
+    {"热带风暴", WEATHER_ICON_WIND},
+    {"霾", WEATHER_ICON_HAZE},
+    {"中度霾", WEATHER_ICON_HAZE},
+    {"重度霾", WEATHER_ICON_HAZE},
+    {"严重霾", WEATHER_ICON_HAZE},
+    {"阵雨", WEATHER_ICON_SHOWER},
+    {"雷阵雨", WEATHER_ICON_THUNDER},
+    {"雷阵雨并伴有冰雹", WEATHER_ICON_THUNDER},
+    {"小雨", WEATHER_ICON_RAIN},
+    {"中雨", WEATHER_ICON_RAIN},
+    {"大雨", WEATHER_ICON_HEAVY_RAIN},
+    {"暴雨", WEATHER_ICON_HEAVY_RAIN},
+    {"大暴雨", WEATHER_ICON_HEAVY_RAIN},
+    {"特大暴雨", WEATHER_ICON_HEAVY_RAIN},
+    {"强阵雨", WEATHER_ICON_SHOWER},
+    {"强雷阵雨", WEATHER_ICON_THUNDER},
+    {"极端降雨", WEATHER_ICON_HEAVY_RAIN},
+    {"毛毛雨/细雨", WEATHER_ICON_RAIN},
+    {"雨", WEATHER_ICON_RAIN},
+    {"小雨-中雨", WEATHER_ICON_RAIN},
+    {"中雨-大雨", WEATHER_ICON_HEAVY_RAIN},
+    {"大雨-暴雨", WEATHER_ICON_HEAVY_RAIN},
+    {"暴雨-大暴雨", WEATHER_ICON_HEAVY_RAIN},
+    {"大暴雨-特大暴雨", WEATHER_ICON_HEAVY_RAIN},
+    {"雨雪天气", WEATHER_ICON_SLEET},
+    {"雨夹雪", WEATHER_ICON_SLEET},
+    {"阵雨夹雪", WEATHER_ICON_SLEET},
+    {"冻雨", WEATHER_ICON_SLEET},
+    {"雪", WEATHER_ICON_SNOW},
+    {"阵雪", WEATHER_ICON_SNOW},
+    {"小雪", WEATHER_ICON_SNOW},
+    {"中雪", WEATHER_ICON_SNOW},
+    {"大雪", WEATHER_ICON_SNOW},
+    {"暴雪", WEATHER_ICON_SNOW},
+    {"小雪-中雪", WEATHER_ICON_SNOW},
+    {"中雪-大雪", WEATHER_ICON_SNOW},
+    {"大雪-暴雪", WEATHER_ICON_SNOW},
+    {"浮尘", WEATHER_ICON_DUST},
+    {"扬沙", WEATHER_ICON_DUST},
+    {"沙尘暴", WEATHER_ICON_DUST},
+    {"强沙尘暴", WEATHER_ICON_DUST},
+    {"龙卷风", WEATHER_ICON_WIND},
+    {"雾", WEATHER_ICON_FOG},
+    {"浓雾", WEATHER_ICON_FOG},
+    {"强浓雾", WEATHER_ICON_FOG},
+    {"轻雾", WEATHER_ICON_FOG},
+    {"大雾", WEATHER_ICON_FOG},
+    {"特强浓雾", WEATHER_ICON_FOG},
+    {"热", WEATHER_ICON_HOT},
+    {"冷", WEATHER_ICON_COLD},
+};
+
+/* 下标即weather_wind_t */
+static const char *const wind_names[WEATHER_WIND_COUNT] = {
+    "", "东北", "东", "东南", "南", "西南", "西", "西北", "北", "旋转不定", "无风向",
+};
+
+static const char *const icon_names[WEATHER_ICON_COUNT] = {
+    "unknown", "clear", "partly_cloudy", "cloudy", "overcast", "wind", "haze", "shower",
+    "thunder", "rain", "heavy_rain", "sleet", "snow", "dust", "fog", "hot", "cold",
+};
+
+/*
+ * 完美哈希（两级位移）：h = FNV-1a(描述, 种子)，先用种子0的哈希选桶，
+ * 再用桶的位移作种子算出槽位，槽位中存编码（0为空）。表大小都是2的幂。
+ */
+/* --- 以下由 weather_codes_tool.py 生成 --- */
+static const uint8_t weather_hash_disp[16] = {
+      1,   1,   3,   5,   1,   5,   9,   3,   1,   2,  11,  10,   4,   3,   6,   1,
+};
+static const uint8_t weather_hash_slots[128] = {
+      1,  66,  45,  40,   0,  12,  41,   0,   0,   9,  63,  53,   0,  49,   0,   0,
+     64,  35,   0,   0,   0,   0,  38,   0,   0,  17,  25,   0,  42,   0,  33,   7,
+     52,   0,  13,   0,   8,   0,   0,   0,  29,  27,   0,   0,   0,  54,  18,  16,
+     31,   0,   0,  62,   0,  51,   0,  39,  65,   0,   0,   0,   0,  58,  43,  20,
+      0,   0,   0,  61,  30,   0,  47,   0,  67,   0,  56,   5,  26,   0,   0,   0,
+     22,   6,  28,   3,  57,   0,  37,   0,  55,   0,  44,   0,  24,  15,   0,  50,
+     21,   2,   0,  32,  36,   4,   0,  60,  11,  10,   0,   0,   0,   0,  46,   0,
+      0,   0,  48,   0,  23,  34,   0,  19,  14,   0,   0,  59,   0,   0,   0,   0,
+};
+static const uint8_t wind_hash_disp[4] = {
+      3,   2,   1,   1,
+};
+static const uint8_t wind_hash_slots[16] = {
+      0,   4,   0,   9,   6,   0,   1,   5,   0,  10,   0,   8,   2,   0,   7,   3,
+};
+/* --- 生成结束 --- */
+
+static uint32_t code_hash(const char *text, uint8_t seed)
+{
+    uint32_t h = 2166136261u ^ seed;
+    while (*text) {
+        h ^= (uint8_t)*text++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint8_t hash_lookup(const char *text, const uint8_t *disp, size_t bucket_count,
+                           const uint8_t *slots, size_t slot_count)
+{
+    uint8_t seed = disp[code_hash(text, 0) & (bucket_count - 1)];
+    return slots[code_hash(text, seed) & (slot_count - 1)];
+}
+
+weather_code_t weather_code_from_text(const char *text)
+{
+    if (text == NULL || text[0] == '\0') {
+        return WEATHER_UNKNOWN;
+    }
+    uint8_t code = hash_lookup(text, weather_hash_disp, sizeof(weather_hash_disp),
+                               weather_hash_slots, sizeof(weather_hash_slots));
+    if (code == WEATHER_UNKNOWN || code >= WEATHER_CODE_COUNT || strcmp(weather_entries[code].name, text) != 0) {
+        return WEATHER_UNKNOWN;
+    }
+    return (weather_code_t)code;
+}
+
+weather_wind_t weather_wind_from_text(const char *text)
+{
+    if (text == NULL || text[0] == '\0') {
+        return WEATHER_WIND_UNKNOWN;
+    }
+    uint8_t wind = hash_lookup(text, wind_hash_disp, sizeof(wind_hash_disp),
+                               wind_hash_slots, sizeof(wind_hash_slots));
+    if (wind == WEATHER_WIND_UNKNOWN || wind >= WEATHER_WIND_COUNT || strcmp(wind_names[wind], text) != 0) {
+        return WEATHER_WIND_UNKNOWN;
+    }
+    return (weather_wind_t)wind;
+}
+
+uint8_t weather_power_from_text(const char *text)
+{
+    static const char le[] = "≤";
+    if (text == NULL) {
+        return 0;
+    }
+    int low = 0;
+    if (strncmp(text, le, sizeof(le) - 1) == 0) {
+        text += sizeof(le) - 1;
+    } else if (text[0] == '<') {
+        text++;
+    } else {
+        char *end;
+        low = (int)strtol(text, &end, 10);
+        if (end == text) {
+            return 0;
+        }
+        if (*end != '-') {
+            return low > 0 && low <= 15 ? WEATHER_POWER(low, low) : 0;
+        }
+        text = end + 1;
+    }
+    char *end;
+    int high = (int)strtol(text, &end, 10);
+    if (end == text || high <= 0 || high > 15 || low > high) {
+        return 0;
+    }
+    return WEATHER_POWER(low, high);
+}
+
+const char *weather_code_name(weather_code_t code)
+{
+    return weather_entries[(unsigned)code < WEATHER_CODE_COUNT ? code : WEATHER_UNKNOWN].name;
+}
+
+weather_icon_t weather_code_icon(weather_code_t code)
+{
+    return (weather_icon_t)weather_entries[(unsigned)code < WEATHER_CODE_COUNT ? code : WEATHER_UNKNOWN].icon;
+}
+
+const char *weather_icon_name(weather_icon_t icon)
+{
+    return icon_names[(unsigned)icon < WEATHER_ICON_COUNT ? icon : WEATHER_ICON_UNKNOWN];
+}
+
+const char *weather_wind_name(weather_wind_t wind)
+{
+    return wind_names[(unsigned)wind < WEATHER_WIND_COUNT ? wind : WEATHER_WIND_UNKNOWN];
+}
+
+void weather_power_format(uint8_t power, char *buf, size_t size)
+{
+    int low = WEATHER_POWER_LOW(power);
+    int high = WEATHER_POWER_HIGH(power);
+    if (size == 0) {
+        return;
+    }
+    if (high == 0) {
+        buf[0] = '\0';
+    } else if (low == 0) {
+        snprintf(buf, size, "≤%d", high);
+    } else if (low == high) {
+        snprintf(buf, size, "%d", high);
+    } else {
+        snprintf(buf, size, "%d-%d", low, high);
+    }
+}
@@ -0,0 +1,186 @@
+#ifndef WEATHER_CODES_H
+#define WEATHER_CODES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 高德天气现象、风向、风力的紧凑编码
+ *
+ * 接口返回的汉字描述在解析时经完美哈希表转为单字节编码，快照只存编码；
+ * 显示时再按编码查名称表和图标分类表。完美哈希表由 weather_codes_tool.py
+ * 按 weather_codes.c 中的名称表生成，查表后与名称逐字比对，未收录的描述得到UNKNOWN。
+ * 编码随快照保存在NVS，已有取值不能改动，新增只能追加在末尾。
+ */
+
+/**
+ * @brief 天气现象（高德天气现象表，顺序即编码）
+ */
+typedef enum {
+    WEATHER_UNKNOWN = 0,                // 未知或未收录
+    WEATHER_SUNNY,                      // 晴
+    WEATHER_FEW_CLOUDS,                 // 少云
+    WEATHER_PARTLY_CLOUDY,              // 晴间多云
+    WEATHER_CLOUDY,                     // 多云
+    WEATHER_OVERCAST,                   // 阴
+    WEATHER_WINDY,                      // 有风
+    WEATHER_CALM,                       // 平静
+    WEATHER_LIGHT_BREEZE,               // 微风
+    WEATHER_MODERATE_BREEZE,            // 和风
+    WEATHER_FRESH_BREEZE,               // 清风
+    WEATHER_STRONG_BREEZE,              // 强风/劲风
+    WEATHER_HIGH_WIND,                  // 疾风
+    WEATHER_GALE,                       // 大风
+    WEATHER_STRONG_GALE,                // 烈风
+    WEATHER_STORM,                      // 风暴
+    WEATHER_VIOLENT_STORM,              // 狂爆风
+    WEATHER_HURRICANE,                  // 飓风
+    WEATHER_TROPICAL_STORM,             // 热带风暴
+    WEATHER_HAZE,                       // 霾
+    WEATHER_MODERATE_HAZE,              // 中度霾
+    WEATHER_HEAVY_HAZE,                 // 重度霾
+    WEATHER_SEVERE_HAZE,                // 严重霾
+    WEATHER_SHOWER,                     // 阵雨
+    WEATHER_THUNDERSHOWER,              // 雷阵雨
+    WEATHER_THUNDERSHOWER_HAIL,         // 雷阵雨并伴有冰雹
+    WEATHER_LIGHT_RAIN,                 // 小雨
+    WEATHER_MODERATE_RAIN,              // 中雨
+    WEATHER_HEAVY_RAIN,                 // 大雨
+    WEATHER_RAINSTORM,                  // 暴雨
+    WEATHER_HEAVY_RAINSTORM,            // 大暴雨
+    WEATHER_SEVERE_RAINSTORM,           // 特大暴雨
+    WEATHER_HEAVY_SHOWER,               // 强阵雨
+    WEATHER_HEAVY_THUNDERSHOWER,        // 强雷阵雨
+    WEATHER_EXTREME_RAIN,               // 极端降雨
+    WEATHER_DRIZZLE,                    // 毛毛雨/细雨
+    WEATHER_RAIN,                       // 雨
+    WEATHER_LIGHT_TO_MODERATE_RAIN,     // 小雨-中雨
+    WEATHER_MODERATE_TO_HEAVY_RAIN,     // 中雨-大雨
+    WEATHER_HEAVY_RAIN_TO_RAINSTORM,    // 大雨-暴雨
+    WEATHER_RAINSTORM_TO_HEAVY,         // 暴雨-大暴雨
+    WEATHER_HEAVY_TO_SEVERE_RAINSTORM,  // 大暴雨-特大暴雨
+    WEATHER_RAIN_AND_SNOW,              // 雨雪天气
+    WEATHER_SLEET,                      // 雨夹雪
+    WEATHER_SLEET_SHOWER,               // 阵雨夹雪
+    WEATHER_FREEZING_RAIN,              // 冻雨
+    WEATHER_SNOW,                       // 雪
+    WEATHER_SNOW_SHOWER,                // 阵雪
+    WEATHER_LIGHT_SNOW,                 // 小雪
+    WEATHER_MODERATE_SNOW,              // 中雪
+    WEATHER_HEAVY_SNOW,                 // 大雪
+    WEATHER_SNOWSTORM,                  // 暴雪
+    WEATHER_LIGHT_TO_MODERATE_SNOW,     // 小雪-中雪
+    WEATHER_MODERATE_TO_HEAVY_SNOW,     // 中雪-大雪
+    WEATHER_HEAVY_SNOW_TO_SNOWSTORM,    // 大雪-暴雪
+    WEATHER_DUST,                       // 浮尘
+    WEATHER_BLOWING_SAND,               // 扬沙
+    WEATHER_SANDSTORM,                  // 沙尘暴
+    WEATHER_SEVERE_SANDSTORM,           // 强沙尘暴
+    WEATHER_TORNADO,                    // 龙卷风
+    WEATHER_FOG,                        // 雾
+    WEATHER_DENSE_FOG,                  // 浓雾
+    WEATHER_STRONG_DENSE_FOG,           // 强浓雾
+    WEATHER_MIST,                       // 轻雾
+    WEATHER_HEAVY_FOG,                  // 大雾
+    WEATHER_EXTRA_DENSE_FOG,            // 特强浓雾
+    WEATHER_HOT,                        // 热
+    WEATHER_COLD,                       // 冷
+    WEATHER_CODE_COUNT,
+} weather_code_t;
+
+/**
+ * @brief 图标分类，多个天气现象共用一个图标
+ */
+typedef enum {
+    WEATHER_ICON_UNKNOWN = 0,
+    WEATHER_ICON_CLEAR,
+    WEATHER_ICON_PARTLY_CLOUDY,
+    WEATHER_ICON_CLOUDY,
+    WEATHER_ICON_OVERCAST,
+    WEATHER_ICON_WIND,
+    WEATHER_ICON_HAZE,
+    WEATHER_ICON_SHOWER,
+    WEATHER_ICON_THUNDER,
+    WEATHER_ICON_RAIN,
+    WEATHER_ICON_HEAVY_RAIN,
+    WEATHER_ICON_SLEET,
+    WEATHER_ICON_SNOW,
+    WEATHER_ICON_DUST,
+    WEATHER_ICON_FOG,
+    WEATHER_ICON_HOT,
+    WEATHER_ICON_COLD,
+    WEATHER_ICON_COUNT,
+} weather_icon_t;
+
+/**
+ * @brief 风向
+ */
+typedef enum {
+    WEATHER_WIND_UNKNOWN = 0,
+    WEATHER_WIND_NE,                    // 东北
+    WEATHER_WIND_E,                     // 东
+    WEATHER_WIND_SE,                    // 东南
+    WEATHER_WIND_S,                     // 南
+    WEATHER_WIND_SW,                    // 西南
+    WEATHER_WIND_W,                     // 西
+    WEATHER_WIND_NW,                    // 西北
+    WEATHER_WIND_N,                     // 北
+    WEATHER_WIND_VARIABLE,              // 旋转不定
+    WEATHER_WIND_NONE,                  // 无风向
+    WEATHER_WIND_COUNT,
+} weather_wind_t;
+
+/* 风力级别范围打包为一个字节：高4位下限、低4位上限。"≤3"为(0,3)，"4-5"为(4,5)，0表示未知 */
+#define WEATHER_POWER(low, high)        ((uint8_t)(((low) << 4) | (high)))
+#define WEATHER_POWER_LOW(power)        ((power) >> 4)
+#define WEATHER_POWER_HIGH(power)       ((power) & 0x0F)
+
+/**
+ * @brief 天气现象描述转为编码，未收录的返回WEATHER_UNKNOWN
+ */
+weather_code_t weather_code_from_text(const char *text);
+
+/**
+ * @brief 风向描述转为编码，未收录的返回WEATHER_WIND_UNKNOWN
+ */
+weather_wind_t weather_wind_from_text(const char *text);
+
+/**
+ * @brief 解析"≤3"、"4"、"4-5"形式的风力
+ */
+uint8_t weather_power_from_text(const char *text);
+
+/**
+ * @brief 天气现象的汉字描述（与高德一致），未知返回"未知"
+ */
+const char *weather_code_name(weather_code_t code);
+
+/**
+ * @brief 天气现象对应的图标分类
+ */
+weather_icon_t weather_code_icon(weather_code_t code);
+
+/**
+ * @brief 图标分类的英文标识，供网页端选择图标
+ */
+const char *weather_icon_name(weather_icon_t icon);
+
+/**
+ * @brief 风向的汉字描述，未知返回空串
+ */
+const char *weather_wind_name(weather_wind_t wind);
+
+/**
+ * @brief 风力格式化为"≤3"、"4"、"4-5"，未知时为空串
+ */
+void weather_power_format(uint8_t power, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEATHER_CODES_H
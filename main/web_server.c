@@ -1,15 +1,26 @@
 #include "web_server.h"
 #include "ds3231.h"
+#include "time_service.h"
+#include "rtc_calib.h"
+#include "civil_time.h"
+#include "lunar_calendar.h"
+#include "ai_chat.h"
+#include "speech_recognition.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "esp_http_client.h"
 #include "cJSON.h"
+#include "json_arena.h"
+#include "net_service.h"
+#include "net_hedge.h"
+#include "weather_api.h"
 #include "wifi_manager.h"
 #include <string.h>
 
 static const char *TAG = "WEB_SERVER";
 
 static httpd_handle_t server_handle = NULL;
+static json_arena_t web_arena = JSON_ARENA_INITIALIZER("WEB");    // 各接口的cJSON节点，请求结束时整体释放
 
 // 客户端连接计数器
 static uint32_t active_connections = 0;
@@ -61,6 +72,110 @@ static esp_err_t root_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static cJSON *tls_stats_to_json(void (*get_stats)(tls_session_stats_t *))
+{
+    tls_session_stats_t stats;
+    get_stats(&stats);
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddBoolToObject(obj, "cache_enabled", TLS_SESSION_CACHE_ENABLED);
+    cJSON_AddNumberToObject(obj, "requests", stats.requests);
+    cJSON_AddNumberToObject(obj, "full_handshakes", stats.full_handshakes);
+    cJSON_AddNumberToObject(obj, "full_avg_ms", stats.full_handshakes ?
+                            stats.full_handshake_us_total / 1000.0 / stats.full_handshakes : 0);
+    cJSON_AddNumberToObject(obj, "full_heap_peak", stats.full_heap_peak_max);
+    cJSON_AddNumberToObject(obj, "resumed_handshakes", stats.resumed_handshakes);
+    cJSON_AddNumberToObject(obj, "resumed_avg_ms", stats.resumed_handshakes ?
+                            stats.resumed_handshake_us_total / 1000.0 / stats.resumed_handshakes : 0);
+    cJSON_AddNumberToObject(obj, "resumed_heap_peak", stats.resumed_heap_peak_max);
+    cJSON_AddNumberToObject(obj, "warm_reuses", stats.warm_reuses);
+    cJSON_AddNumberToObject(obj, "last_handshake_ms", stats.last_handshake_us / 1000.0);
+    cJSON_AddNumberToObject(obj, "last_heap_peak", stats.last_heap_peak);
+    return obj;
+}
+
+static void web_arena_stats(json_arena_stats_t *stats)
+{
+    json_arena_get_stats(&web_arena, stats);
+}
+
+static cJSON *arena_stats_to_json(void (*get_stats)(json_arena_stats_t *))
+{
+    json_arena_stats_t stats;
+    get_stats(&stats);
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "scopes", stats.scopes);
+    cJSON_AddNumberToObject(obj, "allocs", stats.allocs);
+    cJSON_AddNumberToObject(obj, "chunk_allocs", stats.chunk_allocs);
+    cJSON_AddNumberToObject(obj, "large_allocs", stats.large_allocs);
+    cJSON_AddNumberToObject(obj, "last_bytes", stats.last_bytes);
+    cJSON_AddNumberToObject(obj, "peak_bytes", stats.peak_bytes);
+    return obj;
+}
+
+static cJSON *net_stats_to_json(void)
+{
+    static const char *const priority_names[NET_PRIORITY_COUNT] = { "voice", "time", "weather", "background" };
+    net_service_stats_t stats;
+    net_service_get_stats(&stats);
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "submitted", stats.submitted);
+    cJSON_AddNumberToObject(obj, "coalesced", stats.coalesced);
+    cJSON_AddNumberToObject(obj, "rejected", stats.rejected);
+    cJSON_AddNumberToObject(obj, "retries", stats.retries);
+    cJSON_AddNumberToObject(obj, "succeeded", stats.succeeded);
+    cJSON_AddNumberToObject(obj, "failed", stats.failed);
+    cJSON_AddNumberToObject(obj, "cancelled", stats.cancelled);
+    cJSON_AddNumberToObject(obj, "queued", stats.queued);
+    cJSON_AddNumberToObject(obj, "running", stats.running);
+    cJSON *wait_obj = cJSON_CreateObject();
+    for (int i = 0; i < NET_PRIORITY_COUNT; i++) {
+        cJSON_AddNumberToObject(wait_obj, priority_names[i], stats.max_queue_wait_ms[i]);
+    }
+    cJSON_AddItemToObject(obj, "max_queue_wait_ms", wait_obj);
+    return obj;
+}
+
+// 单个端点的耗时分位与对冲次数，分位为0表示样本不足
+static cJSON *hedge_stats_to_json(const net_hedge_stats_t *stats)
+{
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "calls", stats->calls);
+    cJSON_AddNumberToObject(obj, "samples", stats->samples);
+    cJSON_AddNumberToObject(obj, "p50_ms", stats->p50_ms);
+    cJSON_AddNumberToObject(obj, "p90_ms", stats->p90_ms);
+    cJSON_AddNumberToObject(obj, "p99_ms", stats->p99_ms);
+    cJSON_AddNumberToObject(obj, "hedges", stats->hedges);
+    cJSON_AddNumberToObject(obj, "hedge_wins", stats->hedge_wins);
+    cJSON_AddNumberToObject(obj, "hedge_skipped", stats->skipped);
+    return obj;
+}
+
+static cJSON *cache_stats_to_json(const http_cache_stats_t *stats)
+{
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "lookups", stats->lookups);
+    cJSON_AddNumberToObject(obj, "fresh_hits", stats->fresh_hits);
+    cJSON_AddNumberToObject(obj, "revalidated", stats->revalidated);
+    cJSON_AddNumberToObject(obj, "misses", stats->misses);
+    cJSON_AddNumberToObject(obj, "stores", stats->stores);
+    cJSON_AddNumberToObject(obj, "errors", stats->errors);
+    // 命中率：未联网的命中和304都算，没有下载响应体
+    uint32_t hits = stats->fresh_hits + stats->revalidated;
+    cJSON_AddNumberToObject(obj, "hit_rate", stats->lookups ? hits * 100 / stats->lookups : 0);
+    return obj;
+}
+
+static cJSON *decode_stats_to_json(const http_decode_stats_t *stats)
+{
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "responses", stats->responses);
+    cJSON_AddNumberToObject(obj, "compressed", stats->compressed);
+    cJSON_AddNumberToObject(obj, "wire_bytes", (double)stats->wire_bytes);
+    cJSON_AddNumberToObject(obj, "decoded_bytes", (double)stats->decoded_bytes);
+    cJSON_AddNumberToObject(obj, "errors", stats->errors);
+    return obj;
+}
+
 // HTTP处理函数 - 获取设备状态
 static esp_err_t get_status_handler(httpd_req_t *req)
 {
@@ -75,7 +190,7 @@ static esp_err_t get_status_handler(httpd_req_t *req)
     
     // 获取当前时间
     ds3231_time_t current_time;
-    if (ds3231_get_time(&current_time) == ESP_OK) {
+    if (time_service_get_time(&current_time) == ESP_OK) {
         cJSON *time_obj = cJSON_CreateObject();
         cJSON_AddNumberToObject(time_obj, "year", current_time.year);
         cJSON_AddNumberToObject(time_obj, "month", current_time.month);
@@ -84,6 +199,185 @@ static esp_err_t get_status_handler(httpd_req_t *req)
         cJSON_AddNumberToObject(time_obj, "minute", current_time.minute);
         cJSON_AddNumberToObject(time_obj, "second", current_time.second);
         cJSON_AddItemToObject(response, "current_time", time_obj);
+        
+        // 添加农历、节气和传统节日（本地计算）
+        lunar_date_t lunar;
+        if (lunar_calendar_from_solar(current_time.year, current_time.month, current_time.date, &lunar) == ESP_OK) {
+            char lunar_text[48];
+            cJSON *lunar_obj = cJSON_CreateObject();
+            cJSON_AddNumberToObject(lunar_obj, "year", lunar.year);
+            cJSON_AddNumberToObject(lunar_obj, "month", lunar.month);
+            cJSON_AddNumberToObject(lunar_obj, "day", lunar.day);
+            cJSON_AddBoolToObject(lunar_obj, "leap", lunar.leap);
+            lunar_calendar_format(&lunar, lunar_text, sizeof(lunar_text));
+            cJSON_AddStringToObject(lunar_obj, "text", lunar_text);
+            lunar_calendar_format_year(&lunar, lunar_text, sizeof(lunar_text));
+            cJSON_AddStringToObject(lunar_obj, "year_text", lunar_text);
+            cJSON_AddStringToObject(lunar_obj, "solar_term", lunar_calendar_solar_term_name(lunar.solar_term));
+            cJSON_AddStringToObject(lunar_obj, "festival", lunar_calendar_festival_name(lunar.festival));
+            cJSON_AddItemToObject(response, "lunar", lunar_obj);
+        }
+    }
+    
+    // 添加RTC芯片状态（来自时间服务缓存，不访问I2C）
+    ds3231_regs_t rtc_regs;
+    if (time_service_get_rtc_regs(&rtc_regs) == ESP_OK) {
+        cJSON *rtc_obj = cJSON_CreateObject();
+        cJSON_AddNumberToObject(rtc_obj, "temperature", rtc_regs.temperature_q / 4.0);
+        cJSON_AddNumberToObject(rtc_obj, "control", rtc_regs.control);
+        cJSON_AddNumberToObject(rtc_obj, "status", rtc_regs.status);
+        cJSON_AddNumberToObject(rtc_obj, "aging", rtc_regs.aging);
+        cJSON_AddBoolToObject(rtc_obj, "edge_driven", time_service_is_edge_driven());
+        cJSON_AddItemToObject(response, "rtc", rtc_obj);
+    }
+    
+    // 添加RTC漂移估计
+    rtc_calib_estimate_t calib;
+    rtc_calib_get_estimate(&calib);
+    cJSON *calib_obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(calib_obj, "samples", calib.samples);
+    cJSON_AddNumberToObject(calib_obj, "span_hours", calib.span_s / 3600.0);
+    cJSON_AddNumberToObject(calib_obj, "drift_ppm", calib.drift_ppm);
+    cJSON_AddNumberToObject(calib_obj, "stderr_ppm", calib.stderr_ppm);
+    cJSON_AddNumberToObject(calib_obj, "aging", calib.aging);
+    cJSON_AddNumberToObject(calib_obj, "adjustments", calib.adjustments);
+    cJSON_AddBoolToObject(calib_obj, "valid", calib.valid);
+    cJSON_AddItemToObject(response, "rtc_calibration", calib_obj);
+    
+    // 添加网络校时状态
+    static const char *sync_state_names[] = {"none", "synced", "checked", "failed"};
+    static const char *sync_source_names[] = {"none", "sntp", "http"};
+    time_sync_info_t sync_info;
+    time_service_get_sync_info(&sync_info);
+    cJSON *sync_obj = cJSON_CreateObject();
+    cJSON_AddBoolToObject(sync_obj, "enabled", sync_info.enabled);
+    cJSON_AddStringToObject(sync_obj, "state", sync_state_names[sync_info.state]);
+    cJSON_AddStringToObject(sync_obj, "source", sync_source_names[sync_info.source]);
+    cJSON_AddNumberToObject(sync_obj, "last_offset_ms", sync_info.last_offset_us / 1000.0);
+    cJSON_AddNumberToObject(sync_obj, "rtt_ms", sync_info.last_rtt_us / 1000.0);
+    cJSON_AddNumberToObject(sync_obj, "residual_ms", sync_info.last_residual_us / 1000.0);
+    cJSON_AddNumberToObject(sync_obj, "count", sync_info.sync_count);
+    cJSON_AddItemToObject(response, "time_sync", sync_obj);
+    
+    // 添加云端连接的TLS握手统计（完整握手与会话复用分开）
+    cJSON *tls_obj = cJSON_CreateObject();
+    cJSON_AddItemToObject(tls_obj, "glm", tls_stats_to_json(ai_chat_get_tls_stats));
+    cJSON_AddItemToObject(tls_obj, "asr", tls_stats_to_json(speech_recognition_get_tls_stats));
+    cJSON_AddNumberToObject(tls_obj, "voice_reply_ms", speech_recognition_get_reply_latency_ms());
+    cJSON_AddNumberToObject(tls_obj, "voice_cancel_reclaim_ms", speech_recognition_get_cancel_reclaim_ms());
+    cJSON_AddItemToObject(response, "tls", tls_obj);
+    
+    // 添加内部RAM碎片情况和cJSON分配池统计
+    json_arena_heap_report_t heap_report;
+    json_arena_get_heap_report(&heap_report);
+    cJSON *heap_obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(heap_obj, "internal_free", heap_report.internal_free);
+    cJSON_AddNumberToObject(heap_obj, "largest_block", heap_report.largest_block);
+    cJSON_AddNumberToObject(heap_obj, "largest_block_boot", heap_report.boot_largest_block);
+    cJSON_AddNumberToObject(heap_obj, "largest_block_min", heap_report.min_largest_block);
+    cJSON *arena_obj = cJSON_CreateObject();
+    cJSON_AddItemToObject(arena_obj, "web", arena_stats_to_json(web_arena_stats));
+    cJSON_AddItemToObject(arena_obj, "glm", arena_stats_to_json(ai_chat_get_json_arena_stats));
+    cJSON_AddItemToObject(arena_obj, "asr", arena_stats_to_json(speech_recognition_get_json_arena_stats));
+    cJSON_AddItemToObject(heap_obj, "json_arena", arena_obj);
+    cJSON_AddItemToObject(response, "heap", heap_obj);
+    
+    // 添加网络请求队列统计
+    cJSON *net_obj = net_stats_to_json();
+    net_hedge_stats_t hedge_stats;
+    cJSON *latency_obj = cJSON_CreateObject();
+    speech_recognition_get_hedge_stats(&hedge_stats);
+    cJSON_AddItemToObject(latency_obj, "asr", hedge_stats_to_json(&hedge_stats));
+    ai_chat_get_hedge_stats(&hedge_stats);
+    cJSON_AddItemToObject(latency_obj, "glm", hedge_stats_to_json(&hedge_stats));
+    cJSON_AddItemToObject(net_obj, "latency", latency_obj);
+    http_cache_stats_t live_cache, forecast_cache;
+    weather_api_get_cache_stats(&live_cache, &forecast_cache);
+    cJSON *cache_obj = cJSON_CreateObject();
+    cJSON_AddItemToObject(cache_obj, "weather_live", cache_stats_to_json(&live_cache));
+    cJSON_AddItemToObject(cache_obj, "weather_forecast", cache_stats_to_json(&forecast_cache));
+    cJSON_AddItemToObject(net_obj, "cache", cache_obj);
+    http_decode_stats_t live_decode, forecast_decode, decode_stats;
+    weather_api_get_decode_stats(&live_decode, &forecast_decode);
+    cJSON *encoding_obj = cJSON_CreateObject();
+    cJSON_AddItemToObject(encoding_obj, "weather_live", decode_stats_to_json(&live_decode));
+    cJSON_AddItemToObject(encoding_obj, "weather_forecast", decode_stats_to_json(&forecast_decode));
+    ai_chat_get_decode_stats(&decode_stats);
+    cJSON_AddItemToObject(encoding_obj, "glm", decode_stats_to_json(&decode_stats));
+    speech_recognition_get_decode_stats(&decode_stats);
+    cJSON_AddItemToObject(encoding_obj, "asr", decode_stats_to_json(&decode_stats));
+    cJSON_AddItemToObject(net_obj, "encoding", encoding_obj);
+    cJSON_AddItemToObject(response, "net", net_obj);
+    
+    // 添加开机天气显示计时（快照恢复、首次联网成功距上电的毫秒数，-1表示尚未发生）
+    int32_t boot_snapshot_ms, boot_live_ms;
+    weather_api_get_boot_timing(&boot_snapshot_ms, &boot_live_ms);
+    cJSON *weather_boot_obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(weather_boot_obj, "snapshot_ms", boot_snapshot_ms);
+    cJSON_AddNumberToObject(weather_boot_obj, "live_ms", boot_live_ms);
+    cJSON_AddItemToObject(response, "weather_boot", weather_boot_obj);
+    
+    // 添加关注的城市及各自的请求统计（实况与预报各算一次，命中率=缓存命中/(联网+缓存命中)）
+    static weather_report_t web_weather;
+    weather_city_t cities[WEATHER_MAX_CITIES];
+    int city_count = weather_api_get_cities(cities, WEATHER_MAX_CITIES);
+    cJSON *cities_arr = cJSON_CreateArray();
+    for (int i = 0; i < city_count; i++) {
+        weather_city_stats_t city_stats;
+        if (weather_api_get_city_stats(i, &city_stats) != ESP_OK ||
+            weather_api_get_report(i, &web_weather) != ESP_OK) {
+            continue;
+        }
+        uint32_t lookups = city_stats.fetches + city_stats.cache_hits;
+        cJSON *city_obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(city_obj, "adcode", cities[i].adcode);
+        cJSON_AddStringToObject(city_obj, "name", cities[i].name);
+        cJSON_AddNumberToObject(city_obj, "fetches", city_stats.fetches);
+        cJSON_AddNumberToObject(city_obj, "cache_hits", city_stats.cache_hits);
+        cJSON_AddNumberToObject(city_obj, "errors", city_stats.errors);
+        cJSON_AddNumberToObject(city_obj, "hit_rate", lookups ? (double)city_stats.cache_hits / lookups : 0);
+        cJSON_AddBoolToObject(city_obj, "valid", web_weather.live_valid);
+        cJSON_AddBoolToObject(city_obj, "stale", web_weather.live_stale);
+        cJSON_AddItemToArray(cities_arr, city_obj);
+    }
+    cJSON_AddItemToObject(response, "weather_cities", cities_arr);
+    
+    // 添加本地城市的当前天气（编码转为文字和图标标识，网页端按icon选图标）
+    if (weather_api_get_report(0, &web_weather) == ESP_OK && web_weather.live_valid) {
+        char power[8];
+        cJSON *weather_obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(weather_obj, "city", web_weather.city);
+        cJSON_AddStringToObject(weather_obj, "weather", weather_code_name(web_weather.live.weather));
+        cJSON_AddStringToObject(weather_obj, "icon", weather_icon_name(weather_code_icon(web_weather.live.weather)));
+        if (web_weather.live.temperature != WEATHER_TEMP_UNKNOWN) {
+            cJSON_AddNumberToObject(weather_obj, "temperature", web_weather.live.temperature);
+        }
+        if (web_weather.live.humidity != WEATHER_HUMIDITY_UNKNOWN) {
+            cJSON_AddNumberToObject(weather_obj, "humidity", web_weather.live.humidity);
+        }
+        weather_power_format(web_weather.live.windpower, power, sizeof(power));
+        cJSON_AddStringToObject(weather_obj, "wind", weather_wind_name(web_weather.live.winddirection));
+        cJSON_AddStringToObject(weather_obj, "power", power);
+        cJSON_AddBoolToObject(weather_obj, "stale", web_weather.live_stale);
+        cJSON *casts_arr = cJSON_CreateArray();
+        for (int i = 0; web_weather.forecast_valid && i < web_weather.cast_count; i++) {
+            const weather_forecast_t *cast = &web_weather.casts[i];
+            int year, month, day;
+            char date[12];
+            civil_date_from_days(cast->date, &year, &month, &day);
+            snprintf(date, sizeof(date), "%04d-%02d-%02d", year, month, day);
+            cJSON *cast_obj = cJSON_CreateObject();
+            cJSON_AddStringToObject(cast_obj, "date", date);
+            cJSON_AddStringToObject(cast_obj, "day", weather_code_name(cast->dayweather));
+            cJSON_AddStringToObject(cast_obj, "day_icon", weather_icon_name(weather_code_icon(cast->dayweather)));
+            cJSON_AddStringToObject(cast_obj, "night", weather_code_name(cast->nightweather));
+            cJSON_AddStringToObject(cast_obj, "night_icon", weather_icon_name(weather_code_icon(cast->nightweather)));
+            cJSON_AddNumberToObject(cast_obj, "high", cast->daytemp);
+            cJSON_AddNumberToObject(cast_obj, "low", cast->nighttemp);
+            cJSON_AddItemToArray(casts_arr, cast_obj);
+        }
+        cJSON_AddItemToObject(weather_obj, "forecast", casts_arr);
+        cJSON_AddItemToObject(response, "weather", weather_obj);
     }
     
     // 添加时间格式设置
@@ -121,7 +415,7 @@ static esp_err_t get_status_handler(httpd_req_t *req)
     httpd_resp_send(req, json_str, strlen(json_str));
     
     // 释放内存
-    free(json_str);
+    cJSON_free(json_str);
     cJSON_Delete(response);
     
     // 减少活动连接计数
@@ -194,14 +488,14 @@ static esp_err_t set_time_handler(httpd_req_t *req)
         time.hour = hour->valueint;
         time.minute = minute->valueint;
         time.second = second ? second->valueint : 0;
-        time.day_of_week = 1; // 暂时不设置星期几
         
         // 验证值范围
         if (time.year < 2000 || time.year > 2099 ||
-            time.month < 1 || time.month > 12 ||
-            time.date < 1 || time.date > 31 ||
+            !civil_date_is_valid(time.year, time.month, time.date) ||
             time.hour > 23 || time.minute > 59 || time.second > 59) {
             valid_time = false;
+        } else {
+            time.day_of_week = civil_weekday(civil_days_from_date(time.year, time.month, time.date));
         }
     }
     
@@ -209,7 +503,7 @@ static esp_err_t set_time_handler(httpd_req_t *req)
     
     // 如果时间有效，设置RTC
     if (valid_time) {
-        esp_err_t err = ds3231_set_time(&time);
+        esp_err_t err = time_service_set_time(&time);
         if (err != ESP_OK) {
             httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set time");
             return ESP_FAIL;
@@ -346,7 +640,7 @@ static esp_err_t set_timer_handler(httpd_req_t *req)
     cJSON *hours = cJSON_GetObjectItem(json, "hours");
     cJSON *minutes = cJSON_GetObjectItem(json, "minutes");
     cJSON *seconds = cJSON_GetObjectItem(json, "seconds");
-    cJSON *action = cJSON_GetObjectItem(json, "action"); // "start", "stop", "reset"
+    cJSON *action = cJSON_GetObjectItem(json, "action"); // "start", "stop", "reset", "pause", "resume", "extend"
     
     // 检查参数有效性
     if (!hours || !minutes || !seconds || !action ||
@@ -359,47 +653,43 @@ static esp_err_t set_timer_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
     
-    // 更新系统状态
     uint8_t timer_hours = hours->valueint;
     uint8_t timer_minutes = minutes->valueint;
     uint8_t timer_seconds = seconds->valueint;
-    bool timer_running = false;
-    
-    system_status.timer.hours = timer_hours;
-    system_status.timer.minutes = timer_minutes;
-    system_status.timer.seconds = timer_seconds;
-    
-    // 处理动作
-    const char *action_str = action->valuestring;
-    if (strcmp(action_str, "start") == 0) {
-        system_status.timer.running = true;
-        timer_running = true;
-    } else if (strcmp(action_str, "stop") == 0) {
-        system_status.timer.running = false;
-        timer_running = false;
-    } else if (strcmp(action_str, "reset") == 0) {
-        system_status.timer.running = false;
-        timer_running = false;
-    } else {
-        cJSON_Delete(json);
+    
+    // 检查动作；extend时参数为增量
+    static const char *const actions[] = { "start", "stop", "reset", "pause", "resume", "extend" };
+    const char *action_str = NULL;
+    for (size_t i = 0; i < sizeof(actions) / sizeof(actions[0]); i++) {
+        if (strcmp(action->valuestring, actions[i]) == 0) {
+            action_str = actions[i];
+            break;
+        }
+    }
+    cJSON_Delete(json);
+    if (!action_str) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid action parameter");
         return ESP_FAIL;
     }
     
-    // 声明外部函数，用于直接更新主程序中的定时器设置
-    extern void update_timer_settings(uint8_t hours, uint8_t minutes, uint8_t seconds, bool running, const char* action);
-    
-    // 调用外部函数更新定时器设置
-    update_timer_settings(timer_hours, timer_minutes, timer_seconds, timer_running, action_str);
+    // 声明外部函数，用于直接更新主程序中的定时器设置；定时器状态由主程序按倒计时的实际剩余时间更新
+    extern esp_err_t update_timer_settings(uint8_t hours, uint8_t minutes, uint8_t seconds, const char* action);
     
-    ESP_LOGI(TAG, "定时器已通过Web接口更新: %02d:%02d:%02d, 动作: %s", 
-             timer_hours, timer_minutes, timer_seconds, action_str);
+    esp_err_t err = update_timer_settings(timer_hours, timer_minutes, timer_seconds, action_str);
+    ESP_LOGI(TAG, "定时器Web接口: %02d:%02d:%02d, 动作: %s, 结果: %s",
+             timer_hours, timer_minutes, timer_seconds, action_str, esp_err_to_name(err));
     
-    cJSON_Delete(json);
+    httpd_resp_set_type(req, "application/json");
+    if (err != ESP_OK) {
+        // 例如没有进行中的倒计时时暂停、继续或延长
+        httpd_resp_set_status(req, "409 Conflict");
+        const char* resp_str = "{\"status\":\"error\",\"message\":\"Timer action not applied\"}";
+        httpd_resp_send(req, resp_str, strlen(resp_str));
+        return ESP_OK;
+    }
     
     // 发送成功响应
     const char* resp_str = "{\"status\":\"ok\",\"message\":\"Timer updated successfully\"}";
-    httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, resp_str, strlen(resp_str));
     
     return ESP_OK;
@@ -471,6 +761,61 @@ static esp_err_t set_reminder_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+// 设置关注的天气城市，body: {"cities":[{"adcode":"370215","name":"即墨"},...]}，第一个为本地城市
+static esp_err_t set_weather_cities_handler(httpd_req_t *req)
+{
+    char buffer[512] = {0};
+    if (parse_json_body(req, buffer, sizeof(buffer)) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    
+    cJSON *json = cJSON_Parse(buffer);
+    if (!json) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+    
+    // 提取城市列表，名称缺省时用编码
+    weather_city_t cities[WEATHER_MAX_CITIES] = {0};
+    int count = 0;
+    bool valid = true;
+    cJSON *list = cJSON_GetObjectItem(json, "cities");
+    if (!cJSON_IsArray(list) || cJSON_GetArraySize(list) > WEATHER_MAX_CITIES) {
+        valid = false;
+        list = NULL;
+    }
+    cJSON *item;
+    cJSON_ArrayForEach(item, list) {
+        cJSON *adcode = cJSON_GetObjectItem(item, "adcode");
+        cJSON *name = cJSON_GetObjectItem(item, "name");
+        if (!cJSON_IsString(adcode) || (name && !cJSON_IsString(name)) ||
+            strlen(adcode->valuestring) >= sizeof(cities[count].adcode) ||
+            (name && strlen(name->valuestring) >= sizeof(cities[count].name))) {
+            valid = false;
+            break;
+        }
+        strcpy(cities[count].adcode, adcode->valuestring);
+        strcpy(cities[count].name, name ? name->valuestring : adcode->valuestring);
+        count++;
+    }
+    cJSON_Delete(json);
+    
+    // 编码格式、数量和重复由weather_api检查
+    if (!valid || weather_api_set_cities(cities, count) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid weather cities");
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "天气城市已通过Web接口更新: %d 个，本地城市 %s", count, cities[0].name);
+    
+    // 发送成功响应
+    const char* resp_str = "{\"status\":\"ok\",\"message\":\"Weather cities set successfully\"}";
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp_str, strlen(resp_str));
+    
+    return ESP_OK;
+}
+
 // 初始化Web服务器
 esp_err_t web_server_init(void)
 {
@@ -492,6 +837,16 @@ esp_err_t web_server_init(void)
     return ESP_OK;
 }
 
+// JSON接口的包装：user_ctx为实际处理函数，处理期间cJSON分配走web_arena
+static esp_err_t json_api_handler(httpd_req_t *req)
+{
+    esp_err_t (*handler)(httpd_req_t *) = req->user_ctx;
+    json_arena_begin(&web_arena);
+    esp_err_t ret = handler(req);
+    json_arena_end(&web_arena);
+    return ret;
+}
+
 // 启动Web服务器
 esp_err_t web_server_start(void)
 {
@@ -528,8 +883,8 @@ esp_err_t web_server_start(void)
     httpd_uri_t status = {
         .uri       = "/api/status",
         .method    = HTTP_GET,
-        .handler   = get_status_handler,
-        .user_ctx  = NULL
+        .handler   = json_api_handler,
+        .user_ctx  = get_status_handler
     };
     httpd_register_uri_handler(server_handle, &status);
     
@@ -537,8 +892,8 @@ esp_err_t web_server_start(void)
     httpd_uri_t set_time = {
         .uri       = "/api/time",
         .method    = HTTP_POST,
-        .handler   = set_time_handler,
-        .user_ctx  = NULL
+        .handler   = json_api_handler,
+        .user_ctx  = set_time_handler
     };
     httpd_register_uri_handler(server_handle, &set_time);
     
@@ -546,8 +901,8 @@ esp_err_t web_server_start(void)
     httpd_uri_t set_time_format = {
         .uri       = "/api/time_format",
         .method    = HTTP_POST,
-        .handler   = set_time_format_handler,
-        .user_ctx  = NULL
+        .handler   = json_api_handler,
+        .user_ctx  = set_time_format_handler
     };
     httpd_register_uri_handler(server_handle, &set_time_format);
     
@@ -555,8 +910,8 @@ esp_err_t web_server_start(void)
     httpd_uri_t set_alarm = {
         .uri       = "/api/alarm",
         .method    = HTTP_POST,
-        .handler   = set_alarm_handler,
-        .user_ctx  = NULL
+        .handler   = json_api_handler,
+        .user_ctx  = set_alarm_handler
     };
     httpd_register_uri_handler(server_handle, &set_alarm);
     
@@ -564,8 +919,8 @@ esp_err_t web_server_start(void)
     httpd_uri_t set_timer = {
         .uri       = "/api/timer",
         .method    = HTTP_POST,
-        .handler   = set_timer_handler,
-        .user_ctx  = NULL
+        .handler   = json_api_handler,
+        .user_ctx  = set_timer_handler
     };
     httpd_register_uri_handler(server_handle, &set_timer);
     
@@ -573,11 +928,20 @@ esp_err_t web_server_start(void)
     httpd_uri_t set_reminder = {
         .uri       = "/api/reminder",
         .method    = HTTP_POST,
-        .handler   = set_reminder_handler,
-        .user_ctx  = NULL
+        .handler   = json_api_handler,
+        .user_ctx  = set_reminder_handler
     };
     httpd_register_uri_handler(server_handle, &set_reminder);
     
+    // Set weather cities handler
+    httpd_uri_t set_weather_cities = {
+        .uri       = "/api/weather/cities",
+        .method    = HTTP_POST,
+        .handler   = json_api_handler,
+        .user_ctx  = set_weather_cities_handler
+    };
+    httpd_register_uri_handler(server_handle, &set_weather_cities);
+    
     ESP_LOGI(TAG, "Web server started successfully");
     
     return ESP_OK;
@@ -0,0 +1,94 @@
+/*
+ * civil_time主机检查：与glibc的gmtime_r/timegm逐一比对，范围为1843年至2255年，
+ * 覆盖1900、2100、2200等非闰世纪年和2000年。
+ * 逐日检查日期与天数互换、星期、年内序号和月天数，另按3607秒步长检查时分秒和非零UTC偏移。
+ */
+#define _GNU_SOURCE
+#include "civil_time.h"
+#include <stdio.h>
+#include <time.h>
+
+#define CHECK_MIN_YEAR  1843
+#define CHECK_MAX_YEAR  2255
+#define BEIJING_OFFSET  (8 * 3600)
+
+static long failures;
+
+static void expect(bool ok, const char *what, int64_t value)
+{
+    if (!ok) {
+        if (failures < 20) {
+            fprintf(stderr, "FAIL %s: %lld\n", what, (long long)value);
+        }
+        failures++;
+    }
+}
+
+static bool same_as_tm(const civil_time_t *c, const struct tm *tm)
+{
+    return c->year == tm->tm_year + 1900 && c->month == tm->tm_mon + 1 && c->day == tm->tm_mday &&
+           c->hour == tm->tm_hour && c->minute == tm->tm_min && c->second == tm->tm_sec &&
+           c->day_of_week == (tm->tm_wday == 0 ? 7 : tm->tm_wday);
+}
+
+int main(void)
+{
+    const int64_t first_day = civil_days_from_date(CHECK_MIN_YEAR, 1, 1);
+    const int64_t end_day = civil_days_from_date(CHECK_MAX_YEAR + 1, 1, 1);
+    long cases = 0;
+
+    /* 逐日：天数 <-> 日期、星期、年内序号、日期合法性 */
+    for (int64_t days = first_day; days < end_day; days++) {
+        time_t t = (time_t)(days * CIVIL_SECONDS_PER_DAY);
+        struct tm tm;
+        gmtime_r(&t, &tm);
+
+        int y, m, d;
+        civil_date_from_days(days, &y, &m, &d);
+        expect(y == tm.tm_year + 1900 && m == tm.tm_mon + 1 && d == tm.tm_mday, "date_from_days", days);
+        expect(civil_days_from_date(y, m, d) == days, "days_from_date", days);
+        expect(civil_weekday(days) == (tm.tm_wday == 0 ? 7 : tm.tm_wday), "weekday", days);
+        expect(civil_day_of_year(y, m, d) == tm.tm_yday + 1, "day_of_year", days);
+        expect(civil_date_is_valid(y, m, d), "date_is_valid", days);
+
+        int ny = y, nm = m, nd = d;
+        civil_add_days(&ny, &nm, &nd, 1);
+        expect(civil_days_from_date(ny, nm, nd) == days + 1, "add_days", days);
+        cases++;
+    }
+
+    /* 月天数与闰年：timegm把下月0日规范化为本月最后一天 */
+    for (int year = CHECK_MIN_YEAR; year <= CHECK_MAX_YEAR; year++) {
+        for (int month = 1; month <= 12; month++) {
+            struct tm tm = { .tm_year = year - 1900, .tm_mon = month, .tm_mday = 0 };
+            timegm(&tm);
+            expect(civil_days_in_month(year, month) == tm.tm_mday, "days_in_month", year * 100 + month);
+            expect(!civil_date_is_valid(year, month, tm.tm_mday + 1), "date_is_valid end", year * 100 + month);
+            cases++;
+        }
+        expect(civil_is_leap(year) == (civil_days_in_month(year, 2) == 29), "is_leap", year);
+    }
+
+    /* 时间戳：UTC和北京时间往返，步长与一天互质，遍历一天中的各个时分秒 */
+    for (int64_t epoch = first_day * CIVIL_SECONDS_PER_DAY; epoch < end_day * CIVIL_SECONDS_PER_DAY;
+         epoch += 3607) {
+        time_t t = (time_t)epoch;
+        struct tm tm;
+        civil_time_t c;
+
+        gmtime_r(&t, &tm);
+        civil_from_epoch(epoch, 0, &c);
+        expect(same_as_tm(&c, &tm), "from_epoch utc", epoch);
+        expect(civil_to_epoch(&c, 0) == epoch && (int64_t)timegm(&tm) == epoch, "to_epoch utc", epoch);
+
+        t = (time_t)(epoch + BEIJING_OFFSET);
+        gmtime_r(&t, &tm);
+        civil_from_epoch(epoch, BEIJING_OFFSET, &c);
+        expect(same_as_tm(&c, &tm), "from_epoch +8", epoch);
+        expect(civil_to_epoch(&c, BEIJING_OFFSET) == epoch, "to_epoch +8", epoch);
+        cases++;
+    }
+
+    printf("civil_time: %ld cases, %ld failures\n", cases, failures);
+    return failures == 0 ? 0 : 1;
+}
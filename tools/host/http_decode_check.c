@@ -0,0 +1,150 @@
+/*
+ * http_decode主机检查：用zlib生成gzip/zlib/裸deflate响应体，按不同分块大小交给解码器，
+ * 比对解压结果和finish的返回值。tinfl由stubs/rom/miniz.h替身提供，流结束时按ROM快速路径
+ * 的方式预读gzip尾，覆盖尾部字节全部或部分留在位缓冲里的情况。
+ */
+#include "http_decode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define BODY_MAX    (256 * 1024)
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} sink_buf_t;
+
+unsigned tinfl_host_pad_bits;
+unsigned tinfl_host_lookahead;
+
+static int failures;
+
+static void sink(const char *data, int len, void *ctx)
+{
+    sink_buf_t *out = ctx;
+    if (out->len + len <= BODY_MAX) {
+        memcpy(out->data + out->len, data, len);
+    }
+    out->len += len;
+}
+
+/* window_bits：31为gzip，15为zlib，-15为裸deflate */
+static size_t compress_body(const uint8_t *src, size_t len, int window_bits, int level, uint8_t *dst, size_t cap)
+{
+    z_stream zs = { 0 };
+    if (deflateInit2(&zs, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        abort();
+    }
+    if (window_bits > 15) {
+        static gz_header header = { .name = (Bytef *)"weather.json", .comment = (Bytef *)"host check", .hcrc = 1 };
+        deflateSetHeader(&zs, &header);
+    }
+    zs.next_in = (Bytef *)src;
+    zs.avail_in = (uInt)len;
+    zs.next_out = dst;
+    zs.avail_out = (uInt)cap;
+    if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+        abort();
+    }
+    size_t out = zs.total_out;
+    deflateEnd(&zs);
+    return out;
+}
+
+static esp_err_t decode(const char *encoding, const uint8_t *wire, size_t wire_len, size_t chunk,
+                        sink_buf_t *out)
+{
+    static http_decode_endpoint_t endpoint = HTTP_DECODE_ENDPOINT_INITIALIZER("check");
+    http_decoder_t dec;
+    http_decoder_begin(&dec, &endpoint, sink, out);
+    out->len = 0;
+
+    esp_http_client_event_t evt = {
+        .event_id = HTTP_EVENT_ON_HEADER,
+        .header_key = "Content-Encoding",
+        .header_value = (char *)encoding,
+    };
+    http_decoder_on_event(&dec, &evt);
+    for (size_t ofs = 0; ofs < wire_len; ofs += chunk) {
+        evt.event_id = HTTP_EVENT_ON_DATA;
+        evt.data = (void *)(wire + ofs);
+        evt.data_len = (int)(wire_len - ofs < chunk ? wire_len - ofs : chunk);
+        http_decoder_on_event(&dec, &evt);
+    }
+    return http_decoder_finish(&dec);
+}
+
+static void expect(bool ok, const char *what, const char *encoding, size_t body_len, size_t chunk)
+{
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "FAIL %s: %s body=%zu chunk=%zu pad=%u lookahead=%u\n", what, encoding,
+                body_len, chunk, tinfl_host_pad_bits, tinfl_host_lookahead);
+    }
+}
+
+int main(void)
+{
+    static uint8_t body[BODY_MAX], wire[BODY_MAX + 1024], bad[BODY_MAX + 1024], decoded[BODY_MAX];
+    static const size_t body_sizes[] = { 0, 1, 100, 4000, 40000, 200000 };
+    static const size_t chunks[] = { 1, 2, 3, 7, 8, 9, 64, 1000, BODY_MAX * 2 };
+    sink_buf_t out = { .data = decoded };
+    int cases = 0;
+
+    /* 类似接口返回的JSON，夹杂随机字节避免压缩率过高 */
+    srand(1);
+    for (size_t i = 0; i < BODY_MAX; i++) {
+        body[i] = i % 97 < 80 ? "{\"status\":\"1\",\"lives\":[{\"weather\":\"cloudy\",\"temperature\":\"21\"}]}"[i % 64]
+                              : (uint8_t)rand();
+    }
+
+    for (size_t b = 0; b < sizeof(body_sizes) / sizeof(body_sizes[0]); b++) {
+        size_t body_len = body_sizes[b];
+        for (int level = 1; level <= 9; level += 8) {
+            size_t gz_len = compress_body(body, body_len, 31, level, wire, sizeof(wire));
+            for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+                for (tinfl_host_pad_bits = 0; tinfl_host_pad_bits < 8; tinfl_host_pad_bits += 3) {
+                    for (tinfl_host_lookahead = 0; tinfl_host_lookahead <= 4; tinfl_host_lookahead++) {
+                        esp_err_t ret = decode("gzip", wire, gz_len, chunks[c], &out);
+                        expect(ret == ESP_OK && out.len == body_len && memcmp(out.data, body, body_len) == 0,
+                               "gzip decode", "gzip", body_len, chunks[c]);
+                        cases++;
+                    }
+                }
+
+                /* CRC32、长度、截断都必须报错 */
+                tinfl_host_pad_bits = 5;
+                tinfl_host_lookahead = 4;
+                memcpy(bad, wire, gz_len);
+                bad[gz_len - 8] ^= 0x01;
+                expect(decode("gzip", bad, gz_len, chunks[c], &out) != ESP_OK, "crc mismatch", "gzip", body_len, chunks[c]);
+                memcpy(bad, wire, gz_len);
+                bad[gz_len - 1] ^= 0x80;
+                expect(decode("gzip", bad, gz_len, chunks[c], &out) != ESP_OK, "isize mismatch", "gzip", body_len, chunks[c]);
+                expect(decode("gzip", wire, gz_len - 1, chunks[c], &out) != ESP_OK, "truncated", "gzip", body_len, chunks[c]);
+                cases += 3;
+            }
+
+            for (int window_bits = 15; window_bits >= -15; window_bits -= 30) {
+                size_t len = compress_body(body, body_len, window_bits, level, wire, sizeof(wire));
+                for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+                    esp_err_t ret = decode("deflate", wire, len, chunks[c], &out);
+                    expect(ret == ESP_OK && out.len == body_len && memcmp(out.data, body, body_len) == 0,
+                           window_bits > 0 ? "zlib decode" : "raw deflate decode", "deflate", body_len, chunks[c]);
+                    cases++;
+                }
+            }
+        }
+    }
+
+    memcpy(wire, body, 1000);
+    expect(decode("identity", wire, 1000, 7, &out) == ESP_OK && out.len == 1000 &&
+           memcmp(out.data, body, 1000) == 0, "identity", "identity", 1000, 7);
+    expect(decode("br", wire, 1000, 7, &out) != ESP_OK, "unsupported", "br", 1000, 7);
+    cases += 2;
+
+    printf("http_decode: %d cases, %d failures\n", cases, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/*
+ * lunar_calendar主机检查：逐日比对tools/lunar_reference.py按天文算法独立推算的参考数据
+ * （1900-01-31至2101-01-28），覆盖公历转农历、农历转公历、闰月、月天数、节气和节日，
+ * 另外检查表格范围边界和几个已知日期的格式化文本。
+ */
+#include "lunar_calendar.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+static void expect(bool ok, const char *what, int year, int month, int day)
+{
+    if (!ok) {
+        if (failures < 20) {
+            fprintf(stderr, "FAIL %s: %04d-%02d-%02d\n", what, year, month, day);
+        }
+        failures++;
+    }
+}
+
+/* 按lunar_calendar.h中的节日定义由参考数据推出期望值 */
+static lunar_festival_t expected_festival(int month, int day, bool leap, int month_days, int term)
+{
+    static const struct {
+        int date;
+        lunar_festival_t festival;
+    } fixed[] = {
+        { 101, LUNAR_FESTIVAL_SPRING }, { 115, LUNAR_FESTIVAL_LANTERN }, { 202, LUNAR_FESTIVAL_DRAGON_HEAD },
+        { 505, LUNAR_FESTIVAL_DRAGON_BOAT }, { 707, LUNAR_FESTIVAL_QIXI }, { 715, LUNAR_FESTIVAL_ZHONGYUAN },
+        { 815, LUNAR_FESTIVAL_MID_AUTUMN }, { 909, LUNAR_FESTIVAL_DOUBLE_NINTH }, { 1208, LUNAR_FESTIVAL_LABA },
+        { 1223, LUNAR_FESTIVAL_LITTLE_NEW_YEAR },
+    };
+
+    if (term == 6) {
+        return LUNAR_FESTIVAL_QINGMING;
+    }
+    if (leap) {
+        return LUNAR_FESTIVAL_NONE;
+    }
+    for (size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+        if (fixed[i].date == month * 100 + day) {
+            return fixed[i].festival;
+        }
+    }
+    return month == 12 && day == month_days ? LUNAR_FESTIVAL_NEW_YEARS_EVE : LUNAR_FESTIVAL_NONE;
+}
+
+static void check_text(int year, int month, int day, const char *date_text, const char *year_text,
+                       const char *extra)
+{
+    lunar_date_t lunar;
+    char buf[64];
+
+    expect(lunar_calendar_from_solar(year, month, day, &lunar) == ESP_OK, "text from_solar", year, month, day);
+    lunar_calendar_format(&lunar, buf, sizeof(buf));
+    expect(strcmp(buf, date_text) == 0, "format", year, month, day);
+    lunar_calendar_format_year(&lunar, buf, sizeof(buf));
+    expect(strcmp(buf, year_text) == 0, "format_year", year, month, day);
+    expect(strcmp(lunar_calendar_festival_name(lunar.festival), extra) == 0 ||
+           strcmp(lunar_calendar_solar_term_name(lunar.solar_term), extra) == 0, "festival/term name",
+           year, month, day);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s lunar_reference.txt\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "r");
+    if (!f) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    int gy, gm, gd, ly, lm, ld, leap, month_days, term;
+    int days = 0;
+    while (fscanf(f, "%d %d %d %d %d %d %d %d %d", &gy, &gm, &gd, &ly, &lm, &ld, &leap, &month_days,
+                  &term) == 9) {
+        lunar_date_t lunar;
+        days++;
+        if (lunar_calendar_from_solar(gy, gm, gd, &lunar) != ESP_OK) {
+            expect(false, "from_solar", gy, gm, gd);
+            continue;
+        }
+        expect(lunar.year == ly && lunar.month == lm && lunar.day == ld && lunar.leap == (leap != 0),
+               "lunar date", gy, gm, gd);
+        expect(lunar.month_days == month_days && lunar_calendar_month_days(ly, lm, leap) == month_days,
+               "month days", gy, gm, gd);
+        expect(!leap || lunar_calendar_leap_month(ly) == lm, "leap month", gy, gm, gd);
+        expect(lunar.stem == (ly + 6) % 10 && lunar.branch == (ly + 8) % 12, "stem/branch", gy, gm, gd);
+        expect(lunar.solar_term == term, "solar term", gy, gm, gd);
+        expect(term < 0 || lunar_calendar_solar_term_day(gy, term) == gd, "solar term day", gy, gm, gd);
+        expect(lunar.festival == expected_festival(lm, ld, leap, month_days, term), "festival", gy, gm, gd);
+
+        int y, m, d;
+        expect(lunar_calendar_to_solar(ly, lm, ld, leap, &y, &m, &d) == ESP_OK && y == gy && m == gm && d == gd,
+               "to_solar", gy, gm, gd);
+    }
+    fclose(f);
+    expect(days == 73412, "reference covers 1900-01-31..2101-01-28", 0, 0, days);
+
+    /* 表格范围之外和不存在的日期 */
+    lunar_date_t lunar;
+    int y, m, d;
+    expect(lunar_calendar_from_solar(1900, 1, 30, &lunar) != ESP_OK, "before range", 1900, 1, 30);
+    expect(lunar_calendar_from_solar(2101, 1, 29, &lunar) != ESP_OK, "after range", 2101, 1, 29);
+    expect(lunar_calendar_from_solar(2023, 2, 29, &lunar) != ESP_OK, "invalid date", 2023, 2, 29);
+    expect(lunar_calendar_to_solar(2023, 3, 1, true, &y, &m, &d) == ESP_ERR_NOT_FOUND, "no such leap month",
+           2023, 3, 1);
+    expect(lunar_calendar_to_solar(1899, 12, 1, false, &y, &m, &d) == ESP_ERR_INVALID_ARG, "lunar year range",
+           1899, 12, 1);
+
+    check_text(2024, 2, 10, "正月 初一", "甲辰龙年", "春节");
+    check_text(2023, 3, 22, "闰二月 初一", "癸卯兔年", "");
+    check_text(2024, 9, 17, "八月 十五", "甲辰龙年", "中秋");
+    check_text(2025, 4, 4, "三月 初七", "乙巳蛇年", "清明");
+
+    printf("lunar_calendar: %d days, %d failures\n", days, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <stdlib.h>
+#include <stdint.h>
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define heap_caps_malloc(size, caps)    malloc(size)
@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+#include <zlib.h>
+/* 与ROM中的esp_rom_crc32_le一致：初值0，结果可作为下次调用的crc继续累加 */
+static inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    return (uint32_t)crc32(crc, buf, len);
+}
@@ -0,0 +1,89 @@
+/*
+ * ROM tinfl的主机替身：解压由zlib完成，接口和tinfl_decompressor的位缓冲字段与ROM（miniz 1.x）一致。
+ *
+ * ROM版本的快速路径一次预读多个输入字节到m_bit_buf，流结束时不退回，gzip尾的开头因此留在位缓冲里。
+ * 这里在流结束后按同样方式把紧随其后的字节（最多填满32位）记为已消耗并放进m_bit_buf，
+ * 低位先放tinfl_host_pad_bits个填充位，模拟最后一个压缩字节未用完的位。
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <zlib.h>
+
+#define TINFL_LZ_DICT_SIZE              32768
+#define TINFL_FLAG_PARSE_ZLIB_HEADER    1
+#define TINFL_FLAG_HAS_MORE_INPUT       2
+
+typedef enum {
+    TINFL_STATUS_BAD_PARAM = -3,
+    TINFL_STATUS_ADLER32_MISMATCH = -2,
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2,
+} tinfl_status;
+
+typedef uint32_t tinfl_bit_buf_t;
+
+typedef struct {
+    uint32_t m_num_bits;
+    tinfl_bit_buf_t m_bit_buf;
+    z_stream zs;
+    int inited;
+    int done;
+} tinfl_decompressor;
+
+extern unsigned tinfl_host_pad_bits;        // 流结束时位缓冲低位的填充位数（0~7），由检查程序定义
+extern unsigned tinfl_host_lookahead;       // 流结束时最多预读的字节数
+
+#define tinfl_init(r) do { (r)->inited = 0; (r)->done = 0; (r)->m_num_bits = 0; (r)->m_bit_buf = 0; } while (0)
+
+static inline tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *in, size_t *in_size,
+                                            uint8_t *out_start, uint8_t *out_next, size_t *out_size,
+                                            uint32_t flags)
+{
+    (void)out_start;
+    if (r->done) {
+        *in_size = 0;
+        *out_size = 0;
+        return TINFL_STATUS_DONE;
+    }
+    if (!r->inited) {
+        memset(&r->zs, 0, sizeof(r->zs));
+        if (inflateInit2(&r->zs, (flags & TINFL_FLAG_PARSE_ZLIB_HEADER) ? 15 : -15) != Z_OK) {
+            return TINFL_STATUS_BAD_PARAM;
+        }
+        r->inited = 1;
+    }
+    r->zs.next_in = (Bytef *)in;
+    r->zs.avail_in = (uInt)*in_size;
+    r->zs.next_out = out_next;
+    r->zs.avail_out = (uInt)*out_size;
+    int ret = inflate(&r->zs, Z_NO_FLUSH);
+    size_t used = *in_size - r->zs.avail_in;
+    *out_size -= r->zs.avail_out;
+
+    if (ret == Z_STREAM_END) {
+        inflateEnd(&r->zs);
+        r->done = 1;
+        /* 预读：填充位在低位，其后是紧随压缩流的字节 */
+        r->m_num_bits = tinfl_host_pad_bits;
+        r->m_bit_buf = (tinfl_bit_buf_t)((1u << tinfl_host_pad_bits) - 1);
+        for (unsigned i = 0; i < tinfl_host_lookahead && used < *in_size &&
+                             r->m_num_bits + 8 <= sizeof(tinfl_bit_buf_t) * 8; i++) {
+            r->m_bit_buf |= (tinfl_bit_buf_t)in[used++] << r->m_num_bits;
+            r->m_num_bits += 8;
+        }
+        *in_size = used;
+        return TINFL_STATUS_DONE;
+    }
+    *in_size = used;
+    if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR || ret == Z_STREAM_ERROR) {
+        return TINFL_STATUS_FAILED;
+    }
+    if (r->zs.avail_out == 0) {
+        return TINFL_STATUS_HAS_MORE_OUTPUT;
+    }
+    return TINFL_STATUS_NEEDS_MORE_INPUT;
+}
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+主机检查：把main/中与硬件无关的模块用本机编译器编译，链接tools/host/下的检查程序后运行。
+ESP-IDF的头文件由tools/host/stubs/中的替身代替，只提供被检查模块用到的部分。
+
+用法：
+    python tools/host_check.py              # 运行全部检查
+    python tools/host_check.py http_decode  # 只运行指定检查
+需要cc和zlib开发库（libz）。带参考数据生成脚本的检查先运行脚本，把生成的文件路径传给检查程序。
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HOST_DIR = os.path.join(ROOT, 'tools', 'host')
+MAIN_DIR = os.path.join(ROOT, 'main')
+
+# 检查名 -> (检查程序, 被检查的源文件, 链接库, 参考数据生成脚本)
+CHECKS = {
+    'civil_time': ('civil_time_check.c', [], [], None),
+    'http_decode': ('http_decode_check.c', ['http_decode.c'], ['-lz'], None),
+    'lunar_calendar': ('lunar_calendar_check.c', ['lunar_calendar.c'], [], 'lunar_reference.py'),
+}
+
+
+def run_check(name, build_dir):
+    program, sources, libs, generator = CHECKS[name]
+    exe = os.path.join(build_dir, name)
+    cmd = [os.environ.get('CC', 'cc'), '-O2', '-Wall', '-Wextra', '-Werror',
+           '-I', os.path.join(HOST_DIR, 'stubs'), '-I', MAIN_DIR,
+           os.path.join(HOST_DIR, program)]
+    cmd += [os.path.join(MAIN_DIR, src) for src in sources]
+    cmd += ['-o', exe] + libs
+    if subprocess.call(cmd) != 0:
+        print('%s: 编译失败' % name)
+        return False
+    args = [exe]
+    if generator:
+        reference = os.path.join(build_dir, name + '.txt')
+        if subprocess.call([sys.executable, os.path.join(ROOT, 'tools', generator), '--output', reference]) != 0:
+            print('%s: 参考数据生成失败' % name)
+            return False
+        args.append(reference)
+    return subprocess.call(args, cwd=HOST_DIR) == 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='在主机上运行模块检查')
+    parser.add_argument('checks', nargs='*', help='要运行的检查（%s），缺省为全部' % ', '.join(sorted(CHECKS)))
+    args = parser.parse_args()
+    unknown = [name for name in args.checks if name not in CHECKS]
+    if unknown:
+        parser.error('未知的检查: %s' % ', '.join(unknown))
+
+    build_dir = tempfile.mkdtemp(prefix='host_check_')
+    try:
+        failed = [name for name in (args.checks or sorted(CHECKS)) if not run_check(name, build_dir)]
+    finally:
+        shutil.rmtree(build_dir, ignore_errors=True)
+
+    if failed:
+        print('失败: %s' % ', '.join(failed))
+        return 1
+    print('全部通过')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
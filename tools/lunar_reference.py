@@ -0,0 +1,312 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+农历参考数据生成工具
+不使用 main/lunar_calendar.c 中的任何表格，按天文算法独立推算1900-01-31至2101-01-28
+每一天的农历日期和节气，供 tools/host/lunar_calendar_check.c 逐日比对。
+
+推算方法（现行农历的定朔定气规则）：
+- 朔：Meeus《天文算法》第49章的朔望月级数
+- 节气：VSOP87截断级数求太阳视黄经，牛顿迭代到15°的整数倍
+- 以含冬至的月为十一月；两个冬至之间有13个月时，第一个不含中气的月为闰月
+- 日界取北京时间；1929年以前使用北京地方平时（东经116°25'），节气一律按东经120°
+- 力学时换算用Espenak-Meeus的ΔT多项式
+
+截断级数在子夜前后几分钟内无法可靠判断朔日，此类已知情况按紫金山天文台历书修正，
+见 NEW_MOON_CORRECTIONS；其余距子夜不足 EDGE_MINUTES 的朔和节气可用 --warnings 列出。
+
+用法：
+    python tools/lunar_reference.py --output lunar_reference.txt
+每行一天："公历年 月 日 农历年 月 日 闰月 当月天数 节气"，无节气为-1。
+"""
+
+import argparse
+import bisect
+import datetime
+import math
+import sys
+
+MIN_YEAR = 1900
+MAX_YEAR = 2100
+EDGE_MINUTES = 10
+
+# 朔在子夜前几分钟，官方历书的初一在次日
+NEW_MOON_CORRECTIONS = {
+    datetime.date(1906, 4, 23): datetime.date(1906, 4, 24),
+    datetime.date(2057, 9, 28): datetime.date(2057, 9, 29),
+}
+
+D2R = math.pi / 180
+JDN_ORDINAL_OFFSET = 1721425
+BEIJING_LMT_H = (116 + 25 / 60) / 15
+
+
+def delta_t(year):
+    """ΔT（秒），Espenak-Meeus多项式"""
+    if year < 1920:
+        t = year - 1900
+        return -2.79 + 1.494119 * t - 0.0598939 * t ** 2 + 0.0061966 * t ** 3 - 0.000197 * t ** 4
+    if year < 1941:
+        t = year - 1920
+        return 21.20 + 0.84493 * t - 0.076100 * t ** 2 + 0.0020936 * t ** 3
+    if year < 1961:
+        t = year - 1950
+        return 29.07 + 0.407 * t - t ** 2 / 233 + t ** 3 / 2547
+    if year < 1986:
+        t = year - 1975
+        return 45.45 + 1.067 * t - t ** 2 / 260 - t ** 3 / 718
+    if year < 2005:
+        t = year - 2000
+        return (63.86 + 0.3345 * t - 0.060374 * t ** 2 + 0.0017275 * t ** 3 +
+                0.000651814 * t ** 4 + 0.00002373599 * t ** 5)
+    if year < 2050:
+        t = year - 2000
+        return 62.92 + 0.32217 * t + 0.005589 * t ** 2
+    return -20 + 32 * ((year - 1820) / 100) ** 2 - 0.5628 * (2150 - year)
+
+
+def jde_to_year(jde):
+    return 2000 + (jde - 2451545) / 365.25
+
+
+def new_moon(k):
+    """第k个朔的儒略历书日（k=0为2000-01-06）"""
+    t = k / 1236.85
+    jde = (2451550.09766 + 29.530588861 * k + 0.00015437 * t ** 2 - 0.000000150 * t ** 3 +
+           0.00000000073 * t ** 4)
+    m = (2.5534 + 29.10535670 * k - 0.0000014 * t ** 2 - 0.00000011 * t ** 3) * D2R
+    mp = (201.5643 + 385.81693528 * k + 0.0107582 * t ** 2 + 0.00001238 * t ** 3 -
+          0.000000058 * t ** 4) * D2R
+    f = (160.7108 + 390.67050284 * k - 0.0016118 * t ** 2 - 0.00000227 * t ** 3 +
+         0.000000011 * t ** 4) * D2R
+    om = (124.7746 - 1.56375588 * k + 0.0020672 * t ** 2 + 0.00000215 * t ** 3) * D2R
+    e = 1 - 0.002516 * t - 0.0000074 * t ** 2
+    s = (-0.40720 * math.sin(mp) + 0.17241 * e * math.sin(m) + 0.01608 * math.sin(2 * mp) +
+         0.01039 * math.sin(2 * f) + 0.00739 * e * math.sin(mp - m) - 0.00514 * e * math.sin(mp + m) +
+         0.00208 * e * e * math.sin(2 * m) - 0.00111 * math.sin(mp - 2 * f) -
+         0.00057 * math.sin(mp + 2 * f) + 0.00056 * e * math.sin(2 * mp + m) -
+         0.00042 * math.sin(3 * mp) + 0.00042 * e * math.sin(m + 2 * f) +
+         0.00038 * e * math.sin(m - 2 * f) - 0.00024 * e * math.sin(2 * mp - m) -
+         0.00017 * math.sin(om) - 0.00007 * math.sin(mp + 2 * m) + 0.00004 * math.sin(2 * mp - 2 * f) +
+         0.00004 * math.sin(3 * m) + 0.00003 * math.sin(mp + m - 2 * f) +
+         0.00003 * math.sin(2 * mp + 2 * f) - 0.00003 * math.sin(mp + m + 2 * f) +
+         0.00003 * math.sin(mp - m + 2 * f) - 0.00002 * math.sin(mp - m - 2 * f) -
+         0.00002 * math.sin(3 * mp + m) + 0.00002 * math.sin(4 * mp))
+    planetary = [
+        (299.77 + 0.107408 * k - 0.009173 * t ** 2, 0.000325), (251.88 + 0.016321 * k, 0.000165),
+        (251.83 + 26.651886 * k, 0.000164), (349.42 + 36.412478 * k, 0.000126),
+        (84.66 + 18.206239 * k, 0.000110), (141.74 + 53.303771 * k, 0.000062),
+        (207.14 + 2.453732 * k, 0.000060), (154.84 + 7.306860 * k, 0.000056),
+        (34.52 + 27.261239 * k, 0.000047), (207.19 + 0.121824 * k, 0.000042),
+        (291.34 + 1.844379 * k, 0.000040), (161.72 + 24.198154 * k, 0.000037),
+        (239.56 + 25.513099 * k, 0.000035), (331.55 + 3.592518 * k, 0.000023),
+    ]
+    s += sum(c * math.sin(a * D2R) for a, c in planetary)
+    return jde + s
+
+
+# VSOP87地球日心黄经的截断级数 (A, B, C)
+VSOP87_L = [
+    [(175347046, 0, 0), (3341656, 4.6692568, 6283.07585), (34894, 4.6261, 12566.1517),
+     (3497, 2.7441, 5753.3849), (3418, 2.8289, 3.5231), (3136, 3.6277, 77713.7715),
+     (2676, 4.4181, 7860.4194), (2343, 6.1352, 3930.2097), (1324, 0.7425, 11506.7698),
+     (1273, 2.0371, 529.691), (1199, 1.1096, 1577.3435), (990, 5.233, 5884.927), (902, 2.045, 26.298),
+     (857, 3.508, 398.149), (780, 1.179, 5223.694), (753, 2.533, 5507.553), (505, 4.583, 18849.228),
+     (492, 4.205, 775.523), (357, 2.92, 0.067), (317, 5.849, 11790.629), (284, 1.899, 796.298),
+     (271, 0.315, 10977.079), (243, 0.345, 5486.778), (206, 4.806, 2544.314), (205, 1.869, 5573.143),
+     (202, 2.458, 6069.777), (156, 0.833, 213.299), (132, 3.411, 2942.463), (126, 1.083, 20.775),
+     (115, 0.645, 0.98), (103, 0.636, 4694.003), (102, 0.976, 15720.839), (102, 4.267, 7.114),
+     (99, 6.21, 2146.17), (98, 0.68, 155.42), (86, 5.98, 161000.69), (85, 1.3, 6275.96),
+     (85, 3.67, 71430.7), (80, 1.81, 17260.15), (79, 3.04, 12036.46), (75, 1.76, 5088.63),
+     (74, 3.5, 3154.69), (74, 4.68, 801.82), (70, 0.83, 9437.76), (62, 3.98, 8827.39),
+     (61, 1.82, 7084.9), (57, 2.78, 6286.6), (56, 4.39, 14143.5), (56, 3.47, 6279.55),
+     (52, 0.19, 12139.55), (52, 1.33, 1748.02), (51, 0.28, 5856.48), (49, 0.49, 1194.45),
+     (41, 5.37, 8429.24), (41, 2.4, 19651.05), (39, 6.17, 10447.39), (37, 6.04, 10213.29),
+     (37, 2.57, 1059.38), (36, 1.71, 2352.87), (36, 1.78, 6812.77), (33, 0.59, 17789.85),
+     (30, 0.44, 83996.85), (30, 2.74, 1349.87), (25, 3.16, 4690.48)],
+    [(628331966747, 0, 0), (206059, 2.678235, 6283.07585), (4303, 2.6351, 12566.1517),
+     (425, 1.59, 3.523), (119, 5.796, 26.298), (109, 2.966, 1577.344), (93, 2.59, 18849.23),
+     (72, 1.14, 529.69), (68, 1.87, 398.15), (67, 4.41, 5507.55), (59, 2.89, 5223.69),
+     (56, 2.17, 155.42), (45, 0.4, 796.3), (36, 0.47, 775.52), (29, 2.65, 7.11), (21, 5.34, 0.98),
+     (19, 1.85, 5486.78), (19, 4.97, 213.3), (17, 2.99, 6275.96), (16, 0.03, 2544.31),
+     (16, 1.43, 2146.17), (15, 1.21, 10977.08), (12, 2.83, 1748.02), (12, 3.26, 5088.63),
+     (12, 5.27, 1194.45), (12, 2.08, 4694), (11, 0.77, 553.57), (10, 1.3, 6286.6),
+     (10, 4.24, 1349.87), (9, 2.7, 242.73), (9, 5.64, 951.72), (8, 5.3, 2352.87), (6, 2.65, 9437.76),
+     (6, 4.67, 4690.48)],
+    [(52919, 0, 0), (8720, 1.0721, 6283.0758), (309, 0.867, 12566.152), (27, 0.05, 3.52),
+     (16, 5.19, 26.3), (16, 3.68, 155.42), (10, 0.76, 18849.23), (9, 2.06, 77713.77),
+     (7, 0.83, 775.52), (5, 4.66, 1577.34), (4, 1.03, 7.11), (4, 3.44, 5573.14), (3, 5.14, 796.3),
+     (3, 6.05, 5507.55), (3, 1.19, 242.73), (3, 6.12, 529.69), (3, 0.31, 398.15), (3, 2.28, 553.57),
+     (2, 4.38, 5223.69), (2, 3.75, 0.98)],
+    [(289, 5.844, 6283.076), (35, 0, 0), (17, 5.49, 12566.15), (3, 5.2, 155.42), (1, 4.72, 3.52),
+     (1, 5.3, 18849.23), (1, 5.97, 242.73)],
+    [(114, 3.142, 0), (8, 4.13, 6283.08), (1, 3.84, 12566.15)],
+    [(1, 3.14, 0)],
+]
+
+
+def sun_longitude(jde):
+    """太阳视黄经（度），含章动和光行差"""
+    tau = (jde - 2451545) / 365250
+    lon = sum(sum(a * math.cos(b + c * tau) for a, b, c in series) * tau ** i
+              for i, series in enumerate(VSOP87_L)) / 1e8
+    lon = lon / D2R + 180
+    t = tau * 10
+    om = (125.04452 - 1934.136261 * t) * D2R
+    ls = (280.4665 + 36000.7698 * t) * D2R
+    lm = (218.3165 + 481267.8813 * t) * D2R
+    dpsi = (-17.20 * math.sin(om) - 1.32 * math.sin(2 * ls) - 0.23 * math.sin(2 * lm) +
+            0.21 * math.sin(2 * om)) / 3600
+    lon += -0.09033 / 3600 + dpsi - 20.4898 / 3600
+    return lon % 360
+
+
+def solar_term_jde(year, angle):
+    """year年中太阳视黄经到达angle的时刻"""
+    jde = 2451545 + (year - 2000) * 365.2422 + ((angle - 280.46) % 360) / 360 * 365.2422
+    for _ in range(50):
+        d = (angle - sun_longitude(jde) + 180) % 360 - 180
+        jde += d / 360 * 365.2422
+        if abs(d) < 1e-7:
+            break
+    return jde
+
+
+def local_day(jde, tz_hours):
+    """返回 (当地日的儒略日数, 距子夜最近的分钟数)"""
+    local = jde - delta_t(jde_to_year(jde)) / 86400 + tz_hours / 24 + 0.5
+    frac = local - math.floor(local)
+    return math.floor(local), min(frac, 1 - frac) * 1440
+
+
+def jdn_to_date(jdn):
+    return datetime.date.fromordinal(jdn - JDN_ORDINAL_OFFSET)
+
+
+def date_to_jdn(date):
+    return date.toordinal() + JDN_ORDINAL_OFFSET
+
+
+def calendar_tz(jde):
+    return 8.0 if jde_to_year(jde) >= 1929 else BEIJING_LMT_H
+
+
+def compute_months(warnings):
+    """返回按起始日排序的 [(起始儒略日数, 月份, 是否闰月)]，覆盖MIN_YEAR-1至MAX_YEAR+1"""
+    moon_days = []
+    k = int((MIN_YEAR - 1 - 2000) * 12.3685) - 2
+    while True:
+        jde = new_moon(k)
+        k += 1
+        if jde_to_year(jde) > MAX_YEAR + 3:
+            break
+        day, edge = local_day(jde, calendar_tz(jde))
+        corrected = NEW_MOON_CORRECTIONS.get(jdn_to_date(day))
+        if corrected:
+            day = date_to_jdn(corrected)
+        elif edge < EDGE_MINUTES and MIN_YEAR <= jdn_to_date(day).year <= MAX_YEAR:
+            warnings.append('朔距子夜%.1f分钟: %s' % (edge, jdn_to_date(day)))
+        moon_days.append(day)
+
+    # 中气（黄经30°的整数倍）和其中的冬至
+    major_terms = []
+    solstices = []
+    for year in range(MIN_YEAR - 2, MAX_YEAR + 3):
+        for angle in range(0, 360, 30):
+            jde = solar_term_jde(year, angle)
+            day = local_day(jde, calendar_tz(jde))[0]
+            major_terms.append(day)
+            if angle == 270:
+                solstices.append(day)
+    major_terms.sort()
+    solstices.sort()
+
+    def month_of(day):
+        return bisect.bisect_right(moon_days, day) - 1
+
+    def has_major_term(i):
+        j = bisect.bisect_left(major_terms, moon_days[i])
+        return j < len(major_terms) and major_terms[j] < moon_days[i + 1]
+
+    months = {}
+    for w in range(len(solstices) - 1):
+        first, last = month_of(solstices[w]), month_of(solstices[w + 1])
+        if first < 0 or last + 1 >= len(moon_days):
+            continue
+        need_leap = last - first == 13
+        number = 11
+        for i in range(first, last):
+            if need_leap and i > first and not has_major_term(i):
+                months[moon_days[i]] = ((number - 2) % 12 + 1, True)
+                need_leap = False
+            else:
+                months[moon_days[i]] = ((number - 1) % 12 + 1, False)
+                number += 1
+    return [(day, month, leap) for day, (month, leap) in sorted(months.items())]
+
+
+def compute_solar_terms(warnings):
+    """返回 {(公历年, 月, 日): 节气序号}，0=小寒 ... 23=冬至，按东经120°取日"""
+    terms = {}
+    for year in range(MIN_YEAR, MAX_YEAR + 1):
+        for index in range(24):
+            angle = (285 + 15 * index) % 360
+            jde = solar_term_jde(year, angle)
+            day, edge = local_day(jde, 8.0)
+            date = jdn_to_date(day)
+            if date.year != year:
+                jde = solar_term_jde(year + (1 if date.year < year else -1), angle)
+                day, edge = local_day(jde, 8.0)
+                date = jdn_to_date(day)
+            if date.year != year or date.month != index // 2 + 1:
+                raise ValueError('节气%d落在%s' % (index, date))
+            if edge < EDGE_MINUTES:
+                warnings.append('节气%d距子夜%.1f分钟: %s' % (index, edge, date))
+            terms[(date.year, date.month, date.day)] = index
+    return terms
+
+
+def write_reference(path, months, terms):
+    start = date_to_jdn(datetime.date(MIN_YEAR, 1, 31))
+    first = next(i for i, m in enumerate(months) if m[0] == start)
+    if months[first][1:] != (1, False):
+        raise ValueError('1900-01-31不是正月初一')
+
+    lunar_year = MIN_YEAR - 1
+    count = 0
+    with open(path, 'w') as out:
+        for i in range(first, len(months) - 1):
+            day, month, leap = months[i]
+            if month == 1 and not leap:
+                lunar_year += 1
+                if lunar_year > MAX_YEAR:
+                    break
+            length = months[i + 1][0] - day
+            for d in range(length):
+                date = jdn_to_date(day + d)
+                term = terms.get((date.year, date.month, date.day), -1)
+                out.write('%d %d %d %d %d %d %d %d %d\n' % (date.year, date.month, date.day, lunar_year,
+                                                            month, d + 1, int(leap), length, term))
+                count += 1
+    return count, jdn_to_date(day - 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='按天文算法生成农历逐日参考数据')
+    parser.add_argument('--output', required=True, help='输出文件')
+    parser.add_argument('--warnings', action='store_true', help='列出距子夜过近的朔和节气')
+    args = parser.parse_args()
+
+    warnings = []
+    months = compute_months(warnings)
+    terms = compute_solar_terms(warnings)
+    count, last = write_reference(args.output, months, terms)
+    if args.warnings:
+        for w in warnings:
+            print('警告: ' + w, file=sys.stderr)
+    print('农历参考数据: %d天，至%s，%d处距子夜不足%d分钟' % (count, last, len(warnings), EDGE_MINUTES))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
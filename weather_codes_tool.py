@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+天气编码完美哈希表生成工具
+读取 main/weather_codes.c 中的天气现象名称表和风向名称表，为每张表搜索两级位移
+完美哈希（FNV-1a，先按种子0选桶，再以桶的位移为种子定槽位），把生成的数组写回
+weather_codes.c 中"以下由 weather_codes_tool.py 生成"与"生成结束"之间。
+
+使用方法:
+1. 生成: python weather_codes_tool.py            （名称表改动后运行）
+2. 校验: python weather_codes_tool.py --verify   （检查文件中的表与名称表一致）
+
+算法与 main/weather_codes.c 中的 code_hash/hash_lookup 一致。
+"""
+
+import argparse
+import re
+import sys
+from pathlib import Path
+
+SOURCE = Path(__file__).resolve().parent / 'main' / 'weather_codes.c'
+BEGIN_MARK = '/* --- 以下由 weather_codes_tool.py 生成 --- */'
+END_MARK = '/* --- 生成结束 --- */'
+
+FNV_BASIS = 2166136261
+FNV_PRIME = 16777619
+
+# (表名, 名称数组, 槽位数, 桶数)，都必须是2的幂
+TABLES = [
+    ('weather', 'weather_entries', 128, 16),
+    ('wind', 'wind_names', 16, 4),
+]
+
+
+def code_hash(text, seed):
+    h = FNV_BASIS ^ seed
+    for byte in text.encode('utf-8'):
+        h = ((h ^ byte) * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def parse_names(source, array):
+    """取出名称数组中按顺序出现的字符串，下标0（未知）不参与哈希"""
+    match = re.search(r'\b' + array + r'\[[^\]]*\]\s*=\s*\{(.*?)\n\};', source, re.S)
+    if not match:
+        raise ValueError(f'未在weather_codes.c中找到数组 {array}')
+    return re.findall(r'"((?:[^"\\]|\\.)*)"', match.group(1))
+
+
+def build(names, slot_count, bucket_count):
+    """两级位移：大桶优先放置，每个桶找一个使全部键落入空槽的位移"""
+    buckets = [[] for _ in range(bucket_count)]
+    for code, name in enumerate(names):
+        if code == 0:
+            continue
+        buckets[code_hash(name, 0) % bucket_count].append(code)
+    disp = [0] * bucket_count
+    slots = [0] * slot_count
+    for bucket in sorted(range(bucket_count), key=lambda b: -len(buckets[b])):
+        if not buckets[bucket]:
+            continue
+        for seed in range(1, 256):
+            positions = [code_hash(names[code], seed) % slot_count for code in buckets[bucket]]
+            if len(set(positions)) == len(positions) and all(slots[p] == 0 for p in positions):
+                for position, code in zip(positions, buckets[bucket]):
+                    slots[position] = code
+                disp[bucket] = seed
+                break
+        else:
+            raise ValueError(f'找不到完美哈希，请增大槽位数（{slot_count}）或桶数（{bucket_count}）')
+    return disp, slots
+
+
+def format_array(name, values):
+    lines = [f'static const uint8_t {name}[{len(values)}] = {{']
+    for i in range(0, len(values), 16):
+        lines.append('    ' + ', '.join(f'{v:3d}' for v in values[i:i + 16]) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def generate(source):
+    blocks = []
+    for prefix, array, slot_count, bucket_count in TABLES:
+        names = parse_names(source, array)
+        disp, slots = build(names, slot_count, bucket_count)
+        blocks.append(format_array(f'{prefix}_hash_disp', disp))
+        blocks.append(format_array(f'{prefix}_hash_slots', slots))
+        print(f'{array}: {len(names) - 1} 项 -> {slot_count} 槽 / {bucket_count} 桶')
+    return '\n'.join(blocks)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='生成天气编码的完美哈希表')
+    parser.add_argument('--verify', action='store_true', help='只检查，不改写文件')
+    args = parser.parse_args()
+
+    source = SOURCE.read_text(encoding='utf-8')
+    start = source.find(BEGIN_MARK)
+    end = source.find(END_MARK)
+    if start < 0 or end < start:
+        print('weather_codes.c中缺少生成区标记', file=sys.stderr)
+        return 1
+    current = source[start + len(BEGIN_MARK):end].strip('\n')
+    generated = generate(source)
+
+    if args.verify:
+        if current != generated:
+            print('哈希表与名称表不一致，请重新生成', file=sys.stderr)
+            return 1
+        print('校验通过')
+        return 0
+
+    source = source[:start + len(BEGIN_MARK)] + '\n' + generated + '\n' + source[end:]
+    SOURCE.write_text(source, encoding='utf-8')
+    print(f'已写入 {SOURCE}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())